@@ -0,0 +1,151 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-arena.c - Compare malloc() and an arena for short lived structures.
+ *
+ * Usage: bench-arena [max_items [total_items]]
+ *
+ * Simulates requests that each build a bst of items with random keys, look each one up, and then throw the whole
+ * tree away.  For request sizes of 10, 100, ... up to max_items, with items from malloc() (freed one by one after a
+ * bst_drain()) and from an arena (thrown away with arena_reset()), runs enough requests to handle total_items items,
+ * and prints a CSV line with the throughput in items per second and the time spent freeing, per item.
+ */
+
+#include <inttypes.h>
+#include "mec-lib/arena.h"
+#include "mec-lib/bst.h"
+#include "bench.h"
+
+
+
+struct item {
+        uint64_t key;
+        struct bst_node node;
+};
+
+struct bst bst;
+struct arena arena;
+uint64_t state = 0x1234567;
+
+void *item_get_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct item, node)->key;
+}
+
+int compare_u64s(void *key_a, void *key_b)
+{
+        uint64_t a = *(uint64_t *)key_a;
+        uint64_t b = *(uint64_t *)key_b;
+
+        return (a > b) - (a < b);
+}
+
+struct bst_ops item_bst_ops = {
+        .get_key = item_get_key,
+        .compare = compare_u64s,
+};
+
+void *alloc_chunk(size_t size)
+{
+        return malloc(size);
+}
+
+void free_chunk(void *chunk, size_t size)
+{
+        free(chunk);
+}
+
+struct arena_ops ops = {
+        .alloc_chunk = alloc_chunk,
+        .free_chunk = free_chunk,
+};
+
+void free_node(struct bst_node *n)
+{
+        free(BST_ITEM(n, struct item, node));
+}
+
+/* Build a tree of 'n' items and look each of them up. */
+void build(struct item **items, uint64_t n, int use_arena)
+{
+        uint64_t i;
+
+        bst_init(&bst, &item_bst_ops);
+        for (i=0; i<n; i++) {
+                items[i] = use_arena ? arena_alloc(&arena, sizeof(struct item)) : malloc(sizeof(struct item));
+                BENCH_CHECK(items[i] != NULL);
+                items[i]->key = bench_rand(&state);
+                BENCH_CHECK(bst_insert(&bst, &items[i]->node) == 0);
+        }
+
+        for (i=0; i<n; i++)
+                BENCH_CHECK(bst_find(&bst, &items[i]->key) == &items[i]->node);
+}
+
+void run(struct item **items, uint64_t n, uint64_t total, int use_arena)
+{
+        uint64_t start, t, free_ns = 0, r, requests = total / n;
+
+        start = bench_now_ns();
+        for (r=0; r<requests; r++) {
+                build(items, n, use_arena);
+
+                t = bench_now_ns();
+                if (use_arena)
+                        arena_reset(&arena);
+                else
+                        BENCH_CHECK(bst_drain(&bst, free_node) == n);
+                free_ns += bench_now_ns() - t;
+        }
+
+        printf("%s,%" PRIu64 ",%.0f,%.2f\n", use_arena ? "arena" : "malloc", n,
+               (double)(requests * n) * 1e9 / (bench_now_ns() - start), (double)free_ns / (requests * n));
+        fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+        uint64_t max_items = (argc > 1) ? strtoull(argv[1], NULL, 0) : 100000;
+        uint64_t total = (argc > 2) ? strtoull(argv[2], NULL, 0) : 2000000;
+        struct item **items;
+        uint64_t n;
+
+        items = malloc(sizeof(*items) * max_items);
+        BENCH_CHECK(items);
+        arena_init(&arena, &ops, NULL, 0);
+
+        printf("allocator,items_per_request,items_per_sec,free_ns_per_item\n");
+        for (n = 10; n <= max_items; n *= 10) {
+                run(items, n, total, 0);
+                run(items, n, total, 1);
+        }
+
+        arena_destroy(&arena);
+        free(items);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,240 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-art.c - Compare art against bst.
+ *
+ * Usage: bench-art [max_items [ops_per_phase]]
+ *
+ * For tree sizes of 1000, 10000, ... up to max_items, and for both random 64 bit integer keys and path-like string
+ * keys ("/user/<n>/session/<n>", which share long prefixes), builds an art and a bst (AA balanced) over the same
+ * items and times:
+ *
+ *   insert  every item inserted
+ *   find    items looked up uniformly at random
+ *   gte     a random item's key, plus a byte, looked up with find_smallest_gte
+ *   delete  every item deleted, in the order they were inserted
+ *
+ * printing a CSV line for each with its throughput.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "mec-lib/art.h"
+#include "mec-lib/bst.h"
+#include "bench.h"
+
+
+
+#define KEY_LEN         40
+
+struct item {
+        uint64_t key;           /* Integer keys, in native byte order for bst. */
+        uint64_t key_be;        /* The same, big endian, for art. */
+        char str[KEY_LEN];      /* String keys. */
+        size_t str_len;
+        struct bst_node node;
+};
+
+struct bst bst;
+struct art art;
+struct item *items;
+uint64_t *lookups;      /* Items to look up, as indexes into items. */
+uint64_t num_items;
+int use_strings;
+volatile uint64_t sink;        /* Keeps the compiler from dropping lookups whose results aren't checked. */
+
+void *item_get_key(struct bst_node *n)
+{
+        struct item *it = BST_ITEM(n, struct item, node);
+
+        return use_strings ? (void *)it->str : (void *)&it->key;
+}
+
+int compare_keys(void *key_a, void *key_b)
+{
+        uint64_t a, b;
+
+        if (use_strings)
+                return strcmp(key_a, key_b);
+
+        a = *(uint64_t *)key_a;
+        b = *(uint64_t *)key_b;
+
+        return (a > b) - (a < b);
+}
+
+struct bst_ops item_bst_ops = {
+        .get_key = item_get_key,
+        .compare = compare_keys,
+};
+
+const void *item_art_key(void *item, size_t *len)
+{
+        struct item *it = item;
+
+        if (use_strings) {
+                *len = it->str_len;
+                return it->str;
+        }
+
+        *len = sizeof(it->key_be);
+        return &it->key_be;
+}
+
+struct art_node *alloc_node(size_t size)
+{
+        return malloc(size);
+}
+
+void free_node(struct art_node *n, size_t size)
+{
+        free(n);
+}
+
+struct art_ops item_art_ops = {
+        .get_key = item_art_key,
+        .alloc_node = alloc_node,
+        .free_node = free_node,
+};
+
+void report(const char *tree, const char *op, uint64_t ops, uint64_t elapsed)
+{
+        printf("%s,%s,%" PRIu64 ",%s,%.0f\n", tree, use_strings ? "string" : "u64", num_items, op,
+               (double)ops * 1e9 / elapsed);
+        fflush(stdout);
+}
+
+void run_bst(uint64_t ops)
+{
+        struct item probe;
+        uint64_t start, i;
+
+        bst_init(&bst, &item_bst_ops);
+
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++)
+                BENCH_CHECK(bst_insert(&bst, &items[i].node) == 0);
+        report("bst", "insert", num_items, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++)
+                BENCH_CHECK(bst_find(&bst, item_get_key(&items[lookups[i]].node)) == &items[lookups[i]].node);
+        report("bst", "find", ops, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++) {
+                /* Just past an item: one more for integers, and a trailing character for strings. */
+                probe = items[lookups[i]];
+                probe.key++;
+                probe.str[probe.str_len] = '0';
+                probe.str[probe.str_len + 1] = 0;
+                sink += (uintptr_t)bst_find_smallest_gte(&bst, item_get_key(&probe.node));
+        }
+        report("bst", "gte", ops, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++)
+                BENCH_CHECK(bst_delete(&bst, &items[i].node) == 0);
+        report("bst", "delete", num_items, bench_now_ns() - start);
+        BENCH_CHECK(bst.root == bst_nil);
+}
+
+void run_art(uint64_t ops)
+{
+        struct item probe;
+        const void *key;
+        uint64_t start, i;
+        size_t len;
+
+        art_init(&art, &item_art_ops);
+
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++)
+                BENCH_CHECK(art_insert(&art, &items[i]) == 0);
+        report("art", "insert", num_items, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++) {
+                key = item_art_key(&items[lookups[i]], &len);
+                BENCH_CHECK(art_find(&art, key, len) == &items[lookups[i]]);
+        }
+        report("art", "find", ops, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++) {
+                probe = items[lookups[i]];
+                probe.key_be = art_u64_key(probe.key + 1);
+                probe.str[probe.str_len++] = '0';
+                key = item_art_key(&probe, &len);
+                sink += (uintptr_t)art_find_smallest_gte(&art, key, len);
+        }
+        report("art", "gte", ops, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++) {
+                key = item_art_key(&items[i], &len);
+                BENCH_CHECK(art_delete(&art, key, len) == 0);
+        }
+        report("art", "delete", num_items, bench_now_ns() - start);
+        BENCH_CHECK(art.root == NULL);
+}
+
+int main(int argc, char **argv)
+{
+        uint64_t max_items = (argc > 1) ? strtoull(argv[1], NULL, 0) : 1000000;
+        uint64_t ops = (argc > 2) ? strtoull(argv[2], NULL, 0) : 1000000;
+        uint64_t state = 0x1234567;
+        uint64_t i;
+
+        items = malloc(sizeof(*items) * max_items);
+        lookups = malloc(sizeof(*lookups) * ops);
+        BENCH_CHECK(items && lookups);
+
+        printf("tree,keys,items,op,ops_per_sec\n");
+        for (num_items = 1000; num_items <= max_items; num_items *= 10) {
+                /* Random 64 bit keys won't collide in practice, and the inserts check anyway.  String keys are made
+                   unique by their session number. */
+                for (i=0; i<num_items; i++) {
+                        items[i].key = bench_rand(&state);
+                        items[i].key_be = art_u64_key(items[i].key);
+                        items[i].str_len = snprintf(items[i].str, KEY_LEN - 2, "/user/%" PRIu64 "/session/%" PRIu64,
+                                                    bench_rand(&state) % (num_items / 10 + 1), i);
+                }
+                for (i=0; i<ops; i++)
+                        lookups[i] = bench_rand(&state) % num_items;
+
+                for (use_strings = 0; use_strings <= 1; use_strings++) {
+                        run_bst(ops);
+                        run_art(ops);
+                }
+        }
+
+        free(lookups);
+        free(items);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,190 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-bst-balance.c - Compare the AA, red-black and splay balancing of bst.
+ *
+ * Usage: bench-bst-balance [max_items [ops_per_phase]]
+ *
+ * For tree sizes of 1000, 10000, ... up to max_items, and each balancing scheme, runs:
+ *
+ *   insert  items with random keys inserted
+ *   churn   session expiry: the oldest item is deleted and a new one with a random key inserted
+ *   find    items looked up uniformly at random
+ *   zipf    items looked up with a Zipfian (theta 0.99) distribution
+ *   hot     90% of lookups go to 1% of the items, the rest are uniform
+ *   delete  every item deleted, in random order
+ *
+ * and prints a CSV line for each phase with its throughput, the rotations done per operation, and the average depth
+ * of a find.  bst is built with BST_STATS here, so the numbers include the cost of counting.
+ */
+
+#include <inttypes.h>
+#include "mec-lib/bst.h"
+#include "bench.h"
+
+
+
+struct item {
+        uint64_t key;
+        struct bst_node node;
+};
+
+const char *balance_names[] = { [BST_BALANCE_AA] = "aa", [BST_BALANCE_RB] = "rb", [BST_BALANCE_SPLAY] = "splay" };
+
+struct bst bst;
+struct item *items;
+uint64_t *order;
+uint64_t *lookups;      /* Items to look up, as indexes into items. */
+uint64_t num_items;
+
+void *item_get_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct item, node)->key;
+}
+
+int compare_u64s(void *key_a, void *key_b)
+{
+        uint64_t a = *(uint64_t *)key_a;
+        uint64_t b = *(uint64_t *)key_b;
+
+        return (a > b) - (a < b);
+}
+
+struct bst_ops item_bst_ops = {
+        .get_key = item_get_key,
+        .compare = compare_u64s,
+};
+
+static inline unsigned long rotations(void)
+{
+        return bst.stats.skews + bst.stats.splits + bst.stats.rotations;
+}
+
+void report(enum bst_balance balance, const char *op, uint64_t ops, uint64_t elapsed)
+{
+        unsigned long finds = bst.stats.ops[BST_STATS_FIND];
+
+        printf("%s,%" PRIu64 ",%s,%.0f,%.3f,%.2f\n", balance_names[balance], num_items, op, (double)ops * 1e9 / elapsed,
+               (double)rotations() / ops, finds ? (double)bst.stats.depth[BST_STATS_FIND] / finds : 0);
+        fflush(stdout);
+}
+
+/* Time looking up each of lookups[0 .. ops-1]. */
+void run_finds(enum bst_balance balance, const char *op, uint64_t ops)
+{
+        uint64_t start, i;
+
+        bst_stats_reset(&bst);
+        start = bench_now_ns();
+        for (i=0; i<ops; i++)
+                BENCH_CHECK(bst_find(&bst, &items[lookups[i]].key) == &items[lookups[i]].node);
+        report(balance, op, ops, bench_now_ns() - start);
+}
+
+void run(enum bst_balance balance, uint64_t ops)
+{
+        struct bench_zipf zipf = { 0 };
+        uint64_t state = 0x1234567;
+        uint64_t start, i, j, t;
+
+        bst_init_balanced(&bst, &item_bst_ops, balance);
+
+        /* Random 64 bit keys won't collide in practice, but check anyway. */
+        bst_stats_reset(&bst);
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++) {
+                items[i].key = bench_rand(&state);
+                BENCH_CHECK(bst_insert(&bst, &items[i].node) == 0);
+        }
+        report(balance, "insert", num_items, bench_now_ns() - start);
+
+        /* Items are recycled in the order they were inserted, so the oldest one is always the next to go. */
+        bst_stats_reset(&bst);
+        start = bench_now_ns();
+        for (i=0; i<ops; i++) {
+                struct item *it = &items[i % num_items];
+
+                BENCH_CHECK(bst_delete(&bst, &it->node) == 0);
+                it->key = bench_rand(&state);
+                BENCH_CHECK(bst_insert(&bst, &it->node) == 0);
+        }
+        report(balance, "churn", ops, bench_now_ns() - start);
+
+        for (i=0; i<ops; i++)
+                lookups[i] = bench_rand(&state) % num_items;
+        run_finds(balance, "find", ops);
+
+        /* The order is shuffled so that the most popular items are spread out through the tree. */
+        for (i=0; i<num_items; i++)
+                order[i] = i;
+        for (i=num_items-1; i>0; i--) {
+                j = bench_rand(&state) % (i + 1);
+                t = order[i];
+                order[i] = order[j];
+                order[j] = t;
+        }
+
+        bench_zipf_init(&zipf, num_items, 0.99);
+        for (i=0; i<ops; i++)
+                lookups[i] = order[bench_zipf(&zipf, &state)];
+        run_finds(balance, "zipf", ops);
+
+        for (i=0; i<ops; i++)
+                lookups[i] = order[(bench_rand(&state) % 10) ? bench_rand(&state) % (num_items / 100) :
+                                   bench_rand(&state) % num_items];
+        run_finds(balance, "hot", ops);
+
+        bst_stats_reset(&bst);
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++)
+                BENCH_CHECK(bst_delete(&bst, &items[order[i]].node) == 0);
+        report(balance, "delete", num_items, bench_now_ns() - start);
+        BENCH_CHECK(bst.root == bst_nil);
+}
+
+int main(int argc, char **argv)
+{
+        uint64_t max_items = (argc > 1) ? strtoull(argv[1], NULL, 0) : 1000000;
+        uint64_t ops = (argc > 2) ? strtoull(argv[2], NULL, 0) : 1000000;
+        enum bst_balance balance;
+
+        items = malloc(sizeof(*items) * max_items);
+        order = malloc(sizeof(*order) * max_items);
+        lookups = malloc(sizeof(*lookups) * ops);
+        BENCH_CHECK(items && order && lookups);
+
+        printf("balance,items,op,ops_per_sec,rotations_per_op,find_depth\n");
+        for (num_items = 1000; num_items <= max_items; num_items *= 10)
+                for (balance = BST_BALANCE_AA; balance <= BST_BALANCE_SPLAY; balance++)
+                        run(balance, ops);
+
+        free(lookups);
+        free(order);
+        free(items);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
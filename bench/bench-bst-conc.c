@@ -0,0 +1,217 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-bst-conc.c - Reader scaling of a concurrent bst versus a bst behind a rwlock.
+ *
+ * Usage: bench-bst-conc [max_threads [num_items [msecs_per_run [write_interval_usecs]]]]
+ *
+ * Runs 1, 2, 4, ... max_threads readers doing random lookups while a single writer deletes and reinserts a random item
+ * every write_interval_usecs, and prints one CSV line per run.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include "mec-lib/bst-conc.h"
+#include "mec-lib/epoch.h"
+#include "bench.h"
+
+
+
+struct thing {
+        uint64_t key;
+        struct bst_node bstn;
+        struct epoch_deferred ed;
+};
+
+enum impl {
+        IMPL_RWLOCK,
+        IMPL_CONC,
+};
+
+const char *impl_names[] = {
+        [IMPL_RWLOCK] = "rwlock",
+        [IMPL_CONC] = "bst_conc",
+};
+
+struct bst_conc tree;
+pthread_rwlock_t tree_lock = PTHREAD_RWLOCK_INITIALIZER;
+struct epoch epoch;
+struct thing *things;
+uint64_t num_items;
+uint64_t write_interval_ns;
+enum impl impl;
+int stop;
+
+void *thing_get_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct thing, bstn)->key;
+}
+
+int compare_u64s(void *key_a, void *key_b)
+{
+        uint64_t a = *(uint64_t *)key_a;
+        uint64_t b = *(uint64_t *)key_b;
+
+        return (a > b) - (a < b);
+}
+
+struct bst_ops thing_bst_ops = {
+        .get_key = thing_get_key,
+        .compare = compare_u64s,
+};
+
+/* Nothing to free; the thing just goes back into the tree later. */
+void thing_reclaim(struct epoch_deferred *d)
+{
+}
+
+void *reader_thread(void *arg)
+{
+        uint64_t state = (uint64_t)(unsigned long)arg * 0x9e3779b97f4a7c15ULL;
+        struct epoch_reader reader;
+        unsigned long lookups = 0;
+        uint64_t key;
+
+        epoch_reader_register(&epoch, &reader);
+
+        while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+                key = (bench_rand(&state) % num_items) * 2;
+
+                if (impl == IMPL_RWLOCK) {
+                        pthread_rwlock_rdlock(&tree_lock);
+                        bst_find(&tree.bst, &key);
+                        pthread_rwlock_unlock(&tree_lock);
+                } else {
+                        epoch_enter(&reader);
+                        bst_conc_find(&tree, &key);
+                        epoch_exit(&reader);
+                }
+                lookups++;
+        }
+
+        epoch_reader_unregister(&reader);
+
+        return (void *)lookups;
+}
+
+/* Churn the tree by deleting a random item and putting it back, so that readers keep seeing writes. */
+void *writer_thread(void *arg)
+{
+        uint64_t state = 12345;
+        struct epoch_reader writer;
+        struct thing *thing;
+        struct timespec ts = { .tv_sec = 0, .tv_nsec = write_interval_ns };
+
+        epoch_reader_register(&epoch, &writer);
+
+        while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+                thing = &things[bench_rand(&state) % num_items];
+
+                if (impl == IMPL_RWLOCK) {
+                        pthread_rwlock_wrlock(&tree_lock);
+                        BENCH_CHECK(bst_delete(&tree.bst, &thing->bstn) == 0);
+                        BENCH_CHECK(bst_insert(&tree.bst, &thing->bstn) == 0);
+                        pthread_rwlock_unlock(&tree_lock);
+                } else {
+                        /* A real user would retire the item and wait for it to be reclaimed before reusing it; since
+                           the key doesn't change here it is safe to reinsert straight away. */
+                        BENCH_CHECK(bst_conc_delete(&tree, &thing->bstn) == 0);
+                        epoch_retire(&writer, &thing->ed, thing_reclaim);
+                        epoch_synchronize(&writer);
+                        BENCH_CHECK(bst_conc_insert(&tree, &thing->bstn) == 0);
+                }
+
+                if (write_interval_ns)
+                        nanosleep(&ts, NULL);
+        }
+
+        epoch_reader_unregister(&writer);
+
+        return NULL;
+}
+
+void run(unsigned num_threads, unsigned msecs)
+{
+        pthread_t readers[num_threads];
+        pthread_t writer;
+        unsigned long total = 0;
+        struct timespec ts = { .tv_sec = msecs / 1000, .tv_nsec = (msecs % 1000) * 1000000 };
+        uint64_t start, elapsed;
+        unsigned i;
+        void *lookups;
+
+        stop = 0;
+        start = bench_now_ns();
+        for (i=0; i<num_threads; i++)
+                BENCH_CHECK(pthread_create(&readers[i], NULL, reader_thread, (void *)(unsigned long)(i + 1)) == 0);
+        BENCH_CHECK(pthread_create(&writer, NULL, writer_thread, NULL) == 0);
+
+        nanosleep(&ts, NULL);
+        __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+
+        for (i=0; i<num_threads; i++) {
+                BENCH_CHECK(pthread_join(readers[i], &lookups) == 0);
+                total += (unsigned long)lookups;
+        }
+        BENCH_CHECK(pthread_join(writer, NULL) == 0);
+        elapsed = bench_now_ns() - start;
+
+        printf("%s,%u,%lu,%.0f\n", impl_names[impl], num_threads, (unsigned long)num_items,
+               (double)total * 1e9 / elapsed);
+        fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+        long nprocs = sysconf(_SC_NPROCESSORS_ONLN);
+        unsigned max_threads = (argc > 1) ? atoi(argv[1]) : (nprocs > 1 ? nprocs : 2);
+        unsigned msecs = (argc > 3) ? atoi(argv[3]) : 500;
+        unsigned threads;
+        uint64_t i;
+
+        num_items = (argc > 2) ? strtoull(argv[2], NULL, 0) : 1000000;
+        write_interval_ns = ((argc > 4) ? strtoull(argv[4], NULL, 0) : 100) * 1000;
+
+        things = malloc(sizeof(*things) * num_items);
+        BENCH_CHECK(things);
+
+        epoch_init(&epoch);
+        bst_conc_init(&tree, &thing_bst_ops);
+        for (i=0; i<num_items; i++) {
+                things[i].key = i * 2;
+                BENCH_CHECK(bst_conc_insert(&tree, &things[i].bstn) == 0);
+        }
+
+        printf("impl,threads,items,lookups_per_sec\n");
+        for (impl = IMPL_RWLOCK; impl <= IMPL_CONC; impl++)
+                for (threads = 1; threads <= max_threads; threads *= 2)
+                        run(threads, msecs);
+
+        free(things);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,150 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-bst-parallel.c - Scaling of parallel scans over a bst.
+ *
+ * Usage: bench-bst-parallel [num_items [max_threads]]
+ *
+ * Builds a tree of num_items (default 4M) items inserted in random order, then sums a field of every item with a
+ * plain bst_next() loop, and with bst_parallel_reduce() on 1, 2, 4, ... up to max_threads (default 8) threads, and
+ * prints a CSV line for each with its throughput and its speedup over the bst_next() loop.  The speedup can't be
+ * more than the number of cores.
+ */
+
+#include <inttypes.h>
+#include "mec-lib/bst-parallel.h"
+#include "bench.h"
+
+
+
+#define PASSES  3
+
+struct item {
+        uint64_t key;
+        uint64_t value;
+        struct bst_node node;
+};
+
+struct sum {
+        uint64_t total;
+} __attribute__((aligned(64)));
+
+void *item_get_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct item, node)->key;
+}
+
+int compare_u64s(void *key_a, void *key_b)
+{
+        uint64_t a = *(uint64_t *)key_a;
+        uint64_t b = *(uint64_t *)key_b;
+
+        return (a > b) - (a < b);
+}
+
+struct bst_ops item_bst_ops = {
+        .get_key = item_get_key,
+        .compare = compare_u64s,
+};
+
+void sum_map(void *acc, struct bst_node *n)
+{
+        ((struct sum *)acc)->total += BST_ITEM(n, struct item, node)->value;
+}
+
+void sum_combine(void *acc, void *other)
+{
+        ((struct sum *)acc)->total += ((struct sum *)other)->total;
+}
+
+void report(const char *method, unsigned nthreads, uint64_t num_items, uint64_t elapsed, uint64_t base)
+{
+        printf("%s,%u,%" PRIu64 ",%.0f,%.2f\n", method, nthreads, num_items, (double)num_items * 1e9 / elapsed,
+               (double)base / elapsed);
+        fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+        uint64_t num_items = (argc > 1) ? strtoull(argv[1], NULL, 0) : 4000000;
+        unsigned max_threads = (argc > 2) ? strtoul(argv[2], NULL, 0) : 8;
+        uint64_t state = 0x1234567;
+        uint64_t expected = 0, total, start, elapsed, base, t;
+        struct item *items;
+        struct sum *sums;
+        struct bst_node *n;
+        struct bst bst;
+        unsigned nthreads, pass, i;
+        uint64_t j;
+
+        items = malloc(sizeof(*items) * num_items);
+        sums = malloc(sizeof(*sums) * max_threads);
+        BENCH_CHECK(items && sums);
+
+        /* Random keys, so that neighbours in the tree are scattered around memory, as they are in a long lived tree. */
+        bst_init(&bst, &item_bst_ops);
+        for (j=0; j<num_items; j++) {
+                items[j].key = bench_rand(&state);
+                items[j].value = j;
+                expected += j;
+                BENCH_CHECK(bst_insert(&bst, &items[j].node) == 0);
+        }
+
+        printf("method,threads,items,items_per_sec,speedup\n");
+
+        base = UINT64_MAX;
+        for (pass=0; pass<PASSES; pass++) {
+                start = bench_now_ns();
+                for (total = 0, n = bst_next(&bst, NULL); n; n = bst_next(&bst, n))
+                        total += BST_ITEM(n, struct item, node)->value;
+                elapsed = bench_now_ns() - start;
+                BENCH_CHECK(total == expected);
+                if (elapsed < base)
+                        base = elapsed;
+        }
+        report("bst_next", 1, num_items, base, base);
+
+        for (nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+                elapsed = UINT64_MAX;
+                for (pass=0; pass<PASSES; pass++) {
+                        for (i=0; i<nthreads; i++)
+                                sums[i].total = 0;
+                        start = bench_now_ns();
+                        bst_parallel_reduce(&bst, nthreads, sums, sizeof(sums[0]), sum_map, sum_combine);
+                        t = bench_now_ns() - start;
+                        BENCH_CHECK(sums[0].total == expected);
+                        if (t < elapsed)
+                                elapsed = t;
+                }
+                report("bst_parallel_reduce", nthreads, num_items, elapsed, base);
+        }
+
+        free(sums);
+        free(items);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
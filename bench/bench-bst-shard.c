@@ -0,0 +1,182 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-bst-shard.c - Writer scaling of a sharded bst versus a single bst behind a mutex.
+ *
+ * Usage: bench-bst-shard [max_threads [num_items [num_shards]]]
+ *
+ * Runs 1, 2, 4, ... max_threads writers that between them insert and then delete num_items random keys, and prints
+ * one CSV line per phase.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include "mec-lib/bst-shard.h"
+#include "bench.h"
+
+
+
+struct thing {
+        uint64_t key;
+        struct bst_node bstn;
+};
+
+enum impl {
+        IMPL_MUTEX,
+        IMPL_SHARD,
+};
+
+const char *impl_names[] = {
+        [IMPL_MUTEX] = "mutex",
+        [IMPL_SHARD] = "bst_shard",
+};
+
+struct bst tree;
+pthread_mutex_t tree_lock = PTHREAD_MUTEX_INITIALIZER;
+struct bst_shard_set set;
+struct thing *things;
+uint64_t num_items;
+unsigned num_threads;
+enum impl impl;
+
+void *thing_get_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct thing, bstn)->key;
+}
+
+int compare_u64s(void *key_a, void *key_b)
+{
+        uint64_t a = *(uint64_t *)key_a;
+        uint64_t b = *(uint64_t *)key_b;
+
+        return (a > b) - (a < b);
+}
+
+struct bst_ops thing_bst_ops = {
+        .get_key = thing_get_key,
+        .compare = compare_u64s,
+};
+
+void *insert_thread(void *arg)
+{
+        uint64_t i;
+
+        for (i = (unsigned long)arg; i < num_items; i += num_threads) {
+                if (impl == IMPL_MUTEX) {
+                        pthread_mutex_lock(&tree_lock);
+                        BENCH_CHECK(bst_insert(&tree, &things[i].bstn) == 0);
+                        pthread_mutex_unlock(&tree_lock);
+                } else {
+                        BENCH_CHECK(bst_shard_insert(&set, &things[i].bstn) == 0);
+                }
+        }
+
+        return NULL;
+}
+
+void *delete_thread(void *arg)
+{
+        uint64_t i;
+
+        for (i = (unsigned long)arg; i < num_items; i += num_threads) {
+                if (impl == IMPL_MUTEX) {
+                        pthread_mutex_lock(&tree_lock);
+                        BENCH_CHECK(bst_delete(&tree, &things[i].bstn) == 0);
+                        pthread_mutex_unlock(&tree_lock);
+                } else {
+                        BENCH_CHECK(bst_shard_delete(&set, &things[i].bstn) == 0);
+                }
+        }
+
+        return NULL;
+}
+
+void run(const char *phase, void *(*fn)(void *))
+{
+        pthread_t threads[num_threads];
+        uint64_t start, elapsed;
+        unsigned long i;
+
+        start = bench_now_ns();
+        for (i=0; i<num_threads; i++)
+                BENCH_CHECK(pthread_create(&threads[i], NULL, fn, (void *)i) == 0);
+        for (i=0; i<num_threads; i++)
+                BENCH_CHECK(pthread_join(threads[i], NULL) == 0);
+        elapsed = bench_now_ns() - start;
+
+        printf("%s,%s,%u,%lu,%.0f\n", impl_names[impl], phase, num_threads, (unsigned long)num_items,
+               (double)num_items * 1e9 / elapsed);
+        fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+        long nprocs = sysconf(_SC_NPROCESSORS_ONLN);
+        unsigned max_threads = (argc > 1) ? atoi(argv[1]) : (nprocs > 1 ? nprocs : 2);
+        unsigned num_shards = (argc > 3) ? atoi(argv[3]) : 64;
+        struct bst_shard *shards;
+        char *splitters;
+        uint64_t i, state = 1;
+
+        num_items = (argc > 2) ? strtoull(argv[2], NULL, 0) : 1000000;
+
+        things = malloc(sizeof(*things) * num_items);
+        shards = malloc(sizeof(*shards) * num_shards);
+        splitters = malloc(BST_SHARD_SPLITTERS_SIZE(num_shards, sizeof(uint64_t)));
+        BENCH_CHECK(things && shards && splitters);
+
+        /* Distinct keys in a random order. */
+        for (i=0; i<num_items; i++)
+                things[i].key = i;
+        for (i=num_items-1; i>0; i--) {
+                uint64_t j = bench_rand(&state) % (i + 1);
+                uint64_t key = things[i].key;
+
+                things[i].key = things[j].key;
+                things[j].key = key;
+        }
+
+        printf("impl,phase,threads,items,ops_per_sec\n");
+        for (impl = IMPL_MUTEX; impl <= IMPL_SHARD; impl++) {
+                for (num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+                        bst_init(&tree, &thing_bst_ops);
+                        bst_shard_init(&set, &thing_bst_ops, shards, num_shards, splitters, sizeof(uint64_t),
+                                       num_items / num_shards / 2);
+
+                        run("insert", insert_thread);
+                        run("delete", delete_thread);
+
+                        bst_shard_destroy(&set);
+                }
+        }
+
+        free(splitters);
+        free(shards);
+        free(things);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,690 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-bst.c - Throughput and latency of bst operations, against a sorted array and a hash table.
+ *
+ * Usage: bench-bst [max_items [lookups_per_phase]]
+ *
+ * For tree sizes of 1000, 10000, ... up to max_items, with integer keys, string keys, and string keys that all start
+ * with the same 19 characters, runs these workloads:
+ *
+ *   seq     items inserted in key order, looked up in key order
+ *   random  items inserted in random order, looked up uniformly at random
+ *   zipf    items inserted in random order, looked up with a Zipfian (theta 0.99) distribution
+ *   mix     items inserted in random order, then 90% uniform finds and 10% delete + reinsert
+ *
+ * and prints a CSV line for each operation with its throughput and the median and 99th percentile latency of every
+ * 64th operation (which is timed on its own).  The find phase is followed by gte and lte phases, looking up keys that
+ * fall just above each lookup.  The sorted array is built in one go with qsort(), so it has no per operation latency
+ * for inserts, and it can't delete; the hash table can't do gte, lte or next.
+ *
+ * The plain string keys differ in their first few characters, so bst-prefix can always settle a comparison with the
+ * cached prefix, which is its best case.  The shared-prefix keys are its worst: every cached prefix is the same, so
+ * every comparison falls through to strcmp(), as with plain bst.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "mec-lib/bst.h"
+#include "bench.h"
+
+
+
+#define SAMPLE_EVERY    64
+#define STR_KEY_SIZE    40
+#define STR_KEY_FORMAT  "%s%016" PRIx64
+#define STR_KEY_PREFIX  "/srv/cache/objects/"
+
+struct item {
+        uint64_t key;
+        char str[STR_KEY_SIZE];
+        struct bst_node int_node;
+        struct bst_node str_node;
+        struct bst_prefix_node prefix_node;
+};
+
+/* A lookup key that isn't in the tree, for gte and lte. */
+struct probe {
+        uint64_t key;
+        char str[STR_KEY_SIZE];
+};
+
+enum key_type {
+        KEY_INT,
+        KEY_STRING,
+        KEY_SHARED_PREFIX,
+        NUM_KEY_TYPES,
+};
+
+enum workload {
+        WL_SEQ,
+        WL_RANDOM,
+        WL_ZIPF,
+        WL_MIX,
+        NUM_WORKLOADS,
+};
+
+enum op {
+        OP_INSERT,
+        OP_FIND,
+        OP_GTE,
+        OP_LTE,
+        OP_NEXT,
+        OP_MIX,
+        OP_DELETE,
+};
+
+const char *key_type_names[] = {
+        [KEY_INT] = "int", [KEY_STRING] = "string", [KEY_SHARED_PREFIX] = "shared-prefix",
+};
+const char *workload_names[] = { [WL_SEQ] = "seq", [WL_RANDOM] = "random", [WL_ZIPF] = "zipf", [WL_MIX] = "mix" };
+const char *op_names[] = {
+        [OP_INSERT] = "insert", [OP_FIND] = "find", [OP_GTE] = "gte", [OP_LTE] = "lte", [OP_NEXT] = "next",
+        [OP_MIX] = "mix", [OP_DELETE] = "delete",
+};
+
+/* Any of the operations an implementation can't do are left NULL.  Implementations with build() are filled in all at
+   once instead of with insert(). */
+struct impl {
+        const char *name;
+        int string_only;
+        void (*init)(void);
+        void (*insert)(struct item *it);
+        void (*build)(void);
+        struct item *(*find)(void *key);
+        struct item *(*gte)(void *key);
+        struct item *(*lte)(void *key);
+        void *(*next)(void *cursor);
+        void (*delete)(struct item *it);
+        void (*destroy)(void);
+};
+
+/* The run in progress. */
+enum key_type key_type;
+enum workload workload;
+struct impl *impl;
+uint64_t num_items;
+uint64_t num_lookups;
+
+struct item *items;
+uint64_t *order;        /* Insert (and delete) order, as indexes into items. */
+uint64_t *lookups;      /* Items to look up, as indexes into items. */
+struct probe *probes;   /* Keys just above each lookup, for gte and lte. */
+uint64_t *samples;
+void *cursor;
+uint64_t hits;
+uint64_t mix_state;
+
+static inline void *item_key(struct item *it)
+{
+        return (key_type == KEY_INT) ? (void *)&it->key : (void *)it->str;
+}
+
+static inline void *probe_key(struct probe *p)
+{
+        return (key_type == KEY_INT) ? (void *)&p->key : (void *)p->str;
+}
+
+int compare_u64s(void *key_a, void *key_b)
+{
+        uint64_t a = *(uint64_t *)key_a;
+        uint64_t b = *(uint64_t *)key_b;
+
+        return (a > b) - (a < b);
+}
+
+int compare_strings(void *key_a, void *key_b)
+{
+        return strcmp(key_a, key_b);
+}
+
+static inline int compare_keys(void *key_a, void *key_b)
+{
+        return (key_type == KEY_INT) ? compare_u64s(key_a, key_b) : strcmp(key_a, key_b);
+}
+
+
+
+/* bst, and bst with cached string prefixes. */
+
+struct bst tree;
+int use_prefix;
+
+void *item_get_int_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct item, int_node)->key;
+}
+
+void *item_get_string_key(struct bst_node *n)
+{
+        return BST_ITEM(n, struct item, str_node)->str;
+}
+
+void *item_get_prefix_string_key(struct bst_node *n)
+{
+        return BST_ITEM(BST_PREFIX_NODE(n), struct item, prefix_node)->str;
+}
+
+struct bst_ops int_bst_ops = {
+        .get_key = item_get_int_key,
+        .compare = compare_u64s,
+};
+
+struct bst_ops string_bst_ops = {
+        .get_key = item_get_string_key,
+        .compare = compare_strings,
+};
+
+struct bst_ops prefix_string_bst_ops = {
+        .get_key = item_get_prefix_string_key,
+        .compare = compare_strings,
+        .get_prefix = bst_string_prefix,
+};
+
+static inline struct bst_node *item_node(struct item *it)
+{
+        if (key_type == KEY_INT)
+                return &it->int_node;
+        return use_prefix ? &it->prefix_node.node : &it->str_node;
+}
+
+static inline struct item *node_item(struct bst_node *n)
+{
+        if (n == NULL)
+                return NULL;
+        if (key_type == KEY_INT)
+                return BST_ITEM(n, struct item, int_node);
+        return use_prefix ? BST_ITEM(BST_PREFIX_NODE(n), struct item, prefix_node) : BST_ITEM(n, struct item, str_node);
+}
+
+void bst_impl_init(void)
+{
+        use_prefix = 0;
+        bst_init(&tree, (key_type == KEY_INT) ? &int_bst_ops : &string_bst_ops);
+}
+
+void bst_prefix_impl_init(void)
+{
+        use_prefix = 1;
+        bst_init(&tree, &prefix_string_bst_ops);
+}
+
+void bst_impl_insert(struct item *it)
+{
+        BENCH_CHECK(bst_insert(&tree, item_node(it)) == 0);
+}
+
+struct item *bst_impl_find(void *key)
+{
+        return node_item(bst_find(&tree, key));
+}
+
+struct item *bst_impl_gte(void *key)
+{
+        return node_item(bst_find_smallest_gte(&tree, key));
+}
+
+struct item *bst_impl_lte(void *key)
+{
+        return node_item(bst_find_largest_lte(&tree, key));
+}
+
+void *bst_impl_next(void *cursor)
+{
+        return bst_next(&tree, cursor);
+}
+
+void bst_impl_delete(struct item *it)
+{
+        BENCH_CHECK(bst_delete(&tree, item_node(it)) == 0);
+}
+
+void bst_impl_destroy(void)
+{
+}
+
+struct impl bst_impl = {
+        .name = "bst",
+        .init = bst_impl_init,
+        .insert = bst_impl_insert,
+        .find = bst_impl_find,
+        .gte = bst_impl_gte,
+        .lte = bst_impl_lte,
+        .next = bst_impl_next,
+        .delete = bst_impl_delete,
+        .destroy = bst_impl_destroy,
+};
+
+struct impl bst_prefix_impl = {
+        .name = "bst-prefix",
+        .string_only = 1,
+        .init = bst_prefix_impl_init,
+        .insert = bst_impl_insert,
+        .find = bst_impl_find,
+        .gte = bst_impl_gte,
+        .lte = bst_impl_lte,
+        .next = bst_impl_next,
+        .delete = bst_impl_delete,
+        .destroy = bst_impl_destroy,
+};
+
+
+
+/* Sorted array of item pointers, searched with binary search. */
+
+struct item **array;
+
+int compare_array_items(const void *a, const void *b)
+{
+        return compare_keys(item_key(*(struct item **)a), item_key(*(struct item **)b));
+}
+
+void array_impl_init(void)
+{
+        array = malloc(sizeof(*array) * num_items);
+        BENCH_CHECK(array);
+}
+
+void array_impl_build(void)
+{
+        uint64_t i;
+
+        for (i=0; i<num_items; i++)
+                array[i] = &items[order[i]];
+        qsort(array, num_items, sizeof(*array), compare_array_items);
+}
+
+/* Index of the first item whose key is greater than or equal to 'key'. */
+static inline uint64_t array_lower_bound(void *key)
+{
+        uint64_t lo = 0, hi = num_items, mid;
+
+        while (lo < hi) {
+                mid = lo + (hi - lo) / 2;
+                if (compare_keys(item_key(array[mid]), key) < 0)
+                        lo = mid + 1;
+                else
+                        hi = mid;
+        }
+
+        return lo;
+}
+
+struct item *array_impl_find(void *key)
+{
+        uint64_t i = array_lower_bound(key);
+
+        return ((i < num_items) && (compare_keys(item_key(array[i]), key) == 0)) ? array[i] : NULL;
+}
+
+struct item *array_impl_gte(void *key)
+{
+        uint64_t i = array_lower_bound(key);
+
+        return (i < num_items) ? array[i] : NULL;
+}
+
+struct item *array_impl_lte(void *key)
+{
+        uint64_t i = array_lower_bound(key);
+
+        if ((i < num_items) && (compare_keys(item_key(array[i]), key) == 0))
+                return array[i];
+
+        return i ? array[i - 1] : NULL;
+}
+
+void *array_impl_next(void *cursor)
+{
+        struct item **p = cursor ? (struct item **)cursor + 1 : array;
+
+        return (p < array + num_items) ? p : NULL;
+}
+
+void array_impl_destroy(void)
+{
+        free(array);
+}
+
+struct impl array_impl = {
+        .name = "array",
+        .init = array_impl_init,
+        .build = array_impl_build,
+        .find = array_impl_find,
+        .gte = array_impl_gte,
+        .lte = array_impl_lte,
+        .next = array_impl_next,
+        .destroy = array_impl_destroy,
+};
+
+
+
+/* Open addressing hash table with linear probing, at most half full. */
+
+struct item **slots;
+uint64_t slot_mask;
+unsigned slot_shift;
+
+static inline uint64_t hash_key(void *key)
+{
+        const unsigned char *s;
+        uint64_t h;
+
+        if (key_type == KEY_INT) {
+                h = *(uint64_t *)key;
+        } else {
+                /* FNV-1a */
+                h = 0xcbf29ce484222325ULL;
+                for (s = key; *s; s++)
+                        h = (h ^ *s) * 0x100000001b3ULL;
+        }
+
+        return (h * 0x9e3779b97f4a7c15ULL) >> slot_shift;
+}
+
+void hash_impl_init(void)
+{
+        unsigned bits = 1;
+
+        while ((1ULL << bits) < num_items * 2)
+                bits++;
+        slot_mask = (1ULL << bits) - 1;
+        slot_shift = 64 - bits;
+        slots = calloc(slot_mask + 1, sizeof(*slots));
+        BENCH_CHECK(slots);
+}
+
+void hash_impl_insert(struct item *it)
+{
+        uint64_t i;
+
+        for (i = hash_key(item_key(it)); slots[i]; i = (i + 1) & slot_mask)
+                BENCH_CHECK(slots[i] != it);
+        slots[i] = it;
+}
+
+struct item *hash_impl_find(void *key)
+{
+        uint64_t i;
+
+        for (i = hash_key(key); slots[i]; i = (i + 1) & slot_mask)
+                if (compare_keys(item_key(slots[i]), key) == 0)
+                        return slots[i];
+
+        return NULL;
+}
+
+void hash_impl_delete(struct item *it)
+{
+        uint64_t i, j, home;
+
+        for (i = hash_key(item_key(it)); slots[i] != it; i = (i + 1) & slot_mask)
+                BENCH_CHECK(slots[i]);
+        slots[i] = NULL;
+
+        /* Shift back any following items whose probe sequence passes through the hole. */
+        for (j = (i + 1) & slot_mask; slots[j]; j = (j + 1) & slot_mask) {
+                home = hash_key(item_key(slots[j]));
+                if (((j - home) & slot_mask) >= ((j - i) & slot_mask)) {
+                        slots[i] = slots[j];
+                        slots[j] = NULL;
+                        i = j;
+                }
+        }
+}
+
+void hash_impl_destroy(void)
+{
+        free(slots);
+}
+
+struct impl hash_impl = {
+        .name = "hash",
+        .init = hash_impl_init,
+        .insert = hash_impl_insert,
+        .find = hash_impl_find,
+        .delete = hash_impl_delete,
+        .destroy = hash_impl_destroy,
+};
+
+struct impl *impls[] = { &bst_impl, &bst_prefix_impl, &array_impl, &hash_impl };
+
+
+
+/* The operations that get timed. */
+
+void do_insert(uint64_t i)
+{
+        impl->insert(&items[order[i]]);
+}
+
+void do_find(uint64_t i)
+{
+        hits += (impl->find(item_key(&items[lookups[i]])) != NULL);
+}
+
+void do_gte(uint64_t i)
+{
+        hits += (impl->gte(probe_key(&probes[i])) != NULL);
+}
+
+/* Each probe is just above its lookup's item, so this finds that item. */
+void do_lte(uint64_t i)
+{
+        hits += (impl->lte(probe_key(&probes[i])) == &items[lookups[i]]);
+}
+
+void do_next(uint64_t i)
+{
+        cursor = impl->next(cursor);
+        hits += (cursor != NULL);
+}
+
+void do_mix(uint64_t i)
+{
+        struct item *it = &items[lookups[i]];
+
+        if (bench_rand(&mix_state) % 10) {
+                hits += (impl->find(item_key(it)) != NULL);
+        } else {
+                impl->delete(it);
+                impl->insert(it);
+                hits++;
+        }
+}
+
+void do_delete(uint64_t i)
+{
+        impl->delete(&items[order[i]]);
+}
+
+void report(enum op op, uint64_t ops, uint64_t elapsed, size_t num_samples)
+{
+        printf("%s,%s,%s,%" PRIu64 ",%s,%.0f,%" PRIu64 ",%" PRIu64 "\n", impl->name, key_type_names[key_type],
+               workload_names[workload], num_items, op_names[op], (double)ops * 1e9 / elapsed,
+               bench_percentile(samples, num_samples, 50), bench_percentile(samples, num_samples, 99));
+        fflush(stdout);
+}
+
+/* Run 'fn' for 0 .. ops-1, timing every SAMPLE_EVERY'th call on its own, and report the results. */
+void run_phase(enum op op, uint64_t ops, void (*fn)(uint64_t i))
+{
+        uint64_t start, t, i;
+        size_t num_samples = 0;
+
+        hits = 0;
+        start = bench_now_ns();
+        for (i=0; i<ops; i++) {
+                if ((i % SAMPLE_EVERY) == 0) {
+                        t = bench_now_ns();
+                        fn(i);
+                        samples[num_samples++] = bench_now_ns() - t;
+                } else {
+                        fn(i);
+                }
+        }
+        report(op, ops, bench_now_ns() - start, num_samples);
+}
+
+void run_impl(void)
+{
+        uint64_t start;
+
+        impl->init();
+
+        if (impl->build) {
+                start = bench_now_ns();
+                impl->build();
+                report(OP_INSERT, num_items, bench_now_ns() - start, 0);
+        } else {
+                run_phase(OP_INSERT, num_items, do_insert);
+        }
+
+        if (workload == WL_MIX) {
+                if (impl->delete) {
+                        mix_state = 42;
+                        run_phase(OP_MIX, num_lookups, do_mix);
+                        BENCH_CHECK(hits == num_lookups);
+                }
+        } else {
+                run_phase(OP_FIND, num_lookups, do_find);
+                BENCH_CHECK(hits == num_lookups);
+
+                if (impl->gte)
+                        run_phase(OP_GTE, num_lookups, do_gte);
+
+                if (impl->lte) {
+                        run_phase(OP_LTE, num_lookups, do_lte);
+                        BENCH_CHECK(hits == num_lookups);
+                }
+
+                if (impl->next) {
+                        cursor = NULL;
+                        run_phase(OP_NEXT, num_items, do_next);
+                        BENCH_CHECK(hits == num_items);
+                }
+        }
+
+        if (impl->delete)
+                run_phase(OP_DELETE, num_items, do_delete);
+
+        impl->destroy();
+}
+
+/* Set up the insert order and lookups for the current workload. */
+void setup_workload(void)
+{
+        uint64_t state = 0x1234567 + workload;
+        struct bench_zipf zipf = { 0 };
+        uint64_t i, j, t;
+
+        for (i=0; i<num_items; i++)
+                order[i] = i;
+        if (workload != WL_SEQ) {
+                for (i=num_items-1; i>0; i--) {
+                        j = bench_rand(&state) % (i + 1);
+                        t = order[i];
+                        order[i] = order[j];
+                        order[j] = t;
+                }
+        }
+
+        if (workload == WL_ZIPF)
+                bench_zipf_init(&zipf, num_items, 0.99);
+
+        for (i=0; i<num_lookups; i++) {
+                if (workload == WL_SEQ)
+                        lookups[i] = i % num_items;
+                else if (workload == WL_ZIPF)
+                        /* The most popular items are the first ones in the shuffled order, so they are spread out. */
+                        lookups[i] = order[bench_zipf(&zipf, &state)];
+                else
+                        lookups[i] = bench_rand(&state) % num_items;
+
+                probes[i].key = items[lookups[i]].key + 1;
+        }
+}
+
+/* Write out the string keys of the items and probes for the current key type. */
+void setup_string_keys(void)
+{
+        const char *prefix = (key_type == KEY_SHARED_PREFIX) ? STR_KEY_PREFIX : "";
+        uint64_t i;
+
+        for (i=0; i<num_items; i++)
+                snprintf(items[i].str, STR_KEY_SIZE, STR_KEY_FORMAT, prefix, items[i].key << 32);
+        for (i=0; i<num_lookups; i++)
+                snprintf(probes[i].str, STR_KEY_SIZE, STR_KEY_FORMAT, prefix, probes[i].key << 32);
+}
+
+int main(int argc, char **argv)
+{
+        uint64_t max_items = (argc > 1) ? strtoull(argv[1], NULL, 0) : 1000000;
+        uint64_t i;
+        unsigned k;
+
+        num_lookups = (argc > 2) ? strtoull(argv[2], NULL, 0) : 1000000;
+
+        /* Items have even keys, so that key + 1 can be used as a probe that isn't present.  String keys are the same
+           numbers shifted up, so that they sort the same way but differ in their first few characters, like most real
+           strings do; the shared-prefix keys put the same 19 characters in front of those. */
+        items = malloc(sizeof(*items) * max_items);
+        order = malloc(sizeof(*order) * max_items);
+        lookups = malloc(sizeof(*lookups) * num_lookups);
+        probes = malloc(sizeof(*probes) * num_lookups);
+        samples = malloc(sizeof(*samples) * ((max_items > num_lookups ? max_items : num_lookups) / SAMPLE_EVERY + 1));
+        BENCH_CHECK(items && order && lookups && probes && samples);
+        BENCH_CHECK(max_items < (1ULL << 31));
+
+        for (i=0; i<max_items; i++)
+                items[i].key = i * 2;
+
+        printf("impl,keys,workload,items,op,ops_per_sec,p50_ns,p99_ns\n");
+        for (num_items = 1000; num_items <= max_items; num_items *= 10) {
+                for (workload = WL_SEQ; workload < NUM_WORKLOADS; workload++) {
+                        setup_workload();
+                        for (key_type = KEY_INT; key_type < NUM_KEY_TYPES; key_type++) {
+                                if (key_type != KEY_INT)
+                                        setup_string_keys();
+                                for (k=0; k<sizeof(impls)/sizeof(impls[0]); k++) {
+                                        impl = impls[k];
+                                        if (impl->string_only && (key_type == KEY_INT))
+                                                continue;
+                                        run_impl();
+                                }
+                        }
+                }
+        }
+
+        free(samples);
+        free(probes);
+        free(lookups);
+        free(order);
+        free(items);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
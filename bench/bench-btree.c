@@ -0,0 +1,230 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-btree.c - Compare btree against bst.
+ *
+ * Usage: bench-btree [max_items [ops_per_phase]]
+ *
+ * For tree sizes of 1000, 10000, ... up to max_items, builds a btree and a bst (AA balanced) over the same items with
+ * random 64 bit keys, and times:
+ *
+ *   insert  every item inserted
+ *   find    items looked up uniformly at random
+ *   gte     a random key looked up with find_smallest_gte
+ *   lte     a random key looked up with find_largest_lte
+ *   scan    from a random key, the next 100 items walked in order
+ *   delete  every item deleted, in the order they were inserted (which is random, by key)
+ *
+ * printing a CSV line for each with its throughput.  Scans count one operation per item visited.
+ */
+
+#include <inttypes.h>
+#include "mec-lib/bst.h"
+#include "mec-lib/btree.h"
+#include "bench.h"
+
+
+
+#define SCAN_LENGTH     100
+
+struct item {
+        uint64_t key;
+        struct bst_node node;
+};
+
+struct bst bst;
+struct btree bt;
+struct item *items;
+uint64_t *lookups;      /* Items to look up, as indexes into items. */
+uint64_t *probes;       /* Random keys, for gte and scans. */
+uint64_t num_items;
+volatile uint64_t sink;        /* Keeps the compiler from dropping lookups whose results aren't checked. */
+
+void *item_get_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct item, node)->key;
+}
+
+int compare_u64s(void *key_a, void *key_b)
+{
+        uint64_t a = *(uint64_t *)key_a;
+        uint64_t b = *(uint64_t *)key_b;
+
+        return (a > b) - (a < b);
+}
+
+struct bst_ops item_bst_ops = {
+        .get_key = item_get_key,
+        .compare = compare_u64s,
+};
+
+uint64_t item_btree_key(void *item)
+{
+        return ((struct item *)item)->key;
+}
+
+struct btree_node *alloc_node(void)
+{
+        void *n;
+
+        return posix_memalign(&n, 64, sizeof(struct btree_node)) ? NULL : n;
+}
+
+void free_node(struct btree_node *n)
+{
+        free(n);
+}
+
+struct btree_ops item_btree_ops = {
+        .get_key = item_btree_key,
+        .alloc_node = alloc_node,
+        .free_node = free_node,
+};
+
+void report(const char *tree, const char *op, uint64_t ops, uint64_t elapsed)
+{
+        printf("%s,%" PRIu64 ",%s,%.0f\n", tree, num_items, op, (double)ops * 1e9 / elapsed);
+        fflush(stdout);
+}
+
+void run_bst(uint64_t ops)
+{
+        struct bst_node *n;
+        uint64_t start, i, j;
+
+        bst_init(&bst, &item_bst_ops);
+
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++)
+                BENCH_CHECK(bst_insert(&bst, &items[i].node) == 0);
+        report("bst", "insert", num_items, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++)
+                BENCH_CHECK(bst_find(&bst, &items[lookups[i]].key) == &items[lookups[i]].node);
+        report("bst", "find", ops, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++)
+                sink += (uintptr_t)bst_find_smallest_gte(&bst, &probes[i]);
+        report("bst", "gte", ops, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++)
+                sink += (uintptr_t)bst_find_largest_lte(&bst, &probes[i]);
+        report("bst", "lte", ops, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops / SCAN_LENGTH; i++) {
+                n = bst_find_smallest_gte(&bst, &probes[i]);
+                for (j=0; n && (j < SCAN_LENGTH); j++, n = bst_next(&bst, n))
+                        sink += BST_ITEM(n, struct item, node)->key;
+        }
+        report("bst", "scan", i * SCAN_LENGTH, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++)
+                BENCH_CHECK(bst_delete(&bst, &items[i].node) == 0);
+        report("bst", "delete", num_items, bench_now_ns() - start);
+        BENCH_CHECK(bst.root == bst_nil);
+}
+
+void run_btree(uint64_t ops)
+{
+        struct btree_iter it;
+        struct item *item;
+        uint64_t start, i, j;
+
+        btree_init(&bt, &item_btree_ops);
+
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++)
+                BENCH_CHECK(btree_insert(&bt, &items[i]) == 0);
+        report("btree", "insert", num_items, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++)
+                BENCH_CHECK(btree_find(&bt, items[lookups[i]].key) == &items[lookups[i]]);
+        report("btree", "find", ops, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++)
+                sink += (uintptr_t)btree_find_smallest_gte(&bt, probes[i]);
+        report("btree", "gte", ops, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++)
+                sink += (uintptr_t)btree_find_largest_lte(&bt, probes[i]);
+        report("btree", "lte", ops, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops / SCAN_LENGTH; i++) {
+                btree_iter_seek(&bt, &it, probes[i]);
+                for (j=0; (j < SCAN_LENGTH) && (item = btree_iter_next(&it)); j++)
+                        sink += item->key;
+        }
+        report("btree", "scan", i * SCAN_LENGTH, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++)
+                BENCH_CHECK(btree_delete(&bt, items[i].key) == 0);
+        report("btree", "delete", num_items, bench_now_ns() - start);
+        BENCH_CHECK(bt.root == NULL);
+}
+
+int main(int argc, char **argv)
+{
+        uint64_t max_items = (argc > 1) ? strtoull(argv[1], NULL, 0) : 1000000;
+        uint64_t ops = (argc > 2) ? strtoull(argv[2], NULL, 0) : 1000000;
+        uint64_t state = 0x1234567;
+        uint64_t i;
+
+        items = malloc(sizeof(*items) * max_items);
+        lookups = malloc(sizeof(*lookups) * ops);
+        probes = malloc(sizeof(*probes) * ops);
+        BENCH_CHECK(items && lookups && probes);
+
+        printf("tree,items,op,ops_per_sec\n");
+        for (num_items = 1000; num_items <= max_items; num_items *= 10) {
+                /* Random 64 bit keys won't collide in practice, and the inserts check anyway. */
+                for (i=0; i<num_items; i++)
+                        items[i].key = bench_rand(&state);
+                for (i=0; i<ops; i++) {
+                        lookups[i] = bench_rand(&state) % num_items;
+                        probes[i] = bench_rand(&state);
+                }
+
+                run_bst(ops);
+                run_btree(ops);
+        }
+
+        free(probes);
+        free(lookups);
+        free(items);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
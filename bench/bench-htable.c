@@ -0,0 +1,224 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-htable.c - Compare htable against bst for exact match lookups.
+ *
+ * Usage: bench-htable [max_items [ops_per_phase]]
+ *
+ * For table sizes of 1000, 10000, ... up to max_items, builds an htable and a bst (AA balanced) over the same items
+ * with random 64 bit keys, and times:
+ *
+ *   insert  every item inserted, with each insert timed to show the latency of resizing
+ *   find    items looked up uniformly at random
+ *   batch   the same lookups through htable_find_batch() (htable only)
+ *   delete  every item deleted, in the order they were inserted
+ *
+ * printing a CSV line for each with its throughput, and for inserts the 99.9th percentile and worst latency.
+ */
+
+#include <inttypes.h>
+#include "mec-lib/bst.h"
+#include "mec-lib/htable.h"
+#include "bench.h"
+
+
+
+#define BATCH_SIZE      64
+
+struct item {
+        uint64_t key;
+        struct bst_node bst_node;
+        struct htable_node ht_node;
+};
+
+struct bst bst;
+struct htable ht;
+struct item *items;
+uint64_t *lookups;      /* Items to look up, as indexes into items. */
+uint64_t *latencies;
+uint64_t num_items;
+
+void *item_bst_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct item, bst_node)->key;
+}
+
+int compare_u64s(void *key_a, void *key_b)
+{
+        uint64_t a = *(uint64_t *)key_a;
+        uint64_t b = *(uint64_t *)key_b;
+
+        return (a > b) - (a < b);
+}
+
+struct bst_ops item_bst_ops = {
+        .get_key = item_bst_key,
+        .compare = compare_u64s,
+};
+
+void *item_htable_key(struct htable_node *n)
+{
+        return &HTABLE_ITEM(n, struct item, ht_node)->key;
+}
+
+uint64_t hash_u64(void *key)
+{
+        return htable_hash_u64(*(uint64_t *)key);
+}
+
+int equal_u64s(void *key_a, void *key_b)
+{
+        return *(uint64_t *)key_a != *(uint64_t *)key_b;
+}
+
+struct htable_node **alloc_buckets(size_t num_buckets)
+{
+        return malloc(num_buckets * sizeof(struct htable_node *));
+}
+
+void free_buckets(struct htable_node **buckets, size_t num_buckets)
+{
+        free(buckets);
+}
+
+struct htable_ops item_htable_ops = {
+        .get_key = item_htable_key,
+        .hash = hash_u64,
+        .compare = equal_u64s,
+        .alloc_buckets = alloc_buckets,
+        .free_buckets = free_buckets,
+};
+
+void report(const char *table, const char *op, uint64_t ops, uint64_t elapsed, int with_latency)
+{
+        uint64_t p999;
+
+        printf("%s,%" PRIu64 ",%s,%.0f,", table, num_items, op, (double)ops * 1e9 / elapsed);
+        if (with_latency) {
+                /* This sorts the latencies, so the last is then the worst. */
+                p999 = bench_percentile(latencies, ops, 99.9);
+                printf("%" PRIu64 ",%" PRIu64 "\n", p999, latencies[ops - 1]);
+        } else {
+                printf(",\n");
+        }
+        fflush(stdout);
+}
+
+void run_bst(uint64_t ops)
+{
+        uint64_t start, t, i;
+
+        bst_init(&bst, &item_bst_ops);
+
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++) {
+                t = bench_now_ns();
+                BENCH_CHECK(bst_insert(&bst, &items[i].bst_node) == 0);
+                latencies[i] = bench_now_ns() - t;
+        }
+        report("bst", "insert", num_items, bench_now_ns() - start, 1);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++)
+                BENCH_CHECK(bst_find(&bst, &items[lookups[i]].key) == &items[lookups[i]].bst_node);
+        report("bst", "find", ops, bench_now_ns() - start, 0);
+
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++)
+                BENCH_CHECK(bst_delete(&bst, &items[i].bst_node) == 0);
+        report("bst", "delete", num_items, bench_now_ns() - start, 0);
+}
+
+void run_htable(uint64_t ops)
+{
+        struct htable_node *found[BATCH_SIZE];
+        void *keys[BATCH_SIZE];
+        uint64_t start, t, i, j;
+
+        htable_init(&ht, &item_htable_ops);
+
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++) {
+                t = bench_now_ns();
+                BENCH_CHECK(htable_insert(&ht, &items[i].ht_node) == 0);
+                latencies[i] = bench_now_ns() - t;
+        }
+        report("htable", "insert", num_items, bench_now_ns() - start, 1);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++)
+                BENCH_CHECK(htable_find(&ht, &items[lookups[i]].key) == &items[lookups[i]].ht_node);
+        report("htable", "find", ops, bench_now_ns() - start, 0);
+
+        start = bench_now_ns();
+        for (i=0; i + BATCH_SIZE <= ops; i += BATCH_SIZE) {
+                for (j=0; j<BATCH_SIZE; j++)
+                        keys[j] = &items[lookups[i + j]].key;
+                htable_find_batch(&ht, keys, found, BATCH_SIZE);
+                for (j=0; j<BATCH_SIZE; j++)
+                        BENCH_CHECK(found[j] == &items[lookups[i + j]].ht_node);
+        }
+        report("htable", "batch", i, bench_now_ns() - start, 0);
+
+        start = bench_now_ns();
+        for (i=0; i<num_items; i++)
+                BENCH_CHECK(htable_delete(&ht, &items[i].ht_node) == 0);
+        report("htable", "delete", num_items, bench_now_ns() - start, 0);
+        BENCH_CHECK(htable_count(&ht) == 0);
+        htable_destroy(&ht);
+}
+
+int main(int argc, char **argv)
+{
+        uint64_t max_items = (argc > 1) ? strtoull(argv[1], NULL, 0) : 1000000;
+        uint64_t ops = (argc > 2) ? strtoull(argv[2], NULL, 0) : 1000000;
+        uint64_t state = 0x1234567;
+        uint64_t i;
+
+        items = malloc(sizeof(*items) * max_items);
+        latencies = malloc(sizeof(*latencies) * max_items);
+        lookups = malloc(sizeof(*lookups) * ops);
+        BENCH_CHECK(items && latencies && lookups);
+
+        printf("table,items,op,ops_per_sec,p999_ns,max_ns\n");
+        for (num_items = 1000; num_items <= max_items; num_items *= 10) {
+                /* Random 64 bit keys won't collide in practice, and the inserts check anyway. */
+                for (i=0; i<num_items; i++)
+                        items[i].key = bench_rand(&state);
+                for (i=0; i<ops; i++)
+                        lookups[i] = bench_rand(&state) % num_items;
+
+                run_bst(ops);
+                run_htable(ops);
+        }
+
+        free(lookups);
+        free(latencies);
+        free(items);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
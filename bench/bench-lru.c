@@ -0,0 +1,237 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-lru.c - Measure lru_cache hit throughput on a Zipfian trace.
+ *
+ * Usage: bench-lru [max_threads [ops_per_thread [num_keys]]]
+ *
+ * Each thread looks up keys drawn from a Zipfian (theta 0.99) distribution over num_keys keys, in a cache that holds a
+ * tenth of them, and inserts the key's item on a miss.  For 1, 2, 4, ... up to max_threads threads, this is run
+ * against:
+ *
+ *   mutex   a cache built by hand: one mutex around an htable and a dlist, moving each hit to the front
+ *   lru-1   an lru_cache with a single shard (hits only lock their thread's reader slot, inserts lock them all)
+ *   lru-16  an lru_cache with 16 shards
+ *
+ * and a CSV line is printed for each with the total throughput and hit ratio.
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include "mec-lib/lru.h"
+#include "bench.h"
+
+
+
+#define MAX_SHARDS      16
+
+struct item {
+        uint64_t key;
+        struct lru_node lru;
+};
+
+struct lru_cache cache;
+struct lru_shard shards[MAX_SHARDS];
+struct item *items;
+uint32_t *traces;        /* ops_per_thread item indexes for each thread, made up front so only the cache is timed. */
+uint64_t num_keys;
+uint64_t ops_per_thread;
+int use_mutex;
+
+/* The hand-built cache. */
+pthread_mutex_t mutex_lock = PTHREAD_MUTEX_INITIALIZER;
+struct htable mutex_index;
+struct dlist mutex_list;
+size_t mutex_capacity;
+
+void *item_get_key(struct htable_node *n)
+{
+        return &HTABLE_ITEM(n, struct item, lru.index)->key;
+}
+
+uint64_t hash_u64(void *key)
+{
+        return htable_hash_u64(*(uint64_t *)key);
+}
+
+int equal_u64s(void *key_a, void *key_b)
+{
+        return *(uint64_t *)key_a != *(uint64_t *)key_b;
+}
+
+struct htable_node **alloc_buckets(size_t num_buckets)
+{
+        return malloc(num_buckets * sizeof(struct htable_node *));
+}
+
+void free_buckets(struct htable_node **buckets, size_t num_buckets)
+{
+        free(buckets);
+}
+
+void item_evict(struct lru_node *n)
+{
+}
+
+struct lru_ops item_lru_ops = {
+        .index = {
+                .get_key = item_get_key,
+                .hash = hash_u64,
+                .compare = equal_u64s,
+                .alloc_buckets = alloc_buckets,
+                .free_buckets = free_buckets,
+        },
+        .evict = item_evict,
+};
+
+/* Look up a key in the hand-built cache, inserting it on a miss.  Returns non-zero on a hit. */
+int mutex_lookup(struct item *it)
+{
+        struct htable_node *hn;
+        struct lru_node *n;
+        int hit;
+
+        pthread_mutex_lock(&mutex_lock);
+        hn = htable_find(&mutex_index, &it->key);
+        hit = (hn != NULL);
+        if (hit) {
+                n = (struct lru_node *)hn;
+                dlist_del(&n->list);
+                dlist_insert_front(&mutex_list, &n->list);
+        } else {
+                BENCH_CHECK(htable_insert(&mutex_index, &it->lru.index) == 0);
+                dlist_insert_front(&mutex_list, &it->lru.list);
+                if (htable_count(&mutex_index) > mutex_capacity) {
+                        n = DLIST_ITEM(mutex_list.prev, struct lru_node, list);
+                        htable_delete(&mutex_index, &n->index);
+                        dlist_del(&n->list);
+                }
+        }
+        pthread_mutex_unlock(&mutex_lock);
+
+        return hit;
+}
+
+struct thread_arg {
+        pthread_t thread;
+        uint32_t *trace;
+        uint64_t hits;
+};
+
+void *thread_fn(void *arg)
+{
+        struct thread_arg *ta = arg;
+        struct item *it;
+        uint64_t i;
+
+        for (i=0; i<ops_per_thread; i++) {
+                it = &items[ta->trace[i]];
+
+                if (use_mutex) {
+                        ta->hits += mutex_lookup(it);
+                } else if (lru_find(&cache, &it->key)) {
+                        ta->hits++;
+                } else {
+                        /* Another thread may have just inserted it. */
+                        lru_insert(&cache, &it->lru);
+                }
+        }
+
+        return NULL;
+}
+
+void run(const char *name, unsigned num_shards, unsigned nthreads)
+{
+        struct thread_arg args[nthreads];
+        uint64_t start, elapsed, hits = 0;
+        unsigned i;
+
+        use_mutex = (num_shards == 0);
+        if (use_mutex) {
+                htable_init(&mutex_index, &item_lru_ops.index);
+                dlist_init(&mutex_list);
+                mutex_capacity = num_keys / 10;
+        } else {
+                lru_init(&cache, &item_lru_ops, shards, num_shards, num_keys / 10);
+        }
+
+        start = bench_now_ns();
+        for (i=0; i<nthreads; i++) {
+                args[i].trace = &traces[i * ops_per_thread];
+                args[i].hits = 0;
+                BENCH_CHECK(pthread_create(&args[i].thread, NULL, thread_fn, &args[i]) == 0);
+        }
+        for (i=0; i<nthreads; i++) {
+                BENCH_CHECK(pthread_join(args[i].thread, NULL) == 0);
+                hits += args[i].hits;
+        }
+        elapsed = bench_now_ns() - start;
+
+        printf("%s,%u,%.0f,%.3f\n", name, nthreads, (double)ops_per_thread * nthreads * 1e9 / elapsed,
+               (double)hits / (ops_per_thread * nthreads));
+        fflush(stdout);
+
+        if (use_mutex)
+                htable_destroy(&mutex_index);
+        else
+                lru_destroy(&cache);
+}
+
+int main(int argc, char **argv)
+{
+        unsigned max_threads = (argc > 1) ? strtoul(argv[1], NULL, 0) : 8;
+        struct bench_zipf zipf = { 0 };
+        uint64_t state = 0x1234567;
+        uint64_t i;
+        unsigned n;
+
+        ops_per_thread = (argc > 2) ? strtoull(argv[2], NULL, 0) : 1000000;
+        num_keys = (argc > 3) ? strtoull(argv[3], NULL, 0) : 1000000;
+
+        items = malloc(sizeof(*items) * num_keys);
+        traces = malloc(sizeof(*traces) * max_threads * ops_per_thread);
+        BENCH_CHECK(items && traces);
+        for (i=0; i<num_keys; i++)
+                items[i].key = i;
+
+        /* The popular keys are scattered, rather than all being at the bottom of the key space. */
+        bench_zipf_init(&zipf, num_keys, 0.99);
+        for (i=0; i<max_threads * ops_per_thread; i++)
+                traces[i] = (bench_zipf(&zipf, &state) * 0x9e3779b97f4a7c15ULL) % num_keys;
+
+        printf("cache,threads,ops_per_sec,hit_ratio\n");
+        for (n = 1; n <= max_threads; n *= 2) {
+                run("mutex", 0, n);
+                run("lru-1", 1, n);
+                run("lru-16", MAX_SHARDS, n);
+        }
+
+        free(traces);
+        free(items);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
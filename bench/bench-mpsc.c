@@ -0,0 +1,196 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-mpsc.c - Compare an MPSC queue with a mutex protected dlist.
+ *
+ * Usage: bench-mpsc [max_producers [items_per_producer]]
+ *
+ * For 1, 2, 4, ... up to max_producers producer threads, each pushing items_per_producer items to the main thread as
+ * fast as it can, runs:
+ *
+ *   mutex    producers lock a mutex around dlist_insert_back(), the consumer around dlist_pop_front()
+ *   pop      an mpsc_queue, consumed one item at a time with mpsc_pop()
+ *   pop_all  an mpsc_queue, consumed a batch at a time with mpsc_pop_all()
+ *   wait     as pop_all, but the consumer sleeps in mpsc_wait() whenever the queue is empty
+ *
+ * and prints a CSV line for each with the throughput, in items per second.
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include "mec-lib/mpsc.h"
+#include "bench.h"
+
+
+
+enum mode {
+        MODE_MUTEX,
+        MODE_POP,
+        MODE_POP_ALL,
+        MODE_WAIT,
+        NUM_MODES,
+};
+
+const char *mode_names[] = { [MODE_MUTEX] = "mutex", [MODE_POP] = "pop", [MODE_POP_ALL] = "pop_all",
+                             [MODE_WAIT] = "wait" };
+
+struct item {
+        uint64_t value;
+        struct dlist link;
+};
+
+struct producer {
+        pthread_t thread;
+        struct item *items;
+} __attribute__((aligned(64)));
+
+enum mode mode;
+uint64_t items_per_producer;
+pthread_barrier_t start_barrier;
+struct mpsc_queue queue;
+pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+struct dlist list;
+
+void *producer_fn(void *arg)
+{
+        struct producer *p = arg;
+        uint64_t i;
+
+        pthread_barrier_wait(&start_barrier);
+
+        for (i=0; i<items_per_producer; i++) {
+                if (mode == MODE_MUTEX) {
+                        pthread_mutex_lock(&lock);
+                        dlist_insert_back(&list, &p->items[i].link);
+                        pthread_mutex_unlock(&lock);
+                } else {
+                        mpsc_push(&queue, &p->items[i].link);
+                }
+        }
+
+        return NULL;
+}
+
+/* Take whatever is available, and return the number of items taken. */
+uint64_t consume(uint64_t *sum)
+{
+        struct dlist out, *d;
+        struct item *it;
+        uint64_t n = 0;
+
+        switch (mode) {
+        case MODE_MUTEX:
+                pthread_mutex_lock(&lock);
+                d = dlist_pop_front(&list);
+                pthread_mutex_unlock(&lock);
+                if (d) {
+                        *sum += DLIST_ITEM(d, struct item, link)->value;
+                        n = 1;
+                }
+                break;
+
+        case MODE_POP:
+                d = mpsc_pop(&queue);
+                if (d) {
+                        *sum += DLIST_ITEM(d, struct item, link)->value;
+                        n = 1;
+                }
+                break;
+
+        case MODE_WAIT:
+                mpsc_wait(&queue);
+                /* Fall through. */
+        case MODE_POP_ALL:
+                dlist_init(&out);
+                n = mpsc_pop_all(&queue, &out);
+                dlist_for_each_item(&out, it, struct item, link)
+                        *sum += it->value;
+                break;
+
+        default:
+                break;
+        }
+
+        return n;
+}
+
+void run(struct producer *producers, unsigned num_producers)
+{
+        uint64_t start, total = 0, sum = 0, i;
+        unsigned p;
+
+        mpsc_init(&queue);
+        dlist_init(&list);
+        BENCH_CHECK(pthread_barrier_init(&start_barrier, NULL, num_producers + 1) == 0);
+        for (p=0; p<num_producers; p++)
+                BENCH_CHECK(pthread_create(&producers[p].thread, NULL, producer_fn, &producers[p]) == 0);
+
+        pthread_barrier_wait(&start_barrier);
+        start = bench_now_ns();
+        while (total < num_producers * items_per_producer)
+                total += consume(&sum);
+        printf("%s,%u,%.0f\n", mode_names[mode], num_producers, (double)total * 1e9 / (bench_now_ns() - start));
+        fflush(stdout);
+
+        for (p=0; p<num_producers; p++)
+                BENCH_CHECK(pthread_join(producers[p].thread, NULL) == 0);
+        pthread_barrier_destroy(&start_barrier);
+
+        for (i=0; i<items_per_producer; i++)
+                sum -= i * num_producers;
+        BENCH_CHECK(sum == 0);
+}
+
+int main(int argc, char **argv)
+{
+        unsigned max_producers = (argc > 1) ? strtoul(argv[1], NULL, 0) : 8;
+        struct producer *producers;
+        unsigned num_producers, p;
+        uint64_t i;
+
+        items_per_producer = (argc > 2) ? strtoull(argv[2], NULL, 0) : 1000000;
+
+        producers = calloc(max_producers, sizeof(*producers));
+        BENCH_CHECK(producers);
+        for (p=0; p<max_producers; p++) {
+                producers[p].items = malloc(sizeof(struct item) * items_per_producer);
+                BENCH_CHECK(producers[p].items);
+                for (i=0; i<items_per_producer; i++)
+                        producers[p].items[i].value = i;
+        }
+
+        printf("mode,producers,items_per_sec\n");
+        for (num_producers = 1; num_producers <= max_producers; num_producers *= 2)
+                for (mode = MODE_MUTEX; mode < NUM_MODES; mode++)
+                        run(producers, num_producers);
+
+        for (p=0; p<max_producers; p++)
+                free(producers[p].items);
+        free(producers);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
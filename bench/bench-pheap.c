@@ -0,0 +1,189 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-pheap.c - Compare a pairing heap with a bst used as a priority queue, for a scheduler's run queue.
+ *
+ * Usage: bench-pheap [num_tasks [ops]]
+ *
+ * For each of a bst (taking the smallest with bst_next(bst, NULL) and bst_delete()) and a pairing heap, both ordered
+ * by deadline then task number, runs:
+ *
+ *   insert    every task is queued with a random deadline
+ *   hold      the task with the earliest deadline is taken off and queued again with a later one
+ *   decrease  a random task has its deadline brought forward (a bst has to delete and insert it again)
+ *   drain     every task is taken off in order
+ *
+ * and prints a CSV line for each with its throughput (operations per second).
+ */
+
+#include <inttypes.h>
+#include "mec-lib/bst.h"
+#include "mec-lib/pheap.h"
+#include "mec-lib/util.h"
+#include "bench.h"
+
+
+
+#define SPREAD          1000000
+
+struct task {
+        uint64_t deadline;
+        uint64_t id;
+        struct bst_node bst_node;
+        struct pheap_node heap_node;
+};
+
+struct bst bst;
+struct pheap heap;
+struct task *tasks;
+uint64_t num_tasks;
+
+void *task_bst_get_key(struct bst_node *n)
+{
+        return BST_ITEM(n, struct task, bst_node);
+}
+
+void *task_heap_get_key(struct pheap_node *n)
+{
+        return PHEAP_ITEM(n, struct task, heap_node);
+}
+
+int compare_tasks(void *key_a, void *key_b)
+{
+        struct task *a = key_a, *b = key_b;
+
+        if (a->deadline != b->deadline)
+                return (a->deadline > b->deadline) - (a->deadline < b->deadline);
+
+        return (a->id > b->id) - (a->id < b->id);
+}
+
+struct bst_ops task_bst_ops = {
+        .get_key = task_bst_get_key,
+        .compare = compare_tasks,
+};
+
+struct pheap_ops task_heap_ops = {
+        .get_key = task_heap_get_key,
+        .compare = compare_tasks,
+};
+
+void report(const char *kind, const char *op, uint64_t ops, uint64_t elapsed)
+{
+        printf("%s,%" PRIu64 ",%s,%.0f\n", kind, num_tasks, op, (double)ops * 1e9 / elapsed);
+        fflush(stdout);
+}
+
+static inline void queue(int use_heap, struct task *t)
+{
+        if (use_heap)
+                pheap_insert(&heap, &t->heap_node);
+        else
+                BENCH_CHECK(bst_insert(&bst, &t->bst_node) == 0);
+}
+
+static inline struct task *dequeue(int use_heap)
+{
+        struct pheap_node *h;
+        struct bst_node *n;
+
+        if (use_heap) {
+                h = pheap_pop(&heap);
+                BENCH_CHECK(h != NULL);
+                return PHEAP_ITEM(h, struct task, heap_node);
+        }
+
+        n = bst_next(&bst, NULL);
+        BENCH_CHECK(n != NULL);
+        BENCH_CHECK(bst_delete(&bst, n) == 0);
+        return BST_ITEM(n, struct task, bst_node);
+}
+
+void run(int use_heap, uint64_t ops)
+{
+        const char *kind = use_heap ? "pheap" : "bst";
+        uint64_t state = 0x1234567, start, i, prev;
+        struct task *t;
+
+        bst_init(&bst, &task_bst_ops);
+        pheap_init(&heap, &task_heap_ops);
+
+        start = bench_now_ns();
+        for (i=0; i<num_tasks; i++) {
+                tasks[i].id = i;
+                tasks[i].deadline = SPREAD + bench_rand(&state) % SPREAD;
+                queue(use_heap, &tasks[i]);
+        }
+        report(kind, "insert", num_tasks, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++) {
+                t = dequeue(use_heap);
+                t->deadline += 1 + bench_rand(&state) % SPREAD;
+                queue(use_heap, t);
+        }
+        report(kind, "hold", ops, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++) {
+                t = &tasks[bench_rand(&state) % num_tasks];
+                if (use_heap) {
+                        t->deadline -= MEC_MIN(t->deadline, bench_rand(&state) % SPREAD);
+                        pheap_decrease(&heap, &t->heap_node);
+                } else {
+                        BENCH_CHECK(bst_delete(&bst, &t->bst_node) == 0);
+                        t->deadline -= MEC_MIN(t->deadline, bench_rand(&state) % SPREAD);
+                        BENCH_CHECK(bst_insert(&bst, &t->bst_node) == 0);
+                }
+        }
+        report(kind, "decrease", ops, bench_now_ns() - start);
+
+        start = bench_now_ns();
+        for (i=0, prev=0; i<num_tasks; i++) {
+                t = dequeue(use_heap);
+                BENCH_CHECK(t->deadline >= prev);
+                prev = t->deadline;
+        }
+        report(kind, "drain", num_tasks, bench_now_ns() - start);
+}
+
+int main(int argc, char **argv)
+{
+        uint64_t ops = (argc > 2) ? strtoull(argv[2], NULL, 0) : 10000000;
+
+        num_tasks = (argc > 1) ? strtoull(argv[1], NULL, 0) : 1000000;
+        tasks = malloc(sizeof(*tasks) * num_tasks);
+        BENCH_CHECK(tasks);
+
+        printf("kind,tasks,op,ops_per_sec\n");
+        run(0, ops);
+        run(1, ops);
+
+        free(tasks);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
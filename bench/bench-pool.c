@@ -0,0 +1,199 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-pool.c - Compare malloc() and a pool for allocating bst items.
+ *
+ * Usage: bench-pool [max_items [ops]]
+ *
+ * For tree sizes of 1000, 10000, ... up to max_items, and for items from malloc() and from a pool (with and without
+ * huge pages), runs:
+ *
+ *   alloc   items allocated and inserted, with increasing keys
+ *   walk    every item visited in key order with bst_next(), summing the keys, ten times over
+ *   churn   a random item is deleted and freed, and a new one allocated and inserted at the end
+ *   walk2   walk again, now that churn has mixed freed memory back in
+ *   free    every item removed and freed; for a pool that is a bst_drain() and pool_destroy()
+ *
+ * and prints a CSV line for each phase with its throughput.
+ */
+
+#include <inttypes.h>
+#include "mec-lib/bst.h"
+#include "mec-lib/pool.h"
+#include "bench.h"
+
+
+
+struct item {
+        uint64_t key;
+        struct bst_node node;
+};
+
+enum allocator {
+        ALLOC_MALLOC,
+        ALLOC_POOL,
+        ALLOC_POOL_HUGE,
+        NUM_ALLOCATORS,
+};
+
+const char *allocator_names[] = { [ALLOC_MALLOC] = "malloc", [ALLOC_POOL] = "pool", [ALLOC_POOL_HUGE] = "pool-huge" };
+
+struct bst bst;
+struct pool pool;
+struct pool_cache cache;
+struct item **items;    /* Live items, in no particular order. */
+uint64_t num_items;
+
+void *item_get_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct item, node)->key;
+}
+
+int compare_u64s(void *key_a, void *key_b)
+{
+        uint64_t a = *(uint64_t *)key_a;
+        uint64_t b = *(uint64_t *)key_b;
+
+        return (a > b) - (a < b);
+}
+
+struct bst_ops item_bst_ops = {
+        .get_key = item_get_key,
+        .compare = compare_u64s,
+};
+
+static inline struct item *item_alloc(enum allocator a)
+{
+        return (a == ALLOC_MALLOC) ? malloc(sizeof(struct item)) : pool_alloc(&cache);
+}
+
+static inline void item_free(enum allocator a, struct item *it)
+{
+        if (a == ALLOC_MALLOC)
+                free(it);
+        else
+                pool_free(&cache, it);
+}
+
+void free_node(struct bst_node *n)
+{
+        free(BST_ITEM(n, struct item, node));
+}
+
+void report(enum allocator a, const char *op, uint64_t ops, uint64_t elapsed)
+{
+        printf("%s,%" PRIu64 ",%s,%.0f\n", allocator_names[a], num_items, op, (double)ops * 1e9 / elapsed);
+        fflush(stdout);
+}
+
+void walk(enum allocator a, const char *op, uint64_t expect)
+{
+        struct bst_node *n;
+        uint64_t start, sum;
+        unsigned i;
+
+        start = bench_now_ns();
+        for (i=0; i<10; i++) {
+                sum = 0;
+                for (n = bst_next(&bst, NULL); n; n = bst_next(&bst, n))
+                        sum += BST_ITEM(n, struct item, node)->key;
+                BENCH_CHECK(sum == expect);
+        }
+        report(a, op, num_items * 10, bench_now_ns() - start);
+}
+
+void run(enum allocator a, uint64_t ops)
+{
+        uint64_t state = 0x1234567;
+        uint64_t start, i, j, key, sum = 0;
+        struct item *it;
+
+        if (a != ALLOC_MALLOC) {
+                BENCH_CHECK(pool_init(&pool, sizeof(struct item), (a == ALLOC_POOL_HUGE) ? POOL_HUGE_PAGES : 0) == 0);
+                pool_cache_init(&pool, &cache);
+        }
+        bst_init(&bst, &item_bst_ops);
+
+        start = bench_now_ns();
+        for (key=0; key<num_items; key++) {
+                it = item_alloc(a);
+                BENCH_CHECK(it != NULL);
+                it->key = key;
+                BENCH_CHECK(bst_insert(&bst, &it->node) == 0);
+                items[key] = it;
+                sum += key;
+        }
+        report(a, "alloc", num_items, bench_now_ns() - start);
+
+        walk(a, "walk", sum);
+
+        start = bench_now_ns();
+        for (i=0; i<ops; i++, key++) {
+                j = bench_rand(&state) % num_items;
+                sum -= items[j]->key;
+                BENCH_CHECK(bst_delete(&bst, &items[j]->node) == 0);
+                item_free(a, items[j]);
+
+                it = item_alloc(a);
+                BENCH_CHECK(it != NULL);
+                it->key = key;
+                BENCH_CHECK(bst_insert(&bst, &it->node) == 0);
+                items[j] = it;
+                sum += key;
+        }
+        report(a, "churn", ops, bench_now_ns() - start);
+
+        walk(a, "walk2", sum);
+
+        start = bench_now_ns();
+        if (a == ALLOC_MALLOC) {
+                BENCH_CHECK(bst_drain(&bst, free_node) == num_items);
+        } else {
+                BENCH_CHECK(bst_drain(&bst, NULL) == num_items);
+                pool_destroy(&pool);
+        }
+        report(a, "free", num_items, bench_now_ns() - start);
+}
+
+int main(int argc, char **argv)
+{
+        uint64_t max_items = (argc > 1) ? strtoull(argv[1], NULL, 0) : 1000000;
+        uint64_t ops = (argc > 2) ? strtoull(argv[2], NULL, 0) : 1000000;
+        enum allocator a;
+
+        items = malloc(sizeof(*items) * max_items);
+        BENCH_CHECK(items);
+
+        printf("allocator,items,op,ops_per_sec\n");
+        for (num_items = 1000; num_items <= max_items; num_items *= 10)
+                for (a = ALLOC_MALLOC; a < NUM_ALLOCATORS; a++)
+                        run(a, ops);
+
+        free(items);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
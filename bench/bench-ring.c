@@ -0,0 +1,284 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-ring.c - Throughput and latency of ring buffers between two pinned threads.
+ *
+ * Usage: bench-ring [items [round_trips]]
+ *
+ * The producer is pinned to CPU 0 and the consumer to CPU 1 (or also CPU 0, on a single CPU machine).  Prints a CSV
+ * line for each of:
+ *
+ *   mutex        a dlist protected by a mutex, for comparison
+ *   spsc         spsc_push() and spsc_pop() of one 8 byte element at a time
+ *   spsc-bulk    spsc_push_bulk() and spsc_pop_bulk() of up to 32 elements at a time
+ *   spsc-inplace spsc_reserve()/spsc_commit() and spsc_peek()/spsc_release() of up to 32 slots at a time
+ *   mpmc         mpmc_push() and mpmc_pop()
+ *   mpmc-bulk    mpmc_push_bulk() and mpmc_pop_bulk() of up to 32 elements at a time
+ *
+ * with the throughput of passing 'items' elements, and the median and 99th percentile one way latency, measured as
+ * half the round trip time of passing one element to the consumer and back on a second ring.  Waiting threads spin
+ * for a while and then yield.
+ */
+
+#define _GNU_SOURCE
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "mec-lib/dlist.h"
+#include "mec-lib/ring.h"
+#include "bench.h"
+
+
+
+#define RING_SLOTS      1024
+#define BATCH           32
+
+enum mode {
+        MODE_MUTEX,
+        MODE_SPSC,
+        MODE_SPSC_BULK,
+        MODE_SPSC_INPLACE,
+        MODE_MPMC,
+        MODE_MPMC_BULK,
+        NUM_MODES,
+};
+
+const char *mode_names[] = {
+        [MODE_MUTEX] = "mutex", [MODE_SPSC] = "spsc", [MODE_SPSC_BULK] = "spsc-bulk",
+        [MODE_SPSC_INPLACE] = "spsc-inplace", [MODE_MPMC] = "mpmc", [MODE_MPMC_BULK] = "mpmc-bulk",
+};
+
+/* For the mutex mode, which needs something to link. */
+struct item {
+        uint64_t value;
+        struct dlist link;
+};
+
+/* A pair of rings of each kind, one for each direction. */
+struct channel {
+        struct spsc_ring spsc;
+        struct mpmc_ring mpmc;
+        pthread_mutex_t lock;
+        struct dlist list;
+        uint64_t spsc_slots[RING_SLOTS];
+        size_t mpmc_slots[RING_SLOTS * MPMC_RING_SLOT_SIZE(sizeof(uint64_t)) / sizeof(size_t)];
+};
+
+enum mode mode;
+struct channel to_consumer, to_producer;
+struct item *items;
+uint64_t num_items, num_round_trips;
+int num_cpus;
+
+void pin(int cpu)
+{
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        CPU_SET(cpu % num_cpus, &set);
+        BENCH_CHECK(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0);
+}
+
+static inline void backoff(unsigned *spins)
+{
+        if (++*spins < 1000) {
+                MEC_CPU_RELAX();
+        } else {
+                *spins = 0;
+                sched_yield();
+        }
+}
+
+void channel_init(struct channel *c)
+{
+        BENCH_CHECK(spsc_ring_init(&c->spsc, c->spsc_slots, RING_SLOTS, sizeof(uint64_t)) == 0);
+        BENCH_CHECK(mpmc_ring_init(&c->mpmc, c->mpmc_slots, RING_SLOTS, sizeof(uint64_t)) == 0);
+        pthread_mutex_init(&c->lock, NULL);
+        dlist_init(&c->list);
+}
+
+/* Send values[0 .. n-1], and return how many were sent. */
+uint64_t send(struct channel *c, uint64_t *values, uint64_t n)
+{
+        uint64_t *slots, i;
+        size_t k;
+
+        switch (mode) {
+        case MODE_MUTEX:
+                pthread_mutex_lock(&c->lock);
+                items[values[0]].value = values[0];
+                dlist_insert_back(&c->list, &items[values[0]].link);
+                pthread_mutex_unlock(&c->lock);
+                return 1;
+        case MODE_SPSC:
+                return !spsc_push(&c->spsc, values);
+        case MODE_SPSC_BULK:
+                return spsc_push_bulk(&c->spsc, values, MEC_MIN(n, (uint64_t)BATCH));
+        case MODE_SPSC_INPLACE:
+                k = spsc_reserve(&c->spsc, (void **)&slots, MEC_MIN(n, (uint64_t)BATCH));
+                for (i=0; i<k; i++)
+                        slots[i] = values[i];
+                spsc_commit(&c->spsc, k);
+                return k;
+        case MODE_MPMC:
+                return !mpmc_push(&c->mpmc, values);
+        case MODE_MPMC_BULK:
+                return mpmc_push_bulk(&c->mpmc, values, MEC_MIN(n, (uint64_t)BATCH));
+        default:
+                return 0;
+        }
+}
+
+/* Receive up to BATCH values into 'values', and return how many were received. */
+uint64_t receive(struct channel *c, uint64_t *values)
+{
+        uint64_t *slots, i;
+        struct dlist *d;
+        size_t k;
+
+        switch (mode) {
+        case MODE_MUTEX:
+                pthread_mutex_lock(&c->lock);
+                d = dlist_pop_front(&c->list);
+                pthread_mutex_unlock(&c->lock);
+                if (d == NULL)
+                        return 0;
+                values[0] = DLIST_ITEM(d, struct item, link)->value;
+                return 1;
+        case MODE_SPSC:
+                return !spsc_pop(&c->spsc, values);
+        case MODE_SPSC_BULK:
+                return spsc_pop_bulk(&c->spsc, values, BATCH);
+        case MODE_SPSC_INPLACE:
+                k = spsc_peek(&c->spsc, (void **)&slots, BATCH);
+                for (i=0; i<k; i++)
+                        values[i] = slots[i];
+                spsc_release(&c->spsc, k);
+                return k;
+        case MODE_MPMC:
+                return !mpmc_pop(&c->mpmc, values);
+        case MODE_MPMC_BULK:
+                return mpmc_pop_bulk(&c->mpmc, values, BATCH);
+        default:
+                return 0;
+        }
+}
+
+/* Consume 'num_items' values and check they arrive in order, then echo 'num_round_trips' values back. */
+void *consumer_fn(void *arg)
+{
+        uint64_t values[BATCH], next = 0, i, n;
+        unsigned spins = 0;
+
+        pin(1);
+
+        while (next < num_items) {
+                n = receive(&to_consumer, values);
+                if (n == 0)
+                        backoff(&spins);
+                for (i=0; i<n; i++)
+                        BENCH_CHECK(values[i] == next++);
+        }
+
+        for (i=0; i<num_round_trips; i++) {
+                while (receive(&to_consumer, values) == 0)
+                        backoff(&spins);
+                while (send(&to_producer, values, 1) == 0)
+                        backoff(&spins);
+        }
+
+        return NULL;
+}
+
+void run(uint64_t *values, uint64_t *samples)
+{
+        uint64_t start, elapsed = 0, sent, n, i, p50, p99;
+        unsigned spins = 0;
+        pthread_t thread;
+
+        channel_init(&to_consumer);
+        channel_init(&to_producer);
+        BENCH_CHECK(pthread_create(&thread, NULL, consumer_fn, NULL) == 0);
+
+        start = bench_now_ns();
+        for (sent = 0; sent < num_items; sent += n) {
+                n = send(&to_consumer, &values[sent], num_items - sent);
+                if (n == 0)
+                        backoff(&spins);
+        }
+
+        /* The consumer only starts echoing once it has seen everything, so the throughput is timed up to the end of the
+           first round trip. */
+        for (i=0; i<num_round_trips; i++) {
+                uint64_t t = bench_now_ns(), echo[BATCH];
+
+                while (send(&to_consumer, &values[0], 1) == 0)
+                        backoff(&spins);
+                while (receive(&to_producer, echo) == 0)
+                        backoff(&spins);
+                samples[i] = (bench_now_ns() - t) / 2;
+                if (i == 0)
+                        elapsed = bench_now_ns() - start;
+        }
+
+        BENCH_CHECK(pthread_join(thread, NULL) == 0);
+
+        p50 = bench_percentile(samples, num_round_trips, 50);
+        p99 = bench_percentile(samples, num_round_trips, 99);
+        printf("%s,%.0f,%" PRIu64 ",%" PRIu64 "\n", mode_names[mode], (double)num_items * 1e9 / elapsed, p50, p99);
+        fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+        uint64_t *values, *samples, i;
+
+        num_items = (argc > 1) ? strtoull(argv[1], NULL, 0) : 10000000;
+        num_round_trips = (argc > 2) ? strtoull(argv[2], NULL, 0) : 100000;
+        BENCH_CHECK(num_round_trips > 0);
+        num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        values = malloc(sizeof(*values) * num_items);
+        items = malloc(sizeof(*items) * num_items);
+        samples = malloc(sizeof(*samples) * num_round_trips);
+        BENCH_CHECK(values && items && samples);
+        for (i=0; i<num_items; i++)
+                values[i] = i;
+
+        pin(0);
+
+        printf("mode,items_per_sec,latency_p50_ns,latency_p99_ns\n");
+        for (mode = MODE_MUTEX; mode < NUM_MODES; mode++)
+                run(values, samples);
+
+        free(samples);
+        free(items);
+        free(values);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,246 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-skiplist.c - Scaling of a lock-free skip list versus a bst behind a mutex, with many writers.
+ *
+ * Usage: bench-skiplist [max_threads [num_items [msecs_per_run [write_percent]]]]
+ *
+ * Runs 1, 2, 4, ... max_threads threads on a set of num_items keys, half of them present.  Each operation is a
+ * lookup of a random key, or (write_percent of the time) a delete or insert of a random key, and every thread both
+ * reads and writes.  Prints one CSV line per run.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include "mec-lib/bst.h"
+#include "mec-lib/skiplist.h"
+#include "bench.h"
+
+
+
+/* A thing is only inserted and deleted by the thread that owns its key, and a deleted thing can't go back into the
+   skip list until it has been reclaimed. */
+enum state {
+        STATE_FREE,
+        STATE_IN_LIST,
+        STATE_RETIRED,
+};
+
+struct thing {
+        uint64_t key;
+        enum state state;
+        struct bst_node bstn;
+        struct skiplist_node node;      /* Must be last. */
+};
+
+enum impl {
+        IMPL_MUTEX,
+        IMPL_SKIPLIST,
+};
+
+const char *impl_names[] = {
+        [IMPL_MUTEX] = "mutex_bst",
+        [IMPL_SKIPLIST] = "skiplist",
+};
+
+struct bst tree;
+pthread_mutex_t tree_lock = PTHREAD_MUTEX_INITIALIZER;
+struct skiplist list;
+struct epoch epoch;
+struct thing **things;
+uint64_t num_items;
+unsigned write_percent;
+unsigned num_threads;
+enum impl impl;
+int stop;
+
+void *thing_get_bst_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct thing, bstn)->key;
+}
+
+void *thing_get_skiplist_key(struct skiplist_node *n)
+{
+        return &SKIPLIST_ITEM(n, struct thing, node)->key;
+}
+
+int compare_u64s(void *key_a, void *key_b)
+{
+        uint64_t a = *(uint64_t *)key_a;
+        uint64_t b = *(uint64_t *)key_b;
+
+        return (a > b) - (a < b);
+}
+
+/* Runs on the thread that retired the thing, which is the one that owns it. */
+void thing_reclaim(struct epoch_deferred *d)
+{
+        EPOCH_ITEM(d, struct thing, node.deferred)->state = STATE_FREE;
+}
+
+struct bst_ops thing_bst_ops = {
+        .get_key = thing_get_bst_key,
+        .compare = compare_u64s,
+};
+
+struct skiplist_ops thing_skiplist_ops = {
+        .get_key = thing_get_skiplist_key,
+        .compare = compare_u64s,
+        .reclaim = thing_reclaim,
+};
+
+/* Delete or insert one of our own things. */
+static void write_one(struct epoch_reader *r, struct thing *thing)
+{
+        if (impl == IMPL_MUTEX) {
+                pthread_mutex_lock(&tree_lock);
+                if (thing->state == STATE_IN_LIST)
+                        BENCH_CHECK(bst_delete(&tree, &thing->bstn) == 0);
+                else
+                        BENCH_CHECK(bst_insert(&tree, &thing->bstn) == 0);
+                pthread_mutex_unlock(&tree_lock);
+                thing->state = (thing->state == STATE_IN_LIST) ? STATE_FREE : STATE_IN_LIST;
+        } else if (thing->state == STATE_IN_LIST) {
+                thing->state = STATE_RETIRED;
+                BENCH_CHECK(skiplist_delete(&list, r, &thing->node) == 0);
+        } else if (thing->state == STATE_FREE) {
+                BENCH_CHECK(skiplist_insert(&list, r, &thing->node) == 0);
+                thing->state = STATE_IN_LIST;
+        }
+}
+
+void *worker_thread(void *arg)
+{
+        unsigned t = (unsigned)(unsigned long)arg;
+        uint64_t state = (uint64_t)(t + 1) * 0x9e3779b97f4a7c15ULL;
+        struct epoch_reader reader;
+        unsigned long ops = 0;
+        uint64_t key;
+
+        epoch_reader_register(&epoch, &reader);
+
+        while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+                key = bench_rand(&state) % num_items;
+
+                if ((bench_rand(&state) % 100) < write_percent) {
+                        /* Move on to the nearest key of our own. */
+                        key = key - (key % num_threads) + t;
+                        if (key < num_items)
+                                write_one(&reader, things[key]);
+                } else if (impl == IMPL_MUTEX) {
+                        pthread_mutex_lock(&tree_lock);
+                        bst_find(&tree, &key);
+                        pthread_mutex_unlock(&tree_lock);
+                } else {
+                        epoch_enter(&reader);
+                        skiplist_find(&list, &key);
+                        epoch_exit(&reader);
+                }
+                ops++;
+        }
+
+        epoch_reader_unregister(&reader);
+
+        return (void *)ops;
+}
+
+void run(unsigned msecs)
+{
+        pthread_t threads[num_threads];
+        unsigned long total = 0;
+        struct timespec ts = { .tv_sec = msecs / 1000, .tv_nsec = (msecs % 1000) * 1000000 };
+        uint64_t start, elapsed;
+        unsigned i;
+        void *ops;
+
+        stop = 0;
+        start = bench_now_ns();
+        for (i=0; i<num_threads; i++)
+                BENCH_CHECK(pthread_create(&threads[i], NULL, worker_thread, (void *)(unsigned long)i) == 0);
+
+        nanosleep(&ts, NULL);
+        __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+
+        for (i=0; i<num_threads; i++) {
+                BENCH_CHECK(pthread_join(threads[i], &ops) == 0);
+                total += (unsigned long)ops;
+        }
+        elapsed = bench_now_ns() - start;
+
+        printf("%s,%u,%lu,%u,%.0f\n", impl_names[impl], num_threads, (unsigned long)num_items, write_percent,
+               (double)total * 1e9 / elapsed);
+        fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+        long nprocs = sysconf(_SC_NPROCESSORS_ONLN);
+        unsigned max_threads = (argc > 1) ? atoi(argv[1]) : (nprocs > 1 ? nprocs : 2);
+        unsigned msecs = (argc > 3) ? atoi(argv[3]) : 500;
+        struct epoch_reader reader;
+        uint64_t state = 1, i;
+        unsigned height;
+
+        num_items = (argc > 2) ? strtoull(argv[2], NULL, 0) : 1000000;
+        write_percent = (argc > 4) ? atoi(argv[4]) : 10;
+
+        things = malloc(sizeof(*things) * num_items);
+        BENCH_CHECK(things);
+        for (i=0; i<num_items; i++) {
+                height = skiplist_random_height(&state);
+                things[i] = malloc(sizeof(struct thing) + height * sizeof(struct skiplist_node *));
+                BENCH_CHECK(things[i]);
+                things[i]->key = i;
+                skiplist_node_init(&things[i]->node, height);
+        }
+
+        epoch_init(&epoch);
+        epoch_reader_register(&epoch, &reader);
+
+        printf("impl,threads,items,write_percent,ops_per_sec\n");
+        for (impl = IMPL_MUTEX; impl <= IMPL_SKIPLIST; impl++) {
+                for (num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+                        /* Start each run with every other key present. */
+                        bst_init(&tree, &thing_bst_ops);
+                        skiplist_init(&list, &thing_skiplist_ops);
+                        for (i=0; i<num_items; i++) {
+                                things[i]->state = STATE_FREE;
+                                if (i & 1)
+                                        write_one(&reader, things[i]);
+                        }
+
+                        run(msecs);
+                }
+        }
+
+        epoch_reader_unregister(&reader);
+        for (i=0; i<num_items; i++)
+                free(things[i]);
+        free(things);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,204 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-twheel.c - Compare a timer wheel with a bst keyed by deadline, for connection timeouts.
+ *
+ * Usage: bench-twheel [num_timers [ops]]
+ *
+ * For each of a bst (ordered by deadline, then connection number) and a timer wheel, runs:
+ *
+ *   arm      every connection gets a timeout 30000 to 60000 ticks away
+ *   rearm    a random connection sees a packet and pushes its timeout back, as each tick goes by
+ *   expire   time moves on 100 ticks at a time until every timeout has gone off
+ *   cancel   every connection is armed again, then cancelled in random order
+ *
+ * and prints a CSV line for each with its throughput (timers armed, re-armed, expired or cancelled per second).
+ */
+
+#include <inttypes.h>
+#include "mec-lib/bst.h"
+#include "mec-lib/twheel.h"
+#include "bench.h"
+
+
+
+#define TIMEOUT         30000
+
+struct conn {
+        uint64_t expires;
+        uint64_t id;
+        int in_bst;
+        struct bst_node node;
+        struct twheel_timer timer;
+};
+
+struct bst bst;
+struct twheel wheel;
+struct conn *conns;
+uint64_t *order;
+uint64_t num_conns;
+
+void *conn_get_key(struct bst_node *n)
+{
+        return BST_ITEM(n, struct conn, node);
+}
+
+int compare_conns(void *key_a, void *key_b)
+{
+        struct conn *a = key_a, *b = key_b;
+
+        if (a->expires != b->expires)
+                return (a->expires > b->expires) - (a->expires < b->expires);
+
+        return (a->id > b->id) - (a->id < b->id);
+}
+
+struct bst_ops conn_bst_ops = {
+        .get_key = conn_get_key,
+        .compare = compare_conns,
+};
+
+void report(const char *kind, const char *op, uint64_t ops, uint64_t elapsed)
+{
+        printf("%s,%" PRIu64 ",%s,%.0f\n", kind, num_conns, op, (double)ops * 1e9 / elapsed);
+        fflush(stdout);
+}
+
+static inline void arm(int use_wheel, struct conn *c, uint64_t expires)
+{
+        if (use_wheel) {
+                c->expires = expires;
+                twheel_arm(&wheel, &c->timer, expires);
+        } else {
+                if (c->in_bst)
+                        BENCH_CHECK(bst_delete(&bst, &c->node) == 0);
+                c->expires = expires;
+                BENCH_CHECK(bst_insert(&bst, &c->node) == 0);
+                c->in_bst = 1;
+        }
+}
+
+/* Expire everything due by 'now', returning how many went off. */
+uint64_t expire(int use_wheel, uint64_t now)
+{
+        struct dlist expired, *d;
+        struct bst_node *n;
+        uint64_t count = 0;
+        struct conn *c;
+
+        if (use_wheel) {
+                dlist_init(&expired);
+                twheel_advance(&wheel, now, &expired);
+                while ((d = dlist_pop_front(&expired))) {
+                        c = TWHEEL_ITEM(d, struct conn, timer.link);
+                        BENCH_CHECK(c->expires <= now);
+                        count++;
+                }
+        } else {
+                while ((n = bst_next(&bst, NULL)) && BST_ITEM(n, struct conn, node)->expires <= now) {
+                        BENCH_CHECK(bst_delete(&bst, n) == 0);
+                        BST_ITEM(n, struct conn, node)->in_bst = 0;
+                        count++;
+                }
+        }
+
+        return count;
+}
+
+void run(int use_wheel, uint64_t ops)
+{
+        const char *kind = use_wheel ? "twheel" : "bst";
+        uint64_t state = 0x1234567, now = 1, start, i, expired;
+
+        bst_init(&bst, &conn_bst_ops);
+        twheel_init(&wheel, now);
+        for (i=0; i<num_conns; i++) {
+                conns[i].id = i;
+                conns[i].in_bst = 0;
+                twheel_timer_init(&conns[i].timer);
+        }
+
+        start = bench_now_ns();
+        for (i=0; i<num_conns; i++)
+                arm(use_wheel, &conns[i], now + TIMEOUT + bench_rand(&state) % TIMEOUT);
+        report(kind, "arm", num_conns, bench_now_ns() - start);
+
+        /* Time moves on a tick every 100 packets, so a few timeouts go off along the way. */
+        start = bench_now_ns();
+        for (i=0; i<ops; i++) {
+                arm(use_wheel, &conns[bench_rand(&state) % num_conns], now + TIMEOUT);
+                if ((i % 100) == 99)
+                        expire(use_wheel, now++);
+        }
+        report(kind, "rearm", ops, bench_now_ns() - start);
+
+        /* Count what's left, since some went off during rearm. */
+        start = bench_now_ns();
+        for (expired = 0; now < 3 * TIMEOUT + ops / 100; now += 100)
+                expired += expire(use_wheel, now);
+        report(kind, "expire", expired, bench_now_ns() - start);
+
+        for (i=0; i<num_conns; i++)
+                arm(use_wheel, &conns[i], now + TIMEOUT + bench_rand(&state) % TIMEOUT);
+        start = bench_now_ns();
+        for (i=0; i<num_conns; i++) {
+                if (use_wheel)
+                        BENCH_CHECK(twheel_cancel(&conns[order[i]].timer));
+                else
+                        BENCH_CHECK(bst_delete(&bst, &conns[order[i]].node) == 0);
+        }
+        report(kind, "cancel", num_conns, bench_now_ns() - start);
+}
+
+int main(int argc, char **argv)
+{
+        uint64_t ops = (argc > 2) ? strtoull(argv[2], NULL, 0) : 10000000;
+        uint64_t state = 0x7654321, i, j, t;
+
+        num_conns = (argc > 1) ? strtoull(argv[1], NULL, 0) : 1000000;
+        conns = malloc(sizeof(*conns) * num_conns);
+        order = malloc(sizeof(*order) * num_conns);
+        BENCH_CHECK(conns && order);
+
+        for (i=0; i<num_conns; i++)
+                order[i] = i;
+        for (i=num_conns-1; i>0; i--) {
+                j = bench_rand(&state) % (i + 1);
+                t = order[i];
+                order[i] = order[j];
+                order[j] = t;
+        }
+
+        printf("kind,timers,op,ops_per_sec\n");
+        run(0, ops);
+        run(1, ops);
+
+        free(order);
+        free(conns);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
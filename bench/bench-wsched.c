@@ -0,0 +1,159 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench-wsched.c - Work-stealing scheduler overhead and scaling.
+ *
+ * Usage: bench-wsched [max_workers [fib_n [array_items]]]
+ *
+ * For 1, 2, 4, ... up to max_workers workers, runs:
+ *
+ *   fib      naive recursive Fibonacci of fib_n with a spawn per call, to measure the cost of tiny tasks
+ *   sum      a parallel for summing an array of array_items 64 bit integers, in ranges of 16K items
+ *
+ * and prints a CSV line for each with the time taken, the time per task, and the speed up: over summing the array in
+ * a plain loop for sum, and over one worker for fib (the compiler turns the serial version into something else
+ * entirely).
+ */
+
+#include <inttypes.h>
+#include "mec-lib/wsched.h"
+#include "bench.h"
+
+
+
+#define SUM_GRAIN       16384
+#define MAX_WORKERS     8
+
+struct fib {
+        struct wsched_task task;
+        unsigned n;
+        uint64_t result;
+};
+
+struct wsched sched;
+struct wsched_worker workers[MAX_WORKERS];
+uint64_t *array;
+uint64_t sums[64] __attribute__((aligned(64)));
+
+void fib_fn(struct wsched_task *t, struct wsched_worker *w)
+{
+        struct fib *f = WSCHED_ITEM(t, struct fib, task);
+        struct fib a, b;
+
+        if (f->n < 2) {
+                f->result = f->n;
+                return;
+        }
+
+        a.n = f->n - 1;
+        b.n = f->n - 2;
+        wsched_task_init(&a.task, fib_fn);
+        wsched_task_init(&b.task, fib_fn);
+        wsched_spawn(w, t, &a.task);
+        wsched_spawn(w, t, &b.task);
+        wsched_sync(w, t);
+
+        f->result = a.result + b.result;
+}
+
+uint64_t fib_serial(unsigned n)
+{
+        return (n < 2) ? n : fib_serial(n - 1) + fib_serial(n - 2);
+}
+
+/* Each worker adds into its own slot of sums[], 8 slots apart to keep them on separate cachelines. */
+void sum_fn(size_t lo, size_t hi, void *arg, struct wsched_worker *w)
+{
+        uint64_t sum = 0;
+        size_t i;
+
+        for (i=lo; i<hi; i++)
+                sum += array[i];
+
+        sums[(w->id * 8) % 64] += sum;
+}
+
+int main(int argc, char **argv)
+{
+        unsigned max_workers = (argc > 1) ? strtoul(argv[1], NULL, 0) : 8;
+        unsigned fib_n = (argc > 2) ? strtoul(argv[2], NULL, 0) : 30;
+        uint64_t num_items = (argc > 3) ? strtoull(argv[3], NULL, 0) : 64 * 1024 * 1024;
+        uint64_t start, serial_sum, fib_one = 0, expect, elapsed, total, tasks, i;
+        unsigned num_workers;
+        struct fib f;
+
+        BENCH_CHECK(max_workers <= MAX_WORKERS);
+        array = malloc(sizeof(*array) * num_items);
+        BENCH_CHECK(array);
+        for (i=0; i<num_items; i++)
+                array[i] = i;
+
+        expect = fib_serial(fib_n);
+        tasks = 2 * fib_serial(fib_n + 1) - 1;
+
+        start = bench_now_ns();
+        for (total = 0, i = 0; i < num_items; i++)
+                total += array[i];
+        serial_sum = bench_now_ns() - start;
+        BENCH_CHECK(total == num_items * (num_items - 1) / 2);
+
+        printf("test,workers,ms,ns_per_task,speedup\n");
+        printf("sum,serial,%.1f,,1.00\n", serial_sum / 1e6);
+
+        for (num_workers = 1; num_workers <= max_workers; num_workers *= 2) {
+                BENCH_CHECK(wsched_init(&sched, workers, num_workers) == 0);
+
+                f.n = fib_n;
+                wsched_task_init(&f.task, fib_fn);
+                start = bench_now_ns();
+                wsched_run(&sched, &f.task);
+                elapsed = bench_now_ns() - start;
+                BENCH_CHECK(f.result == expect);
+                if (num_workers == 1)
+                        fib_one = elapsed;
+                printf("fib,%u,%.1f,%.1f,%.2f\n", num_workers, elapsed / 1e6, (double)elapsed / tasks,
+                       (double)fib_one / elapsed);
+
+                for (i=0; i<64; i++)
+                        sums[i] = 0;
+                start = bench_now_ns();
+                wsched_for(&sched, 0, num_items, SUM_GRAIN, sum_fn, NULL);
+                elapsed = bench_now_ns() - start;
+                for (total = 0, i = 0; i < 64; i++)
+                        total += sums[i];
+                BENCH_CHECK(total == num_items * (num_items - 1) / 2);
+                printf("sum,%u,%.1f,%.1f,%.2f\n", num_workers, elapsed / 1e6,
+                       (double)elapsed / ((num_items + SUM_GRAIN - 1) / SUM_GRAIN), (double)serial_sum / elapsed);
+                fflush(stdout);
+
+                wsched_destroy(&sched);
+        }
+
+        free(array);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
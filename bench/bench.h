@@ -0,0 +1,142 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bench.h - Helpers shared by the benchmarks. */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+
+#define BENCH_CHECK(_expr)                                                      \
+        do {                                                                    \
+                if (!(_expr)) {                                                 \
+                        fprintf(stderr, "BENCH FAILED @ %s:%d '%s' not true\n", \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+/* Monotonic time in nanoseconds. */
+static inline uint64_t bench_now_ns(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Small, fast PRNG (xorshift64*) so that generating keys doesn't dominate the measurements.  'state' must not be 0. */
+static inline uint64_t bench_rand(uint64_t *state)
+{
+        uint64_t x = *state;
+
+        x ^= x >> 12;
+        x ^= x << 25;
+        x ^= x >> 27;
+        *state = x;
+
+        return x * 0x2545f4914f6cdd1dULL;
+}
+
+/* Uniform random double in [0, 1). */
+static inline double bench_rand_double(uint64_t *state)
+{
+        return (bench_rand(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Zipfian distribution over the ranks 0 .. n-1, where rank 0 is the most popular, using the method from Gray et al.,
+   "Quickly Generating Billion-Record Synthetic Databases".  Setting up is O(n); each draw is O(1). */
+struct bench_zipf {
+        uint64_t n;
+        double theta;
+        double alpha;
+        double zetan;
+        double eta;
+};
+
+static inline void bench_zipf_init(struct bench_zipf *z, uint64_t n, double theta)
+{
+        double zeta2 = 1.0 + pow(0.5, theta);
+        uint64_t i;
+
+        z->n = n;
+        z->theta = theta;
+        z->zetan = 0;
+        for (i=1; i<=n; i++)
+                z->zetan += pow((double)i, -theta);
+        z->alpha = 1.0 / (1.0 - theta);
+        z->eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / z->zetan);
+}
+
+static inline uint64_t bench_zipf(struct bench_zipf *z, uint64_t *state)
+{
+        double u = bench_rand_double(state);
+        double uz = u * z->zetan;
+        uint64_t rank;
+
+        if (uz < 1.0)
+                return 0;
+        if (uz < 1.0 + pow(0.5, z->theta))
+                return 1;
+
+        rank = (uint64_t)(z->n * pow(z->eta * u - z->eta + 1.0, z->alpha));
+        return (rank < z->n) ? rank : z->n - 1;
+}
+
+static inline int bench_compare_u64s(const void *a, const void *b)
+{
+        uint64_t x = *(const uint64_t *)a;
+        uint64_t y = *(const uint64_t *)b;
+
+        return (x > y) - (x < y);
+}
+
+/* Sort 'samples' and return the value at percentile 'pct' (0 - 100), or 0 if there are no samples. */
+static inline uint64_t bench_percentile(uint64_t *samples, size_t n, double pct)
+{
+        size_t i;
+
+        if (n == 0)
+                return 0;
+
+        qsort(samples, n, sizeof(*samples), bench_compare_u64s);
+        i = (size_t)(pct / 100.0 * n);
+
+        return samples[(i < n) ? i : n - 1];
+}
+
+
+
+#endif /* _BENCH_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
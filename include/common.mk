@@ -13,7 +13,7 @@ ALL_DEPS = $(patsubst %.o,%.d,$(ALL_OBJS))
 
 define BUILD_PROGRAM
 $(1): $($(1)-OBJS)
-	$(CC) $(CFLAGS) $($(1)-LDFLAGS) -o $$@ $$^
+	$(CC) $(CFLAGS) $($(1)-LDFLAGS) -o $$@ $$^ $($(1)-LIBS)
 endef
 
 all: $(PROGRAMS)
@@ -0,0 +1,143 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* arena.h - Region allocator with bulk reset. */
+
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mec-lib/util.h"
+
+/* An arena hands out memory by bumping a pointer through a chunk, and never frees anything on its own: instead the
+   whole arena is reset at once, or rewound to a mark taken earlier, in O(1).  It suits structures that are built up,
+   used and thrown away together - a bst or dlist of items that only live for one request, say - since throwing them
+   away costs nothing per item.  (The structures themselves need no teardown, as long as nothing outside the arena
+   still points into them.)
+
+   The arena starts out with whatever memory the caller gives arena_init(), which may be a static or stack buffer.
+   When that is used up, more chunks come from the ops, if there are any; otherwise allocations fail.  Each chunk
+   starts with a small header, and they are kept in a list in the order they were first used.  Resetting or rewinding
+   keeps every chunk, and later allocations reuse them in the same order before asking the ops for more, so an arena
+   that is reset after every request soon stops calling the ops at all.
+
+   An arena does no locking; it is meant to belong to one thread, or be protected by its owner. */
+
+/* Alignment of memory returned by arena_alloc(). */
+#define ARENA_ALIGN             16
+
+/* Default size of chunks that come from the ops. */
+#define ARENA_CHUNK_SIZE        (64 * 1024)
+
+struct arena_chunk {
+        struct arena_chunk *next;
+        char *end;
+};
+
+struct arena_ops {
+        /* Return 'size' bytes aligned to at least ARENA_ALIGN, or NULL if none are available. */
+        void *(*alloc_chunk)(size_t size);
+        void (*free_chunk)(void *chunk, size_t size);
+};
+
+struct arena {
+        struct arena_ops *ops;
+        struct arena_chunk *chunks;     /* Every chunk, in the order they are used. */
+        struct arena_chunk *chunk;      /* The chunk being allocated from, NULL before the first. */
+        char *ptr;                      /* Next free byte in 'chunk', and its end. */
+        char *end;
+        void *buf;                      /* Memory from the caller, which isn't freed with the ops. */
+        size_t chunk_size;              /* Size of new chunks, which the caller may change after arena_init(). */
+};
+
+/* A position in an arena, to rewind it to. */
+struct arena_mark {
+        struct arena_chunk *chunk;
+        char *ptr;
+};
+
+
+
+/* Initialize an arena that starts with the 'size' bytes at 'buf' (which may be NULL), and gets more chunks from 'ops'
+   (which may also be NULL).  'buf' is used from its first ARENA_ALIGN aligned address. */
+extern void arena_init(struct arena *a, struct arena_ops *ops, void *buf, size_t size);
+
+/* Free every chunk that came from the ops.  Everything allocated from the arena is freed, of course. */
+extern void arena_destroy(struct arena *a);
+
+/* Allocate from the next chunk that has room, or from a new one.  Used by arena_alloc_aligned(). */
+extern void *arena_alloc_slow(struct arena *a, size_t size, size_t align);
+
+/* Allocate 'size' bytes (which must not be 0) aligned to 'align', a power of two.  Returns NULL if there is no room
+   and no more chunks are available.  The memory is not cleared. */
+static inline void *arena_alloc_aligned(struct arena *a, size_t size, size_t align)
+{
+        uintptr_t p = MEC_ALIGN_UP((uintptr_t)a->ptr, (uintptr_t)align);
+
+        if ((p <= (uintptr_t)a->end) && ((uintptr_t)a->end - p >= size)) {
+                a->ptr = (char *)p + size;
+                return (void *)p;
+        }
+
+        return arena_alloc_slow(a, size, align);
+}
+
+/* Allocate 'size' bytes aligned to ARENA_ALIGN. */
+static inline void *arena_alloc(struct arena *a, size_t size)
+{
+        return arena_alloc_aligned(a, size, ARENA_ALIGN);
+}
+
+/* Remember the current position of an arena. */
+static inline void arena_mark(struct arena *a, struct arena_mark *m)
+{
+        m->chunk = a->chunk;
+        m->ptr = a->ptr;
+}
+
+/* Free everything allocated since 'm' was taken, in O(1).  Marks taken after 'm' become invalid. */
+static inline void arena_rewind(struct arena *a, struct arena_mark *m)
+{
+        a->chunk = m->chunk;
+        a->ptr = m->ptr;
+        a->end = m->chunk ? m->chunk->end : NULL;
+}
+
+/* Free everything allocated from an arena, in O(1), keeping its chunks to reuse. */
+static inline void arena_reset(struct arena *a)
+{
+        a->chunk = NULL;
+        a->ptr = a->end = NULL;
+}
+
+/* Return the number of bytes in an arena's chunks, used or not.  This walks every chunk. */
+extern size_t arena_size(struct arena *a);
+
+
+
+#endif /* _ARENA_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,155 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* art.h - Adaptive radix tree. */
+
+#ifndef _ART_H
+#define _ART_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* An adaptive radix tree (see: Leis et al, "The Adaptive Radix Tree: ARTful Indexing for Main-Memory Databases")
+   looks keys up a byte at a time, so a lookup is O(key length) no matter how many items there are, and never calls a
+   comparison function.  Inner nodes come in four sizes - 4, 16, 48 and 256 children - and grow and shrink as children
+   come and go, so sparse parts of the tree stay small.  Two more tricks keep it shallow:
+   - Path compression: a run of bytes with only one child is stored as a prefix in the node below it.  Up to
+     ART_MAX_PREFIX_LEN bytes of it are kept in the node; for longer prefixes lookups skip the rest and check the whole
+     key against the item they end up at.
+   - Lazy expansion: a subtree with only one item is just a pointer to that item.
+
+   Keys are byte strings, ordered as by memcmp() with a shorter key before any longer key that starts with it.  Keys
+   may be prefixes of other keys.  Integer keys must be stored big endian (see art_u64_key()) to sort numerically.
+
+   Like btree, the tree allocates its own nodes through the ops, and items don't embed anything.  Items must be at
+   least 2 byte aligned, as the low bit of a child pointer marks it as an item.  The key of an item must not change
+   while it is in the tree. */
+
+#define ART_MAX_PREFIX_LEN      8
+
+enum art_node_type {
+        ART_NODE4,
+        ART_NODE16,
+        ART_NODE48,
+        ART_NODE256,
+};
+
+/* The common header of every inner node.  A child is either another node, or an item with the low bit set. */
+struct art_node {
+        uint8_t type;                                   /* An enum art_node_type. */
+        uint16_t num_children;
+        uint32_t prefix_len;
+        unsigned char prefix[ART_MAX_PREFIX_LEN];       /* The first bytes of the prefix. */
+        void *leaf;                                     /* The item whose key ends at this node, if any. */
+};
+
+/* Node4 and node16 keep their keys sorted, with children in the same order. */
+struct art_node4 {
+        struct art_node n;
+        unsigned char keys[4];
+        void *children[4];
+};
+
+struct art_node16 {
+        struct art_node n;
+        unsigned char keys[16];
+        void *children[16];
+};
+
+/* A node48 maps each byte to a slot: 0 for none, or the slot's index plus one. */
+struct art_node48 {
+        struct art_node n;
+        unsigned char index[256];
+        void *children[48];
+};
+
+struct art_node256 {
+        struct art_node n;
+        void *children[256];
+};
+
+struct art_ops {
+        /* Return a pointer to an item's key, and set '*len' to its length in bytes. */
+        const void *(*get_key)(void *item, size_t *len);
+
+        /* Nodes are from 64 to a little over 2048 bytes; 'size' is the same when a node is freed. */
+        struct art_node *(*alloc_node)(size_t size);
+        void (*free_node)(struct art_node *n, size_t size);
+};
+
+struct art {
+        struct art_ops *ops;
+        void *root;                     /* An inner node, an item (with the low bit set), or NULL. */
+};
+
+/* Convert a 64 bit integer to a key, which sorts in the same order, and can be used with a key length of 8 bytes.  On
+   a big endian machine this does nothing. */
+static inline uint64_t art_u64_key(uint64_t v)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        return __builtin_bswap64(v);
+#else
+        return v;
+#endif
+}
+
+
+
+/* Initalize an ART. */
+extern void art_init(struct art *art, struct art_ops *ops);
+
+/* Free every node of an ART.  The items are left alone, and the tree is left empty. */
+extern void art_destroy(struct art *art);
+
+/* Insert an item into an ART.  Returns 0 on success, non-zero on error (the key is already present, or a node could
+   not be allocated - either way the tree is unchanged). */
+extern int art_insert(struct art *art, void *item);
+
+/* Remove the item with the given key from an ART.  Returns 0 on success, non-zero if no item has that key. */
+extern int art_delete(struct art *art, const void *key, size_t len);
+
+/* Find an item in an ART.  Returns a pointer to the item, or NULL if item was not found. */
+extern void *art_find(struct art *art, const void *key, size_t len);
+
+/* Find the smallest item in an ART whose key is greater than or equal to 'key'.  Returns NULL if no such item is
+   found. */
+extern void *art_find_smallest_gte(struct art *art, const void *key, size_t len);
+
+/* Find the largest item in an ART whose key is less than or equal to 'key'.  Returns NULL if no such item is found. */
+extern void *art_find_largest_lte(struct art *art, const void *key, size_t len);
+
+/* Given an item, return the item in the tree with the next highest key.  If NULL is passed in, returns the item with
+   the smallest key.  If no more items exist, returns NULL. */
+extern void *art_next(struct art *art, void *item);
+
+/* Given an item, return the item in the tree with the next lowest key.  If NULL is passed in, returns the item with
+   the largest key.  If no more items exist, returns NULL. */
+extern void *art_prev(struct art *art, void *item);
+
+
+
+#endif /* _ART_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,94 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bst-conc.h - BST with lock-free readers and a single writer. */
+
+#ifndef _BST_CONC_H
+#define _BST_CONC_H
+
+#include "mec-lib/bst.h"
+
+/* A bst_conc wraps a regular BST with a sequence counter.  The writer bumps the counter to an odd value before it
+   touches the tree and back to an even value when it is done; readers walk the tree without taking any locks and
+   retry if the counter changed underneath them.  Readers never write to shared memory, so they do not bounce
+   cachelines between each other.  That includes the BST_STATS counters: only the writer's operations are counted.
+
+   Only one writer may run at a time - callers with several writers must serialize them with their own lock.
+
+   Readers can end up looking at a node the writer has just deleted, so deleted nodes must not be freed or reused
+   until every reader that might have seen them is done.  The usual way to arrange that is to bracket reads with
+   epoch_enter()/epoch_exit() (see epoch.h) and have the writer hand deleted items to epoch_retire().  Nodes returned
+   by the lookup functions are only valid until the reader leaves its critical section.
+
+   The key of an item must not change while it is in the tree or waiting to be reclaimed. */
+
+struct bst_conc {
+        struct bst bst;
+        unsigned long seq;
+};
+
+/* The height of an AA tree is at most 2*log2(n+1), so a reader that goes deeper than this must have wandered into a
+   part of the tree that was being rebalanced, and will retry. */
+#define BST_CONC_MAX_DEPTH 128
+
+
+
+/* Initalize a concurrent BST. */
+extern void bst_conc_init(struct bst_conc *bc, struct bst_ops *ops);
+
+/* Insert an item into a concurrent BST.  Writer only.  Returns 0 on success, non-zero on error. */
+extern int bst_conc_insert(struct bst_conc *bc, struct bst_node *n);
+
+/* Remove an item from a concurrent BST.  Writer only.  Returns 0 on success, non-zero on error. */
+extern int bst_conc_delete(struct bst_conc *bc, struct bst_node *n);
+
+/* Find an item in a concurrent BST.  Returns a pointer to the node, or NULL if item was not found. */
+extern struct bst_node *bst_conc_find(struct bst_conc *bc, void *key);
+
+/* Find the smallest item in a concurrent BST whose key is greater than or equal to 'key'.  Returns NULL if no such
+   item is found. */
+extern struct bst_node *bst_conc_find_smallest_gte(struct bst_conc *bc, void *key);
+
+/* Find the largest item in a concurrent BST whose key is less than or equal to 'key'.  Returns NULL if no such item
+   is found. */
+extern struct bst_node *bst_conc_find_largest_lte(struct bst_conc *bc, void *key);
+
+/* Given a node, return a pointer to the node in the tree with the next highest key.  If NULL is passed in, returns a
+   pointer to the node in the tree with the smallest key.  If no more nodes exist, returns NULL.
+
+   Unlike bst_next(), this searches down from the root by key, so 'n' may have been deleted since it was returned
+   (as long as it has not been reclaimed).  It is O(log n) per call. */
+extern struct bst_node *bst_conc_next(struct bst_conc *bc, struct bst_node *n);
+
+/* Given a node, return a pointer to the node in the tree with the next lowest key.  If NULL is passed in, returns a
+   pointer to the node in the tree with the largest key.  If no more nodes exist, returns NULL.  Like bst_conc_next(),
+   'n' may have been deleted. */
+extern struct bst_node *bst_conc_prev(struct bst_conc *bc, struct bst_node *n);
+
+
+
+#endif /* _BST_CONC_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,114 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bst-cow.h - Persistent (copy-on-write) binary search tree with O(1) snapshots. */
+
+#ifndef _BST_COW_H
+#define _BST_COW_H
+
+#include <stddef.h>
+
+/* The same AA tree as bst.h, but persistent: bst_cow_snapshot() makes a new version of a tree that shares every node
+   with the original, and later inserts and deletes on either version copy only the nodes on the path they touch.
+   Nodes are reference counted and are freed when the last version using them is destroyed.  Nodes that are only
+   used by one version are updated in place, so a tree with no snapshots costs no more than an ordinary one.
+
+   Because one item can be in several versions at once, the links cannot live in the item the way a bst_node does.
+   Instead the tree allocates its own nodes through the ops, and each node points at its item.  Items must stay
+   around (with unchanged keys) until every version that contains them is gone.
+
+   A version may only be changed by one thread at a time, and snapshots must be taken by (or serialized with) that
+   thread.  Once taken, a snapshot can be read and destroyed from any thread without locking, while the original
+   keeps being updated; the allocator must be thread safe for that.
+
+   Before changing anything, insert and delete allocate enough spare nodes for the worst case, so an allocation
+   failure leaves the tree as it was.  Unused spares are kept for the next change and freed by bst_cow_destroy(). */
+
+struct bst_cow_node {
+        struct bst_cow_node *left;
+        struct bst_cow_node *right;
+        void *item;
+        unsigned level;
+        unsigned refs;
+};
+
+struct bst_cow_ops {
+        void *(*get_key)(void *item);
+        int (*compare)(void *key_a, void *key_b);
+        struct bst_cow_node *(*alloc_node)(void);
+        void (*free_node)(struct bst_cow_node *n);
+};
+
+struct bst_cow {
+        struct bst_cow_ops *ops;
+        struct bst_cow_node *root;
+        struct bst_cow_node *spare; /* Nodes allocated ahead of time, linked through 'left'. */
+        unsigned num_spare;
+};
+
+
+
+/* Initalize an empty persistent BST. */
+extern void bst_cow_init(struct bst_cow *t, struct bst_cow_ops *ops);
+
+/* Make 'snap' a new version of 't' with the same contents.  This is O(1). */
+extern void bst_cow_snapshot(struct bst_cow *t, struct bst_cow *snap);
+
+/* Destroy a version, freeing any nodes that no other version is using.  't' is left empty. */
+extern void bst_cow_destroy(struct bst_cow *t);
+
+/* Insert an item into a persistent BST.  Returns 0 on success, non-zero on error (the key is already present, or a
+   node could not be allocated). */
+extern int bst_cow_insert(struct bst_cow *t, void *item);
+
+/* Remove the item with the given key from a persistent BST.  Returns 0 on success, non-zero if no item has that
+   key, or a node could not be allocated. */
+extern int bst_cow_delete(struct bst_cow *t, void *key);
+
+/* Find an item in a persistent BST.  Returns a pointer to the item, or NULL if item was not found. */
+extern void *bst_cow_find(struct bst_cow *t, void *key);
+
+/* Find the smallest item in a persistent BST whose key is greater than or equal to 'key'.  Returns NULL if no such
+   item is found. */
+extern void *bst_cow_find_smallest_gte(struct bst_cow *t, void *key);
+
+/* Find the largest item in a persistent BST whose key is less than or equal to 'key'.  Returns NULL if no such item
+   is found. */
+extern void *bst_cow_find_largest_lte(struct bst_cow *t, void *key);
+
+/* Given an item, return the item in the tree with the next highest key.  If NULL is passed in, returns the item with
+   the smallest key.  If no more items exist, returns NULL.  Nodes have no parent pointers (they can have several
+   parents), so this searches down from the root and is O(log n). */
+extern void *bst_cow_next(struct bst_cow *t, void *item);
+
+/* Given an item, return the item in the tree with the next lowest key.  If NULL is passed in, returns the item with
+   the largest key.  If no more items exist, returns NULL. */
+extern void *bst_cow_prev(struct bst_cow *t, void *item);
+
+
+
+#endif /* _BST_COW_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,84 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bst-frozen.h - Read-only snapshot of a BST laid out for fast searching. */
+
+#ifndef _BST_FROZEN_H
+#define _BST_FROZEN_H
+
+#include <stddef.h>
+#include "mec-lib/bst.h"
+
+/* A frozen BST is a copy of the keys and nodes of a BST stored in one contiguous array in Eytzinger (breadth first)
+   order: the root is at index 1 and the children of index i are at 2i and 2i+1.  Searching is branch-free index
+   arithmetic over that array, so the CPU can prefetch a couple of levels ahead instead of chasing pointers through
+   scattered bst_node's.  See: https://arxiv.org/abs/1509.05053
+
+   The snapshot holds the key pointers returned by get_key(), so keys must stay put while it is in use.  It does not
+   follow later changes to the live tree; call bst_refreeze() after a batch of bst_insert()/bst_delete() calls. */
+
+struct bst_frozen_entry {
+        void *key;
+        struct bst_node *node;
+};
+
+struct bst_frozen {
+        struct bst_ops *ops;
+        struct bst_frozen_entry *entries; /* entries[0] is unused. */
+        size_t count;
+        size_t capacity;
+};
+
+/* Number of bytes of memory needed to freeze a tree with 'count' items.  Aligning the memory to a cacheline lets each
+   prefetch pull in a whole level's worth of entries. */
+#define BST_FROZEN_MEM_SIZE(count) (((count) + 1) * sizeof(struct bst_frozen_entry))
+
+
+
+/* Freeze a BST into caller-supplied memory.  Returns 0 on success, non-zero if 'mem_size' is too small to hold every
+   item in the tree. */
+extern int bst_freeze(struct bst_frozen *f, struct bst *bst, void *mem, size_t mem_size);
+
+/* Rebuild a frozen BST from the current contents of the live tree, reusing the memory it was frozen into.  This takes
+   O(n) time and makes no calls to compare().  Returns 0 on success, non-zero if the tree has outgrown the memory (in
+   which case the old snapshot is left untouched and bst_freeze() should be called with more memory). */
+extern int bst_refreeze(struct bst_frozen *f, struct bst *bst);
+
+/* Find an item in a frozen BST.  Returns a pointer to the node, or NULL if item was not found. */
+extern struct bst_node *bst_frozen_find(struct bst_frozen *f, void *key);
+
+/* Find the smallest item in a frozen BST whose key is greater than or equal to 'key'.  Returns NULL if no such item is
+   found. */
+extern struct bst_node *bst_frozen_find_smallest_gte(struct bst_frozen *f, void *key);
+
+/* Find the largest item in a frozen BST whose key is less than or equal to 'key'.  Returns NULL if no such item is
+   found. */
+extern struct bst_node *bst_frozen_find_largest_lte(struct bst_frozen *f, void *key);
+
+
+
+#endif /* _BST_FROZEN_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,126 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bst-image.h - Relocatable image of a BST that can be searched in place (e.g. after mmap). */
+
+#ifndef _BST_IMAGE_H
+#define _BST_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mec-lib/bst.h"
+
+/* bst_image_build() writes the items of a BST into a block of memory as a self-contained image: a header, then one
+   image node per item in key order, each followed by a copy of the item (a "record") written by the ops.  Links
+   between nodes are byte offsets from the start of the image rather than pointers, so the image can be written to a
+   file and later mapped at any address and searched straight away with bst_image_open(), with no parsing or copying.
+   The nodes form a perfectly balanced tree.
+
+   The image is split into pages of 'page_size' bytes, and a table of CRC-32C's, one per page, is stored at the end.
+   bst_image_verify() checks them, which is O(size of the image); bst_image_open() on its own only checks the header.
+
+   Images use the byte order and alignment of the machine that built them. */
+
+#define BST_IMAGE_MAGIC   0x62636d65 /* "emcb" in little endian. */
+#define BST_IMAGE_VERSION 1
+
+struct bst_image_header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t page_size;
+        uint32_t num_pages;
+        uint64_t size;          /* Bytes in the whole image, including the CRC table. */
+        uint64_t count;         /* Number of items. */
+        uint64_t root;          /* Offset of the root node, or 0 if the image is empty. */
+        uint64_t crc_offset;    /* Offset of the CRC table, which is also the end of the paged data. */
+};
+
+/* Offsets of 0 mean "none" (the header is at offset 0).  The record follows the node, aligned to 8 bytes. */
+struct bst_image_node {
+        uint64_t parent;
+        uint64_t left;
+        uint64_t right;
+};
+
+/* record_size() and write_record() serialize an item of the source BST; get_key() and compare() work on records. */
+struct bst_image_ops {
+        size_t (*record_size)(struct bst_node *n);
+        void (*write_record)(struct bst_node *n, void *record);
+        void *(*get_key)(void *record);
+        int (*compare)(void *key_a, void *key_b);
+};
+
+struct bst_image {
+        struct bst_image_ops *ops;
+        char *base;
+        struct bst_image_header *hdr;
+};
+
+
+
+/* Return the number of bytes bst_image_build() needs for an image of 'bst'.  This walks the tree, so it is O(n). */
+extern size_t bst_image_size(struct bst *bst, struct bst_image_ops *ops, size_t page_size);
+
+/* Write an image of 'bst' into 'mem', which must be 8 byte aligned.  Returns 0 on success, non-zero on error (the
+   memory is too small, or 'page_size' is not a power of two of at least 64). */
+extern int bst_image_build(struct bst *bst, struct bst_image_ops *ops, void *mem, size_t mem_size, size_t page_size);
+
+/* Set up 'img' to search the image at 'mem', which must be 8 byte aligned.  Checks the header against 'mem_size', but
+   not the page CRC's.  Returns 0 on success, non-zero on error. */
+extern int bst_image_open(struct bst_image *img, struct bst_image_ops *ops, void *mem, size_t mem_size);
+
+/* Check every page of an image against its CRC.  Returns 0 if they all match, non-zero otherwise. */
+extern int bst_image_verify(struct bst_image *img);
+
+/* Return the number of items in an image. */
+static inline size_t bst_image_count(struct bst_image *img)
+{
+        return img->hdr->count;
+}
+
+/* Find a record in an image.  Returns a pointer to the record, or NULL if it was not found. */
+extern void *bst_image_find(struct bst_image *img, void *key);
+
+/* Find the smallest record in an image whose key is greater than or equal to 'key'.  Returns NULL if no such record
+   is found. */
+extern void *bst_image_find_smallest_gte(struct bst_image *img, void *key);
+
+/* Find the largest record in an image whose key is less than or equal to 'key'.  Returns NULL if no such record is
+   found. */
+extern void *bst_image_find_largest_lte(struct bst_image *img, void *key);
+
+/* Given a record, return the record in the image with the next highest key.  If NULL is passed in, returns the record
+   with the smallest key.  If no more records exist, returns NULL. */
+extern void *bst_image_next(struct bst_image *img, void *record);
+
+/* Given a record, return the record in the image with the next lowest key.  If NULL is passed in, returns the record
+   with the largest key.  If no more records exist, returns NULL. */
+extern void *bst_image_prev(struct bst_image *img, void *record);
+
+
+
+#endif /* _BST_IMAGE_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
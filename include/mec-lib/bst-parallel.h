@@ -0,0 +1,67 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bst-parallel.h - Multi-threaded scans over a BST. */
+
+#ifndef _BST_PARALLEL_H
+#define _BST_PARALLEL_H
+
+#include "mec-lib/bst.h"
+
+/* These split a tree into disjoint key ranges, by cutting it a few levels below the root, and hand the ranges out to
+   worker threads.  There are several ranges per thread, so that a thread that gets a sparse range just takes another.
+   Each thread takes ranges in key order, and visits the items in each one in key order, so any one thread sees its
+   items in increasing key order (but different threads run at the same time).
+
+   The tree must not change while a scan runs - that includes lookups in a splay tree, which move nodes around.  The
+   calling thread is used as one of the workers.  If a thread can't be started, the others pick up its share.
+
+   Cutting by depth assumes the tree is balanced, as AA and red-black trees are.  A splay tree can be arbitrarily
+   lopsided, so its ranges can be very uneven and most of the items may end up visited by one thread; it is still
+   scanned correctly, just without much speedup. */
+
+/* The most threads a scan will use. */
+#define BST_PARALLEL_MAX_THREADS 64
+
+
+
+/* Call 'fn' on every item of a BST, using up to 'nthreads' threads.  If 'fn' returns non-zero, the scan stops as soon
+   as every thread notices, and that value is returned; otherwise returns 0. */
+extern int bst_parallel_for_each(struct bst *bst, unsigned nthreads, int (*fn)(struct bst_node *n, void *arg),
+                                 void *arg);
+
+/* Fold every item of a BST into an accumulator, using up to 'nthreads' threads.  'nthreads' is clamped to between 1
+   and BST_PARALLEL_MAX_THREADS, and 'accs' points to an array of that many accumulators of 'acc_size' bytes each, set
+   up by the caller as empty; each thread calls 'map' to fold items into its own one.  Once the scan is done,
+   'combine' folds each of the others into the first, which holds the result.  Since it isn't known which thread sees
+   which items, 'map' and 'combine' must not depend on order. */
+extern void bst_parallel_reduce(struct bst *bst, unsigned nthreads, void *accs, size_t acc_size,
+                                void (*map)(void *acc, struct bst_node *n), void (*combine)(void *acc, void *other));
+
+
+
+#endif /* _BST_PARALLEL_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,109 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bst-shard.h - Range partitioned set of BST's for concurrent writers. */
+
+#ifndef _BST_SHARD_H
+#define _BST_SHARD_H
+
+#include <pthread.h>
+#include "mec-lib/bst.h"
+
+/* A bst_shard_set splits the key space into ranges, each held in its own BST with its own lock, so writers working
+   on different ranges don't serialize on each other.  The ranges are separated by splitter keys: shard i+1 holds the
+   keys that are greater than or equal to splitter i.
+
+   The set starts out with a single shard.  When a shard grows past 'max_shard_items' it is split in two, until every
+   shard is in use; after that, a shard that grows to more than twice the size of a neighbour hands half of the
+   difference over to it.  Rebalancing holds the routing lock for writing, which stops all other operations while it
+   runs, so 'max_shard_items' should be large enough that it happens rarely.
+
+   Splitters are copies of item keys, so keys must be plain data of at most 'key_size' bytes that compare() can be
+   called on after being copied with memcpy(). */
+
+struct bst_shard {
+        pthread_mutex_t lock;
+        struct bst bst;
+        size_t count;
+} __attribute__((aligned(64)));
+
+struct bst_shard_set {
+        struct bst_ops *ops;
+        pthread_rwlock_t routing;
+        struct bst_shard *shards;
+        unsigned num_shards;
+        unsigned active_shards;
+        char *splitters; /* num_shards - 1 keys of key_size bytes each. */
+        size_t key_size;
+        size_t max_shard_items;
+};
+
+/* Number of bytes of splitter memory needed for a set with 'num_shards' shards. */
+#define BST_SHARD_SPLITTERS_SIZE(num_shards, key_size) (((num_shards) - 1) * (key_size))
+
+
+
+/* Initialize a sharded BST using caller-supplied arrays of shards and splitter keys. */
+extern void bst_shard_init(struct bst_shard_set *s, struct bst_ops *ops, struct bst_shard *shards, unsigned num_shards,
+                           void *splitters, size_t key_size, size_t max_shard_items);
+
+/* Release the locks of a sharded BST.  The items still in it are left alone. */
+extern void bst_shard_destroy(struct bst_shard_set *s);
+
+/* Insert an item into a sharded BST.  Returns 0 on success, non-zero on error. */
+extern int bst_shard_insert(struct bst_shard_set *s, struct bst_node *n);
+
+/* Remove an item from a sharded BST.  Returns 0 on success, non-zero on error. */
+extern int bst_shard_delete(struct bst_shard_set *s, struct bst_node *n);
+
+/* Find an item in a sharded BST.  Returns a pointer to the node, or NULL if item was not found. */
+extern struct bst_node *bst_shard_find(struct bst_shard_set *s, void *key);
+
+/* Find the smallest item in a sharded BST whose key is greater than or equal to 'key'.  Returns NULL if no such item
+   is found. */
+extern struct bst_node *bst_shard_find_smallest_gte(struct bst_shard_set *s, void *key);
+
+/* Find the largest item in a sharded BST whose key is less than or equal to 'key'.  Returns NULL if no such item is
+   found. */
+extern struct bst_node *bst_shard_find_largest_lte(struct bst_shard_set *s, void *key);
+
+/* Given a node, return a pointer to the node in the set with the next highest key, moving on to the next shard when
+   one runs out.  If NULL is passed in, returns a pointer to the node with the smallest key.  If no more nodes exist,
+   returns NULL.  The caller must make sure 'n' is not deleted while this runs. */
+extern struct bst_node *bst_shard_next(struct bst_shard_set *s, struct bst_node *n);
+
+/* Given a node, return a pointer to the node in the set with the next lowest key.  If NULL is passed in, returns a
+   pointer to the node with the largest key.  If no more nodes exist, returns NULL.  The caller must make sure 'n' is
+   not deleted while this runs. */
+extern struct bst_node *bst_shard_prev(struct bst_shard_set *s, struct bst_node *n);
+
+/* Return the number of items in a sharded BST. */
+extern size_t bst_shard_count(struct bst_shard_set *s);
+
+
+
+#endif /* _BST_SHARD_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
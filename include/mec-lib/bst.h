@@ -21,8 +21,19 @@
 #define _BST_H
 
 #include <stddef.h>
+#include <stdint.h>
 
-/* Currently implemented as an AA Tree (or Andersson Tree).  See: http://en.wikipedia.org/wiki/AA_tree
+/* By default this is implemented as an AA Tree (or Andersson Tree).  See: http://en.wikipedia.org/wiki/AA_tree
+ *
+ * bst_init_balanced() can pick a red-black tree instead.  AA trees are simpler, but a delete can rotate at every level
+ * on the way back up; a red-black tree does at most two rotations per insert and three per delete, which is better
+ * for delete heavy workloads.  Red-black trees keep each node's colour in 'level' (1 for black, 2 for red).
+ *
+ * A splay tree (BST_BALANCE_SPLAY) isn't balanced at all: every insert, and every lookup that has to go more than a
+ * few levels down, moves the node it ends up at to the root, so keys that are used often stay near the top.
+ * Operations are only O(log n) amortized, but for skewed access patterns the hot keys take a few comparisons to find.
+ * Note that this means bst_find(), bst_find_smallest_gte() and bst_find_largest_lte() modify a splay tree, so they need
+ * the same locking as bst_insert().
  */
 
 struct bst_node {
@@ -43,25 +54,124 @@ struct bst_node {
                         (type *)NULL;                                           \
         })
 
+/* A node that also caches a prefix of its item's key, for use with bst_ops that have get_prefix() set. */
+struct bst_prefix_node {
+        struct bst_node node;
+        uint64_t prefix;
+};
+
+/* Extract pointer to the bst_prefix_node that contains a bst node. */
+#define BST_PREFIX_NODE(n) BST_ITEM(n, struct bst_prefix_node, node)
+
 struct bst_ops {
         void *(*get_key)(struct bst_node *n);
         int (*compare)(void *key_a, void *key_b);
+
+        /* Optional.  If set, every node in the tree must be the 'node' of a struct bst_prefix_node, and get_prefix()
+           must map keys to integers in the same order as compare() (so that compare(a, b) < 0 implies
+           get_prefix(a) <= get_prefix(b)).  The prefix is stored in the node when it is inserted, and searches only
+           call get_key() and compare() on nodes whose prefix ties with the key's, which saves a cache miss per level
+           when keys live out in the items (strings, for example). */
+        uint64_t (*get_prefix)(void *key);
 };
 
+/* Building with BST_STATS defined adds counters to every struct bst, and BST_STATS_LATENCY adds per-operation latency
+   histograms on top of that.  Since they change the size of struct bst, everything that uses it must be built with the
+   same setting.  Without them there is no cost at all.
+
+   The counters are plain fields of struct bst, and every lookup updates them.  So with stats on, bst_find(),
+   bst_find_smallest_gte() and bst_find_largest_lte() write to the tree like a splay tree's do, and need the same
+   locking as bst_insert(): lookups running at once under a shared lock would race on the counters and bounce their
+   cache line between CPUs.  Stats builds are for measuring a tree's shape and cost, not for concurrent readers.
+   (bst_conc readers walk the tree themselves and aren't counted, so a bst_conc can still be built with stats.) */
+#if defined(BST_STATS_LATENCY) && !defined(BST_STATS)
+#define BST_STATS
+#endif
+
+enum bst_balance {
+        BST_BALANCE_AA,
+        BST_BALANCE_RB,
+        BST_BALANCE_SPLAY,
+};
+
+#ifdef BST_STATS
+enum bst_stats_op {
+        BST_STATS_INSERT,
+        BST_STATS_DELETE,
+        BST_STATS_FIND,
+        BST_STATS_GTE,
+        BST_STATS_LTE,
+        BST_STATS_NUM_OPS,
+};
+
+/* Latency bucket i counts operations that took from 2^i up to 2^(i+1) nanoseconds (bucket 0 also counts 0). */
+#define BST_STATS_LATENCY_BUCKETS 32
+
+#define BST_STATS_MAX_LEVEL 64
+
+struct bst_stats {
+        unsigned long ops[BST_STATS_NUM_OPS];
+        unsigned long comparisons[BST_STATS_NUM_OPS];   /* Calls to ops->compare(). */
+        unsigned long depth[BST_STATS_NUM_OPS];         /* Nodes visited going down (or, for delete, back up). */
+        unsigned max_depth[BST_STATS_NUM_OPS];
+        unsigned long skews;                            /* Rotations actually done by skew and split. */
+        unsigned long splits;
+        unsigned long rotations;                        /* Red-black and splay tree rotations. */
+#ifdef BST_STATS_LATENCY
+        unsigned long latency[BST_STATS_NUM_OPS][BST_STATS_LATENCY_BUCKETS];
+#endif
+
+        /* Counts for the operation in progress. */
+        unsigned cur_comparisons;
+        unsigned cur_depth;
+};
+
+/* A copy of a tree's stats, plus what can only be found by walking the tree. */
+struct bst_stats_snapshot {
+        struct bst_stats stats;
+        enum bst_balance balance;
+        size_t count;
+        size_t levels[BST_STATS_MAX_LEVEL];             /* Number of nodes at each level (AA trees only). */
+};
+#endif
+
 struct bst {
         struct bst_ops *ops;
         struct bst_node *root;
+        enum bst_balance balance;
+#ifdef BST_STATS
+        struct bst_stats stats;
+#endif
 };
 
 /* This is used internally by the implementation, but may be useful for external code that wants to walk the tree
    manually. */
 extern struct bst_node *bst_nil;
 
+/* A get_prefix() for strcmp() ordered strings: the first 8 bytes, big endian, padded with zeros. */
+static inline uint64_t bst_string_prefix(void *key)
+{
+        const unsigned char *s = key;
+        uint64_t prefix = 0;
+        unsigned i;
+
+        for (i=0; i<8; i++) {
+                prefix <<= 8;
+                if (*s)
+                        prefix |= *s++;
+        }
+
+        return prefix;
+}
+
 
 
 /* Initalize a BST. */
 extern void bst_init(struct bst *bst, struct bst_ops *ops);
 
+/* Initalize a BST that uses the given balancing scheme. */
+extern void bst_init_balanced(struct bst *bst, struct bst_ops *ops, enum bst_balance balance);
+
 /* Insert an item into a BST.  Returns 0 on success, non-zero on error. */
 extern int bst_insert(struct bst *bst, struct bst_node *n);
 
@@ -86,6 +196,31 @@ extern struct bst_node *bst_next(struct bst *bst, struct bst_node *n);
    pointer to the node in the tree with the largest key.  If no more nodes exist, returns NULL. */
 extern struct bst_node *bst_prev(struct bst *bst, struct bst_node *n);
 
+/* Return the number of items in a BST.  Note that this walks the whole tree, so it is O(n). */
+extern size_t bst_count(struct bst *bst);
+
+/* Remove every item with a key from 'lo' to 'hi' (inclusive) from a BST, by splitting the range out of the tree and
+   joining what is left, in O(log n + k) for k items removed.  If 'cb' is not NULL, each item removed is passed to it,
+   with its node already reset, in no particular order.  Returns the number of items removed. */
+extern size_t bst_delete_range(struct bst *bst, void *lo, void *hi, void (*cb)(struct bst_node *n));
+
+/* Remove every item from a BST in O(n), without any rebalancing.  If 'cb' is not NULL, each item is passed to it, with
+   its node already reset, children before parents; so it may free them.  Returns the number of items removed. */
+extern size_t bst_drain(struct bst *bst, void (*cb)(struct bst_node *n));
+
+#ifdef BST_STATS
+#include <stdio.h>
+
+/* Zero the stats of a BST. */
+extern void bst_stats_reset(struct bst *bst);
+
+/* Take a copy of the stats of a BST, and count the nodes at each level.  This walks the whole tree, so it is O(n). */
+extern void bst_stats_snapshot(struct bst *bst, struct bst_stats_snapshot *snap);
+
+/* Print a snapshot in human readable form. */
+extern void bst_stats_dump(struct bst_stats_snapshot *snap, FILE *f);
+#endif
+
 
 
 #endif /* _BST_H */
@@ -0,0 +1,135 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* btree.h - Cache conscious B+tree keyed by 64 bit integers. */
+
+#ifndef _BTREE_H
+#define _BTREE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* A B+tree holds many keys per node, so a search touches a few cache lines in each of a handful of nodes instead of one
+   node per level of a binary tree - about 6 levels instead of 25 for tens of millions of keys.  Nodes are 512 bytes
+   (8 cache lines), with the keys packed together at the front so that a search within a node only reads the key
+   lines, and compares 4 keys at a time with AVX2 where the CPU has it (unless built with BTREE_NO_AVX2).  Items are
+   only held in the leaves, which are linked together, so walking through a range of keys with a btree_iter doesn't
+   need to go back up the tree.
+
+   Keys are unsigned 64 bit integers, and every item's key must be unique.  Other kinds of key can be used if they can
+   be mapped to integers in the same order (see bst_string_prefix() in bst.h for a start).
+
+   Like bst_cow, the tree allocates its own nodes through the ops, and each leaf slot points at an item; items don't
+   embed anything.  alloc_node() should return memory aligned to a cache line (64 bytes).  Before changing anything,
+   insert allocates every node it might need, so an allocation failure leaves the tree as it was. */
+
+#define BTREE_NODE_KEYS         28      /* A multiple of 4, for the AVX2 search. */
+#define BTREE_MAX_HEIGHT        16
+
+struct btree_node {
+        uint64_t keys[BTREE_NODE_KEYS];         /* Unused slots hold UINT64_MAX. */
+        union {
+                /* Inner nodes: child i holds the keys less than or equal to keys[i], and greater than keys[i-1]. */
+                struct btree_node *children[BTREE_NODE_KEYS + 1];
+
+                /* Leaves. */
+                struct {
+                        void *items[BTREE_NODE_KEYS];
+                        struct btree_node *prev;
+                        struct btree_node *next;
+                };
+        };
+        unsigned count;                         /* Keys in use. */
+} __attribute__((aligned(64)));
+
+struct btree_ops {
+        uint64_t (*get_key)(void *item);
+        struct btree_node *(*alloc_node)(void);
+        void (*free_node)(struct btree_node *n);
+};
+
+struct btree {
+        struct btree_ops *ops;
+        struct btree_node *root;
+        unsigned height;                        /* 0 when empty, 1 when the root is a leaf. */
+};
+
+/* A position in the tree, for walking through items in key order. */
+struct btree_iter {
+        struct btree_node *leaf;
+        unsigned pos;
+};
+
+
+
+/* Initalize a B+tree. */
+extern void btree_init(struct btree *bt, struct btree_ops *ops);
+
+/* Free every node of a B+tree.  The items are left alone, and the tree is left empty. */
+extern void btree_destroy(struct btree *bt);
+
+/* Insert an item into a B+tree.  Returns 0 on success, non-zero on error (the key is already present, or a node could
+   not be allocated). */
+extern int btree_insert(struct btree *bt, void *item);
+
+/* Remove the item with the given key from a B+tree.  Returns 0 on success, non-zero if no item has that key. */
+extern int btree_delete(struct btree *bt, uint64_t key);
+
+/* Find an item in a B+tree.  Returns a pointer to the item, or NULL if item was not found. */
+extern void *btree_find(struct btree *bt, uint64_t key);
+
+/* Find the smallest item in a B+tree whose key is greater than or equal to 'key'.  Returns NULL if no such item is
+   found. */
+extern void *btree_find_smallest_gte(struct btree *bt, uint64_t key);
+
+/* Find the largest item in a B+tree whose key is less than or equal to 'key'.  Returns NULL if no such item is
+   found. */
+extern void *btree_find_largest_lte(struct btree *bt, uint64_t key);
+
+/* Given an item, return the item in the tree with the next highest key.  If NULL is passed in, returns the item with
+   the smallest key.  If no more items exist, returns NULL.  This searches down from the root; use a btree_iter to walk
+   through many items. */
+extern void *btree_next(struct btree *bt, void *item);
+
+/* Given an item, return the item in the tree with the next lowest key.  If NULL is passed in, returns the item with
+   the largest key.  If no more items exist, returns NULL. */
+extern void *btree_prev(struct btree *bt, void *item);
+
+/* Point an iterator at the smallest item whose key is greater than or equal to 'key'. */
+extern void btree_iter_seek(struct btree *bt, struct btree_iter *it, uint64_t key);
+
+/* Return the item an iterator points at and move it on to the next one, or return NULL at the end of the tree.  The
+   tree must not be changed while an iterator is in use. */
+extern void *btree_iter_next(struct btree_iter *it);
+
+/* Move an iterator back to the previous item and return it, or return NULL at the start of the tree.  Calling this
+   after btree_iter_next() returns the same item again. */
+extern void *btree_iter_prev(struct btree_iter *it);
+
+
+
+#endif /* _BTREE_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -107,6 +107,20 @@ static inline struct dlist *dlist_pop_back(struct dlist *head)
         }
 }
 
+/* Move every entry of 'list' onto the back of 'head', in order, leaving 'list' empty.  O(1). */
+static inline void dlist_splice_back(struct dlist *head, struct dlist *list)
+{
+        if (is_dlist_empty(list))
+                return;
+
+        list->next->prev = head->prev;
+        head->prev->next = list->next;
+        list->prev->next = head;
+        head->prev = list->prev;
+
+        dlist_init(list);
+}
+
 #define dlist_for_each(head, d)                                         \
         for ((d) = (head)->next; (d) != (head); (d) = (d)->next)
 
@@ -0,0 +1,135 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* epoch.h - Epoch based deferred reclamation for lock-free readers. */
+
+#ifndef _EPOCH_H
+#define _EPOCH_H
+
+#include <pthread.h>
+#include "mec-lib/dlist.h"
+
+/* Each thread that reads a shared structure without locks registers an epoch_reader and brackets its reads with
+   epoch_enter()/epoch_exit().  A writer that unlinks an item hands it to epoch_retire(); the item's callback runs
+   once every reader that might still have been looking at it has left its critical section.
+
+   The global epoch only advances when every active reader has observed the current one, so an item retired in epoch
+   E is safe to reclaim once the global epoch reaches E+2.  See section 5.2.3 of:
+   https://www.cl.cam.ac.uk/techreports/UCAM-CL-TR-579.pdf */
+
+struct epoch {
+        unsigned long global;
+        pthread_mutex_t lock;
+        struct dlist readers;
+};
+
+/* One of these per thread.  Retired items are queued on the retiring thread's own reader, so retiring does not touch
+   any shared cachelines. */
+struct epoch_reader {
+        unsigned long local; /* 0 when not in a critical section. */
+        unsigned nesting;
+        struct epoch *epoch;
+        struct dlist link;
+        struct dlist retired;
+        unsigned num_retired;
+} __attribute__((aligned(64)));
+
+/* Embed one of these in anything that needs deferred reclamation. */
+struct epoch_deferred {
+        struct dlist link;
+        unsigned long epoch;
+        void (*fn)(struct epoch_deferred *d);
+};
+
+/* Extract pointer to an item that contains an epoch_deferred. */
+#define EPOCH_ITEM(d,type,field)                                                \
+        ({                                                                      \
+                typeof(d) _dl = (d);                                            \
+                                                                                \
+                (_dl) ?                                                         \
+                        (type *) ((char *)_dl - offsetof(type, field))          \
+                        :                                                       \
+                        (type *)NULL;                                           \
+        })
+
+/* epoch_retire() tries to reclaim items after this many have been queued on a reader. */
+#define EPOCH_RECLAIM_THRESHOLD 64
+
+
+
+/* Initialize an epoch domain. */
+extern void epoch_init(struct epoch *e);
+
+/* Register a reader with an epoch domain.  This must be done before the reader is used. */
+extern void epoch_reader_register(struct epoch *e, struct epoch_reader *r);
+
+/* Unregister a reader.  Any items it still has retired are waited for and reclaimed first. */
+extern void epoch_reader_unregister(struct epoch_reader *r);
+
+/* Try to advance the global epoch and run the callbacks of any items retired by 'r' that are now safe.  Returns the
+   number of items reclaimed. */
+extern unsigned epoch_reclaim(struct epoch_reader *r);
+
+/* Wait until every item retired by 'r' so far can be reclaimed, and reclaim them.  Must not be called from inside a
+   critical section. */
+extern void epoch_synchronize(struct epoch_reader *r);
+
+/* Enter a read-side critical section.  Items reachable from shared structures will not be reclaimed until the
+   matching epoch_exit().  Critical sections may be nested. */
+static inline void epoch_enter(struct epoch_reader *r)
+{
+        if (r->nesting++ == 0) {
+                __atomic_store_n(&r->local, __atomic_load_n(&r->epoch->global, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+                /* Make our epoch visible before we read any shared pointers. */
+                __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        }
+}
+
+/* Leave a read-side critical section. */
+static inline void epoch_exit(struct epoch_reader *r)
+{
+        if (--r->nesting == 0)
+                __atomic_store_n(&r->local, 0, __ATOMIC_RELEASE);
+}
+
+/* Queue an item that has already been unlinked from every shared structure; 'fn' will be called on it once no reader
+   can still hold a reference. */
+static inline void epoch_retire(struct epoch_reader *r, struct epoch_deferred *d, void (*fn)(struct epoch_deferred *d))
+{
+        d->fn = fn;
+        /* The unlink must be ordered before we read the epoch, or we could stamp the item with a stale one. */
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        d->epoch = __atomic_load_n(&r->epoch->global, __ATOMIC_RELAXED);
+        dlist_insert_back(&r->retired, &d->link);
+
+        if (++r->num_retired >= EPOCH_RECLAIM_THRESHOLD)
+                epoch_reclaim(r);
+}
+
+
+
+#endif /* _EPOCH_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,225 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* hlist.h - Singly-headed intrusive list for hash buckets. */
+
+#ifndef _HLIST_H
+#define _HLIST_H
+
+#include <stddef.h>
+
+/* Like a dlist, but the head is a single pointer, so an array of mostly empty buckets takes half the memory.  The
+   price is that the list is not circular: there is no O(1) way to get at the tail, and iteration stops at NULL
+   rather than at the head.  Each node keeps a pointer to whatever points at it ('pprev', either the head's 'first' or
+   the previous node's 'next'), so a node can still be unlinked in O(1) without knowing which bucket it is in.
+
+   The _publish variants are for lists that readers walk without locks, with hlist_for_each_item_published() inside
+   epoch_enter()/epoch_exit() (see epoch.h).  Writers must still be serialized with each other.  A node is only made
+   visible once it is fully set up, and a deleted node keeps its 'next' so that readers standing on it can carry on;
+   it must go through epoch_retire() before it is reused or freed.
+
+   htable doesn't use this.  Its buckets are already single pointers to singly linked chains, and htable_delete()
+   finds the pointer to a node by walking the chain from the node's bucket (which it can get from the cached hash),
+   checking on the way that the node is in the table at all.  'pprev' would only add a pointer to every node. */
+
+struct hlist_node {
+        struct hlist_node *next;
+        struct hlist_node **pprev;
+};
+
+struct hlist_head {
+        struct hlist_node *first;
+};
+
+/* Extract pointer to an item that contains hlist linkage. */
+#define HLIST_ITEM(d,type,field)                                                \
+        ({                                                                      \
+                typeof(d) _dl = (d);                                            \
+                                                                                \
+                (_dl) ?                                                         \
+                        (type *) ((char *)_dl - offsetof(type, field))          \
+                        :                                                       \
+                        (type *)NULL;                                           \
+        })
+
+/* Initialize the head of an hlist. */
+static inline void hlist_init(struct hlist_head *head)
+{
+        head->first = NULL;
+}
+
+static inline int is_hlist_empty(struct hlist_head *head)
+{
+        return head->first == NULL;
+}
+
+static inline void hlist_clear(struct hlist_node *n)
+{
+        n->next = NULL;
+        n->pprev = NULL;
+}
+
+/* Is a node on a list?  Only meaningful for nodes that have been cleared or deleted since they were last used. */
+static inline int is_hlist_linked(struct hlist_node *n)
+{
+        return n->pprev != NULL;
+}
+
+static inline void hlist_insert_front(struct hlist_head *head, struct hlist_node *new)
+{
+        new->next = head->first;
+        new->pprev = &head->first;
+
+        if (new->next)
+                new->next->pprev = &new->next;
+        head->first = new;
+}
+
+static inline void hlist_insert_after(struct hlist_node *place, struct hlist_node *new)
+{
+        new->next = place->next;
+        new->pprev = &place->next;
+
+        if (new->next)
+                new->next->pprev = &new->next;
+        place->next = new;
+}
+
+static inline void hlist_insert_before(struct hlist_node *place, struct hlist_node *new)
+{
+        new->next = place;
+        new->pprev = place->pprev;
+
+        place->pprev = &new->next;
+        *new->pprev = new;
+}
+
+static inline void hlist_del(struct hlist_node *n)
+{
+        *n->pprev = n->next;
+        if (n->next)
+                n->next->pprev = n->pprev;
+
+        hlist_clear(n);
+}
+
+static inline struct hlist_node *hlist_pop_front(struct hlist_head *head)
+{
+        struct hlist_node *n = head->first;
+
+        if (n)
+                hlist_del(n);
+
+        return n;
+}
+
+/* Move every entry of 'list' onto the front of 'head', in order, leaving 'list' empty.  O(length of 'list'), since
+   the last entry has to be found. */
+static inline void hlist_splice_front(struct hlist_head *head, struct hlist_head *list)
+{
+        struct hlist_node *last;
+
+        if (is_hlist_empty(list))
+                return;
+
+        for (last = list->first; last->next; last = last->next)
+                ;
+
+        last->next = head->first;
+        if (last->next)
+                last->next->pprev = &last->next;
+        head->first = list->first;
+        head->first->pprev = &head->first;
+
+        hlist_init(list);
+}
+
+/* Insert a node that lock-free readers may see as soon as it is linked. */
+static inline void hlist_insert_front_publish(struct hlist_head *head, struct hlist_node *new)
+{
+        new->next = head->first;
+        new->pprev = &head->first;
+
+        if (new->next)
+                new->next->pprev = &new->next;
+        __atomic_store_n(&head->first, new, __ATOMIC_RELEASE);
+}
+
+static inline void hlist_insert_after_publish(struct hlist_node *place, struct hlist_node *new)
+{
+        new->next = place->next;
+        new->pprev = &place->next;
+
+        if (new->next)
+                new->next->pprev = &new->next;
+        __atomic_store_n(&place->next, new, __ATOMIC_RELEASE);
+}
+
+/* Unlink a node that lock-free readers may be looking at.  Its 'next' is left alone; only 'pprev' is cleared. */
+static inline void hlist_del_publish(struct hlist_node *n)
+{
+        __atomic_store_n(n->pprev, n->next, __ATOMIC_RELAXED);
+        if (n->next)
+                n->next->pprev = n->pprev;
+
+        n->pprev = NULL;
+}
+
+#define hlist_for_each(head, n)                                         \
+        for ((n) = (head)->first; (n); (n) = (n)->next)
+
+#define hlist_for_each_safe(head, n, nn)                                \
+        for ((n) = (head)->first, (nn) = (n) ? (n)->next : NULL;        \
+             (n);                                                       \
+             (n) = (nn), (nn) = (n) ? (n)->next : NULL)
+
+#define hlist_for_each_item(head, p, type, field)                       \
+        for ((p) = HLIST_ITEM((head)->first, type, field);              \
+             (p);                                                       \
+             (p) = HLIST_ITEM((p)->field.next, type, field))
+
+#define hlist_for_each_item_safe(head, p, pn, type, field)              \
+        for ((p) = HLIST_ITEM((head)->first, type, field),              \
+                     (pn) = (p) ?                                       \
+                     HLIST_ITEM((p)->field.next, type, field) : NULL;   \
+             (p);                                                       \
+             (p) = (pn),                                                \
+                     (pn) = (p) ?                                       \
+                     HLIST_ITEM((p)->field.next, type, field) : NULL)
+
+/* Walk a list that writers change with the _publish variants.  Must be used inside a read-side critical section. */
+#define hlist_for_each_item_published(head, p, type, field)             \
+        for ((p) = HLIST_ITEM(__atomic_load_n(&(head)->first,           \
+                                              __ATOMIC_ACQUIRE),        \
+                              type, field);                             \
+             (p);                                                       \
+             (p) = HLIST_ITEM(__atomic_load_n(&(p)->field.next,         \
+                                              __ATOMIC_ACQUIRE),        \
+                              type, field))
+
+
+#endif /* _HLIST_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
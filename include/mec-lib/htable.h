@@ -0,0 +1,138 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* htable.h - Intrusive hash table. */
+
+#ifndef _HTABLE_H
+#define _HTABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "mec-lib/crc.h"
+
+/* A chained hash table, for O(1) exact match lookups.  Like bst, items embed a struct htable_node and the table never
+   allocates anything for them; only the bucket arrays are allocated, through the ops.
+
+   The table doubles when it holds more items than buckets, and halves when it drops below an eighth of that.  Rather
+   than moving every item at once, which would make one insert take as long as all the ones before it, a resize
+   allocates the new bucket array and then every insert and delete moves a few buckets' worth of items across, until
+   the old array is empty and can be freed.  Lookups in the meantime check whichever array holds the bucket for the
+   key.  If a bucket array can't be allocated the table just doesn't resize (so lookups get slower), and doesn't try
+   again until the count has doubled or halved; only the first insert into an empty table can fail for lack of memory.
+
+   Each node caches its item's full hash, so moving it doesn't need to rehash the key, and lookups only call compare()
+   on items whose hash matches. */
+
+struct htable_node {
+        struct htable_node *next;
+        uint64_t hash;
+};
+
+/* Extract pointer to an item that contains a hash table node. */
+#define HTABLE_ITEM(d,type,field)                                               \
+        ({                                                                      \
+                typeof(d) _dl = (d);                                            \
+                                                                                \
+                (_dl) ?                                                         \
+                        (type *) ((char *)_dl - offsetof(type, field))          \
+                        :                                                       \
+                        (type *)NULL;                                           \
+        })
+
+struct htable_ops {
+        void *(*get_key)(struct htable_node *n);
+        uint64_t (*hash)(void *key);
+        int (*compare)(void *key_a, void *key_b);       /* Only needs to return 0 for equal keys, non-zero otherwise. */
+        struct htable_node **(*alloc_buckets)(size_t num_buckets);
+        void (*free_buckets)(struct htable_node **buckets, size_t num_buckets);
+};
+
+struct htable {
+        struct htable_ops *ops;
+        struct htable_node **buckets;
+        size_t mask;                            /* The number of buckets, minus one. */
+        struct htable_node **old_buckets;       /* While resizing: the array items are being moved out of. */
+        size_t old_mask;
+        size_t migrate_pos;                     /* Old buckets before this one have been moved. */
+        size_t count;
+        size_t resize_failed;                   /* The count when a bucket array last couldn't be allocated, or 0. */
+};
+
+/* The default hashes are CRC-32C, which is a few cycles for short keys on CPUs with SSE4.2.  They only have 32 bits,
+   which is plenty for bucket indexes. */
+static inline uint64_t htable_hash_bytes(const void *data, size_t len)
+{
+        return crc32c(0, data, len);
+}
+
+static inline uint64_t htable_hash_u64(uint64_t v)
+{
+        return crc32c(0, &v, sizeof(v));
+}
+
+static inline uint64_t htable_hash_string(const char *s)
+{
+        return crc32c(0, s, strlen(s));
+}
+
+
+
+/* Initalize a hash table.  No buckets are allocated until the first insert. */
+extern void htable_init(struct htable *ht, struct htable_ops *ops);
+
+/* Free the bucket arrays of a hash table.  The items are left alone, and the table is left empty. */
+extern void htable_destroy(struct htable *ht);
+
+/* Insert an item into a hash table.  Returns 0 on success, non-zero on error (the key is already present, or the first
+   bucket array could not be allocated). */
+extern int htable_insert(struct htable *ht, struct htable_node *n);
+
+/* Remove an item from a hash table.  Returns 0 on success, non-zero on error. */
+extern int htable_delete(struct htable *ht, struct htable_node *n);
+
+/* Find an item in a hash table.  Returns a pointer to the node, or NULL if item was not found. */
+extern struct htable_node *htable_find(struct htable *ht, void *key);
+
+/* Find many items at once: 'found[i]' is set to the node for 'keys[i]', or NULL.  The lookups are interleaved, with
+   the bucket and first item for each key prefetched before any are looked at, so their cache misses overlap instead of
+   happening one after another.  Worth using for more than a handful of keys in a table too big for the cache. */
+extern void htable_find_batch(struct htable *ht, void **keys, struct htable_node **found, size_t num_keys);
+
+/* Given a node, return the next node in the table, in no particular order.  If NULL is passed in, returns the first
+   node.  If no more nodes exist, returns NULL.  The table must not be changed during a walk. */
+extern struct htable_node *htable_next(struct htable *ht, struct htable_node *n);
+
+/* Return the number of items in a hash table. */
+static inline size_t htable_count(struct htable *ht)
+{
+        return ht->count;
+}
+
+
+
+#endif /* _HTABLE_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,141 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* lru.h - Sharded intrusive LRU cache. */
+
+#ifndef _LRU_H
+#define _LRU_H
+
+#include <pthread.h>
+#include "mec-lib/dlist.h"
+#include "mec-lib/htable.h"
+
+/* An lru_cache holds up to a fixed number of items, and when it is full, inserting a new one evicts the least
+   recently used.  Lookup, insert, delete and eviction are all O(1): each shard indexes its items in an htable and
+   keeps them in a dlist in order of use, most recent first.
+
+   The cache is split into shards by key hash, each with an equal share of the capacity, so threads working on
+   different keys rarely touch the same shard.  A hit doesn't move its item to the front of the list right away: that
+   writes to the list head and both of the item's neighbours, and would need the shard to itself.  Even a shared lock
+   would be a write to a cache line that every thread hitting the shard has to own in turn.  So each shard has
+   LRU_READERS reader slots, each in cache lines of its own with a lock and a hit buffer, and each thread uses the
+   same slot every time (threads are handed slots in turn).  A hit locks only its thread's slot, and records itself in
+   that slot's buffer with a plain store; as long as there are no more threads than slots, none of those lines are
+   written by anyone else.  Anything that changes the shard locks every slot, and first moves the buffered hits to
+   the front of the list: every insert and delete, and a hit that finds its own buffer full.
+
+   Since the buffers are always applied before anything is evicted, the eviction order is close to exact LRU: each
+   thread's hits keep their order, but hits buffered by different threads are applied a slot at a time rather than
+   interleaved, and a hit on the item already at the front of the list isn't recorded.  Inserts and deletes pay for
+   this by taking LRU_READERS locks, so the cache suits workloads that are mostly hits.  This has only been measured
+   on a single CPU, where it can't show the scaling it is meant for; bench-lru compares it against a single mutex.
+
+   Items embed a struct lru_node.  The ops include htable_ops for the index, whose get_key() is passed the 'index'
+   field of the lru_node (so HTABLE_ITEM(n, struct item, lru.index) recovers the item). */
+
+/* Reader slots per shard, and hits buffered per slot before they are applied. */
+#define LRU_READERS     8
+#define LRU_HIT_BUFFER  16
+
+struct lru_node {
+        struct htable_node index;
+        struct dlist list;
+};
+
+/* Extract pointer to an item that contains an lru node. */
+#define LRU_ITEM(d,type,field)                                                  \
+        ({                                                                      \
+                typeof(d) _dl = (d);                                            \
+                                                                                \
+                (_dl) ?                                                         \
+                        (type *) ((char *)_dl - offsetof(type, field))          \
+                        :                                                       \
+                        (type *)NULL;                                           \
+        })
+
+struct lru_ops {
+        struct htable_ops index;
+
+        /* Called when an item is evicted to make room for another, with the whole shard locked, so it must not call
+           back into the cache.  The item may be freed once this returns, unless a thread that found it still holds
+           it. */
+        void (*evict)(struct lru_node *n);
+
+        /* Optional.  Called by lru_find() on the item found, with the thread's reader slot locked, so that the caller
+           can take a reference to it before it can be evicted.  Other threads may be calling it at the same time, even
+           on the same item, so it must be thread-safe (an atomic reference count, say). */
+        void (*hold)(struct lru_node *n);
+};
+
+struct lru_reader {
+        pthread_mutex_t lock;
+        unsigned hit_count;
+        struct lru_node *hits[LRU_HIT_BUFFER];  /* Oldest first. */
+} __attribute__((aligned(64)));
+
+struct lru_shard {
+        struct lru_reader readers[LRU_READERS];
+        struct htable index;
+        struct dlist list;                      /* Most recently used first. */
+        size_t capacity;
+} __attribute__((aligned(64)));
+
+struct lru_cache {
+        struct lru_ops *ops;
+        struct lru_shard *shards;
+        unsigned num_shards;
+};
+
+
+
+/* Initialize an LRU cache that holds up to 'capacity' items, using a caller-supplied array of shards.  Each shard
+   holds capacity / num_shards items (at least 1). */
+extern void lru_init(struct lru_cache *c, struct lru_ops *ops, struct lru_shard *shards, unsigned num_shards,
+                     size_t capacity);
+
+/* Release the locks and indexes of an LRU cache.  The items still in it are left alone. */
+extern void lru_destroy(struct lru_cache *c);
+
+/* Insert an item into an LRU cache, as the most recently used, evicting the least recently used item of its shard if
+   that is full.  Returns 0 on success, non-zero on error (the key is already present, or the index could not be
+   allocated). */
+extern int lru_insert(struct lru_cache *c, struct lru_node *n);
+
+/* Remove an item from an LRU cache, without calling evict().  Returns 0 on success, non-zero on error. */
+extern int lru_delete(struct lru_cache *c, struct lru_node *n);
+
+/* Find an item in an LRU cache, and mark it as used.  Returns a pointer to the node, or NULL if item was not found.
+   Unless the ops have a hold(), the caller must make sure by other means that the item isn't evicted and freed while
+   it is using it. */
+extern struct lru_node *lru_find(struct lru_cache *c, void *key);
+
+/* Return the number of items in an LRU cache. */
+extern size_t lru_count(struct lru_cache *c);
+
+
+
+#endif /* _LRU_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,102 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* mpsc.h - Lock-free intrusive multi-producer single-consumer queue. */
+
+#ifndef _MPSC_H
+#define _MPSC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mec-lib/dlist.h"
+
+/* Items are queued by the struct dlist they already embed, so anything that was passed around on a dlist can go
+   through a queue instead, and DLIST_ITEM() gets the item back.  Only the 'next' pointer is used while an item is
+   queued.
+
+   This is Dmitry Vyukov's intrusive MPSC queue: mpsc_push() is one atomic exchange and a store, so producers never
+   wait for each other or for the consumer.  The catch is that a producer that has done its exchange but not yet its
+   store briefly hides the items queued after it, so mpsc_pop() can return NULL while the queue isn't empty.  Anything
+   it misses is seen on a later call.  See:
+   https://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+
+   Only one thread at a time may call mpsc_pop(), mpsc_pop_all() and mpsc_wait().  Any number may call mpsc_push().
+
+   A consumer with nothing to do can sleep in mpsc_wait() until something is pushed.  That costs producers a load of a
+   flag on a cacheline they have just written anyway, plus a futex wake when the consumer is actually asleep. */
+
+struct mpsc_queue {
+        /* Written by producers. */
+        struct dlist *tail __attribute__((aligned(64)));
+        uint32_t waiting;               /* Non-zero while the consumer is (about to be) asleep in mpsc_wait(). */
+
+        /* Used by the consumer. */
+        struct dlist *head __attribute__((aligned(64)));
+        struct dlist stub;
+};
+
+
+
+/* Initialize an empty queue. */
+extern void mpsc_init(struct mpsc_queue *q);
+
+/* Wake the consumer.  Used by mpsc_push(). */
+extern void mpsc_wake(struct mpsc_queue *q);
+
+/* Add an item to the back of a queue. */
+static inline void mpsc_push(struct mpsc_queue *q, struct dlist *n)
+{
+        struct dlist *prev;
+
+        __atomic_store_n(&n->next, NULL, __ATOMIC_RELAXED);
+        prev = __atomic_exchange_n(&q->tail, n, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&prev->next, n, __ATOMIC_RELEASE);
+
+        if (__atomic_load_n(&q->waiting, __ATOMIC_SEQ_CST))
+                mpsc_wake(q);
+}
+
+/* Remove the item at the front of a queue.  Returns NULL if the queue is empty, or a producer is part way through
+   pushing the item that would be next. */
+extern struct dlist *mpsc_pop(struct mpsc_queue *q);
+
+/* Remove every item that can be removed from a queue, and append them to the dlist 'out' in order.  Returns the number
+   of items removed. */
+extern size_t mpsc_pop_all(struct mpsc_queue *q, struct dlist *out);
+
+/* Return non-zero if a queue has no items in it (though producers may be about to add some).  Only for the consumer. */
+static inline int mpsc_is_empty(struct mpsc_queue *q)
+{
+        return (q->head == &q->stub) && (__atomic_load_n(&q->tail, __ATOMIC_SEQ_CST) == &q->stub);
+}
+
+/* Sleep until a queue has items in it.  Returns straight away if it already does. */
+extern void mpsc_wait(struct mpsc_queue *q);
+
+
+
+#endif /* _MPSC_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,105 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* pheap.h - Pairing heap. */
+
+#ifndef _PHEAP_H
+#define _PHEAP_H
+
+#include <stddef.h>
+
+/* A priority queue that always knows its smallest item.  Inserting, melding two heaps and decreasing a key are O(1),
+   and removing the smallest item (or any other) is O(log n) amortized.  Nothing is ever rebalanced: items are just
+   linked under each other, and the work of sorting them out is done by pheap_pop(), which pairs up the children of
+   the item it removes in two passes.  See:
+   https://www.cs.cmu.edu/~sleator/papers/pairing-heaps.pdf
+
+   Items may have equal keys; which of them comes out first is unspecified. */
+
+struct pheap_node {
+        struct pheap_node *child;       /* Leftmost child. */
+        struct pheap_node *next;        /* Next sibling. */
+        struct pheap_node *prev;        /* Previous sibling, or parent if this is the leftmost child. */
+};
+
+/* Extract pointer to an item that contains a pheap node. */
+#define PHEAP_ITEM(d,type,field)                                                \
+        ({                                                                      \
+                typeof(d) _dl = (d);                                            \
+                                                                                \
+                (_dl) ?                                                         \
+                        (type *) ((char *)_dl - offsetof(type, field))          \
+                        :                                                       \
+                        (type *)NULL;                                           \
+        })
+
+struct pheap_ops {
+        void *(*get_key)(struct pheap_node *n);
+        int (*compare)(void *key_a, void *key_b);
+};
+
+struct pheap {
+        struct pheap_ops *ops;
+        struct pheap_node *root;
+        size_t count;
+};
+
+
+
+/* Initialize an empty heap. */
+extern void pheap_init(struct pheap *h, struct pheap_ops *ops);
+
+/* Add an item to a heap. */
+extern void pheap_insert(struct pheap *h, struct pheap_node *n);
+
+/* Return the item with the smallest key, or NULL if the heap is empty. */
+static inline struct pheap_node *pheap_min(struct pheap *h)
+{
+        return h->root;
+}
+
+/* Remove and return the item with the smallest key, or NULL if the heap is empty. */
+extern struct pheap_node *pheap_pop(struct pheap *h);
+
+/* Remove any item from a heap. */
+extern void pheap_delete(struct pheap *h, struct pheap_node *n);
+
+/* Move an item to where it belongs after its key has been made smaller (or left the same). */
+extern void pheap_decrease(struct pheap *h, struct pheap_node *n);
+
+/* Move every item of 'other', which must use the same ops, into 'h', leaving 'other' empty. */
+extern void pheap_meld(struct pheap *h, struct pheap *other);
+
+/* Return the number of items in a heap. */
+static inline size_t pheap_count(struct pheap *h)
+{
+        return h->count;
+}
+
+
+
+#endif /* _PHEAP_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,142 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* pool.h - Slab allocator for fixed size objects. */
+
+#ifndef _POOL_H
+#define _POOL_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+/* A pool hands out objects of one size, carved from large slabs that it maps from the kernel, so that objects
+   allocated together - the nodes of a tree built in one go, say - end up next to each other in memory instead of
+   scattered over the heap, and walking them touches fewer cache lines and pages.
+
+   Each thread that uses a pool registers a pool_cache, a magazine of free objects that allocations and frees work on
+   without any locking.  Only when a thread's magazine runs empty or fills up does it take the pool's lock, to swap a
+   batch of POOL_BATCH objects with the pool's shared stack of batches (which is O(1) however big the batch is).  An
+   object may be freed by a different thread from the one that allocated it.
+
+   Memory is only given back to the system by pool_destroy(), which frees every object in the pool at once.  So a
+   structure whose nodes all come from one pool can be thrown away without walking it.
+
+   Flags:
+   - POOL_CACHELINE_ALIGN rounds the object size up to a multiple of the cache line size, so that each object starts
+     on a cache line and no two objects share one (for objects that different threads write to).  Otherwise objects
+     are packed as tightly as POOL_ALIGN allows.
+   - POOL_HUGE_PAGES uses 2MB slabs, backed by huge pages if the system has any reserved, and otherwise aligned to 2MB
+     and marked for transparent huge pages.  This saves TLB misses when walking a large structure. */
+
+#define POOL_CACHELINE_ALIGN    0x1
+#define POOL_HUGE_PAGES         0x2
+
+/* Objects are aligned to at least this, like malloc()'s. */
+#define POOL_ALIGN              16
+
+#define POOL_SLAB_SIZE          (64 * 1024)
+#define POOL_HUGE_SLAB_SIZE     (2 * 1024 * 1024)
+
+/* Objects moved between a pool_cache and its pool at a time, and the most a pool_cache holds. */
+#define POOL_BATCH              32
+#define POOL_MAGAZINE_SIZE      (2 * POOL_BATCH)
+
+struct pool_slab;
+struct pool_batch;
+
+struct pool {
+        size_t obj_size;
+        size_t slab_size;
+        int flags;
+        pthread_mutex_t lock;
+        struct pool_batch *batches;     /* Stack of batches of free objects. */
+        struct pool_slab *slabs;        /* Every slab, most recent first. */
+        char *carve;                    /* Unused space at the end of the most recent slab. */
+        char *carve_end;
+        size_t num_slabs;
+};
+
+/* One of these per thread per pool. */
+struct pool_cache {
+        struct pool *pool;
+        unsigned count;
+        void *objs[POOL_MAGAZINE_SIZE];
+} __attribute__((aligned(64)));
+
+
+
+/* Initialize a pool of objects of 'obj_size' bytes.  'flags' is any of POOL_CACHELINE_ALIGN and POOL_HUGE_PAGES.
+   Returns 0 on success, or non-zero if 'obj_size' is more than a quarter of the slab size. */
+extern int pool_init(struct pool *p, size_t obj_size, int flags);
+
+/* Free every object in a pool at once, and give its memory back to the system.  Every pool_cache for it must have been
+   flushed, or not be used again. */
+extern void pool_destroy(struct pool *p);
+
+/* Register a thread's cache for a pool.  This must be done before the cache is used. */
+extern void pool_cache_init(struct pool *p, struct pool_cache *c);
+
+/* Give the objects in a cache back to its pool, for other threads to use; for example before a thread exits. */
+extern void pool_cache_flush(struct pool_cache *c);
+
+/* Refill an empty cache from its pool.  Used by pool_alloc(). */
+extern int pool_cache_refill(struct pool_cache *c);
+
+/* Hand a batch of objects from a full cache back to its pool.  Used by pool_free(). */
+extern void pool_cache_drain(struct pool_cache *c);
+
+/* Allocate an object.  Returns NULL if the pool needed a new slab and couldn't map one.  The object's contents are
+   undefined. */
+static inline void *pool_alloc(struct pool_cache *c)
+{
+        if ((c->count == 0) && pool_cache_refill(c))
+                return NULL;
+
+        return c->objs[--c->count];
+}
+
+/* Free an object, which must have come from the same pool. */
+static inline void pool_free(struct pool_cache *c, void *obj)
+{
+        if (c->count == POOL_MAGAZINE_SIZE)
+                pool_cache_drain(c);
+
+        c->objs[c->count++] = obj;
+}
+
+/* Free many objects at once. */
+extern void pool_free_bulk(struct pool_cache *c, void **objs, size_t num_objs);
+
+/* Return the number of bytes of slabs a pool has mapped. */
+static inline size_t pool_size(struct pool *p)
+{
+        return __atomic_load_n(&p->num_slabs, __ATOMIC_RELAXED) * p->slab_size;
+}
+
+
+
+#endif /* _POOL_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
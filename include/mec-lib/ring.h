@@ -0,0 +1,249 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* ring.h - Bounded lock-free ring buffers. */
+
+#ifndef _RING_H
+#define _RING_H
+
+#include <stddef.h>
+#include <string.h>
+#include "mec-lib/util.h"
+
+/* Fixed capacity queues of fixed size elements, for passing data between threads without locks or allocation.  The
+   caller supplies the storage, and the number of slots must be a power of two.  Elements are copied in and out, or
+   written and read in place: reserve slots, fill them in and commit them on the producer side; peek at filled slots,
+   use them and release them on the consumer side.  Each side has a bulk version of each operation, which costs about
+   the same as a single one, so passing elements in batches amortizes the synchronization.
+
+   An spsc_ring has one producer thread and one consumer thread.  Each side keeps its own index on its own cacheline,
+   along with a cached copy of the other side's, and only reads the other side's cacheline when the cached copy says
+   the ring is full (or empty).
+
+   An mpmc_ring allows any number of producers and consumers.  It is Dmitry Vyukov's bounded MPMC queue: each slot has
+   a sequence number that says which lap of the ring it is ready for, so a producer or consumer claims a slot with one
+   compare and swap and hands it over with one store, without waiting for other threads working on other slots.  See:
+   https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue */
+
+struct spsc_ring {
+        /* Used by the producer. */
+        size_t tail __attribute__((aligned(64)));
+        size_t head_cache;
+
+        /* Used by the consumer. */
+        size_t head __attribute__((aligned(64)));
+        size_t tail_cache;
+
+        /* Read only. */
+        char *slots __attribute__((aligned(64)));
+        size_t mask;
+        size_t elem_size;
+};
+
+/* Size of each slot of an mpmc_ring, for elements of 'elem_size' bytes. */
+#define MPMC_RING_SLOT_SIZE(elem_size) MEC_ALIGN_UP(sizeof(size_t) + (elem_size), sizeof(size_t))
+
+struct mpmc_ring {
+        size_t enqueue_pos __attribute__((aligned(64)));
+        size_t dequeue_pos __attribute__((aligned(64)));
+
+        /* Read only. */
+        char *slots __attribute__((aligned(64)));
+        size_t mask;
+        size_t slot_size;
+        size_t elem_size;
+};
+
+
+
+/* Initialize an empty ring using 'slots', which holds 'num_slots' elements of 'elem_size' bytes each.  Returns 0 on
+   success, non-zero if 'num_slots' is not a power of two. */
+extern int spsc_ring_init(struct spsc_ring *r, void *slots, size_t num_slots, size_t elem_size);
+
+/* Find up to 'n' free slots that follow one another in memory.  Returns how many there are (0 if the ring is full),
+   and sets '*slots' to the first.  Fewer than 'n' may be returned where the ring wraps around, even if more are free.
+   Only for the producer. */
+static inline size_t spsc_reserve(struct spsc_ring *r, void **slots, size_t n)
+{
+        size_t size = r->mask + 1;
+        size_t idx = r->tail & r->mask;
+
+        if (size - (r->tail - r->head_cache) < n)
+                r->head_cache = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+        n = MEC_MIN(n, size - (r->tail - r->head_cache));
+        n = MEC_MIN(n, size - idx);
+        *slots = r->slots + idx * r->elem_size;
+
+        return n;
+}
+
+/* Hand the next 'n' reserved slots to the consumer. */
+static inline void spsc_commit(struct spsc_ring *r, size_t n)
+{
+        __atomic_store_n(&r->tail, r->tail + n, __ATOMIC_RELEASE);
+}
+
+/* Find up to 'n' filled slots that follow one another in memory.  Returns how many there are (0 if the ring is
+   empty), and sets '*slots' to the first.  Only for the consumer. */
+static inline size_t spsc_peek(struct spsc_ring *r, void **slots, size_t n)
+{
+        size_t idx = r->head & r->mask;
+
+        if (r->tail_cache - r->head < n)
+                r->tail_cache = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+
+        n = MEC_MIN(n, r->tail_cache - r->head);
+        n = MEC_MIN(n, r->mask + 1 - idx);
+        *slots = r->slots + idx * r->elem_size;
+
+        return n;
+}
+
+/* Hand the next 'n' slots the consumer has finished with back to the producer. */
+static inline void spsc_release(struct spsc_ring *r, size_t n)
+{
+        __atomic_store_n(&r->head, r->head + n, __ATOMIC_RELEASE);
+}
+
+/* Copy an element into a ring.  Returns 0 on success, non-zero if the ring is full. */
+static inline int spsc_push(struct spsc_ring *r, const void *elem)
+{
+        void *slot;
+
+        if (spsc_reserve(r, &slot, 1) == 0)
+                return -1;
+
+        memcpy(slot, elem, r->elem_size);
+        spsc_commit(r, 1);
+
+        return 0;
+}
+
+/* Copy an element out of a ring.  Returns 0 on success, non-zero if the ring is empty. */
+static inline int spsc_pop(struct spsc_ring *r, void *elem)
+{
+        void *slot;
+
+        if (spsc_peek(r, &slot, 1) == 0)
+                return -1;
+
+        memcpy(elem, slot, r->elem_size);
+        spsc_release(r, 1);
+
+        return 0;
+}
+
+/* Copy up to 'n' elements from the array 'elems' into a ring.  Returns how many were copied. */
+extern size_t spsc_push_bulk(struct spsc_ring *r, const void *elems, size_t n);
+
+/* Copy up to 'n' elements out of a ring into the array 'elems'.  Returns how many were copied. */
+extern size_t spsc_pop_bulk(struct spsc_ring *r, void *elems, size_t n);
+
+
+
+/* Initialize an empty ring using 'slots', which must be 'num_slots' * MPMC_RING_SLOT_SIZE('elem_size') bytes, aligned
+   to sizeof(size_t).  Returns 0 on success, non-zero if 'num_slots' is not a power of two of at least 2. */
+extern int mpmc_ring_init(struct mpmc_ring *r, void *slots, size_t num_slots, size_t elem_size);
+
+/* Return the element for a ticket from mpmc_reserve() or mpmc_peek(). */
+static inline void *mpmc_slot(struct mpmc_ring *r, size_t ticket)
+{
+        return r->slots + (ticket & r->mask) * r->slot_size + sizeof(size_t);
+}
+
+/* Return the sequence number of the slot for a ticket. */
+static inline size_t *mpmc_seq(struct mpmc_ring *r, size_t ticket)
+{
+        return (size_t *)(r->slots + (ticket & r->mask) * r->slot_size);
+}
+
+/* Claim up to 'n' free slots.  Returns how many were claimed (0 if the ring is full), and sets '*ticket' to the
+   ticket of the first; the others have the tickets that follow it.  Each must be handed to consumers with
+   mpmc_commit(), and consumers may have to wait for earlier ones before they see later ones, so fill them in
+   promptly. */
+extern size_t mpmc_reserve(struct mpmc_ring *r, size_t *ticket, size_t n);
+
+/* Hand 'n' claimed slots, from 'ticket' on, to consumers. */
+static inline void mpmc_commit(struct mpmc_ring *r, size_t ticket, size_t n)
+{
+        size_t i;
+
+        for (i=0; i<n; i++)
+                __atomic_store_n(mpmc_seq(r, ticket + i), ticket + i + 1, __ATOMIC_RELEASE);
+}
+
+/* Claim up to 'n' filled slots.  Returns how many were claimed (0 if the ring is empty), and sets '*ticket' to the
+   ticket of the first. */
+extern size_t mpmc_peek(struct mpmc_ring *r, size_t *ticket, size_t n);
+
+/* Hand 'n' claimed slots, from 'ticket' on, back to producers. */
+static inline void mpmc_release(struct mpmc_ring *r, size_t ticket, size_t n)
+{
+        size_t i;
+
+        for (i=0; i<n; i++)
+                __atomic_store_n(mpmc_seq(r, ticket + i), ticket + i + r->mask + 1, __ATOMIC_RELEASE);
+}
+
+/* Copy an element into a ring.  Returns 0 on success, non-zero if the ring is full. */
+static inline int mpmc_push(struct mpmc_ring *r, const void *elem)
+{
+        size_t ticket;
+
+        if (mpmc_reserve(r, &ticket, 1) == 0)
+                return -1;
+
+        memcpy(mpmc_slot(r, ticket), elem, r->elem_size);
+        mpmc_commit(r, ticket, 1);
+
+        return 0;
+}
+
+/* Copy an element out of a ring.  Returns 0 on success, non-zero if the ring is empty. */
+static inline int mpmc_pop(struct mpmc_ring *r, void *elem)
+{
+        size_t ticket;
+
+        if (mpmc_peek(r, &ticket, 1) == 0)
+                return -1;
+
+        memcpy(elem, mpmc_slot(r, ticket), r->elem_size);
+        mpmc_release(r, ticket, 1);
+
+        return 0;
+}
+
+/* Copy up to 'n' elements from the array 'elems' into a ring.  Returns how many were copied. */
+extern size_t mpmc_push_bulk(struct mpmc_ring *r, const void *elems, size_t n);
+
+/* Copy up to 'n' elements out of a ring into the array 'elems'.  Returns how many were copied. */
+extern size_t mpmc_pop_bulk(struct mpmc_ring *r, void *elems, size_t n);
+
+
+
+#endif /* _RING_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,153 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* skiplist.h - Lock-free concurrent skip list. */
+
+#ifndef _SKIPLIST_H
+#define _SKIPLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mec-lib/epoch.h"
+
+/* An ordered set that any number of threads can insert into, delete from and search at once, without locks.  See
+   Fraser's "Practical lock-freedom" (the same report as epoch.h) and chapter 14 of Herlihy and Shavit's "The Art of
+   Multiprocessor Programming".
+
+   Each item embeds a struct skiplist_node, which must be the last member of the item since it ends in a variable
+   number of next pointers: allocate SKIPLIST_NODE_SIZE(height) bytes for it, and pick the height with
+   skiplist_random_height().  Keys are unique; inserting a key that is already there fails.
+
+   An item is deleted by marking its next pointers (the low bit), which stops anyone linking anything after it; the
+   thread whose mark lands on the bottom level owns the delete, and whoever next walks past the item unlinks it.  Once
+   it has been unlinked from every level it is handed to epoch_retire(), and ops->reclaim() is called on its
+   'deferred' after every reader that might have seen it has left its critical section.  Only then may the item be
+   freed or inserted again.
+
+   Lookups must be done inside epoch_enter()/epoch_exit() on a registered reader, and the nodes they return are only
+   valid until the matching epoch_exit().  They never write to shared memory.  Inserts and deletes take the calling
+   thread's reader and enter a critical section of their own.
+
+   The key of an item must not change while it is in the list or waiting to be reclaimed. */
+
+#define SKIPLIST_MAX_HEIGHT 32
+
+struct skiplist_node {
+        struct epoch_deferred deferred;
+        unsigned height;
+        unsigned refs;                          /* The inserter and the deleter each hold one while they work. */
+        struct skiplist_node *next[];
+};
+
+/* Bytes needed for a node with 'height' levels. */
+#define SKIPLIST_NODE_SIZE(height) (sizeof(struct skiplist_node) + (height) * sizeof(struct skiplist_node *))
+
+/* Extract pointer to an item that contains a skiplist node. */
+#define SKIPLIST_ITEM(d,type,field)                                             \
+        ({                                                                      \
+                typeof(d) _dl = (d);                                            \
+                                                                                \
+                (_dl) ?                                                         \
+                        (type *) ((char *)_dl - offsetof(type, field))          \
+                        :                                                       \
+                        (type *)NULL;                                           \
+        })
+
+struct skiplist_ops {
+        void *(*get_key)(struct skiplist_node *n);
+        int (*compare)(void *key_a, void *key_b);
+
+        /* Called on a deleted node's 'deferred' once no reader can still see it. */
+        void (*reclaim)(struct epoch_deferred *d);
+};
+
+struct skiplist {
+        struct skiplist_ops *ops;
+        struct skiplist_node *head[SKIPLIST_MAX_HEIGHT];
+};
+
+/* Visit every item of a skip list in order.  Must be used inside a critical section. */
+#define skiplist_for_each(sl, n)                                                \
+        for ((n) = skiplist_next((sl), NULL); (n); (n) = skiplist_next((sl), (n)))
+
+/* Pick a height for a new node: 1, and then one more with probability 1/4 each time.  'state' is the caller's own
+   (per-thread) random state, which must not be 0. */
+static inline unsigned skiplist_random_height(uint64_t *state)
+{
+        uint64_t x = *state;
+
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        *state = x;
+
+        return __builtin_ctzll(x | (1ULL << (2 * (SKIPLIST_MAX_HEIGHT - 1)))) / 2 + 1;
+}
+
+
+
+/* Initialize an empty skip list. */
+extern void skiplist_init(struct skiplist *sl, struct skiplist_ops *ops);
+
+/* Set the height of a node before it is inserted.  'height' must be from 1 to SKIPLIST_MAX_HEIGHT, and the node must
+   have room for it. */
+extern void skiplist_node_init(struct skiplist_node *n, unsigned height);
+
+/* Insert an item into a skip list.  Returns 0 on success, non-zero if an item with the same key is already there. */
+extern int skiplist_insert(struct skiplist *sl, struct epoch_reader *r, struct skiplist_node *n);
+
+/* Delete an item from a skip list.  Returns 0 if this call deleted it, non-zero if it had already been deleted. */
+extern int skiplist_delete(struct skiplist *sl, struct epoch_reader *r, struct skiplist_node *n);
+
+/* Find an item in a skip list.  Returns a pointer to the node, or NULL if item was not found. */
+extern struct skiplist_node *skiplist_find(struct skiplist *sl, void *key);
+
+/* Find the smallest item in a skip list whose key is greater than or equal to 'key'.  Returns NULL if no such item is
+   found. */
+extern struct skiplist_node *skiplist_find_smallest_gte(struct skiplist *sl, void *key);
+
+/* Find the largest item in a skip list whose key is less than or equal to 'key'.  Returns NULL if no such item is
+   found. */
+extern struct skiplist_node *skiplist_find_largest_lte(struct skiplist *sl, void *key);
+
+/* Given a node, return a pointer to the node in the list with the next highest key.  If NULL is passed in, returns a
+   pointer to the node with the smallest key.  If no more nodes exist, returns NULL.  'n' may have been deleted since
+   it was returned (as long as it has not been reclaimed).  This is O(1) unless 'n' has been deleted. */
+extern struct skiplist_node *skiplist_next(struct skiplist *sl, struct skiplist_node *n);
+
+/* Given a node, return a pointer to the node in the list with the next lowest key.  If NULL is passed in, returns a
+   pointer to the node with the largest key.  If no more nodes exist, returns NULL.  The list is only linked forwards,
+   so this searches from the top, in O(log n). */
+extern struct skiplist_node *skiplist_prev(struct skiplist *sl, struct skiplist_node *n);
+
+/* Return the number of items in a skip list.  Note that this walks the whole list, so it is O(n), and only exact if
+   nothing is changing it.  Must be called inside a critical section. */
+extern size_t skiplist_count(struct skiplist *sl);
+
+
+
+#endif /* _SKIPLIST_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
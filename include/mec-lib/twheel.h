@@ -0,0 +1,125 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* twheel.h - Hierarchical timer wheel. */
+
+#ifndef _TWHEEL_H
+#define _TWHEEL_H
+
+#include <stdint.h>
+#include "mec-lib/dlist.h"
+
+/* Timers are kept in buckets by when they expire, rather than sorted, so arming, re-arming and cancelling one is O(1):
+   a dlist_insert_back() and a dlist_del().  Time is in ticks, of whatever length the caller likes.
+
+   Level 0 of the wheel has a bucket for each of the next TWHEEL_SLOTS ticks, level 1 a bucket for each of the next
+   TWHEEL_SLOTS blocks of TWHEEL_SLOTS ticks, and so on.  Whenever time moves into a new block, the level 1 bucket for
+   that block is emptied into level 0, sorting its timers out to the tick; and so on up the levels.  Each timer is
+   moved at most once per level, and only if it is still armed by then, so timers that are usually re-armed or
+   cancelled before they go off (timeouts, say) cost next to nothing.  Timers more than 2^(TWHEEL_BITS *
+   TWHEEL_LEVELS) - 1 ticks away have their 'expires' brought in to the end of that range.
+
+   twheel_advance() hands every timer that has expired to the caller at once, on a dlist, in tick order.  Timers stay
+   on that list until the caller takes them off it, re-arms them or cancels them.  See:
+   http://www.cs.columbia.edu/~nahum/w6998/papers/sosp87-timing-wheels.pdf */
+
+#define TWHEEL_BITS     6
+#define TWHEEL_SLOTS    (1 << TWHEEL_BITS)
+#define TWHEEL_LEVELS   8
+
+struct twheel_timer {
+        struct dlist link;
+        uint64_t expires;
+};
+
+/* Extract pointer to an item that contains a timer. */
+#define TWHEEL_ITEM(d,type,field)                                               \
+        ({                                                                      \
+                typeof(d) _dl = (d);                                            \
+                                                                                \
+                (_dl) ?                                                         \
+                        (type *) ((char *)_dl - offsetof(type, field))          \
+                        :                                                       \
+                        (type *)NULL;                                           \
+        })
+
+struct twheel {
+        uint64_t now;                                   /* The next tick to be processed. */
+        uint64_t occupied[TWHEEL_LEVELS];               /* Bit i set if slot i may have timers in it. */
+        struct dlist slots[TWHEEL_LEVELS][TWHEEL_SLOTS];
+};
+
+
+
+/* Initialize an empty timer wheel, whose first tick is 'now'. */
+extern void twheel_init(struct twheel *w, uint64_t now);
+
+/* Initialize a timer that isn't armed. */
+static inline void twheel_timer_init(struct twheel_timer *t)
+{
+        dlist_clear(&t->link);
+}
+
+/* Return non-zero if a timer is armed, or has expired and is still on the caller's list. */
+static inline int twheel_timer_pending(struct twheel_timer *t)
+{
+        return t->link.next != NULL;
+}
+
+/* Put an unlinked timer in the right slot.  Used by twheel_arm(). */
+extern void twheel_add(struct twheel *w, struct twheel_timer *t);
+
+/* Arm a timer to expire at tick 'expires', or re-arm it if it is already armed.  A time before the wheel's current
+   one expires on the next twheel_advance(). */
+static inline void twheel_arm(struct twheel *w, struct twheel_timer *t, uint64_t expires)
+{
+        if (twheel_timer_pending(t))
+                dlist_del(&t->link);
+
+        t->expires = expires;
+        twheel_add(w, t);
+}
+
+/* Disarm a timer.  Returns non-zero if it was pending. */
+static inline int twheel_cancel(struct twheel_timer *t)
+{
+        if (!twheel_timer_pending(t))
+                return 0;
+
+        dlist_del(&t->link);
+
+        return 1;
+}
+
+/* Move time forward to tick 'now', and move every timer that expires up to and including then to the back of the
+   dlist 'expired'.  Returns the number of timers expired.  Empty stretches of time are skipped over a slot at a time,
+   not a tick at a time.  A 'now' earlier than the last one does nothing, and the last tick is UINT64_MAX - 1. */
+extern unsigned long twheel_advance(struct twheel *w, uint64_t now, struct dlist *expired);
+
+
+
+#endif /* _TWHEEL_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
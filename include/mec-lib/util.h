@@ -30,6 +30,26 @@
                 (_a < _b) ? _a : _b;            \
         })
 
+#define MEC_MAX(a,b)                            \
+        ({                                      \
+                typeof(a) _a = (a);             \
+                typeof(b) _b = (b);             \
+                                                \
+                (_a > _b) ? _a : _b;            \
+        })
+
+/* Round 'x' up to a multiple of 'align', which must be a power of two. */
+#define MEC_ALIGN_UP(x, align) (((x) + ((align) - 1)) & ~((typeof(x))(align) - 1))
+
+/* Hint to the CPU that we are spinning on a memory location. */
+#if defined(__i386__) || defined(__x86_64__)
+#define MEC_CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define MEC_CPU_RELAX() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define MEC_CPU_RELAX() __asm__ __volatile__("" ::: "memory")
+#endif
+
 
 
 #endif /* _UTIL_H */
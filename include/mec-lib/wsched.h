@@ -0,0 +1,141 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* wsched.h - Work-stealing fork/join task scheduler. */
+
+#ifndef _WSCHED_H
+#define _WSCHED_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* A fixed set of worker threads that run tasks.  A task may spawn child tasks, which go on the running worker's own
+   deque, and later sync, which waits for all of its children to finish - running them itself if nobody has stolen
+   them, and stealing other work while it waits.  Idle workers steal the oldest task from a random worker's deque, so
+   big pieces of work get split up between workers and small ones stay where they were made.  Each worker's deque is
+   a Chase-Lev deque: the owner pushes and pops at one end without any atomic read-modify-write unless it is down to
+   its last task, and thieves take from the other end with a compare and swap.  See:
+   https://www.di.ens.fr/~zappa/readings/ppopp13.pdf
+
+   Tasks are intrusive: embed a struct wsched_task in whatever describes the work, and get it back with WSCHED_ITEM().
+   Nothing is allocated; a child task can live on the stack of the task that spawns it, since that task syncs before
+   returning.  If a worker's deque is full, spawning just runs the child straight away.
+
+   Work is started with wsched_run(), from a thread outside the scheduler, which becomes worker 0 until the task is
+   done.  Worker threads that find nothing to steal for a while go to sleep until something is spawned. */
+
+/* Most spawned tasks a worker can have waiting. */
+#define WSCHED_DEQUE_SIZE       1024
+
+struct wsched_worker;
+
+struct wsched_task {
+        void (*fn)(struct wsched_task *t, struct wsched_worker *w);
+        struct wsched_task *parent;
+        unsigned long pending;          /* Spawned children that haven't finished. */
+};
+
+/* Extract pointer to an item that contains a wsched task. */
+#define WSCHED_ITEM(d,type,field)                                               \
+        ({                                                                      \
+                typeof(d) _dl = (d);                                            \
+                                                                                \
+                (_dl) ?                                                         \
+                        (type *) ((char *)_dl - offsetof(type, field))          \
+                        :                                                       \
+                        (type *)NULL;                                           \
+        })
+
+/* One of these per worker.  'id' is from 0 to num_workers - 1, for indexing per worker data. */
+struct wsched_worker {
+        long top __attribute__((aligned(64)));          /* Where thieves steal from. */
+        long bottom __attribute__((aligned(64)));       /* Where the owner pushes and pops. */
+        struct wsched *sched;
+        unsigned id;
+        uint64_t rand;
+        pthread_t thread;
+        struct wsched_task *deque[WSCHED_DEQUE_SIZE];
+} __attribute__((aligned(64)));
+
+struct wsched {
+        struct wsched_worker *workers;
+        unsigned num_workers;
+        unsigned started;               /* Worker threads actually started. */
+        int stop;
+        pthread_mutex_t run_lock;       /* Held by the thread in wsched_run(). */
+
+        /* For sleeping workers. */
+        pthread_mutex_t lock;
+        pthread_cond_t cond;
+        unsigned sleepers;
+        unsigned long wakeups;
+};
+
+
+
+/* Set up a task that will call 'fn'. */
+static inline void wsched_task_init(struct wsched_task *t, void (*fn)(struct wsched_task *t, struct wsched_worker *w))
+{
+        t->fn = fn;
+        t->parent = NULL;
+        t->pending = 0;
+}
+
+/* Start a scheduler with 'num_workers' workers, using the caller supplied array 'workers'.  The calling thread is
+   worker 0, so num_workers - 1 threads are started.  If a thread can't be started, the others pick up its share.
+   Returns 0 on success, non-zero if 'num_workers' is 0. */
+extern int wsched_init(struct wsched *s, struct wsched_worker *workers, unsigned num_workers);
+
+/* Stop a scheduler's threads.  Must not be called while wsched_run() is running. */
+extern void wsched_destroy(struct wsched *s);
+
+/* Run a task, and everything it spawns, to completion on the calling thread and the scheduler's workers.  Only one
+   thread may run tasks at a time; others wait their turn. */
+extern void wsched_run(struct wsched *s, struct wsched_task *t);
+
+/* Spawn 'child' as a child of 'parent', which must be the task running on 'w' (or one it is running inline, such as
+   a task on its stack).  'child' must not be touched again until 'parent' has synced. */
+extern void wsched_spawn(struct wsched_worker *w, struct wsched_task *parent, struct wsched_task *child);
+
+/* Wait for every child of 'parent' to finish, running tasks in the meantime.  A task that returns without syncing is
+   synced for it, but children that live on its stack must be synced before it returns. */
+extern void wsched_sync(struct wsched_worker *w, struct wsched_task *parent);
+
+/* Call 'fn' on ranges that together cover 'lo' up to (not including) 'hi', each no bigger than 'grain' (which must
+   not be 0), spread over the workers.  Must be called from inside a task running on 'w', and returns when every range
+   is done. */
+extern void wsched_parallel_for(struct wsched_worker *w, size_t lo, size_t hi, size_t grain,
+                                void (*fn)(size_t lo, size_t hi, void *arg, struct wsched_worker *w), void *arg);
+
+/* wsched_parallel_for() from outside the scheduler, as a task of its own run with wsched_run(). */
+extern void wsched_for(struct wsched *s, size_t lo, size_t hi, size_t grain,
+                       void (*fn)(size_t lo, size_t hi, void *arg, struct wsched_worker *w), void *arg);
+
+
+
+#endif /* _WSCHED_H */
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,133 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* arena.c - Region allocator with bulk reset. */
+
+#include "mec-lib/arena.h"
+
+
+
+/* Where allocations start in a chunk. */
+#define ARENA_CHUNK_HEADER      MEC_ALIGN_UP(sizeof(struct arena_chunk), (size_t)ARENA_ALIGN)
+#define ARENA_CHUNK_START(c)    ((char *)(c) + ARENA_CHUNK_HEADER)
+
+/* Initialize an arena. */
+void arena_init(struct arena *a, struct arena_ops *ops, void *buf, size_t size)
+{
+        uintptr_t start = MEC_ALIGN_UP((uintptr_t)buf, (uintptr_t)ARENA_ALIGN);
+        struct arena_chunk *c;
+
+        a->ops = ops;
+        a->chunks = NULL;
+        a->buf = NULL;
+        a->chunk_size = ARENA_CHUNK_SIZE;
+        arena_reset(a);
+
+        if (buf && (start - (uintptr_t)buf + ARENA_CHUNK_HEADER <= size)) {
+                c = (struct arena_chunk *)start;
+                c->next = NULL;
+                c->end = (char *)buf + size;
+                a->chunks = c;
+                a->buf = c;
+        }
+}
+
+/* Free every chunk that came from the ops. */
+void arena_destroy(struct arena *a)
+{
+        struct arena_chunk *c, *next;
+
+        for (c = a->chunks; c; c = next) {
+                next = c->next;
+                if (c != a->buf)
+                        a->ops->free_chunk(c, c->end - (char *)c);
+        }
+
+        a->chunks = NULL;
+        a->buf = NULL;
+        arena_reset(a);
+}
+
+/* Return where an allocation of 'size' aligned to 'align' would go in chunk 'c', or NULL if it doesn't fit. */
+static char *arena_chunk_fit(struct arena_chunk *c, size_t size, size_t align)
+{
+        uintptr_t p = MEC_ALIGN_UP((uintptr_t)ARENA_CHUNK_START(c), (uintptr_t)align);
+
+        return ((p <= (uintptr_t)c->end) && ((uintptr_t)c->end - p >= size)) ? (char *)p : NULL;
+}
+
+/* Allocate from the next chunk that has room, or from a new one.  Chunks that are skipped because they are too small
+   for this allocation go unused until the arena is rewound past them. */
+void *arena_alloc_slow(struct arena *a, size_t size, size_t align)
+{
+        struct arena_chunk **link = a->chunk ? &a->chunk->next : &a->chunks;
+        struct arena_chunk *c;
+        size_t chunk_size;
+        char *p = NULL;
+
+        for (c = *link; c; c = c->next) {
+                p = arena_chunk_fit(c, size, align);
+                if (p)
+                        break;
+        }
+
+        if (c == NULL) {
+                if (a->ops == NULL)
+                        return NULL;
+
+                /* A new chunk goes right after the current one, ahead of any that were skipped. */
+                if (size > SIZE_MAX / 2)
+                        return NULL;
+                chunk_size = MEC_MAX(a->chunk_size, ARENA_CHUNK_HEADER + size + align);
+                c = a->ops->alloc_chunk(chunk_size);
+                if (c == NULL)
+                        return NULL;
+
+                c->end = (char *)c + chunk_size;
+                c->next = *link;
+                *link = c;
+                p = arena_chunk_fit(c, size, align);
+        }
+
+        a->chunk = c;
+        a->ptr = p + size;
+        a->end = c->end;
+
+        return p;
+}
+
+/* Return the number of bytes in an arena's chunks. */
+size_t arena_size(struct arena *a)
+{
+        struct arena_chunk *c;
+        size_t size = 0;
+
+        for (c = a->chunks; c; c = c->next)
+                size += c->end - (char *)c;
+
+        return size;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
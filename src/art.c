@@ -0,0 +1,786 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* art.c - Adaptive radix tree.
+ *
+ * A node at depth d (the number of key bytes consumed to reach it) first matches its prefix, bytes d to
+ * d + prefix_len - 1 of the key, then either ends there (the key is the node's 'leaf') or follows the child for the
+ * next byte.  Children are tagged pointers: an item with the low bit set, or an inner node.  Every inner node has at
+ * least two entries, counting its leaf; one with fewer is folded into its parent's slot.
+ */
+
+#include <string.h>
+#include "mec-lib/art.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+
+static const size_t art_node_size[] = {
+        [ART_NODE4] = sizeof(struct art_node4),
+        [ART_NODE16] = sizeof(struct art_node16),
+        [ART_NODE48] = sizeof(struct art_node48),
+        [ART_NODE256] = sizeof(struct art_node256),
+};
+
+static const unsigned art_node_capacity[] = {
+        [ART_NODE4] = 4,
+        [ART_NODE16] = 16,
+        [ART_NODE48] = 48,
+        [ART_NODE256] = 256,
+};
+
+/* A node shrinks to the next size down when it gets to this many children, which leaves some slack so that a node
+   doesn't flip back and forth between sizes. */
+static const unsigned art_node_shrink_at[] = {
+        [ART_NODE4] = 0,
+        [ART_NODE16] = 3,
+        [ART_NODE48] = 12,
+        [ART_NODE256] = 37,
+};
+
+#define ART_N4(_n)      ((struct art_node4 *)(_n))
+#define ART_N16(_n)     ((struct art_node16 *)(_n))
+#define ART_N48(_n)     ((struct art_node48 *)(_n))
+#define ART_N256(_n)    ((struct art_node256 *)(_n))
+
+static inline int art_is_leaf(void *p)
+{
+        return (uintptr_t)p & 1;
+}
+
+static inline void *art_leaf_item(void *p)
+{
+        return (void *)((uintptr_t)p & ~(uintptr_t)1);
+}
+
+static inline void *art_make_leaf(void *item)
+{
+        return (void *)((uintptr_t)item | 1);
+}
+
+static inline const unsigned char *art_item_key(struct art *art, void *item, size_t *len)
+{
+        return art->ops->get_key(item, len);
+}
+
+static inline size_t art_min(size_t a, size_t b)
+{
+        return (a < b) ? a : b;
+}
+
+/* Compare two keys, as memcmp() but with a shorter key first. */
+static int art_compare(const unsigned char *a, size_t alen, const unsigned char *b, size_t blen)
+{
+        int rc = memcmp(a, b, art_min(alen, blen));
+
+        if (rc)
+                return rc;
+
+        return (alen > blen) - (alen < blen);
+}
+
+static struct art_node *art_alloc_node(struct art *art, enum art_node_type type)
+{
+        struct art_node *n = art->ops->alloc_node(art_node_size[type]);
+
+        if (n) {
+                memset(n, 0, art_node_size[type]);
+                n->type = type;
+        }
+
+        return n;
+}
+
+static void art_free_node(struct art *art, struct art_node *n)
+{
+        art->ops->free_node(n, art_node_size[n->type]);
+}
+
+/* Return the slot of the child for byte 'c', or NULL if there is none. */
+static void **art_find_child(struct art_node *n, unsigned char c)
+{
+        unsigned i;
+
+        switch (n->type) {
+        case ART_NODE4:
+                for (i = 0; i < n->num_children; i++)
+                        if (ART_N4(n)->keys[i] == c)
+                                return &ART_N4(n)->children[i];
+                break;
+
+        case ART_NODE16: {
+#if defined(__SSE2__)
+                __m128i eq = _mm_cmpeq_epi8(_mm_set1_epi8(c), _mm_loadu_si128((__m128i *)ART_N16(n)->keys));
+                unsigned mask = _mm_movemask_epi8(eq) & ((1u << n->num_children) - 1);
+
+                if (mask)
+                        return &ART_N16(n)->children[__builtin_ctz(mask)];
+#else
+                for (i = 0; i < n->num_children; i++)
+                        if (ART_N16(n)->keys[i] == c)
+                                return &ART_N16(n)->children[i];
+#endif
+                break;
+        }
+
+        case ART_NODE48:
+                if (ART_N48(n)->index[c])
+                        return &ART_N48(n)->children[ART_N48(n)->index[c] - 1];
+                break;
+
+        case ART_NODE256:
+                if (ART_N256(n)->children[c])
+                        return &ART_N256(n)->children[c];
+                break;
+        }
+
+        return NULL;
+}
+
+/* Return the slot of the child with the smallest byte that is at least 'c' (which may be 256, for none), and set
+   '*byte' to that byte.  Returns NULL if there is none. */
+static void **art_child_ge(struct art_node *n, unsigned c, unsigned *byte)
+{
+        unsigned i;
+
+        switch (n->type) {
+        case ART_NODE4:
+        case ART_NODE16: {
+                unsigned char *keys = (n->type == ART_NODE4) ? ART_N4(n)->keys : ART_N16(n)->keys;
+                void **children = (n->type == ART_NODE4) ? ART_N4(n)->children : ART_N16(n)->children;
+
+                for (i = 0; i < n->num_children; i++)
+                        if (keys[i] >= c) {
+                                *byte = keys[i];
+                                return &children[i];
+                        }
+                break;
+        }
+
+        case ART_NODE48:
+                for (i = c; i < 256; i++)
+                        if (ART_N48(n)->index[i]) {
+                                *byte = i;
+                                return &ART_N48(n)->children[ART_N48(n)->index[i] - 1];
+                        }
+                break;
+
+        case ART_NODE256:
+                for (i = c; i < 256; i++)
+                        if (ART_N256(n)->children[i]) {
+                                *byte = i;
+                                return &ART_N256(n)->children[i];
+                        }
+                break;
+        }
+
+        return NULL;
+}
+
+/* Return the slot of the child with the largest byte that is at most 'c' (which may be -1, for none).  Returns NULL if
+   there is none. */
+static void **art_child_le(struct art_node *n, int c)
+{
+        int i;
+
+        switch (n->type) {
+        case ART_NODE4:
+        case ART_NODE16: {
+                unsigned char *keys = (n->type == ART_NODE4) ? ART_N4(n)->keys : ART_N16(n)->keys;
+                void **children = (n->type == ART_NODE4) ? ART_N4(n)->children : ART_N16(n)->children;
+
+                for (i = n->num_children - 1; i >= 0; i--)
+                        if (keys[i] <= c)
+                                return &children[i];
+                break;
+        }
+
+        case ART_NODE48:
+                for (i = c; i >= 0; i--)
+                        if (ART_N48(n)->index[i])
+                                return &ART_N48(n)->children[ART_N48(n)->index[i] - 1];
+                break;
+
+        case ART_NODE256:
+                for (i = c; i >= 0; i--)
+                        if (ART_N256(n)->children[i])
+                                return &ART_N256(n)->children[i];
+                break;
+        }
+
+        return NULL;
+}
+
+/* Add a child for byte 'c', which must not already have one, to a node that has room for it. */
+static void art_node_add(struct art_node *n, unsigned char c, void *child)
+{
+        unsigned char *keys;
+        void **children;
+        unsigned i;
+
+        switch (n->type) {
+        case ART_NODE4:
+        case ART_NODE16:
+                keys = (n->type == ART_NODE4) ? ART_N4(n)->keys : ART_N16(n)->keys;
+                children = (n->type == ART_NODE4) ? ART_N4(n)->children : ART_N16(n)->children;
+                for (i = 0; (i < n->num_children) && (keys[i] < c); i++)
+                        ;
+                memmove(&keys[i + 1], &keys[i], n->num_children - i);
+                memmove(&children[i + 1], &children[i], (n->num_children - i) * sizeof(children[0]));
+                keys[i] = c;
+                children[i] = child;
+                break;
+
+        case ART_NODE48:
+                for (i = 0; ART_N48(n)->children[i]; i++)
+                        ;
+                ART_N48(n)->children[i] = child;
+                ART_N48(n)->index[c] = i + 1;
+                break;
+
+        case ART_NODE256:
+                ART_N256(n)->children[c] = child;
+                break;
+        }
+
+        n->num_children++;
+}
+
+/* Remove the child for byte 'c', which must exist, from a node. */
+static void art_node_remove(struct art_node *n, unsigned char c)
+{
+        unsigned char *keys;
+        void **children;
+        unsigned i;
+
+        switch (n->type) {
+        case ART_NODE4:
+        case ART_NODE16:
+                keys = (n->type == ART_NODE4) ? ART_N4(n)->keys : ART_N16(n)->keys;
+                children = (n->type == ART_NODE4) ? ART_N4(n)->children : ART_N16(n)->children;
+                for (i = 0; keys[i] != c; i++)
+                        ;
+                memmove(&keys[i], &keys[i + 1], n->num_children - i - 1);
+                memmove(&children[i], &children[i + 1], (n->num_children - i - 1) * sizeof(children[0]));
+                break;
+
+        case ART_NODE48:
+                ART_N48(n)->children[ART_N48(n)->index[c] - 1] = NULL;
+                ART_N48(n)->index[c] = 0;
+                break;
+
+        case ART_NODE256:
+                ART_N256(n)->children[c] = NULL;
+                break;
+        }
+
+        n->num_children--;
+}
+
+/* Copy the node in '*ref' into a new node of another size, which must be able to hold all its children, and free the
+   old one.  Returns non-zero, leaving the node alone, if a new node couldn't be allocated. */
+static int art_resize(struct art *art, void **ref, enum art_node_type type)
+{
+        struct art_node *n = *ref, *new;
+        unsigned c, byte;
+        void **slot;
+
+        new = art_alloc_node(art, type);
+        if (new == NULL)
+                return -1;
+
+        new->prefix_len = n->prefix_len;
+        memcpy(new->prefix, n->prefix, sizeof(new->prefix));
+        new->leaf = n->leaf;
+        for (c = 0; (slot = art_child_ge(n, c, &byte)); c = byte + 1)
+                art_node_add(new, byte, *slot);
+
+        art_free_node(art, n);
+        *ref = new;
+
+        return 0;
+}
+
+/* Return the item with the smallest key in a subtree. */
+static void *art_minimum(void *p)
+{
+        struct art_node *n;
+        unsigned byte;
+
+        while (!art_is_leaf(p)) {
+                n = p;
+                if (n->leaf)
+                        return n->leaf;
+                p = *art_child_ge(n, 0, &byte);
+        }
+
+        return art_leaf_item(p);
+}
+
+/* Return the item with the largest key in a subtree. */
+static void *art_maximum(void *p)
+{
+        struct art_node *n;
+        void **slot;
+
+        while (!art_is_leaf(p)) {
+                n = p;
+                slot = art_child_le(n, 255);
+                if (slot == NULL)
+                        return n->leaf;
+                p = *slot;
+        }
+
+        return art_leaf_item(p);
+}
+
+/* Return byte 'i' of the prefix of node 'n', at depth 'd'.  Bytes past the ones stored in the node are the same in
+   every key below it, so they can be taken from any item there. */
+static unsigned char art_prefix_byte(struct art *art, struct art_node *n, size_t d, size_t i)
+{
+        size_t len;
+
+        if (i < ART_MAX_PREFIX_LEN)
+                return n->prefix[i];
+
+        return art_item_key(art, art_minimum(n), &len)[d + i];
+}
+
+/* Return the number of bytes of the prefix of node 'n', at depth 'd', that match the key (stopping at the end of the
+   key). */
+static size_t art_prefix_match(struct art *art, struct art_node *n, const unsigned char *key, size_t len, size_t d)
+{
+        size_t max = art_min(n->prefix_len, len - d);
+        const unsigned char *mkey;
+        size_t i, mlen;
+
+        for (i = 0; i < art_min(max, ART_MAX_PREFIX_LEN); i++)
+                if (n->prefix[i] != key[d + i])
+                        return i;
+
+        if (i < max) {
+                mkey = art_item_key(art, art_minimum(n), &mlen);
+                for (; i < max; i++)
+                        if (mkey[d + i] != key[d + i])
+                                return i;
+        }
+
+        return i;
+}
+
+/* Initalize an ART. */
+void art_init(struct art *art, struct art_ops *ops)
+{
+        art->ops = ops;
+        art->root = NULL;
+}
+
+static void art_free_subtree(struct art *art, void *p)
+{
+        unsigned c, byte;
+        void **slot;
+
+        if (art_is_leaf(p))
+                return;
+
+        for (c = 0; (slot = art_child_ge(p, c, &byte)); c = byte + 1)
+                art_free_subtree(art, *slot);
+        art_free_node(art, p);
+}
+
+/* Free every node of an ART. */
+void art_destroy(struct art *art)
+{
+        if (art->root)
+                art_free_subtree(art, art->root);
+        art->root = NULL;
+}
+
+/* Put an item into a new node at depth 'd', either as its leaf or as a child. */
+static void art_place(struct art_node *n, void *item, const unsigned char *key, size_t len, size_t d)
+{
+        if (len == d)
+                n->leaf = item;
+        else
+                art_node_add(n, key[d], art_make_leaf(item));
+}
+
+/* Insert an item into an ART. */
+int art_insert(struct art *art, void *item)
+{
+        const unsigned char *key, *okey;
+        struct art_node *n, *new;
+        size_t len, olen, d = 0, m;
+        void **ref = &art->root;
+        void **slot;
+        void *other;
+        unsigned char c;
+
+        key = art_item_key(art, item, &len);
+
+        for (;;) {
+                if (*ref == NULL) {
+                        /* Only the root can be empty. */
+                        *ref = art_make_leaf(item);
+                        return 0;
+                }
+
+                if (art_is_leaf(*ref)) {
+                        /* Expand the leaf into a node holding both items, with the bytes they share as its prefix. */
+                        other = art_leaf_item(*ref);
+                        okey = art_item_key(art, other, &olen);
+                        for (m = 0; (d + m < len) && (d + m < olen) && (key[d + m] == okey[d + m]); m++)
+                                ;
+                        if ((d + m == len) && (d + m == olen))
+                                return -1;
+
+                        new = art_alloc_node(art, ART_NODE4);
+                        if (new == NULL)
+                                return -1;
+                        new->prefix_len = m;
+                        memcpy(new->prefix, key + d, art_min(m, ART_MAX_PREFIX_LEN));
+                        art_place(new, other, okey, olen, d + m);
+                        art_place(new, item, key, len, d + m);
+                        *ref = new;
+                        return 0;
+                }
+
+                n = *ref;
+                m = art_prefix_match(art, n, key, len, d);
+                if (m < n->prefix_len) {
+                        /* The key leaves the prefix part way along, so split it with a new node at that point.  The
+                           old node keeps the rest of the prefix, after the byte that now leads to it. */
+                        new = art_alloc_node(art, ART_NODE4);
+                        if (new == NULL)
+                                return -1;
+                        new->prefix_len = m;
+                        memcpy(new->prefix, n->prefix, art_min(m, ART_MAX_PREFIX_LEN));
+
+                        c = art_prefix_byte(art, n, d, m);
+                        if (n->prefix_len <= ART_MAX_PREFIX_LEN) {
+                                memmove(n->prefix, n->prefix + m + 1, n->prefix_len - m - 1);
+                        } else {
+                                okey = art_item_key(art, art_minimum(n), &olen);
+                                memcpy(n->prefix, okey + d + m + 1,
+                                       art_min(n->prefix_len - m - 1, ART_MAX_PREFIX_LEN));
+                        }
+                        n->prefix_len -= m + 1;
+
+                        art_node_add(new, c, n);
+                        art_place(new, item, key, len, d + m);
+                        *ref = new;
+                        return 0;
+                }
+
+                d += n->prefix_len;
+                if (d == len) {
+                        if (n->leaf)
+                                return -1;
+                        n->leaf = item;
+                        return 0;
+                }
+
+                slot = art_find_child(n, key[d]);
+                if (slot) {
+                        ref = slot;
+                        d++;
+                        continue;
+                }
+
+                if ((n->num_children == art_node_capacity[n->type]) && art_resize(art, ref, n->type + 1))
+                        return -1;
+                art_node_add(*ref, key[d], art_make_leaf(item));
+                return 0;
+        }
+}
+
+/* After an entry has been removed from the node in '*ref', fold it into its parent's slot if it only has one entry
+   left, or move it to a smaller node if it has few enough children.  Shrinking is skipped if the smaller node can't be
+   allocated, which is harmless. */
+static void art_shrink(struct art *art, void **ref)
+{
+        struct art_node *n = *ref, *child;
+        unsigned char prefix[ART_MAX_PREFIX_LEN];
+        unsigned byte;
+        size_t i, j;
+
+        if (n->num_children == 0) {
+                *ref = art_make_leaf(n->leaf);
+                art_free_node(art, n);
+                return;
+        }
+
+        if ((n->num_children == 1) && (n->leaf == NULL)) {
+                *ref = *art_child_ge(n, 0, &byte);
+                if (!art_is_leaf(*ref)) {
+                        /* The child's prefix becomes this node's prefix, the byte that led to the child, and then
+                           its own prefix. */
+                        child = *ref;
+                        i = art_min(n->prefix_len, ART_MAX_PREFIX_LEN);
+                        memcpy(prefix, n->prefix, i);
+                        if (i < ART_MAX_PREFIX_LEN)
+                                prefix[i++] = byte;
+                        for (j = 0; (i < ART_MAX_PREFIX_LEN) && (j < child->prefix_len); i++, j++)
+                                prefix[i] = child->prefix[j];
+                        memcpy(child->prefix, prefix, i);
+                        child->prefix_len += n->prefix_len + 1;
+                }
+                art_free_node(art, n);
+                return;
+        }
+
+        if (n->num_children <= art_node_shrink_at[n->type])
+                art_resize(art, ref, n->type - 1);
+}
+
+/* Remove the item with 'key' from the subtree under the inner node in '*ref', at depth 'd'. */
+static int art_delete_from(struct art *art, void **ref, const unsigned char *key, size_t len, size_t d)
+{
+        struct art_node *n = *ref;
+        const unsigned char *lkey;
+        size_t llen;
+        void **slot;
+
+        if (art_prefix_match(art, n, key, len, d) != n->prefix_len)
+                return -1;
+        d += n->prefix_len;
+
+        if (d == len) {
+                if (n->leaf == NULL)
+                        return -1;
+                n->leaf = NULL;
+        } else {
+                slot = art_find_child(n, key[d]);
+                if (slot == NULL)
+                        return -1;
+                if (art_is_leaf(*slot)) {
+                        lkey = art_item_key(art, art_leaf_item(*slot), &llen);
+                        if (art_compare(lkey, llen, key, len))
+                                return -1;
+                        art_node_remove(n, key[d]);
+                } else {
+                        /* The child fixes itself up; this node only needs to if it lost the child. */
+                        return art_delete_from(art, slot, key, len, d + 1);
+                }
+        }
+
+        art_shrink(art, ref);
+
+        return 0;
+}
+
+/* Remove the item with the given key from an ART. */
+int art_delete(struct art *art, const void *key, size_t len)
+{
+        const unsigned char *lkey;
+        size_t llen;
+
+        if (art->root == NULL)
+                return -1;
+
+        if (art_is_leaf(art->root)) {
+                lkey = art_item_key(art, art_leaf_item(art->root), &llen);
+                if (art_compare(lkey, llen, key, len))
+                        return -1;
+                art->root = NULL;
+                return 0;
+        }
+
+        return art_delete_from(art, &art->root, key, len, 0);
+}
+
+/* Find an item in an ART.  Only the prefix bytes stored in each node are checked on the way down, so the key of the
+   item found is compared in full at the end. */
+void *art_find(struct art *art, const void *key_, size_t len)
+{
+        const unsigned char *key = key_, *lkey;
+        struct art_node *n;
+        void *p = art->root;
+        void *item = NULL;
+        size_t d = 0, i, llen;
+        void **slot;
+
+        while (p) {
+                if (art_is_leaf(p)) {
+                        item = art_leaf_item(p);
+                        break;
+                }
+
+                n = p;
+                if (len - d < n->prefix_len)
+                        return NULL;
+                for (i = 0; i < art_min(n->prefix_len, ART_MAX_PREFIX_LEN); i++)
+                        if (n->prefix[i] != key[d + i])
+                                return NULL;
+                d += n->prefix_len;
+
+                if (d == len) {
+                        item = n->leaf;
+                        break;
+                }
+
+                slot = art_find_child(n, key[d]);
+                p = slot ? *slot : NULL;
+                d++;
+        }
+
+        if (item == NULL)
+                return NULL;
+        lkey = art_item_key(art, item, &llen);
+
+        return art_compare(lkey, llen, key, len) ? NULL : item;
+}
+
+/* Return the smallest item in the subtree 'p', at depth 'd', whose key is greater than or equal to 'key' (or only
+   greater, if 'strict' is set). */
+static void *art_gte(struct art *art, void *p, const unsigned char *key, size_t len, size_t d, int strict)
+{
+        const unsigned char *lkey;
+        struct art_node *n;
+        size_t llen, m;
+        unsigned byte;
+        void **slot;
+        void *item;
+        int rc;
+
+        if (art_is_leaf(p)) {
+                item = art_leaf_item(p);
+                lkey = art_item_key(art, item, &llen);
+                rc = art_compare(lkey, llen, key, len);
+                return ((rc > 0) || ((rc == 0) && !strict)) ? item : NULL;
+        }
+
+        n = p;
+        m = art_prefix_match(art, n, key, len, d);
+        if (m < n->prefix_len) {
+                /* Every key below here is greater if the key ran out, or has a smaller byte where they differ. */
+                if ((d + m == len) || (art_prefix_byte(art, n, d, m) > key[d + m]))
+                        return art_minimum(n);
+                return NULL;
+        }
+        d += n->prefix_len;
+
+        if (d == len) {
+                if (n->leaf && !strict)
+                        return n->leaf;
+                slot = art_child_ge(n, 0, &byte);
+                return slot ? art_minimum(*slot) : NULL;
+        }
+
+        /* The node's own leaf is shorter than the key, so it is smaller. */
+        slot = art_find_child(n, key[d]);
+        if (slot && (item = art_gte(art, *slot, key, len, d + 1, strict)))
+                return item;
+        slot = art_child_ge(n, key[d] + 1, &byte);
+
+        return slot ? art_minimum(*slot) : NULL;
+}
+
+/* Return the largest item in the subtree 'p', at depth 'd', whose key is less than or equal to 'key' (or only less, if
+   'strict' is set). */
+static void *art_lte(struct art *art, void *p, const unsigned char *key, size_t len, size_t d, int strict)
+{
+        const unsigned char *lkey;
+        struct art_node *n;
+        size_t llen, m;
+        void **slot;
+        void *item;
+        int rc;
+
+        if (art_is_leaf(p)) {
+                item = art_leaf_item(p);
+                lkey = art_item_key(art, item, &llen);
+                rc = art_compare(lkey, llen, key, len);
+                return ((rc < 0) || ((rc == 0) && !strict)) ? item : NULL;
+        }
+
+        n = p;
+        m = art_prefix_match(art, n, key, len, d);
+        if (m < n->prefix_len) {
+                /* Every key below here is less only if it has a smaller byte where they differ. */
+                if ((d + m < len) && (art_prefix_byte(art, n, d, m) < key[d + m]))
+                        return art_maximum(n);
+                return NULL;
+        }
+        d += n->prefix_len;
+
+        if (d == len)
+                return strict ? NULL : n->leaf;
+
+        slot = art_find_child(n, key[d]);
+        if (slot && (item = art_lte(art, *slot, key, len, d + 1, strict)))
+                return item;
+        slot = art_child_le(n, (int)key[d] - 1);
+
+        return slot ? art_maximum(*slot) : n->leaf;
+}
+
+/* Find the smallest item in an ART whose key is greater than or equal to 'key'. */
+void *art_find_smallest_gte(struct art *art, const void *key, size_t len)
+{
+        return art->root ? art_gte(art, art->root, key, len, 0, 0) : NULL;
+}
+
+/* Find the largest item in an ART whose key is less than or equal to 'key'. */
+void *art_find_largest_lte(struct art *art, const void *key, size_t len)
+{
+        return art->root ? art_lte(art, art->root, key, len, 0, 0) : NULL;
+}
+
+/* Return the item with the next highest key. */
+void *art_next(struct art *art, void *item)
+{
+        const unsigned char *key;
+        size_t len;
+
+        if (art->root == NULL)
+                return NULL;
+        if (item == NULL)
+                return art_minimum(art->root);
+
+        key = art_item_key(art, item, &len);
+
+        return art_gte(art, art->root, key, len, 0, 1);
+}
+
+/* Return the item with the next lowest key. */
+void *art_prev(struct art *art, void *item)
+{
+        const unsigned char *key;
+        size_t len;
+
+        if (art->root == NULL)
+                return NULL;
+        if (item == NULL)
+                return art_maximum(art->root);
+
+        key = art_item_key(art, item, &len);
+
+        return art_lte(art, art->root, key, len, 0, 1);
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
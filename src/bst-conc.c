@@ -0,0 +1,197 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bst-conc.c - BST with lock-free readers and a single writer. */
+
+#include "mec-lib/bst-conc.h"
+#include "mec-lib/util.h"
+
+
+
+/* What a reader is searching for. */
+enum bst_conc_search {
+        BST_CONC_EQ,
+        BST_CONC_GTE,
+        BST_CONC_GT,
+        BST_CONC_LTE,
+        BST_CONC_LT,
+};
+
+#define BST_CONC_LOAD(p) __atomic_load_n(&(p), __ATOMIC_RELAXED)
+
+/* Start a read-side section; waits out any write in progress and returns the sequence count to validate against. */
+static inline unsigned long bst_conc_read_begin(struct bst_conc *bc)
+{
+        unsigned long seq;
+
+        while ((seq = __atomic_load_n(&bc->seq, __ATOMIC_ACQUIRE)) & 1)
+                MEC_CPU_RELAX();
+
+        return seq;
+}
+
+/* Returns non-zero if a write happened since bst_conc_read_begin() returned 'seq'. */
+static inline int bst_conc_read_retry(struct bst_conc *bc, unsigned long seq)
+{
+        /* Order the tree reads before the re-read of the counter. */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        return __atomic_load_n(&bc->seq, __ATOMIC_RELAXED) != seq;
+}
+
+static inline void bst_conc_write_begin(struct bst_conc *bc)
+{
+        __atomic_store_n(&bc->seq, bc->seq + 1, __ATOMIC_RELAXED);
+        /* Order the odd count before any of the tree updates. */
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void bst_conc_write_end(struct bst_conc *bc)
+{
+        __atomic_store_n(&bc->seq, bc->seq + 1, __ATOMIC_RELEASE);
+}
+
+/* Initalize a concurrent BST. */
+void bst_conc_init(struct bst_conc *bc, struct bst_ops *ops)
+{
+        bst_init(&bc->bst, ops);
+        bc->seq = 0;
+}
+
+/* Insert an item into a concurrent BST.  Writer only.  Returns 0 on success, non-zero on error. */
+int bst_conc_insert(struct bst_conc *bc, struct bst_node *n)
+{
+        int ret;
+
+        bst_conc_write_begin(bc);
+        ret = bst_insert(&bc->bst, n);
+        bst_conc_write_end(bc);
+
+        return ret;
+}
+
+/* Remove an item from a concurrent BST.  Writer only.  Returns 0 on success, non-zero on error. */
+int bst_conc_delete(struct bst_conc *bc, struct bst_node *n)
+{
+        int ret;
+
+        bst_conc_write_begin(bc);
+        ret = bst_delete(&bc->bst, n);
+        bst_conc_write_end(bc);
+
+        return ret;
+}
+
+/* Walk down from the root looking for 'key'.  A NULL key is smaller than every item for the GT search and larger than
+   every item for the LT search, which finds the first and last items.
+
+   While the writer is active a reader may see a half-rotated tree, or a deleted node whose links have been cleared;
+   rather than trying to make sense of that, it bails out and retries once the write is done. */
+static struct bst_node *bst_conc_search(struct bst_conc *bc, void *key, enum bst_conc_search how)
+{
+        struct bst_ops *ops = bc->bst.ops;
+        struct bst_node *cur, *best;
+        unsigned long seq;
+        unsigned depth;
+
+retry:
+        seq = bst_conc_read_begin(bc);
+        best = NULL;
+        depth = 0;
+
+        cur = BST_CONC_LOAD(bc->bst.root);
+        while (cur != bst_nil) {
+                int comparison;
+
+                if ((cur == NULL) || (++depth > BST_CONC_MAX_DEPTH))
+                        goto retry;
+
+                if (key)
+                        comparison = ops->compare(key, ops->get_key(cur));
+                else
+                        comparison = (how == BST_CONC_GT) ? -1 : 1;
+
+                if (comparison == 0) {
+                        if ((how != BST_CONC_GT) && (how != BST_CONC_LT)) {
+                                best = cur;
+                                break;
+                        }
+                        /* Strict searches treat an equal key as being on the wrong side. */
+                        comparison = (how == BST_CONC_GT) ? 1 : -1;
+                }
+
+                if (comparison < 0) {
+                        /* Every item to the right is bigger than the key, so this is the best successor so far. */
+                        if ((how == BST_CONC_GTE) || (how == BST_CONC_GT))
+                                best = cur;
+                        cur = BST_CONC_LOAD(cur->left);
+                } else {
+                        if ((how == BST_CONC_LTE) || (how == BST_CONC_LT))
+                                best = cur;
+                        cur = BST_CONC_LOAD(cur->right);
+                }
+        }
+
+        if (bst_conc_read_retry(bc, seq))
+                goto retry;
+
+        return best;
+}
+
+/* Find an item in a concurrent BST.  Returns a pointer to the node, or NULL if item was not found. */
+struct bst_node *bst_conc_find(struct bst_conc *bc, void *key)
+{
+        return bst_conc_search(bc, key, BST_CONC_EQ);
+}
+
+/* Find the smallest item in a concurrent BST whose key is greater than or equal to 'key'.  Returns NULL if no such
+   item is found. */
+struct bst_node *bst_conc_find_smallest_gte(struct bst_conc *bc, void *key)
+{
+        return bst_conc_search(bc, key, BST_CONC_GTE);
+}
+
+/* Find the largest item in a concurrent BST whose key is less than or equal to 'key'.  Returns NULL if no such item
+   is found. */
+struct bst_node *bst_conc_find_largest_lte(struct bst_conc *bc, void *key)
+{
+        return bst_conc_search(bc, key, BST_CONC_LTE);
+}
+
+/* Given a node, return a pointer to the node in the tree with the next highest key.  If NULL is passed in, returns a
+   pointer to the node in the tree with the smallest key.  If no more nodes exist, returns NULL. */
+struct bst_node *bst_conc_next(struct bst_conc *bc, struct bst_node *n)
+{
+        return bst_conc_search(bc, n ? bc->bst.ops->get_key(n) : NULL, BST_CONC_GT);
+}
+
+/* Given a node, return a pointer to the node in the tree with the next lowest key.  If NULL is passed in, returns a
+   pointer to the node in the tree with the largest key.  If no more nodes exist, returns NULL. */
+struct bst_node *bst_conc_prev(struct bst_conc *bc, struct bst_node *n)
+{
+        return bst_conc_search(bc, n ? bc->bst.ops->get_key(n) : NULL, BST_CONC_LT);
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,397 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bst-cow.c - Persistent AA tree using path copying.
+ *
+ * The rebalancing is the recursive form of the AA tree algorithms (see bst.c), with every node that is about to be
+ * changed first passed through bst_cow_mutable().  A node whose reference count is 1 is only reachable through its
+ * parent, and since changes always work down from the root making each parent mutable first, such a node belongs to
+ * this version alone and can be changed in place.  Any other node is copied, and the copy takes a reference to each
+ * of its children, so the copying carries on down the path as far as the change goes.
+ */
+
+#include "mec-lib/bst-cow.h"
+#include "mec-lib/util.h"
+
+
+
+/* A change touches at most this many nodes for each node on its path (see the comments in bst_cow_insert_node() and
+   bst_cow_delete_node()). */
+#define BST_COW_INSERT_COPIES 3
+#define BST_COW_DELETE_COPIES 8
+
+static inline unsigned bst_cow_level(struct bst_cow_node *n)
+{
+        return n ? n->level : 0;
+}
+
+static inline void bst_cow_ref(struct bst_cow_node *n)
+{
+        if (n)
+                __atomic_add_fetch(&n->refs, 1, __ATOMIC_RELAXED);
+}
+
+/* Drop a reference to a node, freeing it (and dropping its references to its children) if it was the last one. */
+static void bst_cow_unref(struct bst_cow *t, struct bst_cow_node *n)
+{
+        struct bst_cow_node *right;
+
+        /* Loop down the right side rather than recursing, to bound the stack when freeing a whole tree. */
+        while (n && (__atomic_sub_fetch(&n->refs, 1, __ATOMIC_ACQ_REL) == 0)) {
+                bst_cow_unref(t, n->left);
+                right = n->right;
+                t->ops->free_node(n);
+                n = right;
+        }
+}
+
+/* Make sure there are at least 'needed' spare nodes.  Returns 0 on success, non-zero on error. */
+static int bst_cow_reserve(struct bst_cow *t, unsigned needed)
+{
+        struct bst_cow_node *n;
+
+        while (t->num_spare < needed) {
+                n = t->ops->alloc_node();
+                if (n == NULL)
+                        return 1;
+                n->left = t->spare;
+                t->spare = n;
+                t->num_spare++;
+        }
+
+        return 0;
+}
+
+/* Take a node from the spares reserved by bst_cow_reserve(). */
+static struct bst_cow_node *bst_cow_alloc(struct bst_cow *t)
+{
+        struct bst_cow_node *n = t->spare;
+
+        t->spare = n->left;
+        t->num_spare--;
+
+        return n;
+}
+
+/* Return a version of 'n' that can be changed in place.  The caller must store the result in place of 'n' in its
+   (already mutable) parent. */
+static struct bst_cow_node *bst_cow_mutable(struct bst_cow *t, struct bst_cow_node *n)
+{
+        struct bst_cow_node *c;
+
+        if (__atomic_load_n(&n->refs, __ATOMIC_ACQUIRE) == 1)
+                return n;
+
+        c = bst_cow_alloc(t);
+        c->left = n->left;
+        c->right = n->right;
+        c->item = n->item;
+        c->level = n->level;
+        c->refs = 1;
+        bst_cow_ref(c->left);
+        bst_cow_ref(c->right);
+
+        /* The parent's reference moves from 'n' to the copy. */
+        bst_cow_unref(t, n);
+
+        return c;
+}
+
+/* The AA tree skew operation - repair a left horizontal link.  Nodes are only made mutable if a rotation is needed,
+   and the caller must store the result in place of 'n'. */
+static struct bst_cow_node *bst_cow_skew(struct bst_cow *t, struct bst_cow_node *n)
+{
+        struct bst_cow_node *l;
+
+        if ((n == NULL) || (n->left == NULL) || (n->left->level != n->level))
+                return n;
+
+        /* Horizontal left link - rotate it to the right.  The references just change hands, so no counts change. */
+        n = bst_cow_mutable(t, n);
+        l = bst_cow_mutable(t, n->left);
+        n->left = l->right;
+        l->right = n;
+
+        return l;
+}
+
+/* The AA tree split operation - repair a dual horizontal right link.  As with skew, the caller must store the result
+   in place of 'n'. */
+static struct bst_cow_node *bst_cow_split(struct bst_cow *t, struct bst_cow_node *n)
+{
+        struct bst_cow_node *r;
+
+        if ((n == NULL) || (n->right == NULL) || (n->right->right == NULL) ||
+            (n->level != n->right->right->level))
+                return n;
+
+        /* Two horizontal right links - pop the middle node up a level. */
+        n = bst_cow_mutable(t, n);
+        r = bst_cow_mutable(t, n->right);
+        n->right = r->left;
+        r->left = n;
+        r->level++;
+
+        return r;
+}
+
+/* Insert 'item' below 'n', returning the new root of the subtree.  The key must not already be present.  Each level
+   copies at most 'n' itself and one child in each of skew and split. */
+static struct bst_cow_node *bst_cow_insert_node(struct bst_cow *t, struct bst_cow_node *n, void *item, void *key)
+{
+        if (n == NULL) {
+                n = bst_cow_alloc(t);
+                n->left = n->right = NULL;
+                n->item = item;
+                n->level = 1;
+                n->refs = 1;
+                return n;
+        }
+
+        n = bst_cow_mutable(t, n);
+        if (t->ops->compare(key, t->ops->get_key(n->item)) < 0)
+                n->left = bst_cow_insert_node(t, n->left, item, key);
+        else
+                n->right = bst_cow_insert_node(t, n->right, item, key);
+
+        n = bst_cow_skew(t, n);
+        n = bst_cow_split(t, n);
+
+        return n;
+}
+
+/* Remove the item with 'key' from below 'n', returning the new root of the subtree.  The key must be present.  Each
+   level copies at most 'n', its right child when lowering levels, and the nodes the three skews and two splits
+   rotate. */
+static struct bst_cow_node *bst_cow_delete_node(struct bst_cow *t, struct bst_cow_node *n, void *key)
+{
+        struct bst_cow_node *r;
+        unsigned level;
+        int comparison;
+
+        comparison = t->ops->compare(key, t->ops->get_key(n->item));
+
+        if ((comparison == 0) && (n->left == NULL) && (n->right == NULL)) {
+                /* A leaf can just be dropped. */
+                bst_cow_unref(t, n);
+                return NULL;
+        }
+
+        n = bst_cow_mutable(t, n);
+        if (comparison < 0) {
+                n->left = bst_cow_delete_node(t, n->left, key);
+        } else if (comparison > 0) {
+                n->right = bst_cow_delete_node(t, n->right, key);
+        } else if (n->left == NULL) {
+                /* Replace this item with its successor, then delete the successor from the right subtree. */
+                for (r = n->right; r->left; r = r->left)
+                        ;
+                n->item = r->item;
+                n->right = bst_cow_delete_node(t, n->right, t->ops->get_key(r->item));
+        } else {
+                /* Replace this item with its predecessor, then delete the predecessor from the left subtree. */
+                for (r = n->left; r->right; r = r->right)
+                        ;
+                n->item = r->item;
+                n->left = bst_cow_delete_node(t, n->left, t->ops->get_key(r->item));
+        }
+
+        /* Fix up the level of this node if necessary. */
+        level = MEC_MIN(bst_cow_level(n->left), bst_cow_level(n->right)) + 1;
+        if (n->level > level) {
+                n->level = level;
+                if (bst_cow_level(n->right) > level) {
+                        n->right = bst_cow_mutable(t, n->right);
+                        n->right->level = level;
+                }
+        }
+
+        /* Handle rebalancing. */
+        n = bst_cow_skew(t, n);
+        if (n->right) {
+                n->right = bst_cow_skew(t, n->right);
+                if (n->right->right) {
+                        /* Skewing here changes n->right, so it has to be mutable first. */
+                        n->right = bst_cow_mutable(t, n->right);
+                        n->right->right = bst_cow_skew(t, n->right->right);
+                }
+        }
+        n = bst_cow_split(t, n);
+        if (n->right)
+                n->right = bst_cow_split(t, n->right);
+
+        return n;
+}
+
+/* Search for the item nearest 'key'.  If 'dir' is 0 only an exact match is returned, if it is positive the smallest
+   item greater than (or equal to, if 'inclusive') 'key' is returned, and if it is negative the largest item less
+   than (or equal to) 'key'. */
+static void *bst_cow_search(struct bst_cow *t, void *key, int dir, int inclusive)
+{
+        struct bst_cow_node *cur = t->root;
+        void *best = NULL;
+        int comparison;
+
+        while (cur) {
+                comparison = t->ops->compare(key, t->ops->get_key(cur->item));
+
+                if ((comparison == 0) && inclusive)
+                        return cur->item;
+
+                if ((comparison < 0) || ((comparison == 0) && (dir < 0))) {
+                        if (dir > 0)
+                                best = cur->item;
+                        cur = cur->left;
+                } else {
+                        if (dir < 0)
+                                best = cur->item;
+                        cur = cur->right;
+                }
+        }
+
+        return best;
+}
+
+
+
+/* Initalize an empty persistent BST. */
+void bst_cow_init(struct bst_cow *t, struct bst_cow_ops *ops)
+{
+        t->ops = ops;
+        t->root = NULL;
+        t->spare = NULL;
+        t->num_spare = 0;
+}
+
+/* Make 'snap' a new version of 't' with the same contents.  This is O(1). */
+void bst_cow_snapshot(struct bst_cow *t, struct bst_cow *snap)
+{
+        bst_cow_init(snap, t->ops);
+        bst_cow_ref(t->root);
+        snap->root = t->root;
+}
+
+/* Destroy a version, freeing any nodes that no other version is using.  't' is left empty. */
+void bst_cow_destroy(struct bst_cow *t)
+{
+        bst_cow_unref(t, t->root);
+        t->root = NULL;
+
+        while (t->num_spare)
+                t->ops->free_node(bst_cow_alloc(t));
+}
+
+/* Insert an item into a persistent BST.  Returns 0 on success, non-zero on error (the key is already present, or a
+   node could not be allocated). */
+int bst_cow_insert(struct bst_cow *t, void *item)
+{
+        void *key = t->ops->get_key(item);
+        unsigned depth;
+
+        /* Check first, so a failed insert doesn't copy the path to the existing item. */
+        if (bst_cow_find(t, key))
+                return 1;
+
+        /* There are at most two nodes on each level of an AA tree. */
+        depth = 2 * bst_cow_level(t->root) + 1;
+        if (bst_cow_reserve(t, depth * BST_COW_INSERT_COPIES + 1))
+                return 1;
+
+        t->root = bst_cow_insert_node(t, t->root, item, key);
+
+        return 0;
+}
+
+/* Remove the item with the given key from a persistent BST.  Returns 0 on success, non-zero if no item has that
+   key, or a node could not be allocated. */
+int bst_cow_delete(struct bst_cow *t, void *key)
+{
+        unsigned depth;
+
+        if (bst_cow_find(t, key) == NULL)
+                return 1;
+
+        depth = 2 * bst_cow_level(t->root) + 1;
+        if (bst_cow_reserve(t, depth * BST_COW_DELETE_COPIES))
+                return 1;
+
+        t->root = bst_cow_delete_node(t, t->root, key);
+
+        return 0;
+}
+
+/* Find an item in a persistent BST.  Returns a pointer to the item, or NULL if item was not found. */
+void *bst_cow_find(struct bst_cow *t, void *key)
+{
+        return bst_cow_search(t, key, 0, 1);
+}
+
+/* Find the smallest item in a persistent BST whose key is greater than or equal to 'key'.  Returns NULL if no such
+   item is found. */
+void *bst_cow_find_smallest_gte(struct bst_cow *t, void *key)
+{
+        return bst_cow_search(t, key, 1, 1);
+}
+
+/* Find the largest item in a persistent BST whose key is less than or equal to 'key'.  Returns NULL if no such item
+   is found. */
+void *bst_cow_find_largest_lte(struct bst_cow *t, void *key)
+{
+        return bst_cow_search(t, key, -1, 1);
+}
+
+/* Given an item, return the item in the tree with the next highest key.  If NULL is passed in, returns the item with
+   the smallest key.  If no more items exist, returns NULL. */
+void *bst_cow_next(struct bst_cow *t, void *item)
+{
+        struct bst_cow_node *cur;
+
+        if (item)
+                return bst_cow_search(t, t->ops->get_key(item), 1, 0);
+
+        if (t->root == NULL)
+                return NULL;
+        for (cur = t->root; cur->left; cur = cur->left)
+                ;
+        return cur->item;
+}
+
+/* Given an item, return the item in the tree with the next lowest key.  If NULL is passed in, returns the item with
+   the largest key.  If no more items exist, returns NULL. */
+void *bst_cow_prev(struct bst_cow *t, void *item)
+{
+        struct bst_cow_node *cur;
+
+        if (item)
+                return bst_cow_search(t, t->ops->get_key(item), -1, 0);
+
+        if (t->root == NULL)
+                return NULL;
+        for (cur = t->root; cur->right; cur = cur->right)
+                ;
+        return cur->item;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
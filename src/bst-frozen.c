@@ -0,0 +1,145 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bst-frozen.c - Read-only snapshot of a BST laid out in Eytzinger order. */
+
+#include "mec-lib/bst-frozen.h"
+
+
+
+/* Entries are 16 bytes, so the 4 grandchildren of entry i (at 4i .. 4i+3) share a 64 byte cacheline.  Prefetching
+   them while comparing against entry i hides most of the latency of the next two levels. */
+#define BST_FROZEN_PREFETCH_DISTANCE 4
+
+/* Fill the subtree rooted at Eytzinger index 'i' with the next items from an in-order walk of the live tree.  The
+   recursion depth is log2(count). */
+static struct bst_node *bst_frozen_fill(struct bst_frozen *f, struct bst *bst, size_t i, struct bst_node *n)
+{
+        if (i > f->count)
+                return n;
+
+        n = bst_frozen_fill(f, bst, 2 * i, n);
+
+        f->entries[i].key = bst->ops->get_key(n);
+        f->entries[i].node = n;
+        n = bst_next(bst, n);
+
+        return bst_frozen_fill(f, bst, 2 * i + 1, n);
+}
+
+/* Freeze a BST into caller-supplied memory.  Returns 0 on success, non-zero if 'mem_size' is too small to hold every
+   item in the tree. */
+int bst_freeze(struct bst_frozen *f, struct bst *bst, void *mem, size_t mem_size)
+{
+        f->ops = bst->ops;
+        f->entries = mem;
+        f->count = 0;
+        f->capacity = (mem_size / sizeof(struct bst_frozen_entry));
+        if (f->capacity)
+                f->capacity--;
+
+        return bst_refreeze(f, bst);
+}
+
+/* Rebuild a frozen BST from the current contents of the live tree, reusing the memory it was frozen into.  Returns 0
+   on success, non-zero if the tree has outgrown the memory.
+
+   This is a full rebuild, not an update of the entries that changed.  An entry's place in Eytzinger order depends on
+   its rank, and one insert or delete changes the rank of every item after it; the shape of the implicit tree changes
+   too, since it is always filled level by level.  So a single change can move most of the entries anyway.  Leaving
+   gaps to absorb changes would cost the search its branch-free walk over a dense array, and that walk is the point.
+   The rebuild is one in-order walk of the live tree, with no calls to compare(), and refreezing after a batch of
+   changes spreads its cost over the batch. */
+int bst_refreeze(struct bst_frozen *f, struct bst *bst)
+{
+        size_t count = bst_count(bst);
+
+        if (count > f->capacity)
+                return 1;
+
+        f->ops = bst->ops;
+        f->count = count;
+        bst_frozen_fill(f, bst, 1, bst_next(bst, NULL));
+
+        return 0;
+}
+
+/* Return the Eytzinger index of the smallest entry whose key is greater than or equal to 'key', or 0 if there is no
+   such entry. */
+static size_t bst_frozen_gte_index(struct bst_frozen *f, void *key)
+{
+        struct bst_frozen_entry *e = f->entries;
+        size_t i = 1;
+
+        /* Go right whenever the entry is smaller than the key; the answer is the last place we went left. */
+        while (i <= f->count) {
+                __builtin_prefetch(&e[BST_FROZEN_PREFETCH_DISTANCE * i]);
+                i = 2 * i + (f->ops->compare(key, e[i].key) > 0);
+        }
+
+        /* Strip off the trailing right turns and the final left turn. */
+        return i >> __builtin_ffsl(~i);
+}
+
+/* Find the smallest item in a frozen BST whose key is greater than or equal to 'key'.  Returns NULL if no such item is
+   found. */
+struct bst_node *bst_frozen_find_smallest_gte(struct bst_frozen *f, void *key)
+{
+        size_t i = bst_frozen_gte_index(f, key);
+
+        return i ? f->entries[i].node : NULL;
+}
+
+/* Find the largest item in a frozen BST whose key is less than or equal to 'key'.  Returns NULL if no such item is
+   found. */
+struct bst_node *bst_frozen_find_largest_lte(struct bst_frozen *f, void *key)
+{
+        struct bst_frozen_entry *e = f->entries;
+        size_t i = 1;
+
+        /* Go right whenever the entry is less than or equal to the key; the answer is the last place we went right. */
+        while (i <= f->count) {
+                __builtin_prefetch(&e[BST_FROZEN_PREFETCH_DISTANCE * i]);
+                i = 2 * i + (f->ops->compare(key, e[i].key) >= 0);
+        }
+
+        /* Strip off the trailing left turns and the final right turn. */
+        i >>= __builtin_ffsl(i);
+
+        return i ? e[i].node : NULL;
+}
+
+/* Find an item in a frozen BST.  Returns a pointer to the node, or NULL if item was not found. */
+struct bst_node *bst_frozen_find(struct bst_frozen *f, void *key)
+{
+        size_t i = bst_frozen_gte_index(f, key);
+
+        if (i && (f->ops->compare(key, f->entries[i].key) == 0))
+                return f->entries[i].node;
+
+        return NULL;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
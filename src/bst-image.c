@@ -0,0 +1,340 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bst-image.c - Relocatable image of a BST that can be searched in place.
+ *
+ * The image layout is:
+ *
+ *   header | node, record | node, record | ... | CRC table
+ *
+ * with the nodes in key order.  The CRC table has one 32 bit entry per page of everything before it.
+ */
+
+#include <string.h>
+#include "mec-lib/bst-image.h"
+#include "mec-lib/crc.h"
+#include "mec-lib/util.h"
+
+
+
+static struct crc_config bst_image_crc32c = {
+        .width = 32, .poly = 0x1edc6f41, .init = 0xffffffff, .refin = 1, .refout = 1, .xorout = 0xffffffff,
+};
+
+struct bst_image_build_ctx {
+        struct bst *bst;
+        struct bst_image_ops *ops;
+        char *base;
+        struct bst_node *cur;   /* Next item to write, in key order. */
+        uint64_t pos;           /* Where to write it. */
+};
+
+#define BST_IMAGE_DATA_START MEC_ALIGN_UP(sizeof(struct bst_image_header), 8)
+
+static inline size_t bst_image_node_size(struct bst_image_ops *ops, struct bst_node *n)
+{
+        return sizeof(struct bst_image_node) + MEC_ALIGN_UP(ops->record_size(n), 8);
+}
+
+static inline struct bst_image_node *bst_image_node(struct bst_image *img, uint64_t offset)
+{
+        return (struct bst_image_node *)(img->base + offset);
+}
+
+static inline void *bst_image_record(struct bst_image_node *in)
+{
+        return in + 1;
+}
+
+static inline struct bst_image_node *bst_image_record_node(void *record)
+{
+        return (struct bst_image_node *)record - 1;
+}
+
+static inline uint64_t bst_image_offset(struct bst_image *img, struct bst_image_node *in)
+{
+        return (char *)in - img->base;
+}
+
+/* Write out the items numbered 'lo' up to (but not including) 'hi' as a balanced subtree.  The subtree is built in
+   order, so the items are consumed from the source tree in key order and laid out one after another.  Returns the
+   offset of the subtree's root. */
+static uint64_t bst_image_build_subtree(struct bst_image_build_ctx *ctx, size_t lo, size_t hi)
+{
+        struct bst_image_node *in;
+        size_t mid = lo + (hi - lo) / 2;
+        uint64_t left, offset;
+
+        if (lo >= hi)
+                return 0;
+
+        left = bst_image_build_subtree(ctx, lo, mid);
+
+        offset = ctx->pos;
+        in = (struct bst_image_node *)(ctx->base + offset);
+        ctx->pos += bst_image_node_size(ctx->ops, ctx->cur);
+        memset(in, 0, ctx->pos - offset);
+        ctx->ops->write_record(ctx->cur, bst_image_record(in));
+        ctx->cur = bst_next(ctx->bst, ctx->cur);
+
+        in->left = left;
+        if (left)
+                ((struct bst_image_node *)(ctx->base + left))->parent = offset;
+        in->right = bst_image_build_subtree(ctx, mid + 1, hi);
+        if (in->right)
+                ((struct bst_image_node *)(ctx->base + in->right))->parent = offset;
+
+        return offset;
+}
+
+/* Return the number of bytes bst_image_build() needs for an image of 'bst'.  This walks the tree, so it is O(n). */
+size_t bst_image_size(struct bst *bst, struct bst_image_ops *ops, size_t page_size)
+{
+        struct bst_node *n;
+        size_t size = BST_IMAGE_DATA_START;
+
+        for (n = bst_next(bst, NULL); n; n = bst_next(bst, n))
+                size += bst_image_node_size(ops, n);
+
+        return size + ((size + page_size - 1) / page_size) * sizeof(uint32_t);
+}
+
+/* Write an image of 'bst' into 'mem', which must be 8 byte aligned.  Returns 0 on success, non-zero on error (the
+   memory is too small, or 'page_size' is not a power of two of at least 64). */
+int bst_image_build(struct bst *bst, struct bst_image_ops *ops, void *mem, size_t mem_size, size_t page_size)
+{
+        struct bst_image_build_ctx ctx = { .bst = bst, .ops = ops, .base = mem, .pos = BST_IMAGE_DATA_START };
+        struct bst_image_header *hdr = mem;
+        uint32_t *crcs;
+        size_t size, i;
+
+        if ((page_size < 64) || (page_size & (page_size - 1)) || (page_size > UINT32_MAX))
+                return 1;
+
+        size = bst_image_size(bst, ops, page_size);
+        if (size > mem_size)
+                return 1;
+
+        memset(hdr, 0, BST_IMAGE_DATA_START);
+        hdr->magic = BST_IMAGE_MAGIC;
+        hdr->version = BST_IMAGE_VERSION;
+        hdr->page_size = page_size;
+        hdr->size = size;
+        hdr->count = bst_count(bst);
+
+        ctx.cur = bst_next(bst, NULL);
+        hdr->root = bst_image_build_subtree(&ctx, 0, hdr->count);
+
+        /* Now that the data is all in place, checksum it a page at a time. */
+        hdr->crc_offset = ctx.pos;
+        hdr->num_pages = (ctx.pos + page_size - 1) / page_size;
+        crcs = (uint32_t *)(ctx.base + ctx.pos);
+        for (i=0; i<hdr->num_pages; i++)
+                crcs[i] = crc_calculate(&bst_image_crc32c, (uint8_t *)ctx.base + i * page_size,
+                                        MEC_MIN(page_size, ctx.pos - i * page_size));
+
+        return 0;
+}
+
+/* Set up 'img' to search the image at 'mem', which must be 8 byte aligned.  Checks the header against 'mem_size', but
+   not the page CRC's.  Returns 0 on success, non-zero on error. */
+int bst_image_open(struct bst_image *img, struct bst_image_ops *ops, void *mem, size_t mem_size)
+{
+        struct bst_image_header *hdr = mem;
+
+        if ((mem_size < sizeof(*hdr)) ||
+            (hdr->magic != BST_IMAGE_MAGIC) ||
+            (hdr->version != BST_IMAGE_VERSION) ||
+            (hdr->size > mem_size) ||
+            (hdr->page_size == 0) ||
+            (hdr->crc_offset > hdr->size) ||
+            (hdr->num_pages != (hdr->crc_offset + hdr->page_size - 1) / hdr->page_size) ||
+            (hdr->crc_offset + (uint64_t)hdr->num_pages * sizeof(uint32_t) != hdr->size) ||
+            (hdr->root >= hdr->crc_offset))
+                return 1;
+
+        img->ops = ops;
+        img->base = mem;
+        img->hdr = hdr;
+
+        return 0;
+}
+
+/* Check every page of an image against its CRC.  Returns 0 if they all match, non-zero otherwise. */
+int bst_image_verify(struct bst_image *img)
+{
+        struct bst_image_header *hdr = img->hdr;
+        uint32_t *crcs = (uint32_t *)(img->base + hdr->crc_offset);
+        uint64_t i, offset;
+
+        for (i=0; i<hdr->num_pages; i++) {
+                offset = i * hdr->page_size;
+                if (crcs[i] != crc_calculate(&bst_image_crc32c, (uint8_t *)img->base + offset,
+                                             MEC_MIN((uint64_t)hdr->page_size, hdr->crc_offset - offset)))
+                        return 1;
+        }
+
+        return 0;
+}
+
+/* Find a record in an image.  Returns a pointer to the record, or NULL if it was not found. */
+void *bst_image_find(struct bst_image *img, void *key)
+{
+        uint64_t cur = img->hdr->root;
+
+        while (cur) {
+                struct bst_image_node *in = bst_image_node(img, cur);
+                int comparison = img->ops->compare(key, img->ops->get_key(bst_image_record(in)));
+
+                if (comparison < 0)
+                        cur = in->left;
+                else if (comparison > 0)
+                        cur = in->right;
+                else
+                        return bst_image_record(in);
+        }
+
+        return NULL;
+}
+
+/* Find the smallest record in an image whose key is greater than or equal to 'key'.  Returns NULL if no such record
+   is found. */
+void *bst_image_find_smallest_gte(struct bst_image *img, void *key)
+{
+        uint64_t cur = img->hdr->root;
+        void *best = NULL;
+
+        while (cur) {
+                struct bst_image_node *in = bst_image_node(img, cur);
+                int comparison = img->ops->compare(key, img->ops->get_key(bst_image_record(in)));
+
+                if (comparison < 0) {
+                        best = bst_image_record(in);
+                        cur = in->left;
+                } else if (comparison > 0) {
+                        cur = in->right;
+                } else
+                        return bst_image_record(in);
+        }
+
+        return best;
+}
+
+/* Find the largest record in an image whose key is less than or equal to 'key'.  Returns NULL if no such record is
+   found. */
+void *bst_image_find_largest_lte(struct bst_image *img, void *key)
+{
+        uint64_t cur = img->hdr->root;
+        void *best = NULL;
+
+        while (cur) {
+                struct bst_image_node *in = bst_image_node(img, cur);
+                int comparison = img->ops->compare(key, img->ops->get_key(bst_image_record(in)));
+
+                if (comparison < 0) {
+                        cur = in->left;
+                } else if (comparison > 0) {
+                        best = bst_image_record(in);
+                        cur = in->right;
+                } else
+                        return bst_image_record(in);
+        }
+
+        return best;
+}
+
+/* Given a record, return the record in the image with the next highest key.  If NULL is passed in, returns the record
+   with the smallest key.  If no more records exist, returns NULL. */
+void *bst_image_next(struct bst_image *img, void *record)
+{
+        struct bst_image_node *in;
+        uint64_t cur;
+
+        if (record == NULL) {
+                if (img->hdr->root == 0)
+                        return NULL;
+                in = bst_image_node(img, img->hdr->root);
+                while (in->left)
+                        in = bst_image_node(img, in->left);
+                return bst_image_record(in);
+        }
+
+        in = bst_image_record_node(record);
+        if (in->right) {
+                /* The next node is the left most child of our right subtree. */
+                in = bst_image_node(img, in->right);
+                while (in->left)
+                        in = bst_image_node(img, in->left);
+                return bst_image_record(in);
+        }
+
+        /* Walk up the tree until we walk up a left link; when we do that is the next node. */
+        cur = bst_image_offset(img, in);
+        while (in->parent) {
+                in = bst_image_node(img, in->parent);
+                if (in->left == cur)
+                        return bst_image_record(in);
+                cur = bst_image_offset(img, in);
+        }
+        return NULL;
+}
+
+/* Given a record, return the record in the image with the next lowest key.  If NULL is passed in, returns the record
+   with the largest key.  If no more records exist, returns NULL. */
+void *bst_image_prev(struct bst_image *img, void *record)
+{
+        struct bst_image_node *in;
+        uint64_t cur;
+
+        if (record == NULL) {
+                if (img->hdr->root == 0)
+                        return NULL;
+                in = bst_image_node(img, img->hdr->root);
+                while (in->right)
+                        in = bst_image_node(img, in->right);
+                return bst_image_record(in);
+        }
+
+        in = bst_image_record_node(record);
+        if (in->left) {
+                /* The next node is the right most child of our left subtree. */
+                in = bst_image_node(img, in->left);
+                while (in->right)
+                        in = bst_image_node(img, in->right);
+                return bst_image_record(in);
+        }
+
+        /* Walk up the tree until we walk up a right link; when we do that is the next node. */
+        cur = bst_image_offset(img, in);
+        while (in->parent) {
+                in = bst_image_node(img, in->parent);
+                if (in->right == cur)
+                        return bst_image_record(in);
+                cur = bst_image_offset(img, in);
+        }
+        return NULL;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,227 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bst-parallel.c - Multi-threaded scans over a BST. */
+
+#include <pthread.h>
+#include "mec-lib/bst-parallel.h"
+#include "mec-lib/util.h"
+
+
+
+/* How many ranges to cut the tree into for each thread. */
+#define BST_PARALLEL_RANGES_PER_THREAD  4
+
+#define BST_PARALLEL_MAX_RANGES         (BST_PARALLEL_MAX_THREADS * BST_PARALLEL_RANGES_PER_THREAD * 2)
+
+/* A range is a subtree, followed by the node that comes just after it (if any). */
+struct bst_parallel_range {
+        struct bst_node *subtree;
+        struct bst_node *after;
+};
+
+struct bst_parallel_scan {
+        struct bst *bst;
+        struct bst_parallel_range ranges[BST_PARALLEL_MAX_RANGES];
+        unsigned num_ranges;
+        unsigned next_range;
+        int ret;
+        int (*fn)(struct bst_node *n, void *arg, unsigned worker);
+        void *arg;
+};
+
+struct bst_parallel_worker {
+        pthread_t thread;
+        struct bst_parallel_scan *scan;
+        unsigned id;
+};
+
+/* Cut the subtree 'n' into ranges, going 'depth' levels down.  Every cut leaves the node it was made at as the node
+   after the range on its left. */
+static void bst_parallel_cut(struct bst_parallel_scan *scan, struct bst_node *n, unsigned depth)
+{
+        if ((depth == 0) || (n == bst_nil)) {
+                scan->ranges[scan->num_ranges].subtree = n;
+                scan->ranges[scan->num_ranges].after = NULL;
+                scan->num_ranges++;
+                return;
+        }
+
+        bst_parallel_cut(scan, n->left, depth - 1);
+        scan->ranges[scan->num_ranges - 1].after = n;
+        bst_parallel_cut(scan, n->right, depth - 1);
+}
+
+/* Visit every node of a range in order.  Returns non-zero if the scan should stop. */
+static int bst_parallel_visit(struct bst_parallel_scan *scan, struct bst_parallel_range *range, unsigned worker)
+{
+        struct bst_node *n, *last;
+        int ret;
+
+        if (range->subtree != bst_nil) {
+                for (n = range->subtree; n->left != bst_nil; n = n->left)
+                        ;
+                for (last = range->subtree; last->right != bst_nil; last = last->right)
+                        ;
+
+                for (;; n = bst_next(scan->bst, n)) {
+                        if (__atomic_load_n(&scan->ret, __ATOMIC_RELAXED))
+                                return 1;
+                        ret = scan->fn(n, scan->arg, worker);
+                        if (ret)
+                                goto stop;
+                        if (n == last)
+                                break;
+                }
+        }
+
+        if (range->after) {
+                ret = scan->fn(range->after, scan->arg, worker);
+                if (ret)
+                        goto stop;
+        }
+
+        return 0;
+
+stop:
+        /* Only the first error is kept. */
+        __atomic_compare_exchange_n(&scan->ret, &(int){ 0 }, ret, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        return 1;
+}
+
+static void *bst_parallel_worker(void *arg)
+{
+        struct bst_parallel_worker *w = arg;
+        struct bst_parallel_scan *scan = w->scan;
+        unsigned i;
+
+        while ((i = __atomic_fetch_add(&scan->next_range, 1, __ATOMIC_RELAXED)) < scan->num_ranges)
+                if (bst_parallel_visit(scan, &scan->ranges[i], w->id))
+                        break;
+
+        return NULL;
+}
+
+/* The number of threads a scan will actually use when asked for 'nthreads'. */
+static unsigned bst_parallel_threads(unsigned nthreads)
+{
+        return MEC_MAX(MEC_MIN(nthreads, BST_PARALLEL_MAX_THREADS), 1);
+}
+
+/* Run scan->fn over the whole tree on 'nthreads' threads (already clamped), the calling thread included. */
+static int bst_parallel_run(struct bst_parallel_scan *scan, unsigned nthreads)
+{
+        struct bst_parallel_worker workers[BST_PARALLEL_MAX_THREADS];
+        unsigned depth, started, i;
+
+        /* A balanced tree cut 'depth' levels down gives 2^depth subtrees of about the same size.  A splay tree isn't
+           balanced, so its ranges can be very uneven. */
+        for (depth = 0; (1U << depth) < nthreads * BST_PARALLEL_RANGES_PER_THREAD; depth++)
+                ;
+        if (nthreads == 1)
+                depth = 0;
+
+        scan->num_ranges = 0;
+        scan->next_range = 0;
+        scan->ret = 0;
+        bst_parallel_cut(scan, scan->bst->root, depth);
+
+        for (started = 1; started < nthreads; started++) {
+                workers[started].scan = scan;
+                workers[started].id = started;
+                if (pthread_create(&workers[started].thread, NULL, bst_parallel_worker, &workers[started]))
+                        break;
+        }
+
+        workers[0].scan = scan;
+        workers[0].id = 0;
+        bst_parallel_worker(&workers[0]);
+
+        for (i = 1; i < started; i++)
+                pthread_join(workers[i].thread, NULL);
+
+        return scan->ret;
+}
+
+struct bst_parallel_for_each_arg {
+        int (*fn)(struct bst_node *n, void *arg);
+        void *arg;
+};
+
+static int bst_parallel_for_each_fn(struct bst_node *n, void *arg, unsigned worker)
+{
+        struct bst_parallel_for_each_arg *fe = arg;
+
+        return fe->fn(n, fe->arg);
+}
+
+/* Call 'fn' on every item of a BST, using up to 'nthreads' threads. */
+int bst_parallel_for_each(struct bst *bst, unsigned nthreads, int (*fn)(struct bst_node *n, void *arg), void *arg)
+{
+        struct bst_parallel_for_each_arg fe = { .fn = fn, .arg = arg };
+        struct bst_parallel_scan scan = {
+                .bst = bst,
+                .fn = bst_parallel_for_each_fn,
+                .arg = &fe,
+        };
+
+        return bst_parallel_run(&scan, bst_parallel_threads(nthreads));
+}
+
+struct bst_parallel_reduce_arg {
+        char *accs;
+        size_t acc_size;
+        void (*map)(void *acc, struct bst_node *n);
+};
+
+static int bst_parallel_reduce_fn(struct bst_node *n, void *arg, unsigned worker)
+{
+        struct bst_parallel_reduce_arg *r = arg;
+
+        r->map(r->accs + (worker * r->acc_size), n);
+        return 0;
+}
+
+/* Fold every item of a BST into an accumulator, using up to 'nthreads' threads. */
+void bst_parallel_reduce(struct bst *bst, unsigned nthreads, void *accs, size_t acc_size,
+                         void (*map)(void *acc, struct bst_node *n), void (*combine)(void *acc, void *other))
+{
+        struct bst_parallel_reduce_arg r = { .accs = accs, .acc_size = acc_size, .map = map };
+        struct bst_parallel_scan scan = {
+                .bst = bst,
+                .fn = bst_parallel_reduce_fn,
+                .arg = &r,
+        };
+        unsigned i;
+
+        /* Map and combine must agree on how many accumulators there are. */
+        nthreads = bst_parallel_threads(nthreads);
+        bst_parallel_run(&scan, nthreads);
+
+        for (i = 1; i < nthreads; i++)
+                combine(accs, r.accs + (i * acc_size));
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,389 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* bst-shard.c - Range partitioned set of BST's for concurrent writers.
+ *
+ * Locking: every operation holds the routing lock for reading while it looks up which shard to use and works on it,
+ * and the shard's mutex while it touches the shard's tree.  Rebalancing holds the routing lock for writing, so it has
+ * every shard to itself and can move items and splitters around freely.
+ */
+
+#include <string.h>
+#include "mec-lib/bst-shard.h"
+#include "mec-lib/util.h"
+
+
+
+/* Once every shard is in use, a shard must be this much more than twice the size of its smaller neighbour before
+   rebalancing kicks in, so that two nearly empty shards don't keep bouncing items back and forth. */
+#define BST_SHARD_SLACK 16
+
+static inline void *bst_shard_splitter(struct bst_shard_set *s, unsigned i)
+{
+        return s->splitters + (i * s->key_size);
+}
+
+static inline size_t bst_shard_get_count(struct bst_shard *shard)
+{
+        return __atomic_load_n(&shard->count, __ATOMIC_RELAXED);
+}
+
+static inline void bst_shard_set_count(struct bst_shard *shard, size_t count)
+{
+        __atomic_store_n(&shard->count, count, __ATOMIC_RELAXED);
+}
+
+/* Return the index of the shard that holds 'key'.  That is the number of splitters that are less than or equal to
+   it.  Caller holds the routing lock. */
+static unsigned bst_shard_route(struct bst_shard_set *s, void *key)
+{
+        unsigned lo = 0;
+        unsigned hi = s->active_shards - 1;
+
+        while (lo < hi) {
+                unsigned mid = (lo + hi) / 2;
+
+                if (s->ops->compare(key, bst_shard_splitter(s, mid)) >= 0)
+                        lo = mid + 1;
+                else
+                        hi = mid;
+        }
+
+        return lo;
+}
+
+/* Returns non-zero if shard 'i' should be rebalanced.  Caller holds the routing lock; the neighbour's counts are read
+   without their locks, which is fine for a heuristic. */
+static int bst_shard_overfull(struct bst_shard_set *s, unsigned i)
+{
+        size_t count = bst_shard_get_count(&s->shards[i]);
+        size_t neighbour;
+
+        if ((count <= s->max_shard_items) || (s->num_shards == 1))
+                return 0;
+
+        if (s->active_shards < s->num_shards)
+                return 1;
+
+        if (i == 0)
+                neighbour = bst_shard_get_count(&s->shards[1]);
+        else if (i == s->active_shards - 1)
+                neighbour = bst_shard_get_count(&s->shards[i - 1]);
+        else
+                neighbour = MEC_MIN(bst_shard_get_count(&s->shards[i - 1]), bst_shard_get_count(&s->shards[i + 1]));
+
+        return count > ((2 * neighbour) + BST_SHARD_SLACK);
+}
+
+/* Move 'count' items from shard 'from' to the adjacent shard 'to', taking them from the end nearest to 'to', and
+   update the splitter between them.  Caller holds the routing lock for writing. */
+static void bst_shard_move(struct bst_shard_set *s, unsigned from, unsigned to, size_t count)
+{
+        struct bst_shard *src = &s->shards[from];
+        struct bst_shard *dst = &s->shards[to];
+        unsigned boundary = MEC_MIN(from, to);
+        struct bst_node *n;
+
+        while (count--) {
+                n = (to > from) ? bst_prev(&src->bst, NULL) : bst_next(&src->bst, NULL);
+                bst_delete(&src->bst, n);
+                bst_insert(&dst->bst, n);
+                src->count--;
+                dst->count++;
+        }
+
+        n = bst_next(&s->shards[boundary + 1].bst, NULL);
+        memcpy(bst_shard_splitter(s, boundary), s->ops->get_key(n), s->key_size);
+}
+
+/* Split shard 'i' in two by moving the upper half of it into a new shard right after it.  Caller holds the routing
+   lock for writing. */
+static void bst_shard_split(struct bst_shard_set *s, unsigned i)
+{
+        unsigned j;
+
+        /* Shuffle the later shards and splitters up by one to make room.  The mutexes stay where they are. */
+        for (j = s->active_shards; j > i + 1; j--) {
+                s->shards[j].bst = s->shards[j - 1].bst;
+                s->shards[j].count = s->shards[j - 1].count;
+                memcpy(bst_shard_splitter(s, j - 1), bst_shard_splitter(s, j - 2), s->key_size);
+        }
+
+        bst_init(&s->shards[i + 1].bst, s->ops);
+        s->shards[i + 1].count = 0;
+        s->active_shards++;
+
+        bst_shard_move(s, i, i + 1, s->shards[i].count / 2);
+}
+
+/* Rebalance every shard that needs it. */
+static void bst_shard_rebalance(struct bst_shard_set *s)
+{
+        unsigned i, j;
+
+        pthread_rwlock_wrlock(&s->routing);
+
+        /* Somebody else may already have done the work while we were waiting for the lock. */
+        for (i = 0; i < s->active_shards; i++) {
+                if (!bst_shard_overfull(s, i))
+                        continue;
+
+                if (s->active_shards < s->num_shards) {
+                        bst_shard_split(s, i);
+                        i++;
+                        continue;
+                }
+
+                if (i == 0)
+                        j = 1;
+                else if (i == s->active_shards - 1)
+                        j = i - 1;
+                else
+                        j = (s->shards[i - 1].count < s->shards[i + 1].count) ? i - 1 : i + 1;
+
+                bst_shard_move(s, i, j, (s->shards[i].count - s->shards[j].count) / 2);
+        }
+
+        pthread_rwlock_unlock(&s->routing);
+}
+
+/* Initialize a sharded BST using caller-supplied arrays of shards and splitter keys. */
+void bst_shard_init(struct bst_shard_set *s, struct bst_ops *ops, struct bst_shard *shards, unsigned num_shards,
+                    void *splitters, size_t key_size, size_t max_shard_items)
+{
+        pthread_rwlockattr_t attr;
+        unsigned i;
+
+        s->ops = ops;
+        s->shards = shards;
+        s->num_shards = num_shards;
+        s->active_shards = 1;
+        s->splitters = splitters;
+        s->key_size = key_size;
+        /* A shard needs at least two items to be split. */
+        s->max_shard_items = max_shard_items ? max_shard_items : 1;
+
+        /* Don't let a steady stream of readers starve out rebalancing. */
+        pthread_rwlockattr_init(&attr);
+        pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+        pthread_rwlock_init(&s->routing, &attr);
+        pthread_rwlockattr_destroy(&attr);
+
+        for (i = 0; i < num_shards; i++) {
+                pthread_mutex_init(&shards[i].lock, NULL);
+                bst_init(&shards[i].bst, ops);
+                shards[i].count = 0;
+        }
+}
+
+/* Release the locks of a sharded BST.  The items still in it are left alone. */
+void bst_shard_destroy(struct bst_shard_set *s)
+{
+        unsigned i;
+
+        for (i = 0; i < s->num_shards; i++)
+                pthread_mutex_destroy(&s->shards[i].lock);
+        pthread_rwlock_destroy(&s->routing);
+}
+
+/* Insert an item into a sharded BST.  Returns 0 on success, non-zero on error. */
+int bst_shard_insert(struct bst_shard_set *s, struct bst_node *n)
+{
+        struct bst_shard *shard;
+        int ret, rebalance;
+        unsigned i;
+
+        pthread_rwlock_rdlock(&s->routing);
+
+        i = bst_shard_route(s, s->ops->get_key(n));
+        shard = &s->shards[i];
+
+        pthread_mutex_lock(&shard->lock);
+        ret = bst_insert(&shard->bst, n);
+        if (ret == 0)
+                bst_shard_set_count(shard, shard->count + 1);
+        rebalance = (ret == 0) && bst_shard_overfull(s, i);
+        pthread_mutex_unlock(&shard->lock);
+
+        pthread_rwlock_unlock(&s->routing);
+
+        if (rebalance)
+                bst_shard_rebalance(s);
+
+        return ret;
+}
+
+/* Remove an item from a sharded BST.  Returns 0 on success, non-zero on error. */
+int bst_shard_delete(struct bst_shard_set *s, struct bst_node *n)
+{
+        struct bst_shard *shard;
+        int ret;
+
+        pthread_rwlock_rdlock(&s->routing);
+
+        shard = &s->shards[bst_shard_route(s, s->ops->get_key(n))];
+
+        pthread_mutex_lock(&shard->lock);
+        ret = bst_delete(&shard->bst, n);
+        if (ret == 0)
+                bst_shard_set_count(shard, shard->count - 1);
+        pthread_mutex_unlock(&shard->lock);
+
+        pthread_rwlock_unlock(&s->routing);
+
+        return ret;
+}
+
+/* Find an item in a sharded BST.  Returns a pointer to the node, or NULL if item was not found. */
+struct bst_node *bst_shard_find(struct bst_shard_set *s, void *key)
+{
+        struct bst_shard *shard;
+        struct bst_node *n;
+
+        pthread_rwlock_rdlock(&s->routing);
+
+        shard = &s->shards[bst_shard_route(s, key)];
+
+        pthread_mutex_lock(&shard->lock);
+        n = bst_find(&shard->bst, key);
+        pthread_mutex_unlock(&shard->lock);
+
+        pthread_rwlock_unlock(&s->routing);
+
+        return n;
+}
+
+/* Starting in shard 'i', return the next node after 'n' (or before it, if 'forward' is 0), crossing into later (or
+   earlier) shards if 'n' is the last one in its shard.  If 'n' is NULL, start from the first (or last) node of shard
+   'i'.  Caller holds the routing lock. */
+static struct bst_node *bst_shard_step(struct bst_shard_set *s, unsigned i, struct bst_node *n, int forward)
+{
+        struct bst_shard *shard;
+
+        while (1) {
+                shard = &s->shards[i];
+
+                pthread_mutex_lock(&shard->lock);
+                n = forward ? bst_next(&shard->bst, n) : bst_prev(&shard->bst, n);
+                pthread_mutex_unlock(&shard->lock);
+
+                if (n)
+                        return n;
+
+                if (forward ? (i + 1 == s->active_shards) : (i == 0))
+                        return NULL;
+
+                i = forward ? i + 1 : i - 1;
+        }
+}
+
+/* Find the smallest item in a sharded BST whose key is greater than or equal to 'key'.  Returns NULL if no such item
+   is found. */
+struct bst_node *bst_shard_find_smallest_gte(struct bst_shard_set *s, void *key)
+{
+        struct bst_shard *shard;
+        struct bst_node *n;
+        unsigned i;
+
+        pthread_rwlock_rdlock(&s->routing);
+
+        i = bst_shard_route(s, key);
+        shard = &s->shards[i];
+
+        pthread_mutex_lock(&shard->lock);
+        n = bst_find_smallest_gte(&shard->bst, key);
+        pthread_mutex_unlock(&shard->lock);
+
+        /* Everything in the following shard is bigger than the key. */
+        if (!n && (i + 1 < s->active_shards))
+                n = bst_shard_step(s, i + 1, NULL, 1);
+
+        pthread_rwlock_unlock(&s->routing);
+
+        return n;
+}
+
+/* Find the largest item in a sharded BST whose key is less than or equal to 'key'.  Returns NULL if no such item is
+   found. */
+struct bst_node *bst_shard_find_largest_lte(struct bst_shard_set *s, void *key)
+{
+        struct bst_shard *shard;
+        struct bst_node *n;
+        unsigned i;
+
+        pthread_rwlock_rdlock(&s->routing);
+
+        i = bst_shard_route(s, key);
+        shard = &s->shards[i];
+
+        pthread_mutex_lock(&shard->lock);
+        n = bst_find_largest_lte(&shard->bst, key);
+        pthread_mutex_unlock(&shard->lock);
+
+        if (!n && (i > 0))
+                n = bst_shard_step(s, i - 1, NULL, 0);
+
+        pthread_rwlock_unlock(&s->routing);
+
+        return n;
+}
+
+/* Given a node, return a pointer to the node in the set with the next highest key.  If NULL is passed in, returns a
+   pointer to the node with the smallest key.  If no more nodes exist, returns NULL. */
+struct bst_node *bst_shard_next(struct bst_shard_set *s, struct bst_node *n)
+{
+        pthread_rwlock_rdlock(&s->routing);
+        n = bst_shard_step(s, n ? bst_shard_route(s, s->ops->get_key(n)) : 0, n, 1);
+        pthread_rwlock_unlock(&s->routing);
+
+        return n;
+}
+
+/* Given a node, return a pointer to the node in the set with the next lowest key.  If NULL is passed in, returns a
+   pointer to the node with the largest key.  If no more nodes exist, returns NULL. */
+struct bst_node *bst_shard_prev(struct bst_shard_set *s, struct bst_node *n)
+{
+        pthread_rwlock_rdlock(&s->routing);
+        n = bst_shard_step(s, n ? bst_shard_route(s, s->ops->get_key(n)) : s->active_shards - 1, n, 0);
+        pthread_rwlock_unlock(&s->routing);
+
+        return n;
+}
+
+/* Return the number of items in a sharded BST. */
+size_t bst_shard_count(struct bst_shard_set *s)
+{
+        size_t count = 0;
+        unsigned i;
+
+        pthread_rwlock_rdlock(&s->routing);
+        for (i = 0; i < s->active_shards; i++)
+                count += bst_shard_get_count(&s->shards[i]);
+        pthread_rwlock_unlock(&s->routing);
+
+        return count;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -15,13 +15,21 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
-/* bst.c - Binary search tree - currently implemented as an AA Tree
+/* bst.c - Binary search tree - implemented as an AA Tree
  * (or Andersson Tree).  See: http://en.wikipedia.org/wiki/AA_tree
+ * or optionally as a red-black tree.
  */
 
 #include "mec-lib/bst.h"
 #include "mec-lib/util.h"
 
+#ifdef BST_STATS
+#include <string.h>
+#endif
+#ifdef BST_STATS_LATENCY
+#include <time.h>
+#endif
+
 
 
 /* This is used internally by the implementation, but may be useful for external code that wants to walk the tree
@@ -37,11 +45,87 @@ struct bst_node *bst_nil = (struct bst_node *)&bst_nil_node;
 
 
 
+#ifdef BST_STATS
+#define BST_STATS_INC(bst, field)       ((bst)->stats.field++)
+#define BST_STATS_BEGIN(bst)            uint64_t _bst_stats_start = bst_stats_begin(bst)
+#define BST_STATS_END(bst, op)          bst_stats_end(bst, op, _bst_stats_start)
+
+/* Start counting an operation.  Returns the start time if latency is being measured. */
+static inline uint64_t bst_stats_begin(struct bst *bst)
+{
+        bst->stats.cur_comparisons = 0;
+        bst->stats.cur_depth = 0;
+
+#ifdef BST_STATS_LATENCY
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+        return 0;
+#endif
+}
+
+/* Add the counts for the operation that just finished to the totals. */
+static inline void bst_stats_end(struct bst *bst, enum bst_stats_op op, uint64_t start)
+{
+        struct bst_stats *stats = &bst->stats;
+
+        stats->ops[op]++;
+        stats->comparisons[op] += stats->cur_comparisons;
+        stats->depth[op] += stats->cur_depth;
+        if (stats->cur_depth > stats->max_depth[op])
+                stats->max_depth[op] = stats->cur_depth;
+
+#ifdef BST_STATS_LATENCY
+        struct timespec ts;
+        uint64_t ns;
+        unsigned bucket;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        ns = ts.tv_sec * 1000000000ULL + ts.tv_nsec - start;
+        bucket = 63 - __builtin_clzll(ns | 1);
+        stats->latency[op][MEC_MIN(bucket, BST_STATS_LATENCY_BUCKETS - 1)]++;
+#endif
+}
+#else
+#define BST_STATS_INC(bst, field)       do { } while (0)
+#define BST_STATS_BEGIN(bst)            do { } while (0)
+#define BST_STATS_END(bst, op)          do { } while (0)
+#endif
+
+/* Compare a key (and its prefix, if the tree uses them) with a node's key. */
+static inline int bst_compare(struct bst *bst, void *key, uint64_t prefix, struct bst_node *n)
+{
+        if (bst->ops->get_prefix) {
+                uint64_t n_prefix = BST_PREFIX_NODE(n)->prefix;
+
+                if (prefix != n_prefix)
+                        return (prefix < n_prefix) ? -1 : 1;
+        }
+
+        BST_STATS_INC(bst, cur_comparisons);
+        return bst->ops->compare(key, bst->ops->get_key(n));
+}
+
+/* Return the prefix of 'key', or 0 if the tree does not use prefixes. */
+static inline uint64_t bst_key_prefix(struct bst *bst, void *key)
+{
+        return bst->ops->get_prefix ? bst->ops->get_prefix(key) : 0;
+}
+
 /* Initalize a BST. */
 void bst_init(struct bst *bst, struct bst_ops *ops)
+{
+        bst_init_balanced(bst, ops, BST_BALANCE_AA);
+}
+
+/* Initalize a BST that uses the given balancing scheme. */
+void bst_init_balanced(struct bst *bst, struct bst_ops *ops, enum bst_balance balance)
 {
         bst->root = bst_nil;
         bst->ops = ops;
+        bst->balance = balance;
 }
 
 /* The AA tree skew operation - repair a left horizontal link. */
@@ -53,6 +137,8 @@ static struct bst_node *bst_skew(struct bst *bst, struct bst_node *n)
                 /* Horizontal left link - do a left rotate to eliminate it. */
                 struct bst_node *l = n->left;
 
+                BST_STATS_INC(bst, skews);
+
                 l->parent = n->parent;
                 if (n->parent == NULL)
                         bst->root = l;
@@ -84,6 +170,8 @@ static struct bst_node *bst_split(struct bst *bst, struct bst_node *n)
                 /* We have two horizontal right links - repair it by popping the middle node up a level. */
                 struct bst_node *r = n->right;
 
+                BST_STATS_INC(bst, splits);
+
                 r->parent = n->parent;
                 if (n->parent == NULL)
                         bst->root = r;
@@ -105,28 +193,305 @@ static struct bst_node *bst_split(struct bst *bst, struct bst_node *n)
         }
 }
 
+/* Red-black trees keep the colour of each node in 'level'.  Neither colour is 0, which means a node isn't in a tree.
+   bst_nil does have level 0 and counts as black, so colours are always tested for red, never for black.  bst_nil
+   must never be written to, so the code below always checks a node isn't bst_nil before changing it. */
+#define BST_RB_BLACK 1
+#define BST_RB_RED   2
+
+/* Replace 'n' with 'r' in n's parent (or as the root). */
+static inline void bst_replace_child(struct bst *bst, struct bst_node *n, struct bst_node *r)
+{
+        if (n->parent == NULL)
+                bst->root = r;
+        else if (n->parent->left == n)
+                n->parent->left = r;
+        else
+                n->parent->right = r;
+}
+
+/* Rotate n's right child up into n's place. */
+static void bst_rotate_left(struct bst *bst, struct bst_node *n)
+{
+        struct bst_node *r = n->right;
+
+        BST_STATS_INC(bst, rotations);
+
+        n->right = r->left;
+        if (r->left != bst_nil)
+                r->left->parent = n;
+        r->parent = n->parent;
+        bst_replace_child(bst, n, r);
+        r->left = n;
+        n->parent = r;
+}
+
+/* Rotate n's left child up into n's place. */
+static void bst_rotate_right(struct bst *bst, struct bst_node *n)
+{
+        struct bst_node *l = n->left;
+
+        BST_STATS_INC(bst, rotations);
+
+        n->left = l->right;
+        if (l->right != bst_nil)
+                l->right->parent = n;
+        l->parent = n->parent;
+        bst_replace_child(bst, n, l);
+        l->right = n;
+        n->parent = l;
+}
+
+/* Restore the red-black properties after 'n' has been added as a red leaf.  Returns non-zero if that added one to the
+   black height of the tree, which happens just when the root has to be turned black at the end. */
+static int bst_rb_insert_fixup(struct bst *bst, struct bst_node *n)
+{
+        struct bst_node *p, *g, *u;
+        int grew;
+
+        while ((p = n->parent) && (p->level == BST_RB_RED)) {
+                /* The parent is red, so it isn't the root, and the grandparent exists. */
+                g = p->parent;
+
+                if (p == g->left) {
+                        u = g->right;
+                        if (u->level == BST_RB_RED) {
+                                /* Red uncle - recolour and carry on from the grandparent. */
+                                p->level = u->level = BST_RB_BLACK;
+                                g->level = BST_RB_RED;
+                                n = g;
+                                continue;
+                        }
+                        if (n == p->right) {
+                                bst_rotate_left(bst, p);
+                                n = p;
+                                p = n->parent;
+                        }
+                        p->level = BST_RB_BLACK;
+                        g->level = BST_RB_RED;
+                        bst_rotate_right(bst, g);
+                } else {
+                        u = g->left;
+                        if (u->level == BST_RB_RED) {
+                                p->level = u->level = BST_RB_BLACK;
+                                g->level = BST_RB_RED;
+                                n = g;
+                                continue;
+                        }
+                        if (n == p->left) {
+                                bst_rotate_right(bst, p);
+                                n = p;
+                                p = n->parent;
+                        }
+                        p->level = BST_RB_BLACK;
+                        g->level = BST_RB_RED;
+                        bst_rotate_left(bst, g);
+                }
+        }
+
+        grew = (bst->root->level == BST_RB_RED);
+        bst->root->level = BST_RB_BLACK;
+        return grew;
+}
+
+/* Restore the red-black properties after a black node was removed from above 'x', which is now short one black node
+   on every path.  'x' may be bst_nil, so its parent is passed separately. */
+static void bst_rb_delete_fixup(struct bst *bst, struct bst_node *x, struct bst_node *parent)
+{
+        struct bst_node *w;
+
+        while ((x != bst->root) && (x->level != BST_RB_RED)) {
+                BST_STATS_INC(bst, cur_depth);
+
+                if (x == parent->left) {
+                        w = parent->right;
+                        if (w->level == BST_RB_RED) {
+                                w->level = BST_RB_BLACK;
+                                parent->level = BST_RB_RED;
+                                bst_rotate_left(bst, parent);
+                                w = parent->right;
+                        }
+                        if ((w->left->level != BST_RB_RED) && (w->right->level != BST_RB_RED)) {
+                                w->level = BST_RB_RED;
+                                x = parent;
+                                parent = x->parent;
+                        } else {
+                                if (w->right->level != BST_RB_RED) {
+                                        w->left->level = BST_RB_BLACK;
+                                        w->level = BST_RB_RED;
+                                        bst_rotate_right(bst, w);
+                                        w = parent->right;
+                                }
+                                w->level = parent->level;
+                                parent->level = BST_RB_BLACK;
+                                w->right->level = BST_RB_BLACK;
+                                bst_rotate_left(bst, parent);
+                                x = bst->root;
+                        }
+                } else {
+                        w = parent->left;
+                        if (w->level == BST_RB_RED) {
+                                w->level = BST_RB_BLACK;
+                                parent->level = BST_RB_RED;
+                                bst_rotate_right(bst, parent);
+                                w = parent->left;
+                        }
+                        if ((w->right->level != BST_RB_RED) && (w->left->level != BST_RB_RED)) {
+                                w->level = BST_RB_RED;
+                                x = parent;
+                                parent = x->parent;
+                        } else {
+                                if (w->left->level != BST_RB_RED) {
+                                        w->right->level = BST_RB_BLACK;
+                                        w->level = BST_RB_RED;
+                                        bst_rotate_left(bst, w);
+                                        w = parent->left;
+                                }
+                                w->level = parent->level;
+                                parent->level = BST_RB_BLACK;
+                                w->left->level = BST_RB_BLACK;
+                                bst_rotate_right(bst, parent);
+                                x = bst->root;
+                        }
+                }
+        }
+
+        if (x != bst_nil)
+                x->level = BST_RB_BLACK;
+}
+
+/* Remove 'n' from a red-black tree. */
+static void bst_rb_delete(struct bst *bst, struct bst_node *n)
+{
+        struct bst_node *y, *x, *x_parent;
+        unsigned colour;
+
+        /* 'y' is the node that actually comes out of its place in the tree: 'n' itself if it has at most one child,
+           otherwise its successor, which then takes over n's place. */
+        if ((n->left == bst_nil) || (n->right == bst_nil))
+                y = n;
+        else
+                for (y = n->right; y->left != bst_nil; y = y->left)
+                        ;
+
+        x = (y->left != bst_nil) ? y->left : y->right;
+        x_parent = y->parent;
+        if (x != bst_nil)
+                x->parent = y->parent;
+        bst_replace_child(bst, y, x);
+        colour = y->level;
+
+        if (y != n) {
+                if (x_parent == n)
+                        x_parent = y;
+
+                y->parent = n->parent;
+                bst_replace_child(bst, n, y);
+                y->left = n->left;
+                if (y->left != bst_nil)
+                        y->left->parent = y;
+                y->right = n->right;
+                if (y->right != bst_nil)
+                        y->right->parent = y;
+                y->level = n->level;
+        }
+
+        if (colour != BST_RB_RED)
+                bst_rb_delete_fixup(bst, x, x_parent);
+}
+
+/* Lookups in a splay tree leave a node alone if it was found within this many levels of the root.  Splaying it would
+   cost more than it saves, and every splay pushes the other hot keys near the top back down.  This only adds a
+   constant to the amortized cost of an access. */
+#define BST_SPLAY_MIN_DEPTH     16
+
+/* Move 'n' up to the root of a splay tree, by zig-zig and zig-zag steps, and a final zig if needed. */
+static void bst_splay(struct bst *bst, struct bst_node *n)
+{
+        struct bst_node *p, *g;
+
+        while ((p = n->parent) != NULL) {
+                g = p->parent;
+
+                if (g == NULL) {
+                        if (n == p->left)
+                                bst_rotate_right(bst, p);
+                        else
+                                bst_rotate_left(bst, p);
+                } else if ((n == p->left) && (p == g->left)) {
+                        bst_rotate_right(bst, g);
+                        bst_rotate_right(bst, p);
+                } else if ((n == p->right) && (p == g->right)) {
+                        bst_rotate_left(bst, g);
+                        bst_rotate_left(bst, p);
+                } else if (n == p->left) {
+                        bst_rotate_right(bst, p);
+                        bst_rotate_left(bst, g);
+                } else {
+                        bst_rotate_left(bst, p);
+                        bst_rotate_right(bst, g);
+                }
+        }
+}
+
+/* Remove 'n' from a splay tree: splay it to the root, then join its subtrees by splaying the largest node on the left
+   up to the top of the left subtree, where it has no right child. */
+static void bst_splay_delete(struct bst *bst, struct bst_node *n)
+{
+        struct bst_node *l, *r;
+
+        bst_splay(bst, n);
+        l = n->left;
+        r = n->right;
+
+        if (l == bst_nil) {
+                bst->root = r;
+                if (r != bst_nil)
+                        r->parent = NULL;
+                return;
+        }
+
+        bst->root = l;
+        l->parent = NULL;
+        while (l->right != bst_nil)
+                l = l->right;
+        bst_splay(bst, l);
+
+        l->right = r;
+        if (r != bst_nil)
+                r->parent = l;
+}
+
 /* Insert an item into a BST.  Returns 0 on success, non-zero on error. */
 int bst_insert(struct bst *bst, struct bst_node *n)
 {
         void *k = bst->ops->get_key(n);
+        uint64_t prefix = bst_key_prefix(bst, k);
         struct bst_node *cur;
+        BST_STATS_BEGIN(bst);
 
         /* Initialize n as a leaf node. */
-        n->level = 1;
+        n->level = (bst->balance == BST_BALANCE_RB) ? BST_RB_RED : 1;
         n->left = n->right = bst_nil;
+        if (bst->ops->get_prefix)
+                BST_PREFIX_NODE(n)->prefix = prefix;
 
         /* Handle insertion into an empty tree. */
         if (bst->root == bst_nil) {
                 n->parent = NULL;
                 bst->root = n;
+                if (bst->balance == BST_BALANCE_RB)
+                        n->level = BST_RB_BLACK;
+                BST_STATS_END(bst, BST_STATS_INSERT);
                 return 0;
         }
 
         /* Find the proper place in the tree to insert this node as a leaf. */
         cur = bst->root;
         while (1) {
-                void *cur_key = bst->ops->get_key(cur);
-                int comparison = bst->ops->compare(k, cur_key);
+                int comparison = bst_compare(bst, k, prefix, cur);
+
+                BST_STATS_INC(bst, cur_depth);
 
                 if (comparison < 0) {
                         if (cur->left == bst_nil) {
@@ -146,24 +511,32 @@ int bst_insert(struct bst *bst, struct bst_node *n)
                         }
                 } else {
                         /* Two items with the same key not allowed! */
+                        BST_STATS_END(bst, BST_STATS_INSERT);
                         return 1;
                 }
         }
 
-        /* Now walk back up the tree to repair any temporary damage. */
-        while (n) {
-                n = bst_skew(bst, n);
-                n = bst_split(bst, n);
-                n = n->parent;
+        /* Now walk back up the tree to repair any temporary damage.  For a red-black tree, n is a red leaf already. */
+        if (bst->balance == BST_BALANCE_RB) {
+                bst_rb_insert_fixup(bst, n);
+        } else if (bst->balance == BST_BALANCE_SPLAY) {
+                bst_splay(bst, n);
+        } else {
+                while (n) {
+                        n = bst_skew(bst, n);
+                        n = bst_split(bst, n);
+                        n = n->parent;
+                }
         }
 
+        BST_STATS_END(bst, BST_STATS_INSERT);
         return 0;
 }
 
-/* Remove an item from a BST.  Returns 0 on success, non-zero on error. */
-int bst_delete(struct bst *bst, struct bst_node *n)
+/* Remove 'n' from an AA tree. */
+static void bst_aa_delete(struct bst *bst, struct bst_node *n)
 {
-        struct bst_node *r;
+        struct bst_node *r = NULL;
         struct bst_node *cur;
 
         /* If the node to be deleted is a leaf node, then just remove it. */
@@ -192,6 +565,8 @@ int bst_delete(struct bst *bst, struct bst_node *n)
 
         /* Walk back up the tree rebalancing as we go.  If we find 'n', then substitute 'r' in its place. */
         while (cur) {
+                BST_STATS_INC(bst, cur_depth);
+
                 if (cur == n) {
                         /* Put the node 'r' here. */
                         r->parent = cur->parent;
@@ -228,84 +603,136 @@ int bst_delete(struct bst *bst, struct bst_node *n)
 
                 cur = cur->parent;
         }
+}
+
+/* Remove an item from a BST.  Returns 0 on success, non-zero on error. */
+int bst_delete(struct bst *bst, struct bst_node *n)
+{
+        BST_STATS_BEGIN(bst);
+
+        if (bst->balance == BST_BALANCE_RB)
+                bst_rb_delete(bst, n);
+        else if (bst->balance == BST_BALANCE_SPLAY)
+                bst_splay_delete(bst, n);
+        else
+                bst_aa_delete(bst, n);
 
         /* Clean up the node we just deleted. */
         n->level = 0;
         n->parent = n->left = n->right = NULL;
 
+        BST_STATS_END(bst, BST_STATS_DELETE);
         return 0;
 }
 
 /* Find an item in a BST.  Returns a pointer to the node, or NULL if item was not found. */
 struct bst_node *bst_find(struct bst *bst, void *key)
 {
-        struct bst_node *cur;
+        uint64_t prefix = bst_key_prefix(bst, key);
+        struct bst_node *cur, *last = NULL;
+        unsigned depth = 0;
+        BST_STATS_BEGIN(bst);
 
         cur = bst->root;
         while (cur != bst_nil) {
-                void *cur_key = bst->ops->get_key(cur);
-                int comparison = bst->ops->compare(key, cur_key);
+                int comparison = bst_compare(bst, key, prefix, cur);
 
+                BST_STATS_INC(bst, cur_depth);
+                depth++;
+                last = cur;
                 if (comparison < 0)
                         cur = cur->left;
                 else if (comparison > 0)
                         cur = cur->right;
                 else
-                        return cur;
+                        break;
         }
 
-        return NULL;
+        /* A splay tree brings the node found, or the last one looked at if there wasn't one, up to the root. */
+        if ((bst->balance == BST_BALANCE_SPLAY) && (depth > BST_SPLAY_MIN_DEPTH))
+                bst_splay(bst, last);
+
+        BST_STATS_END(bst, BST_STATS_FIND);
+        return (cur != bst_nil) ? cur : NULL;
 }
 
 /* Find the smallest item in a BST whose key is greater than or equal to 'key'.  Returns NULL if no such item is
    found. */
 struct bst_node *bst_find_smallest_gte(struct bst *bst, void *key)
 {
-        struct bst_node *cur;
+        uint64_t prefix = bst_key_prefix(bst, key);
+        struct bst_node *cur, *found = NULL;
+        unsigned depth = 0;
+        BST_STATS_BEGIN(bst);
 
         cur = bst->root;
         while (cur != bst_nil) {
-                void *cur_key = bst->ops->get_key(cur);
-                int comparison = bst->ops->compare(key, cur_key);
+                int comparison = bst_compare(bst, key, prefix, cur);
 
+                BST_STATS_INC(bst, cur_depth);
+                depth++;
                 if (comparison < 0) {
-                        if (cur->left == bst_nil)
-                                return cur;
+                        if (cur->left == bst_nil) {
+                                found = cur;
+                                break;
+                        }
                         cur = cur->left;
                 } else if (comparison > 0) {
-                        if (cur->right == bst_nil)
-                                return bst_next(bst, cur);
+                        if (cur->right == bst_nil) {
+                                found = bst_next(bst, cur);
+                                break;
+                        }
                         cur = cur->right;
-                } else
-                        return cur;
+                } else {
+                        found = cur;
+                        break;
+                }
         }
 
-        return NULL;
+        if ((bst->balance == BST_BALANCE_SPLAY) && (depth > BST_SPLAY_MIN_DEPTH))
+                bst_splay(bst, found ? found : cur);
+
+        BST_STATS_END(bst, BST_STATS_GTE);
+        return found;
 }
 
 /* Find the largest item in a BST whose key is less than or equal to 'key'.  Returns NULL if no such item is found. */
 struct bst_node *bst_find_largest_lte(struct bst *bst, void *key)
 {
-        struct bst_node *cur;
+        uint64_t prefix = bst_key_prefix(bst, key);
+        struct bst_node *cur, *found = NULL;
+        unsigned depth = 0;
+        BST_STATS_BEGIN(bst);
 
         cur = bst->root;
         while (cur != bst_nil) {
-                void *cur_key = bst->ops->get_key(cur);
-                int comparison = bst->ops->compare(key, cur_key);
+                int comparison = bst_compare(bst, key, prefix, cur);
 
+                BST_STATS_INC(bst, cur_depth);
+                depth++;
                 if (comparison < 0) {
-                        if (cur->left == bst_nil)
-                                return bst_prev(bst, cur);
+                        if (cur->left == bst_nil) {
+                                found = bst_prev(bst, cur);
+                                break;
+                        }
                         cur = cur->left;
                 } else if (comparison > 0) {
-                        if (cur->right == bst_nil)
-                                return cur;
+                        if (cur->right == bst_nil) {
+                                found = cur;
+                                break;
+                        }
                         cur = cur->right;
-                } else
-                        return cur;
+                } else {
+                        found = cur;
+                        break;
+                }
         }
 
-        return NULL;
+        if ((bst->balance == BST_BALANCE_SPLAY) && (depth > BST_SPLAY_MIN_DEPTH))
+                bst_splay(bst, found ? found : cur);
+
+        BST_STATS_END(bst, BST_STATS_LTE);
+        return found;
 }
 
 /* Given a node, return a pointer to the node in the tree with the next highest key.  If NULL is passed in, returns a
@@ -374,6 +801,413 @@ struct bst_node *bst_prev(struct bst *bst, struct bst_node *n)
         }
 }
 
+/* Return the number of items in a BST.  Note that this walks the whole tree, so it is O(n). */
+size_t bst_count(struct bst *bst)
+{
+        struct bst_node *n;
+        size_t count = 0;
+
+        for (n = bst_next(bst, NULL); n; n = bst_next(bst, n))
+                count++;
+
+        return count;
+}
+
+/* Make 'c' the left or right child of 'p'. */
+static inline void bst_set_left(struct bst_node *p, struct bst_node *c)
+{
+        p->left = c;
+        if (c != bst_nil)
+                c->parent = p;
+}
+
+static inline void bst_set_right(struct bst_node *p, struct bst_node *c)
+{
+        p->right = c;
+        if (c != bst_nil)
+                c->parent = p;
+}
+
+/* Cut 'n' loose from its parent, so that it can be used as the root of a tree on its own. */
+static inline struct bst_node *bst_detach(struct bst_node *n)
+{
+        if (n != bst_nil)
+                n->parent = NULL;
+        return n;
+}
+
+/* Join AA trees 'l' and 'r' with 'k' between them; every key in 'l' is less than k's, and every key in 'r' greater.
+   'k' is hung off the spine of the taller tree at the level of the shorter one, and then repaired just as if it had
+   been inserted there, which costs O(difference in levels).  Uses bst->root as scratch, and returns the new root. */
+static struct bst_node *bst_aa_join(struct bst *bst, struct bst_node *l, struct bst_node *k, struct bst_node *r)
+{
+        struct bst_node *c, *p = NULL;
+
+        k->parent = NULL;
+
+        if (l->level == r->level) {
+                bst_set_left(k, l);
+                bst_set_right(k, r);
+                k->level = l->level + 1;
+                return k;
+        }
+
+        if (l->level > r->level) {
+                /* Levels down the right spine drop by at most one at a time, so this stops at the top of the first
+                   horizontal pair (or single node) at r's level. */
+                bst->root = bst_detach(l);
+                for (c = l; c->level > r->level; c = c->right)
+                        p = c;
+                bst_set_left(k, c);
+                bst_set_right(k, r);
+                k->level = r->level + 1;
+                bst_set_right(p, k);
+        } else {
+                bst->root = bst_detach(r);
+                for (c = r; c->level > l->level; c = c->left)
+                        p = c;
+                bst_set_left(k, l);
+                bst_set_right(k, c);
+                k->level = l->level + 1;
+                bst_set_left(p, k);
+        }
+
+        for (c = k; c; c = c->parent) {
+                c = bst_skew(bst, c);
+                c = bst_split(bst, c);
+        }
+
+        return bst->root;
+}
+
+/* Return the number of black nodes on every path down from 'n'. */
+static unsigned bst_rb_black_height(struct bst_node *n)
+{
+        unsigned height = 0;
+
+        for (; n != bst_nil; n = n->left)
+                if (n->level != BST_RB_RED)
+                        height++;
+
+        return height;
+}
+
+/* Return the black height a child 'n' will have once its root is black, given the black height 'height' its parent
+   has with its own root black. */
+static inline unsigned bst_rb_child_height(unsigned height, struct bst_node *n)
+{
+        if ((n != bst_nil) && (n->level == BST_RB_RED))
+                return height;
+
+        return height - 1;
+}
+
+/* Join red-black trees 'l' and 'r' with 'k' between them, as for bst_aa_join().  'k' goes in red in place of the first
+   black node down the spine of the taller tree with the same black height as the shorter one.  'l_height' and
+   'r_height' are the black heights of the two once their roots are black; the caller keeps track of them, since
+   working them out here would make every join O(log n).  The black height of the result is stored in *height. */
+static struct bst_node *bst_rb_join(struct bst *bst, struct bst_node *l, unsigned l_height, struct bst_node *k,
+                                    struct bst_node *r, unsigned r_height, unsigned *height)
+{
+        struct bst_node *c, *p = NULL;
+        unsigned h;
+
+        /* A red root can always be made black; it just adds one to the black height of the whole tree. */
+        if (l != bst_nil)
+                l->level = BST_RB_BLACK;
+        if (r != bst_nil)
+                r->level = BST_RB_BLACK;
+
+        k->parent = NULL;
+
+        if (l_height == r_height) {
+                bst_set_left(k, l);
+                bst_set_right(k, r);
+                k->level = BST_RB_BLACK;
+                *height = l_height + 1;
+                return k;
+        }
+
+        k->level = BST_RB_RED;
+        if (l_height > r_height) {
+                bst->root = bst_detach(l);
+                for (c = l, h = l_height; (c->level == BST_RB_RED) || (h > r_height); c = c->right) {
+                        if (c->level != BST_RB_RED)
+                                h--;
+                        p = c;
+                }
+                bst_set_left(k, c);
+                bst_set_right(k, r);
+                bst_set_right(p, k);
+        } else {
+                bst->root = bst_detach(r);
+                for (c = r, h = r_height; (c->level == BST_RB_RED) || (h > l_height); c = c->left) {
+                        if (c->level != BST_RB_RED)
+                                h--;
+                        p = c;
+                }
+                bst_set_left(k, l);
+                bst_set_right(k, c);
+                bst_set_left(p, k);
+        }
+
+        *height = ((l_height > r_height) ? l_height : r_height) + bst_rb_insert_fixup(bst, k);
+
+        return bst->root;
+}
+
+/* Join two AA or red-black trees with 'k' between them.  The heights are only used (and *height only set) for a
+   red-black tree. */
+static inline struct bst_node *bst_join(struct bst *bst, struct bst_node *l, unsigned l_height, struct bst_node *k,
+                                        struct bst_node *r, unsigned r_height, unsigned *height)
+{
+        if (bst->balance == BST_BALANCE_RB)
+                return bst_rb_join(bst, l, l_height, k, r, r_height, height);
+        else
+                return bst_aa_join(bst, l, k, r);
+}
+
+/* Split the AA or red-black tree 'n' into the nodes with keys less than 'key' (in *l) and the rest (in *r).  If
+   'equal_left' is set, a node with a key equal to 'key' goes in *l instead.  Every subtree of a balanced tree is
+   balanced too, so on the way back up each node just gets joined to the side it belongs on; the costs of the joins
+   add up to O(log n).  For a red-black tree, 'height' is the black height of 'n' with its root black, and the black
+   heights of the two halves are stored in *l_height and *r_height, so that the joins never have to measure them. */
+static void bst_split_tree(struct bst *bst, struct bst_node *n, unsigned height, void *key, uint64_t prefix,
+                           int equal_left, struct bst_node **l, unsigned *l_height, struct bst_node **r,
+                           unsigned *r_height)
+{
+        struct bst_node *left, *right, *mid;
+        unsigned left_height, right_height, mid_height;
+        int comparison;
+
+        if (n == bst_nil) {
+                *l = *r = bst_nil;
+                *l_height = *r_height = 0;
+                return;
+        }
+
+        comparison = bst_compare(bst, key, prefix, n);
+        left = bst_detach(n->left);
+        right = bst_detach(n->right);
+        left_height = bst_rb_child_height(height, left);
+        right_height = bst_rb_child_height(height, right);
+
+        if ((comparison < 0) || ((comparison == 0) && !equal_left)) {
+                bst_split_tree(bst, left, left_height, key, prefix, equal_left, l, l_height, &mid, &mid_height);
+                *r = bst_join(bst, mid, mid_height, n, right, right_height, r_height);
+        } else {
+                bst_split_tree(bst, right, right_height, key, prefix, equal_left, &mid, &mid_height, r, r_height);
+                *l = bst_join(bst, left, left_height, n, mid, mid_height, l_height);
+        }
+}
+
+/* Split a splay tree as bst_split_tree() does, by splaying the node a search for 'key' ends at up to the root.  That
+   node is the closest one to 'key' on one side or the other, so everything below it on the other side goes with it. */
+static void bst_splay_split_tree(struct bst *bst, struct bst_node *n, unsigned height, void *key, uint64_t prefix,
+                                 int equal_left, struct bst_node **l, unsigned *l_height, struct bst_node **r,
+                                 unsigned *r_height)
+{
+        struct bst_node *next;
+        int comparison;
+
+        *l_height = *r_height = 0;
+
+        if (n == bst_nil) {
+                *l = *r = bst_nil;
+                return;
+        }
+
+        bst->root = bst_detach(n);
+        while (1) {
+                comparison = bst_compare(bst, key, prefix, n);
+                next = (comparison < 0) ? n->left : n->right;
+                if ((comparison == 0) || (next == bst_nil))
+                        break;
+                n = next;
+        }
+        bst_splay(bst, n);
+
+        if ((comparison < 0) || ((comparison == 0) && !equal_left)) {
+                *l = bst_detach(n->left);
+                n->left = bst_nil;
+                *r = n;
+        } else {
+                *r = bst_detach(n->right);
+                n->right = bst_nil;
+                *l = n;
+        }
+}
+
+/* Join two trees where every key in 'l' is less than every key in 'r'. */
+static struct bst_node *bst_join_trees(struct bst *bst, struct bst_node *l, struct bst_node *r)
+{
+        struct bst_node *k;
+        unsigned l_height = 0, r_height = 0, height;
+
+        if (l == bst_nil)
+                return r;
+        if (r == bst_nil)
+                return l;
+
+        if (bst->balance == BST_BALANCE_SPLAY) {
+                /* Splay the largest node in 'l' to its root, where it has no right child. */
+                bst->root = bst_detach(l);
+                for (k = l; k->right != bst_nil; k = k->right)
+                        ;
+                bst_splay(bst, k);
+                bst_set_right(k, r);
+                return k;
+        }
+
+        /* Take the smallest node out of 'r' to join the two with. */
+        bst->root = bst_detach(r);
+        for (k = r; k->left != bst_nil; k = k->left)
+                ;
+        bst_delete(bst, k);
+
+        /* Taking 'k' out may have changed the black height of 'r', so measure both trees here.  It's only done once, so
+           the whole join is still O(log n). */
+        if (bst->balance == BST_BALANCE_RB) {
+                l_height = bst_rb_black_height(l) + (l->level == BST_RB_RED);
+                r_height = bst_rb_black_height(bst->root) + (bst->root->level == BST_RB_RED);
+        }
+
+        return bst_join(bst, l, l_height, k, bst->root, r_height, &height);
+}
+
+/* Hand every node of the tree 'n' to 'cb', children before their parents, resetting each one first so that the
+   callback is free to reuse or free it. */
+static size_t bst_drain_tree(struct bst_node *n, void (*cb)(struct bst_node *n))
+{
+        struct bst_node *p, *next;
+        size_t count = 0;
+
+        if (n == bst_nil)
+                return 0;
+
+        /* Stop at the top of this tree, even if it is part of a bigger one. */
+        n->parent = NULL;
+
+        for (;;) {
+                /* Find the first node to visit in the subtree 'n': the deepest one on its leftmost path. */
+                while ((n->left != bst_nil) || (n->right != bst_nil))
+                        n = (n->left != bst_nil) ? n->left : n->right;
+
+                do {
+                        p = n->parent;
+                        if (p && (n == p->left) && (p->right != bst_nil))
+                                next = p->right;
+                        else
+                                next = NULL;
+
+                        n->level = 0;
+                        n->parent = n->left = n->right = NULL;
+                        if (cb)
+                                cb(n);
+                        count++;
+
+                        n = p;
+                } while (n && !next);
+
+                if (!n)
+                        return count;
+                n = next;
+        }
+}
+
+/* Remove every item with a key from 'lo' to 'hi' (inclusive) from a BST. */
+size_t bst_delete_range(struct bst *bst, void *lo, void *hi, void (*cb)(struct bst_node *n))
+{
+        struct bst_node *l, *mid, *m, *r;
+        unsigned height = 0, l_height, mid_height, m_height, r_height;
+        void (*split)(struct bst *bst, struct bst_node *n, unsigned height, void *key, uint64_t prefix, int equal_left,
+                      struct bst_node **l, unsigned *l_height, struct bst_node **r, unsigned *r_height);
+
+        split = (bst->balance == BST_BALANCE_SPLAY) ? bst_splay_split_tree : bst_split_tree;
+        if (bst->balance == BST_BALANCE_RB)
+                height = bst_rb_black_height(bst->root);
+
+        split(bst, bst->root, height, lo, bst_key_prefix(bst, lo), 0, &l, &l_height, &mid, &mid_height);
+        split(bst, mid, mid_height, hi, bst_key_prefix(bst, hi), 1, &m, &m_height, &r, &r_height);
+        bst->root = bst_detach(bst_join_trees(bst, l, r));
+
+        return bst_drain_tree(m, cb);
+}
+
+/* Remove every item from a BST. */
+size_t bst_drain(struct bst *bst, void (*cb)(struct bst_node *n))
+{
+        struct bst_node *root = bst->root;
+
+        bst->root = bst_nil;
+
+        return bst_drain_tree(root, cb);
+}
+
+#ifdef BST_STATS
+static const char *bst_stats_op_names[BST_STATS_NUM_OPS] = {
+        [BST_STATS_INSERT] = "insert",
+        [BST_STATS_DELETE] = "delete",
+        [BST_STATS_FIND] = "find",
+        [BST_STATS_GTE] = "gte",
+        [BST_STATS_LTE] = "lte",
+};
+
+/* Zero the stats of a BST. */
+void bst_stats_reset(struct bst *bst)
+{
+        memset(&bst->stats, 0, sizeof(bst->stats));
+}
+
+/* Take a copy of the stats of a BST, and count the nodes at each level.  This walks the whole tree, so it is O(n). */
+void bst_stats_snapshot(struct bst *bst, struct bst_stats_snapshot *snap)
+{
+        struct bst_node *n;
+
+        memset(snap, 0, sizeof(*snap));
+        snap->stats = bst->stats;
+        snap->balance = bst->balance;
+
+        /* Only AA trees have levels; red-black trees keep a colour there, and splay trees nothing at all. */
+        for (n = bst_next(bst, NULL); n; n = bst_next(bst, n)) {
+                snap->count++;
+                if (bst->balance == BST_BALANCE_AA)
+                        snap->levels[MEC_MIN(n->level, BST_STATS_MAX_LEVEL - 1)]++;
+        }
+}
+
+/* Print a snapshot in human readable form. */
+void bst_stats_dump(struct bst_stats_snapshot *snap, FILE *f)
+{
+        struct bst_stats *stats = &snap->stats;
+        unsigned op, i;
+
+        fprintf(f, "items: %zu  skews: %lu  splits: %lu  rotations: %lu\n", snap->count, stats->skews, stats->splits,
+                stats->rotations);
+
+        for (op=0; op<BST_STATS_NUM_OPS; op++) {
+                if (stats->ops[op] == 0)
+                        continue;
+                fprintf(f, "%s: ops %lu  comparisons/op %.2f  depth avg %.2f max %u\n", bst_stats_op_names[op],
+                        stats->ops[op], (double)stats->comparisons[op] / stats->ops[op],
+                        (double)stats->depth[op] / stats->ops[op], stats->max_depth[op]);
+#ifdef BST_STATS_LATENCY
+                for (i=0; i<BST_STATS_LATENCY_BUCKETS; i++)
+                        if (stats->latency[op][i])
+                                fprintf(f, "  %llu-%lluns: %lu\n", i ? (1ULL << i) : 0, (2ULL << i) - 1,
+                                        stats->latency[op][i]);
+#endif
+        }
+
+        if (snap->balance != BST_BALANCE_AA)
+                return;
+
+        for (i=1; i<BST_STATS_MAX_LEVEL; i++)
+                if (snap->levels[i])
+                        fprintf(f, "level %u: %zu nodes\n", i, snap->levels[i]);
+}
+#endif
+
 
 
 /* Local Variables:            */
@@ -0,0 +1,548 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* btree.c - Cache conscious B+tree keyed by 64 bit integers.
+ *
+ * Every node but the root holds at least BTREE_MIN_KEYS keys.  Separators in inner nodes are upper bounds: child i
+ * holds keys <= keys[i], so the child to follow for a key is the number of separators less than it - the same
+ * "rank" that gives a key's position in a leaf.  A separator doesn't need to be updated when the largest key below it
+ * is deleted, only when keys move between nodes.
+ */
+
+#include <string.h>
+#include "mec-lib/btree.h"
+
+/* Building with BTREE_NO_AVX2 defined leaves out the AVX2 search, so the generic one can be tested on any CPU. */
+#if defined(__x86_64__) && !defined(BTREE_NO_AVX2)
+#define BTREE_AVX2
+#include <immintrin.h>
+#endif
+
+
+
+#define BTREE_MIN_KEYS  (BTREE_NODE_KEYS / 2)
+
+/* Return the number of keys in a node that are less than 'key', which is also the index of the first one that isn't.
+   Unused slots hold UINT64_MAX, so the whole array can be searched without looking at the count. */
+static unsigned btree_rank_generic(const uint64_t *keys, uint64_t key)
+{
+        unsigned lo = 0, hi = BTREE_NODE_KEYS;
+
+        while (lo < hi) {
+                unsigned mid = (lo + hi) / 2;
+
+                if (keys[mid] < key)
+                        lo = mid + 1;
+                else
+                        hi = mid;
+        }
+
+        return lo;
+}
+
+#ifdef BTREE_AVX2
+/* The same, 4 keys at a time.  AVX2 only has signed 64 bit compares, so both sides get their top bit flipped. */
+__attribute__((target("avx2")))
+static unsigned btree_rank_avx2(const uint64_t *keys, uint64_t key)
+{
+        const __m256i bias = _mm256_set1_epi64x(INT64_MIN);
+        __m256i k = _mm256_xor_si256(_mm256_set1_epi64x((long long)key), bias);
+        unsigned rank = 0, mask, i;
+
+        for (i = 0; i < BTREE_NODE_KEYS; i += 4) {
+                __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&keys[i]), bias);
+
+                mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v)));
+                rank += __builtin_popcount(mask);
+                if (mask != 0xf)
+                        break;
+        }
+
+        return rank;
+}
+
+static int btree_use_avx2;
+
+/* Look for AVX2 once, when the program starts, rather than every time a tree is initialized. */
+__attribute__((constructor))
+static void btree_detect_avx2(void)
+{
+        __builtin_cpu_init();
+        btree_use_avx2 = __builtin_cpu_supports("avx2");
+}
+#endif
+
+static inline unsigned btree_rank(const uint64_t *keys, uint64_t key)
+{
+#ifdef BTREE_AVX2
+        if (btree_use_avx2)
+                return btree_rank_avx2(keys, key);
+#endif
+        return btree_rank_generic(keys, key);
+}
+
+/* Walk down to the leaf that would hold 'key'.  If 'path' isn't NULL, path[i] is set to the inner node at depth i, and
+   idx[i] to the child that was taken from it. */
+static struct btree_node *btree_descend(struct btree *bt, uint64_t key, struct btree_node **path, unsigned *idx)
+{
+        struct btree_node *n = bt->root;
+        unsigned depth, i;
+
+        for (depth = 0; depth + 1 < bt->height; depth++) {
+                i = btree_rank(n->keys, key);
+                if (path) {
+                        path[depth] = n;
+                        idx[depth] = i;
+                }
+                n = n->children[i];
+        }
+
+        return n;
+}
+
+static void btree_node_clear(struct btree_node *n)
+{
+        unsigned i;
+
+        for (i = 0; i < BTREE_NODE_KEYS; i++)
+                n->keys[i] = UINT64_MAX;
+        memset(&n->children, 0, sizeof(n->children));
+        n->prev = n->next = NULL;
+        n->count = 0;
+}
+
+/* Make room for an entry at 'pos' in a node.  Inner nodes move the child after each key along with it. */
+static void btree_open_slot(struct btree_node *n, unsigned pos, int leaf)
+{
+        memmove(&n->keys[pos + 1], &n->keys[pos], (n->count - pos) * sizeof(n->keys[0]));
+        if (leaf)
+                memmove(&n->items[pos + 1], &n->items[pos], (n->count - pos) * sizeof(n->items[0]));
+        else
+                memmove(&n->children[pos + 2], &n->children[pos + 1], (n->count - pos) * sizeof(n->children[0]));
+        n->count++;
+}
+
+/* Remove the entry at 'pos' in a node (and for inner nodes, the child after it). */
+static void btree_close_slot(struct btree_node *n, unsigned pos, int leaf)
+{
+        n->count--;
+        memmove(&n->keys[pos], &n->keys[pos + 1], (n->count - pos) * sizeof(n->keys[0]));
+        n->keys[n->count] = UINT64_MAX;
+        if (leaf)
+                memmove(&n->items[pos], &n->items[pos + 1], (n->count - pos) * sizeof(n->items[0]));
+        else
+                memmove(&n->children[pos + 1], &n->children[pos + 2], (n->count - pos) * sizeof(n->children[0]));
+}
+
+/* Initalize a B+tree. */
+void btree_init(struct btree *bt, struct btree_ops *ops)
+{
+        bt->ops = ops;
+        bt->root = NULL;
+        bt->height = 0;
+}
+
+static void btree_free_subtree(struct btree *bt, struct btree_node *n, unsigned height)
+{
+        unsigned i;
+
+        if (height > 1)
+                for (i = 0; i <= n->count; i++)
+                        btree_free_subtree(bt, n->children[i], height - 1);
+        bt->ops->free_node(n);
+}
+
+/* Free every node of a B+tree. */
+void btree_destroy(struct btree *bt)
+{
+        if (bt->root)
+                btree_free_subtree(bt, bt->root, bt->height);
+        bt->root = NULL;
+        bt->height = 0;
+}
+
+/* Split the full inner node 'n' while adding 'key' at 'pos' with 'child' after it.  The bottom half stays in 'n' and
+   the top half goes to the empty node 'r'; the key between them is returned, to go up as the bound of 'n'. */
+static uint64_t btree_split_inner(struct btree_node *n, struct btree_node *r, unsigned pos, uint64_t key,
+                                  struct btree_node *child)
+{
+        uint64_t keys[BTREE_NODE_KEYS + 1];
+        struct btree_node *children[BTREE_NODE_KEYS + 2];
+        unsigned half = (BTREE_NODE_KEYS + 1) / 2;
+
+        memcpy(keys, n->keys, pos * sizeof(keys[0]));
+        keys[pos] = key;
+        memcpy(&keys[pos + 1], &n->keys[pos], (BTREE_NODE_KEYS - pos) * sizeof(keys[0]));
+        memcpy(children, n->children, (pos + 1) * sizeof(children[0]));
+        children[pos + 1] = child;
+        memcpy(&children[pos + 2], &n->children[pos + 1], (BTREE_NODE_KEYS - pos) * sizeof(children[0]));
+
+        btree_node_clear(n);
+        memcpy(n->keys, keys, half * sizeof(keys[0]));
+        memcpy(n->children, children, (half + 1) * sizeof(children[0]));
+        n->count = half;
+
+        memcpy(r->keys, &keys[half + 1], (BTREE_NODE_KEYS - half) * sizeof(keys[0]));
+        memcpy(r->children, &children[half + 1], (BTREE_NODE_KEYS - half + 1) * sizeof(children[0]));
+        r->count = BTREE_NODE_KEYS - half;
+
+        return keys[half];
+}
+
+/* Insert an item into a B+tree.  Returns 0 on success, non-zero on error. */
+int btree_insert(struct btree *bt, void *item)
+{
+        struct btree_node *path[BTREE_MAX_HEIGHT], *spare[BTREE_MAX_HEIGHT + 1];
+        unsigned idx[BTREE_MAX_HEIGHT];
+        uint64_t key = bt->ops->get_key(item);
+        struct btree_node *leaf, *n, *r;
+        unsigned pos, depth, needed, half, i;
+        uint64_t sep;
+
+        if (bt->root == NULL) {
+                leaf = bt->ops->alloc_node();
+                if (leaf == NULL)
+                        return 1;
+                btree_node_clear(leaf);
+                leaf->keys[0] = key;
+                leaf->items[0] = item;
+                leaf->count = 1;
+                bt->root = leaf;
+                bt->height = 1;
+                return 0;
+        }
+
+        leaf = btree_descend(bt, key, path, idx);
+        pos = btree_rank(leaf->keys, key);
+        if ((pos < leaf->count) && (leaf->keys[pos] == key))
+                return 1;
+
+        if (leaf->count < BTREE_NODE_KEYS) {
+                btree_open_slot(leaf, pos, 1);
+                leaf->keys[pos] = key;
+                leaf->items[pos] = item;
+                return 0;
+        }
+
+        /* Every full node on the way up will split, and if they all do, the tree gets a new root too.  Get all of the
+           nodes that will take first. */
+        for (needed = 1, depth = bt->height - 1; (depth > 0) && (path[depth - 1]->count == BTREE_NODE_KEYS); depth--)
+                needed++;
+        if (depth == 0) {
+                if (bt->height == BTREE_MAX_HEIGHT)
+                        return 1;
+                needed++;
+        }
+        for (i = 0; i < needed; i++) {
+                spare[i] = bt->ops->alloc_node();
+                if (spare[i] == NULL) {
+                        while (i--)
+                                bt->ops->free_node(spare[i]);
+                        return 1;
+                }
+                btree_node_clear(spare[i]);
+        }
+
+        /* Split the leaf in half, and put the new item in whichever half it belongs in. */
+        r = spare[--needed];
+        half = BTREE_NODE_KEYS / 2;
+        memcpy(r->keys, &leaf->keys[half], (BTREE_NODE_KEYS - half) * sizeof(leaf->keys[0]));
+        memcpy(r->items, &leaf->items[half], (BTREE_NODE_KEYS - half) * sizeof(leaf->items[0]));
+        r->count = BTREE_NODE_KEYS - half;
+        for (i = half; i < BTREE_NODE_KEYS; i++)
+                leaf->keys[i] = UINT64_MAX;
+        leaf->count = half;
+
+        n = (pos <= half) ? leaf : r;
+        if (n == r)
+                pos -= half;
+        btree_open_slot(n, pos, 1);
+        n->keys[pos] = key;
+        n->items[pos] = item;
+
+        r->prev = leaf;
+        r->next = leaf->next;
+        if (r->next)
+                r->next->prev = r;
+        leaf->next = r;
+
+        /* Push the split up the tree: the left half keeps its place, now bounded by its largest key, and the right
+           half goes in after it with the old bound. */
+        sep = leaf->keys[leaf->count - 1];
+        for (depth = bt->height - 1; depth > 0; depth--) {
+                n = path[depth - 1];
+                pos = idx[depth - 1];
+
+                if (n->count < BTREE_NODE_KEYS) {
+                        btree_open_slot(n, pos, 0);
+                        n->keys[pos] = sep;
+                        n->children[pos + 1] = r;
+                        return 0;
+                }
+
+                sep = btree_split_inner(n, spare[needed - 1], pos, sep, r);
+                r = spare[--needed];
+        }
+
+        /* The root split as well. */
+        n = spare[--needed];
+        n->keys[0] = sep;
+        n->children[0] = bt->root;
+        n->children[1] = r;
+        n->count = 1;
+        bt->root = n;
+        bt->height++;
+
+        return 0;
+}
+
+/* Child 'i' of the inner node 'p' has one key too few.  Move a key over from a neighbour if one can spare it, or
+   otherwise merge it with a neighbour.  'leaf' says whether the children are leaves. */
+static void btree_rebalance(struct btree *bt, struct btree_node *p, unsigned i, int leaf)
+{
+        struct btree_node *c = p->children[i], *l, *r;
+        unsigned s;
+
+        if ((i > 0) && (p->children[i - 1]->count > BTREE_MIN_KEYS)) {
+                /* Take the largest entry of the left neighbour. */
+                l = p->children[i - 1];
+                btree_open_slot(c, 0, leaf);
+                if (leaf) {
+                        c->keys[0] = l->keys[l->count - 1];
+                        c->items[0] = l->items[l->count - 1];
+                        l->count--;
+                        p->keys[i - 1] = l->keys[l->count - 1];
+                } else {
+                        /* A child moves along with the key before it, so the first child needs moving by hand.  The
+                           key between the two nodes comes down, and the left node's largest key goes up. */
+                        c->children[1] = c->children[0];
+                        c->keys[0] = p->keys[i - 1];
+                        c->children[0] = l->children[l->count];
+                        l->count--;
+                        p->keys[i - 1] = l->keys[l->count];
+                }
+                l->keys[l->count] = UINT64_MAX;
+                return;
+        }
+
+        if ((i < p->count) && (p->children[i + 1]->count > BTREE_MIN_KEYS)) {
+                /* Take the smallest entry of the right neighbour. */
+                r = p->children[i + 1];
+                if (leaf) {
+                        c->keys[c->count] = r->keys[0];
+                        c->items[c->count] = r->items[0];
+                        p->keys[i] = r->keys[0];
+                } else {
+                        /* As above, the other way around. */
+                        c->keys[c->count] = p->keys[i];
+                        c->children[c->count + 1] = r->children[0];
+                        p->keys[i] = r->keys[0];
+                        r->children[0] = r->children[1];
+                }
+                c->count++;
+                btree_close_slot(r, 0, leaf);
+                return;
+        }
+
+        /* Neither neighbour has a key to spare, so merge with one of them.  'l' absorbs 'r', and 's' is the key
+           between them in the parent. */
+        s = (i > 0) ? i - 1 : i;
+        l = p->children[s];
+        r = p->children[s + 1];
+
+        if (leaf) {
+                memcpy(&l->keys[l->count], r->keys, r->count * sizeof(r->keys[0]));
+                memcpy(&l->items[l->count], r->items, r->count * sizeof(r->items[0]));
+                l->count += r->count;
+                l->next = r->next;
+                if (l->next)
+                        l->next->prev = l;
+        } else {
+                l->keys[l->count] = p->keys[s];
+                memcpy(&l->keys[l->count + 1], r->keys, r->count * sizeof(r->keys[0]));
+                memcpy(&l->children[l->count + 1], r->children, (r->count + 1) * sizeof(r->children[0]));
+                l->count += r->count + 1;
+        }
+
+        /* Dropping the key between them leaves 'l' with r's bound. */
+        btree_close_slot(p, s, 0);
+        bt->ops->free_node(r);
+}
+
+/* Remove the item with the given key from a B+tree.  Returns 0 on success, non-zero if no item has that key. */
+int btree_delete(struct btree *bt, uint64_t key)
+{
+        struct btree_node *path[BTREE_MAX_HEIGHT];
+        unsigned idx[BTREE_MAX_HEIGHT];
+        struct btree_node *leaf, *n;
+        unsigned pos, depth;
+
+        if (bt->root == NULL)
+                return 1;
+
+        leaf = btree_descend(bt, key, path, idx);
+        pos = btree_rank(leaf->keys, key);
+        if ((pos == leaf->count) || (leaf->keys[pos] != key))
+                return 1;
+
+        btree_close_slot(leaf, pos, 1);
+
+        /* Fix up nodes that have got too small, on the way back up. */
+        for (n = leaf, depth = bt->height - 1; (depth > 0) && (n->count < BTREE_MIN_KEYS); depth--) {
+                btree_rebalance(bt, path[depth - 1], idx[depth - 1], n == leaf);
+                n = path[depth - 1];
+        }
+
+        /* The root can get down to one child, and then that child takes its place; or the last item can go. */
+        n = bt->root;
+        if ((bt->height > 1) && (n->count == 0)) {
+                bt->root = n->children[0];
+                bt->height--;
+                bt->ops->free_node(n);
+        } else if ((bt->height == 1) && (n->count == 0)) {
+                bt->root = NULL;
+                bt->height = 0;
+                bt->ops->free_node(n);
+        }
+
+        return 0;
+}
+
+/* Find an item in a B+tree.  Returns a pointer to the item, or NULL if item was not found. */
+void *btree_find(struct btree *bt, uint64_t key)
+{
+        struct btree_node *leaf;
+        unsigned pos;
+
+        if (bt->root == NULL)
+                return NULL;
+
+        leaf = btree_descend(bt, key, NULL, NULL);
+        pos = btree_rank(leaf->keys, key);
+
+        return ((pos < leaf->count) && (leaf->keys[pos] == key)) ? leaf->items[pos] : NULL;
+}
+
+/* Find the smallest item in a B+tree whose key is greater than or equal to 'key'. */
+void *btree_find_smallest_gte(struct btree *bt, uint64_t key)
+{
+        struct btree_iter it;
+
+        btree_iter_seek(bt, &it, key);
+
+        return btree_iter_next(&it);
+}
+
+/* Find the largest item in a B+tree whose key is less than or equal to 'key'. */
+void *btree_find_largest_lte(struct btree *bt, uint64_t key)
+{
+        struct btree_iter it;
+        void *item;
+
+        btree_iter_seek(bt, &it, key);
+        item = btree_iter_next(&it);
+        if (item && (bt->ops->get_key(item) == key))
+                return item;
+
+        /* Step back over the item that was just returned (if any), to the one before it. */
+        if (item)
+                btree_iter_prev(&it);
+
+        return btree_iter_prev(&it);
+}
+
+/* Given an item, return the item in the tree with the next highest key. */
+void *btree_next(struct btree *bt, void *item)
+{
+        uint64_t key;
+
+        if (item == NULL)
+                return btree_find_smallest_gte(bt, 0);
+
+        key = bt->ops->get_key(item);
+
+        return (key == UINT64_MAX) ? NULL : btree_find_smallest_gte(bt, key + 1);
+}
+
+/* Given an item, return the item in the tree with the next lowest key. */
+void *btree_prev(struct btree *bt, void *item)
+{
+        uint64_t key;
+
+        if (item == NULL)
+                return btree_find_largest_lte(bt, UINT64_MAX);
+
+        key = bt->ops->get_key(item);
+
+        return (key == 0) ? NULL : btree_find_largest_lte(bt, key - 1);
+}
+
+/* Point an iterator at the smallest item whose key is greater than or equal to 'key'.  It can be left pointing just
+   past the end of a leaf, which btree_iter_next() and btree_iter_prev() both cope with. */
+void btree_iter_seek(struct btree *bt, struct btree_iter *it, uint64_t key)
+{
+        if (bt->root == NULL) {
+                it->leaf = NULL;
+                it->pos = 0;
+                return;
+        }
+
+        it->leaf = btree_descend(bt, key, NULL, NULL);
+        it->pos = btree_rank(it->leaf->keys, key);
+}
+
+/* Return the item an iterator points at and move it on to the next one, or return NULL at the end of the tree. */
+void *btree_iter_next(struct btree_iter *it)
+{
+        if (it->leaf == NULL)
+                return NULL;
+
+        if (it->pos == it->leaf->count) {
+                if (it->leaf->next == NULL)
+                        return NULL;
+                it->leaf = it->leaf->next;
+                it->pos = 0;
+        }
+
+        return it->leaf->items[it->pos++];
+}
+
+/* Move an iterator back to the previous item and return it, or return NULL at the start of the tree. */
+void *btree_iter_prev(struct btree_iter *it)
+{
+        if (it->leaf == NULL)
+                return NULL;
+
+        if (it->pos == 0) {
+                if (it->leaf->prev == NULL)
+                        return NULL;
+                it->leaf = it->leaf->prev;
+                it->pos = it->leaf->count;
+        }
+
+        return it->leaf->items[--it->pos];
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
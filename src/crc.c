@@ -16,8 +16,15 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include <mec-lib/crc.h>
 
+/* Building with CRC_NO_SSE42 defined leaves out the SSE4.2 CRC-32C, so the generic one can be tested on any CPU. */
+#if defined(__x86_64__) && !defined(CRC_NO_SSE42)
+#define CRC_SSE42
+#include <nmmintrin.h>
+#endif
+
 /* crc.c - Generic CRC implementation. */
 
 static uint64_t reflect(uint64_t value, uint8_t bits)
@@ -87,6 +94,50 @@ uint64_t crc_finalize(struct crc_config *cfg, uint64_t crc)
         return crc ^ cfg->xorout;
 }
 
+/* CRC-32C, reflected, one bit at a time. */
+static uint32_t crc32c_generic(uint32_t crc, const uint8_t *p, size_t len)
+{
+        while (len--) {
+                crc ^= *p++;
+                for (unsigned i=0; i<8; i++)
+                        crc = (crc >> 1) ^ (0x82f63b78 & -(crc & 1));
+        }
+
+        return crc;
+}
+
+#ifdef CRC_SSE42
+/* CRC-32C with the SSE4.2 crc32 instruction, 8 bytes at a time. */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const uint8_t *p, size_t len)
+{
+        uint64_t crc64 = crc, v;
+
+        for (; len >= 8; len -= 8, p += 8) {
+                memcpy(&v, p, sizeof(v));
+                crc64 = _mm_crc32_u64(crc64, v);
+        }
+        crc = crc64;
+
+        for (; len; len--)
+                crc = _mm_crc32_u8(crc, *p++);
+
+        return crc;
+}
+#endif
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t len)
+{
+        crc = ~crc;
+
+#ifdef CRC_SSE42
+        if (__builtin_cpu_supports("sse4.2"))
+                return ~crc32c_sse42(crc, data, len);
+#endif
+
+        return ~crc32c_generic(crc, data, len);
+}
+
 
 
 /* Local Variables:            */
@@ -0,0 +1,133 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* epoch.c - Epoch based deferred reclamation for lock-free readers. */
+
+#include <sched.h>
+#include "mec-lib/epoch.h"
+
+
+
+/* Initialize an epoch domain. */
+void epoch_init(struct epoch *e)
+{
+        /* Epoch 0 is reserved to mean "not in a critical section". */
+        e->global = 1;
+        pthread_mutex_init(&e->lock, NULL);
+        dlist_init(&e->readers);
+}
+
+/* Register a reader with an epoch domain.  This must be done before the reader is used. */
+void epoch_reader_register(struct epoch *e, struct epoch_reader *r)
+{
+        r->local = 0;
+        r->nesting = 0;
+        r->epoch = e;
+        dlist_init(&r->retired);
+        r->num_retired = 0;
+
+        pthread_mutex_lock(&e->lock);
+        dlist_insert_back(&e->readers, &r->link);
+        pthread_mutex_unlock(&e->lock);
+}
+
+/* Unregister a reader.  Any items it still has retired are waited for and reclaimed first. */
+void epoch_reader_unregister(struct epoch_reader *r)
+{
+        struct epoch *e = r->epoch;
+
+        epoch_synchronize(r);
+
+        pthread_mutex_lock(&e->lock);
+        dlist_del(&r->link);
+        pthread_mutex_unlock(&e->lock);
+}
+
+/* Advance the global epoch if every reader that is in a critical section has seen the current one.  Returns the
+   (possibly new) global epoch. */
+static unsigned long epoch_try_advance(struct epoch *e)
+{
+        struct epoch_reader *r;
+        unsigned long global;
+
+        pthread_mutex_lock(&e->lock);
+
+        global = __atomic_load_n(&e->global, __ATOMIC_RELAXED);
+
+        /* Pairs with the fence in epoch_enter(): either the reader's epoch is visible to us here, or the reader will
+           see every unlink that happened before we got here. */
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        dlist_for_each_item(&e->readers, r, struct epoch_reader, link) {
+                unsigned long local = __atomic_load_n(&r->local, __ATOMIC_RELAXED);
+
+                if (local && (local != global))
+                        goto out;
+        }
+
+        global++;
+        __atomic_store_n(&e->global, global, __ATOMIC_RELEASE);
+
+out:
+        pthread_mutex_unlock(&e->lock);
+
+        return global;
+}
+
+/* Try to advance the global epoch and run the callbacks of any items retired by 'r' that are now safe.  Returns the
+   number of items reclaimed. */
+unsigned epoch_reclaim(struct epoch_reader *r)
+{
+        unsigned long global = epoch_try_advance(r->epoch);
+        struct epoch_deferred *d;
+        unsigned count = 0;
+
+        /* Items are queued in epoch order, so stop at the first one that is not yet safe. */
+        while (!is_dlist_empty(&r->retired)) {
+                d = DLIST_ITEM(r->retired.next, struct epoch_deferred, link);
+                if ((d->epoch + 2) > global)
+                        break;
+
+                dlist_del(&d->link);
+                d->fn(d);
+                count++;
+        }
+
+        r->num_retired -= count;
+
+        return count;
+}
+
+/* Wait until every item retired by 'r' so far can be reclaimed, and reclaim them.  Must not be called from inside a
+   critical section. */
+void epoch_synchronize(struct epoch_reader *r)
+{
+        while (!is_dlist_empty(&r->retired)) {
+                if (epoch_reclaim(r) == 0)
+                        sched_yield();
+        }
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,292 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* htable.c - Intrusive hash table.
+ *
+ * While a resize is in progress, old bucket i has been moved if i < migrate_pos.  An item lives in the old bucket for
+ * its hash if that hasn't been moved yet, and in the new one otherwise - inserts too, so that lookups only ever have
+ * one chain to search.
+ *
+ * The new bucket array isn't cleared when it's allocated, since for a big table that takes as long as the copy being
+ * avoided.  Instead, moving old bucket i first clears the new buckets that its items can go to (i and i + old size
+ * when growing, i when shrinking), and nothing looks at a new bucket until the old ones that map to it have moved.
+ */
+
+#include "mec-lib/htable.h"
+
+
+
+#define HTABLE_MIN_BUCKETS      16
+
+/* Old buckets moved per insert or delete.  Growing starts when there are as many items as old buckets, and the next
+   resize can't be due until that has doubled, so even 1 would finish in time; more keeps the two arrays' cache
+   footprint short lived. */
+#define HTABLE_MIGRATE_STEP     4
+
+/* Keys looked up together by htable_find_batch(). */
+#define HTABLE_BATCH            16
+
+/* Initalize a hash table. */
+void htable_init(struct htable *ht, struct htable_ops *ops)
+{
+        ht->ops = ops;
+        ht->buckets = NULL;
+        ht->mask = 0;
+        ht->old_buckets = NULL;
+        ht->old_mask = 0;
+        ht->migrate_pos = 0;
+        ht->count = 0;
+        ht->resize_failed = 0;
+}
+
+/* Free the bucket arrays of a hash table. */
+void htable_destroy(struct htable *ht)
+{
+        if (ht->old_buckets)
+                ht->ops->free_buckets(ht->old_buckets, ht->old_mask + 1);
+        if (ht->buckets)
+                ht->ops->free_buckets(ht->buckets, ht->mask + 1);
+        htable_init(ht, ht->ops);
+}
+
+/* Return the chain that an item with 'hash' is in, or would go in. */
+static inline struct htable_node **htable_bucket(struct htable *ht, uint64_t hash)
+{
+        if (ht->old_buckets && ((hash & ht->old_mask) >= ht->migrate_pos))
+                return &ht->old_buckets[hash & ht->old_mask];
+
+        return &ht->buckets[hash & ht->mask];
+}
+
+/* Return non-zero if new bucket 'b' is in use: it has been cleared, and may hold items. */
+static inline int htable_bucket_ready(struct htable *ht, size_t b)
+{
+        return (ht->old_buckets == NULL) || ((b & ht->old_mask) < ht->migrate_pos);
+}
+
+/* Move up to 'steps' old buckets into the new array, and free the old array once it's empty. */
+static void htable_migrate(struct htable *ht, size_t steps)
+{
+        struct htable_node *n, *next, **b;
+        size_t i;
+
+        for (; steps && (ht->migrate_pos <= ht->old_mask); steps--, ht->migrate_pos++) {
+                i = ht->migrate_pos;
+                if (ht->mask > ht->old_mask)
+                        ht->buckets[i] = ht->buckets[i + ht->old_mask + 1] = NULL;
+                else if (i <= ht->mask)
+                        ht->buckets[i] = NULL;
+
+                for (n = ht->old_buckets[ht->migrate_pos]; n; n = next) {
+                        next = n->next;
+                        b = &ht->buckets[n->hash & ht->mask];
+                        n->next = *b;
+                        *b = n;
+                }
+                ht->old_buckets[ht->migrate_pos] = NULL;
+        }
+
+        if (ht->migrate_pos > ht->old_mask) {
+                ht->ops->free_buckets(ht->old_buckets, ht->old_mask + 1);
+                ht->old_buckets = NULL;
+                ht->old_mask = 0;
+                ht->migrate_pos = 0;
+        }
+}
+
+/* Switch to a new bucket array of 'num_buckets', leaving the items to be moved into it (and the array to be cleared)
+   bit by bit.  Only called when no resize is under way. */
+static void htable_start_resize(struct htable *ht, size_t num_buckets)
+{
+        struct htable_node **buckets;
+
+        /* If there's no memory, trying again on the very next insert or delete is unlikely to do better, and would
+           call alloc_buckets() every time.  Leave it until the count has doubled (or halved) from here. */
+        buckets = ht->ops->alloc_buckets(num_buckets);
+        if (buckets == NULL) {
+                ht->resize_failed = ht->count;
+                return;
+        }
+
+        ht->resize_failed = 0;
+
+        ht->old_buckets = ht->buckets;
+        ht->old_mask = ht->mask;
+        ht->migrate_pos = 0;
+        ht->buckets = buckets;
+        ht->mask = num_buckets - 1;
+}
+
+/* Insert an item into a hash table. */
+int htable_insert(struct htable *ht, struct htable_node *n)
+{
+        void *key = ht->ops->get_key(n);
+        struct htable_node **b, *p;
+
+        if (ht->buckets == NULL) {
+                ht->buckets = ht->ops->alloc_buckets(HTABLE_MIN_BUCKETS);
+                if (ht->buckets == NULL)
+                        return -1;
+                memset(ht->buckets, 0, HTABLE_MIN_BUCKETS * sizeof(ht->buckets[0]));
+                ht->mask = HTABLE_MIN_BUCKETS - 1;
+        }
+
+        n->hash = ht->ops->hash(key);
+        b = htable_bucket(ht, n->hash);
+        for (p = *b; p; p = p->next)
+                if ((p->hash == n->hash) && (ht->ops->compare(ht->ops->get_key(p), key) == 0))
+                        return -1;
+
+        n->next = *b;
+        *b = n;
+        ht->count++;
+
+        if (ht->old_buckets)
+                htable_migrate(ht, HTABLE_MIGRATE_STEP);
+        else if ((ht->count > ht->mask + 1) && (ht->count >= ht->resize_failed * 2))
+                htable_start_resize(ht, (ht->mask + 1) * 2);
+
+        return 0;
+}
+
+/* Remove an item from a hash table. */
+int htable_delete(struct htable *ht, struct htable_node *n)
+{
+        struct htable_node **pp;
+
+        if (ht->buckets == NULL)
+                return -1;
+
+        for (pp = htable_bucket(ht, n->hash); *pp != n; pp = &(*pp)->next)
+                if (*pp == NULL)
+                        return -1;
+
+        *pp = n->next;
+        n->next = NULL;
+        ht->count--;
+
+        if (ht->old_buckets)
+                htable_migrate(ht, HTABLE_MIGRATE_STEP);
+        else if ((ht->mask + 1 > HTABLE_MIN_BUCKETS) && (ht->count < (ht->mask + 1) / 8) &&
+                 (!ht->resize_failed || (ht->count <= ht->resize_failed / 2)))
+                htable_start_resize(ht, (ht->mask + 1) / 2);
+
+        return 0;
+}
+
+/* Search a chain for a key. */
+static inline struct htable_node *htable_search(struct htable *ht, struct htable_node *n, void *key, uint64_t hash)
+{
+        for (; n; n = n->next)
+                if ((n->hash == hash) && (ht->ops->compare(ht->ops->get_key(n), key) == 0))
+                        return n;
+
+        return NULL;
+}
+
+/* Find an item in a hash table. */
+struct htable_node *htable_find(struct htable *ht, void *key)
+{
+        uint64_t hash;
+
+        if (ht->buckets == NULL)
+                return NULL;
+
+        hash = ht->ops->hash(key);
+
+        return htable_search(ht, *htable_bucket(ht, hash), key, hash);
+}
+
+/* Find many items at once.  Each group of keys goes through three passes: hash and prefetch the bucket, load the
+   bucket and prefetch the first item in it, then search.  By the time a pass gets back to the first key its data has
+   had the rest of the group's worth of time to arrive. */
+void htable_find_batch(struct htable *ht, void **keys, struct htable_node **found, size_t num_keys)
+{
+        struct htable_node **buckets[HTABLE_BATCH];
+        uint64_t hashes[HTABLE_BATCH];
+        size_t i, j, n;
+
+        for (i = 0; i < num_keys; i += n) {
+                n = (num_keys - i < HTABLE_BATCH) ? num_keys - i : HTABLE_BATCH;
+
+                if (ht->buckets == NULL) {
+                        memset(&found[i], 0, n * sizeof(found[0]));
+                        continue;
+                }
+
+                for (j = 0; j < n; j++) {
+                        hashes[j] = ht->ops->hash(keys[i + j]);
+                        buckets[j] = htable_bucket(ht, hashes[j]);
+                        __builtin_prefetch(buckets[j]);
+                }
+
+                for (j = 0; j < n; j++) {
+                        found[i + j] = *buckets[j];
+                        if (found[i + j])
+                                __builtin_prefetch(found[i + j]);
+                }
+
+                for (j = 0; j < n; j++)
+                        found[i + j] = htable_search(ht, found[i + j], keys[i + j], hashes[j]);
+        }
+}
+
+/* Return the first node in the first non-empty bucket from 'b' on, looking at the unmoved old buckets first and then
+   the new ones.  'old' says which array 'b' is in. */
+static struct htable_node *htable_scan(struct htable *ht, size_t b, int old)
+{
+        if (old) {
+                for (; b <= ht->old_mask; b++)
+                        if (ht->old_buckets[b])
+                                return ht->old_buckets[b];
+                b = 0;
+        }
+
+        for (; b <= ht->mask; b++)
+                if (htable_bucket_ready(ht, b) && ht->buckets[b])
+                        return ht->buckets[b];
+
+        return NULL;
+}
+
+/* Return the next node in the table. */
+struct htable_node *htable_next(struct htable *ht, struct htable_node *n)
+{
+        if (ht->buckets == NULL)
+                return NULL;
+
+        if (n == NULL)
+                return htable_scan(ht, ht->migrate_pos, ht->old_buckets != NULL);
+
+        if (n->next)
+                return n->next;
+
+        if (ht->old_buckets && ((n->hash & ht->old_mask) >= ht->migrate_pos))
+                return htable_scan(ht, (n->hash & ht->old_mask) + 1, 1);
+
+        return htable_scan(ht, (n->hash & ht->mask) + 1, 0);
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
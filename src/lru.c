@@ -0,0 +1,227 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* lru.c - Sharded intrusive LRU cache.
+ *
+ * Locking: lookups lock their thread's reader slot, and everything that changes the index or the list locks every
+ * slot, in order.  So a lookup can see the index and list are stable, and can write to its own slot's hit buffer, and
+ * whoever has every slot locked can empty all of the buffers.  Inserts and deletes apply the buffered hits before
+ * doing anything else, so every node in a buffer is still in the cache.
+ */
+
+#include "mec-lib/lru.h"
+
+
+
+/* The next reader slot to hand out, and this thread's slot plus one (or 0 if it hasn't got one yet).  Handing them out
+   in turn spreads threads evenly over the slots of every shard. */
+static unsigned lru_next_reader;
+static __thread unsigned lru_thread_reader;
+
+/* Return the shard that holds 'key'.  The hash is mixed before picking the shard, since the index uses its low bits
+   to pick buckets, and taking the shard from them too would leave most of each shard's buckets empty. */
+static inline struct lru_shard *lru_shard(struct lru_cache *c, void *key)
+{
+        uint64_t h = c->ops->index.hash(key) * 0x9e3779b97f4a7c15ULL;
+
+        return &c->shards[((h >> 32) * c->num_shards) >> 32];
+}
+
+/* Return this thread's reader slot in a shard. */
+static inline struct lru_reader *lru_reader(struct lru_shard *shard)
+{
+        if (lru_thread_reader == 0)
+                lru_thread_reader = __atomic_fetch_add(&lru_next_reader, 1, __ATOMIC_RELAXED) % LRU_READERS + 1;
+
+        return &shard->readers[lru_thread_reader - 1];
+}
+
+static inline struct lru_node *lru_node(struct htable_node *n)
+{
+        return (struct lru_node *)((char *)n - offsetof(struct lru_node, index));
+}
+
+/* Lock every reader slot of a shard, and move the buffered hits to the front of the list, each slot's oldest first so
+   that its most recent ends up in front. */
+static void lru_lock_shard(struct lru_shard *shard)
+{
+        struct lru_reader *r;
+        unsigned i;
+
+        for (r = shard->readers; r < shard->readers + LRU_READERS; r++)
+                pthread_mutex_lock(&r->lock);
+
+        for (r = shard->readers; r < shard->readers + LRU_READERS; r++) {
+                for (i = 0; i < r->hit_count; i++) {
+                        dlist_del(&r->hits[i]->list);
+                        dlist_insert_front(&shard->list, &r->hits[i]->list);
+                }
+                r->hit_count = 0;
+        }
+}
+
+static void lru_unlock_shard(struct lru_shard *shard)
+{
+        unsigned i;
+
+        for (i = LRU_READERS; i--; )
+                pthread_mutex_unlock(&shard->readers[i].lock);
+}
+
+/* Initialize an LRU cache. */
+void lru_init(struct lru_cache *c, struct lru_ops *ops, struct lru_shard *shards, unsigned num_shards,
+              size_t capacity)
+{
+        unsigned i, j;
+
+        c->ops = ops;
+        c->shards = shards;
+        c->num_shards = num_shards;
+
+        for (i = 0; i < num_shards; i++) {
+                for (j = 0; j < LRU_READERS; j++) {
+                        pthread_mutex_init(&shards[i].readers[j].lock, NULL);
+                        shards[i].readers[j].hit_count = 0;
+                }
+                htable_init(&shards[i].index, &ops->index);
+                dlist_init(&shards[i].list);
+                shards[i].capacity = (capacity / num_shards) ? capacity / num_shards : 1;
+        }
+}
+
+/* Release the locks and indexes of an LRU cache. */
+void lru_destroy(struct lru_cache *c)
+{
+        unsigned i, j;
+
+        for (i = 0; i < c->num_shards; i++) {
+                htable_destroy(&c->shards[i].index);
+                for (j = 0; j < LRU_READERS; j++)
+                        pthread_mutex_destroy(&c->shards[i].readers[j].lock);
+        }
+}
+
+/* Insert an item into an LRU cache. */
+int lru_insert(struct lru_cache *c, struct lru_node *n)
+{
+        struct lru_shard *shard = lru_shard(c, c->ops->index.get_key(&n->index));
+        struct lru_node *victim = NULL;
+        int rc;
+
+        lru_lock_shard(shard);
+
+        rc = htable_insert(&shard->index, &n->index);
+        if (rc == 0) {
+                dlist_insert_front(&shard->list, &n->list);
+                if (htable_count(&shard->index) > shard->capacity) {
+                        victim = DLIST_ITEM(shard->list.prev, struct lru_node, list);
+                        htable_delete(&shard->index, &victim->index);
+                        dlist_del(&victim->list);
+                        c->ops->evict(victim);
+                }
+        }
+
+        lru_unlock_shard(shard);
+
+        return rc;
+}
+
+/* Remove an item from an LRU cache. */
+int lru_delete(struct lru_cache *c, struct lru_node *n)
+{
+        struct lru_shard *shard = lru_shard(c, c->ops->index.get_key(&n->index));
+        int rc;
+
+        lru_lock_shard(shard);
+
+        rc = htable_delete(&shard->index, &n->index);
+        if (rc == 0)
+                dlist_del(&n->list);
+
+        lru_unlock_shard(shard);
+
+        return rc;
+}
+
+/* Find an item in an LRU cache, and mark it as used. */
+struct lru_node *lru_find(struct lru_cache *c, void *key)
+{
+        struct lru_shard *shard = lru_shard(c, key);
+        struct lru_reader *r = lru_reader(shard);
+        struct htable_node *hn;
+        struct lru_node *n = NULL;
+        int full = 0;
+
+        pthread_mutex_lock(&r->lock);
+
+        hn = htable_find(&shard->index, key);
+        if (hn) {
+                n = lru_node(hn);
+                if (c->ops->hold)
+                        c->ops->hold(n);
+
+                /* Don't bother recording a hit on the item that is already the most recent. */
+                if (shard->list.next != &n->list) {
+                        if (r->hit_count < LRU_HIT_BUFFER)
+                                r->hits[r->hit_count++] = n;
+                        else
+                                full = 1;
+                }
+        }
+
+        pthread_mutex_unlock(&r->lock);
+
+        /* Our buffer was full: apply every buffer, and move our own item straight to the front.  The item may have been
+           deleted or evicted since we let go of the slot, so look it up again. */
+        if (full) {
+                lru_lock_shard(shard);
+                if (htable_find(&shard->index, key) == &n->index) {
+                        dlist_del(&n->list);
+                        dlist_insert_front(&shard->list, &n->list);
+                }
+                lru_unlock_shard(shard);
+        }
+
+        return n;
+}
+
+/* Return the number of items in an LRU cache. */
+size_t lru_count(struct lru_cache *c)
+{
+        struct lru_reader *r;
+        size_t count = 0;
+        unsigned i;
+
+        for (i = 0; i < c->num_shards; i++) {
+                r = lru_reader(&c->shards[i]);
+                pthread_mutex_lock(&r->lock);
+                count += htable_count(&c->shards[i].index);
+                pthread_mutex_unlock(&r->lock);
+        }
+
+        return count;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,150 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* mpsc.c - Lock-free intrusive multi-producer single-consumer queue.
+ *
+ * The queue is a singly linked list from 'head' to 'tail', which always has at least one node in it: the consumer
+ * pushes the queue's own 'stub' node whenever it is about to take the last real item, so producers always have
+ * something to link onto.  The queue is empty when the stub is both head and tail.
+ */
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <sched.h>
+#endif
+#include "mec-lib/mpsc.h"
+
+
+
+/* Initialize an empty queue. */
+void mpsc_init(struct mpsc_queue *q)
+{
+        q->stub.next = NULL;
+        q->stub.prev = NULL;
+        q->head = &q->stub;
+        q->tail = &q->stub;
+        q->waiting = 0;
+}
+
+/* Wake the consumer.  Several producers may see 'waiting' set, but only the first one makes the system call. */
+void mpsc_wake(struct mpsc_queue *q)
+{
+        if (__atomic_exchange_n(&q->waiting, 0, __ATOMIC_SEQ_CST) == 0)
+                return;
+
+#ifdef __linux__
+        syscall(SYS_futex, &q->waiting, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#endif
+}
+
+/* Remove the item at the front of a queue. */
+struct dlist *mpsc_pop(struct mpsc_queue *q)
+{
+        struct dlist *head = q->head;
+        struct dlist *next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+
+        if (head == &q->stub) {
+                if (next == NULL)
+                        return NULL;
+                q->head = head = next;
+                next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+        }
+
+        if (next) {
+                q->head = next;
+                return head;
+        }
+
+        /* 'head' is the last item we can see.  If it isn't the tail, a producer is part way through linking the next
+           item onto it, and it can't be taken until that is done. */
+        if (head != __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE))
+                return NULL;
+
+        mpsc_push(q, &q->stub);
+
+        next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+        if (next) {
+                q->head = next;
+                return head;
+        }
+
+        return NULL;
+}
+
+/* Remove every item that can be removed from a queue.  Every item but the last one visible already has its 'next'
+   link in place, so no producer will touch it again: they are taken in one walk down the links, writing 'head' once.
+   Only the last item needs mpsc_pop(), which is the one place the producers' cacheline is touched.
+
+   Swapping the stub in as the tail would detach the whole chain with one exchange, but the stub may still be part
+   way along the chain (mpsc_pop() pushes it whenever it takes what was the last item), and the exchange would cost
+   the same trip to the producers' cacheline as that final mpsc_pop(). */
+size_t mpsc_pop_all(struct mpsc_queue *q, struct dlist *out)
+{
+        struct dlist *head, *next, *n;
+        size_t count = 0;
+
+        do {
+                head = q->head;
+                while ((next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE))) {
+                        if (head != &q->stub) {
+                                dlist_insert_back(out, head);
+                                count++;
+                        }
+                        head = next;
+                }
+                q->head = head;
+
+                n = mpsc_pop(q);
+                if (n) {
+                        dlist_insert_back(out, n);
+                        count++;
+                }
+        } while (n);
+
+        return count;
+}
+
+/* Sleep until a queue has items in it.  Setting 'waiting' and then checking the tail, against producers swapping the
+   tail and then checking 'waiting', means that either the consumer sees the new item or the producer sees the flag. */
+void mpsc_wait(struct mpsc_queue *q)
+{
+        while (mpsc_is_empty(q)) {
+                __atomic_store_n(&q->waiting, 1, __ATOMIC_SEQ_CST);
+                if (mpsc_is_empty(q)) {
+#ifdef __linux__
+                        syscall(SYS_futex, &q->waiting, FUTEX_WAIT_PRIVATE, 1, NULL, NULL, 0);
+#else
+                        sched_yield();
+#endif
+                }
+        }
+
+        __atomic_store_n(&q->waiting, 0, __ATOMIC_RELAXED);
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,175 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* pheap.c - Pairing heap. */
+
+#include "mec-lib/pheap.h"
+
+
+
+/* Initialize an empty heap. */
+void pheap_init(struct pheap *h, struct pheap_ops *ops)
+{
+        h->ops = ops;
+        h->root = NULL;
+        h->count = 0;
+}
+
+/* Link two trees, making the one with the larger root the leftmost child of the other.  Returns the new root, whose
+   'next' and 'prev' are left for the caller to set. */
+static struct pheap_node *pheap_link(struct pheap *h, struct pheap_node *a, struct pheap_node *b)
+{
+        struct pheap_node *t;
+
+        if (h->ops->compare(h->ops->get_key(b), h->ops->get_key(a)) < 0) {
+                t = a;
+                a = b;
+                b = t;
+        }
+
+        b->next = a->child;
+        if (b->next)
+                b->next->prev = b;
+        b->prev = a;
+        a->child = b;
+
+        return a;
+}
+
+/* Link a list of sibling trees into one, in the standard two passes: link them in pairs from left to right, then link
+   the pairs together from right to left.  The pairs are kept on a list in reverse order, through 'next', so the
+   second pass is a walk down it. */
+static struct pheap_node *pheap_merge_pairs(struct pheap *h, struct pheap_node *first)
+{
+        struct pheap_node *pairs = NULL, *a, *b, *next;
+
+        for (a = first; a; a = next) {
+                b = a->next;
+                if (b) {
+                        next = b->next;
+                        a = pheap_link(h, a, b);
+                } else {
+                        next = NULL;
+                }
+                a->next = pairs;
+                pairs = a;
+        }
+
+        if (pairs == NULL)
+                return NULL;
+
+        for (a = pairs, b = a->next; b; b = next) {
+                next = b->next;
+                a = pheap_link(h, a, b);
+        }
+
+        a->next = a->prev = NULL;
+
+        return a;
+}
+
+/* Take a non-root node, and its subtree, out of the tree. */
+static void pheap_cut(struct pheap_node *n)
+{
+        if (n->prev->child == n)
+                n->prev->child = n->next;
+        else
+                n->prev->next = n->next;
+
+        if (n->next)
+                n->next->prev = n->prev;
+
+        n->next = n->prev = NULL;
+}
+
+/* Add an item to a heap. */
+void pheap_insert(struct pheap *h, struct pheap_node *n)
+{
+        n->child = n->next = n->prev = NULL;
+        h->root = h->root ? pheap_link(h, h->root, n) : n;
+        h->root->next = h->root->prev = NULL;
+        h->count++;
+}
+
+/* Remove and return the item with the smallest key. */
+struct pheap_node *pheap_pop(struct pheap *h)
+{
+        struct pheap_node *n = h->root;
+
+        if (n) {
+                h->root = pheap_merge_pairs(h, n->child);
+                n->child = NULL;
+                h->count--;
+        }
+
+        return n;
+}
+
+/* Remove any item from a heap: cut it out with its subtree, and put its children back. */
+void pheap_delete(struct pheap *h, struct pheap_node *n)
+{
+        struct pheap_node *sub;
+
+        if (n == h->root) {
+                pheap_pop(h);
+                return;
+        }
+
+        pheap_cut(n);
+        sub = pheap_merge_pairs(h, n->child);
+        n->child = NULL;
+        if (sub) {
+                h->root = pheap_link(h, h->root, sub);
+                h->root->next = h->root->prev = NULL;
+        }
+        h->count--;
+}
+
+/* Move an item whose key has been made smaller: its subtree is still in order, so just cut it out and link it with the
+   root. */
+void pheap_decrease(struct pheap *h, struct pheap_node *n)
+{
+        if (n == h->root)
+                return;
+
+        pheap_cut(n);
+        h->root = pheap_link(h, h->root, n);
+        h->root->next = h->root->prev = NULL;
+}
+
+/* Move every item of 'other' into 'h'. */
+void pheap_meld(struct pheap *h, struct pheap *other)
+{
+        if (other->root) {
+                h->root = h->root ? pheap_link(h, h->root, other->root) : other->root;
+                h->root->next = h->root->prev = NULL;
+        }
+
+        h->count += other->count;
+        other->root = NULL;
+        other->count = 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,256 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* pool.c - Slab allocator for fixed size objects.
+ *
+ * A free object in a batch holds the next object in the batch in its first word, and the first object of a batch
+ * also holds the next batch on the pool's stack and the batch's size, so objects are at least three words.  A batch
+ * on the stack may have fewer than POOL_BATCH objects (from pool_cache_flush()), never more.
+ *
+ * Each slab starts with a struct pool_slab, in a cache line of its own, and the objects follow.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "mec-lib/pool.h"
+#include "mec-lib/util.h"
+
+
+
+#define POOL_CACHELINE  64
+
+struct pool_slab {
+        struct pool_slab *next;
+        size_t size;
+};
+
+/* The head of a batch of free objects. */
+struct pool_batch {
+        void *next_obj;
+        struct pool_batch *next;
+        size_t count;
+};
+
+/* Initialize a pool. */
+int pool_init(struct pool *p, size_t obj_size, int flags)
+{
+        size_t slab_size = (flags & POOL_HUGE_PAGES) ? POOL_HUGE_SLAB_SIZE : POOL_SLAB_SIZE;
+
+        obj_size = MEC_MAX(obj_size, sizeof(struct pool_batch));
+        if (flags & POOL_CACHELINE_ALIGN)
+                obj_size = MEC_ALIGN_UP(obj_size, (size_t)POOL_CACHELINE);
+        else
+                obj_size = MEC_ALIGN_UP(obj_size, (size_t)POOL_ALIGN);
+
+        /* Big objects would waste most of each slab, and one that didn't fit in a slab at all could never be
+           allocated. */
+        if (obj_size > slab_size / 4)
+                return -1;
+
+        p->obj_size = obj_size;
+        p->slab_size = slab_size;
+        p->flags = flags;
+        pthread_mutex_init(&p->lock, NULL);
+        p->batches = NULL;
+        p->slabs = NULL;
+        p->carve = p->carve_end = NULL;
+        p->num_slabs = 0;
+
+        return 0;
+}
+
+/* Free every object in a pool at once. */
+void pool_destroy(struct pool *p)
+{
+        struct pool_slab *s, *next;
+
+        for (s = p->slabs; s; s = next) {
+                next = s->next;
+                munmap(s, s->size);
+        }
+
+        pthread_mutex_destroy(&p->lock);
+        p->slabs = NULL;
+        p->batches = NULL;
+        p->carve = p->carve_end = NULL;
+        p->num_slabs = 0;
+}
+
+/* Map 'size' bytes aligned to 'size', for transparent huge pages to be able to back it. */
+static void *pool_map_aligned(size_t size)
+{
+        char *m, *aligned;
+
+        m = mmap(NULL, size * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (m == MAP_FAILED)
+                return NULL;
+
+        aligned = (char *)MEC_ALIGN_UP((uintptr_t)m, (uintptr_t)size);
+        if (aligned > m)
+                munmap(m, aligned - m);
+        munmap(aligned + size, (m + size * 2) - (aligned + size));
+
+#ifdef MADV_HUGEPAGE
+        madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+
+        return aligned;
+}
+
+/* Map a new slab and make it the one objects are carved from.  Caller holds the pool's lock. */
+static int pool_new_slab(struct pool *p)
+{
+        struct pool_slab *s = NULL;
+
+        if (p->flags & POOL_HUGE_PAGES) {
+#ifdef MAP_HUGETLB
+                s = mmap(NULL, p->slab_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (s == MAP_FAILED)
+                        s = NULL;
+#endif
+                if (s == NULL)
+                        s = pool_map_aligned(p->slab_size);
+        } else {
+                s = mmap(NULL, p->slab_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (s == MAP_FAILED)
+                        s = NULL;
+        }
+
+        if (s == NULL)
+                return -1;
+
+        s->size = p->slab_size;
+        s->next = p->slabs;
+        p->slabs = s;
+        __atomic_store_n(&p->num_slabs, p->num_slabs + 1, __ATOMIC_RELAXED);
+
+        p->carve = (char *)s + POOL_CACHELINE;
+        p->carve_end = (char *)s + p->slab_size;
+
+        return 0;
+}
+
+/* Register a thread's cache for a pool. */
+void pool_cache_init(struct pool *p, struct pool_cache *c)
+{
+        c->pool = p;
+        c->count = 0;
+}
+
+/* Refill an empty cache from its pool: a batch from the stack if there is one, or else objects carved fresh from the
+   current slab.  Only taking the batch needs the lock; walking it happens after. */
+int pool_cache_refill(struct pool_cache *c)
+{
+        struct pool *p = c->pool;
+        struct pool_batch *b;
+        void *obj;
+        size_t i, n;
+
+        pthread_mutex_lock(&p->lock);
+
+        b = p->batches;
+        if (b) {
+                p->batches = b->next;
+                pthread_mutex_unlock(&p->lock);
+
+                for (i = b->count, obj = b; i; i--, obj = *(void **)obj)
+                        c->objs[c->count++] = obj;
+
+                return 0;
+        }
+
+        if ((p->carve + p->obj_size > p->carve_end) && pool_new_slab(p)) {
+                pthread_mutex_unlock(&p->lock);
+                return -1;
+        }
+
+        /* The cache pops objects off its end, so put them in backwards for them to be handed out in address order. */
+        n = MEC_MIN((size_t)POOL_BATCH, (size_t)(p->carve_end - p->carve) / p->obj_size);
+        if (n == 0) {
+                /* Can't happen with the size limit pool_init() enforces, but pool_alloc() relies on getting some. */
+                pthread_mutex_unlock(&p->lock);
+                return -1;
+        }
+        for (i = n; i--; )
+                c->objs[c->count++] = p->carve + i * p->obj_size;
+        p->carve += n * p->obj_size;
+
+        pthread_mutex_unlock(&p->lock);
+
+        return 0;
+}
+
+/* Link the top 'count' objects of a cache into a batch and push it onto the pool's stack. */
+static void pool_cache_push(struct pool_cache *c, size_t count)
+{
+        struct pool *p = c->pool;
+        struct pool_batch *b;
+        size_t i;
+
+        c->count -= count;
+        for (i = 0; i < count; i++)
+                *(void **)c->objs[c->count + i] = (i + 1 < count) ? c->objs[c->count + i + 1] : NULL;
+
+        b = c->objs[c->count];
+        b->count = count;
+
+        pthread_mutex_lock(&p->lock);
+        b->next = p->batches;
+        p->batches = b;
+        pthread_mutex_unlock(&p->lock);
+}
+
+/* Hand a batch of objects from a full cache back to its pool. */
+void pool_cache_drain(struct pool_cache *c)
+{
+        pool_cache_push(c, POOL_BATCH);
+}
+
+/* Give the objects in a cache back to its pool. */
+void pool_cache_flush(struct pool_cache *c)
+{
+        while (c->count)
+                pool_cache_push(c, MEC_MIN(c->count, (unsigned)POOL_BATCH));
+}
+
+/* Free many objects at once. */
+void pool_free_bulk(struct pool_cache *c, void **objs, size_t num_objs)
+{
+        size_t n;
+
+        while (num_objs) {
+                if (c->count == POOL_MAGAZINE_SIZE)
+                        pool_cache_drain(c);
+
+                n = MEC_MIN(num_objs, (size_t)(POOL_MAGAZINE_SIZE - c->count));
+                memcpy(&c->objs[c->count], objs, n * sizeof(objs[0]));
+                c->count += n;
+                objs += n;
+                num_objs -= n;
+        }
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
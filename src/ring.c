@@ -0,0 +1,182 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* ring.c - Bounded lock-free ring buffers.
+ *
+ * Indexes and tickets count up forever, and are only reduced modulo the number of slots to find a slot, so the
+ * difference between two of them is always the number of elements between them, even after they wrap around.
+ */
+
+#include <stdint.h>
+#include "mec-lib/ring.h"
+
+
+
+/* Initialize an empty SPSC ring. */
+int spsc_ring_init(struct spsc_ring *r, void *slots, size_t num_slots, size_t elem_size)
+{
+        if ((num_slots == 0) || (num_slots & (num_slots - 1)))
+                return -1;
+
+        r->tail = r->head_cache = 0;
+        r->head = r->tail_cache = 0;
+        r->slots = slots;
+        r->mask = num_slots - 1;
+        r->elem_size = elem_size;
+
+        return 0;
+}
+
+/* Copy up to 'n' elements into a ring, in two pieces where it wraps around. */
+size_t spsc_push_bulk(struct spsc_ring *r, const void *elems, size_t n)
+{
+        size_t done = 0, k;
+        void *slots;
+
+        while (done < n) {
+                k = spsc_reserve(r, &slots, n - done);
+                if (k == 0)
+                        break;
+                memcpy(slots, (const char *)elems + done * r->elem_size, k * r->elem_size);
+                spsc_commit(r, k);
+                done += k;
+        }
+
+        return done;
+}
+
+/* Copy up to 'n' elements out of a ring. */
+size_t spsc_pop_bulk(struct spsc_ring *r, void *elems, size_t n)
+{
+        size_t done = 0, k;
+        void *slots;
+
+        while (done < n) {
+                k = spsc_peek(r, &slots, n - done);
+                if (k == 0)
+                        break;
+                memcpy((char *)elems + done * r->elem_size, slots, k * r->elem_size);
+                spsc_release(r, k);
+                done += k;
+        }
+
+        return done;
+}
+
+
+
+/* Initialize an empty MPMC ring.  Slot i starts out ready for ticket i, the first lap's producer. */
+int mpmc_ring_init(struct mpmc_ring *r, void *slots, size_t num_slots, size_t elem_size)
+{
+        size_t i;
+
+        if ((num_slots < 2) || (num_slots & (num_slots - 1)))
+                return -1;
+
+        r->enqueue_pos = 0;
+        r->dequeue_pos = 0;
+        r->slots = slots;
+        r->mask = num_slots - 1;
+        r->slot_size = MPMC_RING_SLOT_SIZE(elem_size);
+        r->elem_size = elem_size;
+
+        for (i=0; i<num_slots; i++)
+                *mpmc_seq(r, i) = i;
+
+        return 0;
+}
+
+/* Claim up to 'n' consecutive slots whose sequence numbers are 'pos' + i + 'offset', from the position at '*posp',
+   which is the producers' or the consumers' position.  A slot with a lower sequence number is still in use from the
+   last lap (for producers) or not filled yet (for consumers), so the ring is full or empty.  A higher one means
+   another thread has already claimed it, and we are behind. */
+static size_t mpmc_claim(struct mpmc_ring *r, size_t *posp, size_t *ticket, size_t n, size_t offset)
+{
+        size_t pos = __atomic_load_n(posp, __ATOMIC_RELAXED);
+        intptr_t dif;
+        size_t k;
+
+        if (n == 0)
+                return 0;
+
+        for (;;) {
+                for (k=0; k<n; k++) {
+                        dif = (intptr_t)(__atomic_load_n(mpmc_seq(r, pos + k), __ATOMIC_ACQUIRE) - (pos + k + offset));
+                        if (dif)
+                                break;
+                }
+
+                if (k) {
+                        if (__atomic_compare_exchange_n(posp, &pos, pos + k, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                                *ticket = pos;
+                                return k;
+                        }
+                } else if (dif < 0) {
+                        return 0;
+                } else {
+                        pos = __atomic_load_n(posp, __ATOMIC_RELAXED);
+                }
+        }
+}
+
+/* Claim up to 'n' free slots. */
+size_t mpmc_reserve(struct mpmc_ring *r, size_t *ticket, size_t n)
+{
+        return mpmc_claim(r, &r->enqueue_pos, ticket, n, 0);
+}
+
+/* Claim up to 'n' filled slots. */
+size_t mpmc_peek(struct mpmc_ring *r, size_t *ticket, size_t n)
+{
+        return mpmc_claim(r, &r->dequeue_pos, ticket, n, 1);
+}
+
+/* Copy up to 'n' elements into a ring. */
+size_t mpmc_push_bulk(struct mpmc_ring *r, const void *elems, size_t n)
+{
+        size_t ticket, i;
+
+        n = mpmc_reserve(r, &ticket, n);
+        for (i=0; i<n; i++)
+                memcpy(mpmc_slot(r, ticket + i), (const char *)elems + i * r->elem_size, r->elem_size);
+        mpmc_commit(r, ticket, n);
+
+        return n;
+}
+
+/* Copy up to 'n' elements out of a ring. */
+size_t mpmc_pop_bulk(struct mpmc_ring *r, void *elems, size_t n)
+{
+        size_t ticket, i;
+
+        n = mpmc_peek(r, &ticket, n);
+        for (i=0; i<n; i++)
+                memcpy((char *)elems + i * r->elem_size, mpmc_slot(r, ticket + i), r->elem_size);
+        mpmc_release(r, ticket, n);
+
+        return n;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,311 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* skiplist.c - Lock-free concurrent skip list. */
+
+#include "mec-lib/skiplist.h"
+
+
+
+/* A next pointer with its low bit set belongs to a node that is being deleted. */
+#define IS_MARKED(p)    (((uintptr_t)(p)) & 1)
+#define MARKED(p)       ((struct skiplist_node *)(((uintptr_t)(p)) | 1))
+#define UNMARKED(p)     ((struct skiplist_node *)(((uintptr_t)(p)) & ~(uintptr_t)1))
+
+/* How far skiplist_seek() goes along the bottom level. */
+enum skiplist_seek {
+        SEEK_GTE,       /* To the first item >= key. */
+        SEEK_GT,        /* To the first item > key. */
+        SEEK_END,       /* Off the end. */
+};
+
+static inline struct skiplist_node *load_next(struct skiplist_node **slot)
+{
+        return __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+}
+
+static inline int cas_next(struct skiplist_node **slot, struct skiplist_node *old, struct skiplist_node *new)
+{
+        return __atomic_compare_exchange_n(slot, &old, new, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/* Where a node's pointer for 'level' lives, with NULL standing for the head of the list. */
+static inline struct skiplist_node **next_slot(struct skiplist *sl, struct skiplist_node *n, unsigned level)
+{
+        return n ? &n->next[level] : &sl->head[level];
+}
+
+
+
+/* Initialize an empty skip list. */
+void skiplist_init(struct skiplist *sl, struct skiplist_ops *ops)
+{
+        unsigned i;
+
+        sl->ops = ops;
+        for (i=0; i<SKIPLIST_MAX_HEIGHT; i++)
+                sl->head[i] = NULL;
+}
+
+/* Set the height of a node before it is inserted. */
+void skiplist_node_init(struct skiplist_node *n, unsigned height)
+{
+        n->height = height;
+}
+
+/* Find where 'key' goes on every level, unlinking any marked nodes on the way.  preds[i] is the pointer to follow on
+   level i, and succs[i] what it pointed to: the first node with a key >= 'key' (or > 'key', if 'past_equal' is set).
+   Returns 1 if an unmarked node with the key was found on the bottom level (in succs[0]), 0 if not.
+
+   A marked node is only ever unlinked by a CAS on an unmarked predecessor, so once a node is unlinked from a level
+   nothing can link it back. */
+static int skiplist_search(struct skiplist *sl, void *key, int past_equal, struct skiplist_node **preds[],
+                           struct skiplist_node *succs[])
+{
+        struct skiplist_node *pred, **slot, *curr, *succ;
+        int i, c = 1;
+
+retry:
+        pred = NULL;
+        for (i = SKIPLIST_MAX_HEIGHT - 1; i >= 0; i--) {
+                slot = next_slot(sl, pred, i);
+                curr = UNMARKED(load_next(slot));
+                c = 1;
+                while (curr) {
+                        succ = load_next(&curr->next[i]);
+                        if (IS_MARKED(succ)) {
+                                if (!cas_next(slot, curr, UNMARKED(succ)))
+                                        goto retry;
+                                curr = UNMARKED(succ);
+                                continue;
+                        }
+
+                        c = sl->ops->compare(sl->ops->get_key(curr), key);
+                        if ((c > 0) || ((c == 0) && !past_equal))
+                                break;
+
+                        pred = curr;
+                        slot = &curr->next[i];
+                        curr = succ;
+                }
+                preds[i] = slot;
+                succs[i] = curr;
+        }
+
+        return curr && (c == 0);
+}
+
+/* Read-only search along the bottom level, skipping over marked nodes.  Returns the first node at or past 'key' (as
+   'how' says) and, if 'last' is not NULL, the node before it. */
+static struct skiplist_node *skiplist_seek(struct skiplist *sl, void *key, enum skiplist_seek how,
+                                           struct skiplist_node **last)
+{
+        struct skiplist_node *pred = NULL, *curr = NULL, *succ;
+        int i, c;
+
+        for (i = SKIPLIST_MAX_HEIGHT - 1; i >= 0; i--) {
+                curr = UNMARKED(load_next(next_slot(sl, pred, i)));
+                while (curr) {
+                        succ = load_next(&curr->next[i]);
+                        if (IS_MARKED(succ)) {
+                                curr = UNMARKED(succ);
+                                continue;
+                        }
+
+                        if (how != SEEK_END) {
+                                c = sl->ops->compare(sl->ops->get_key(curr), key);
+                                if ((c > 0) || ((c == 0) && (how == SEEK_GTE)))
+                                        break;
+                        }
+
+                        pred = curr;
+                        curr = succ;
+                }
+        }
+
+        if (last)
+                *last = pred;
+
+        return curr;
+}
+
+/* Called by whichever of the inserter and the deleter finishes last, when nothing more will be linked to 'n'.  One
+   more search unlinks it from every level it is still on, after which it can be retired. */
+static void skiplist_finish(struct skiplist *sl, struct epoch_reader *r, struct skiplist_node *n)
+{
+        struct skiplist_node **preds[SKIPLIST_MAX_HEIGHT], *succs[SKIPLIST_MAX_HEIGHT];
+
+        skiplist_search(sl, sl->ops->get_key(n), 1, preds, succs);
+        epoch_retire(r, &n->deferred, sl->ops->reclaim);
+}
+
+static void skiplist_put(struct skiplist *sl, struct epoch_reader *r, struct skiplist_node *n)
+{
+        if (__atomic_sub_fetch(&n->refs, 1, __ATOMIC_ACQ_REL) == 0)
+                skiplist_finish(sl, r, n);
+}
+
+/* Insert an item: link it into the bottom level, which makes it part of the list, then into each level above.  If it
+   gets deleted part way through, stop; the deleter has marked the levels that are not linked yet, so they never
+   will be. */
+int skiplist_insert(struct skiplist *sl, struct epoch_reader *r, struct skiplist_node *n)
+{
+        struct skiplist_node **preds[SKIPLIST_MAX_HEIGHT], *succs[SKIPLIST_MAX_HEIGHT], *old;
+        void *key = sl->ops->get_key(n);
+        unsigned i;
+
+        for (i=1; i<n->height; i++)
+                n->next[i] = NULL;
+        n->refs = 2;
+
+        epoch_enter(r);
+
+        do {
+                if (skiplist_search(sl, key, 0, preds, succs)) {
+                        epoch_exit(r);
+                        return -1;
+                }
+                n->next[0] = succs[0];
+        } while (!cas_next(preds[0], succs[0], n));
+
+        for (i=1; i<n->height; i++) {
+                for (;;) {
+                        /* Only a deleter can change our pointer under us, and only by marking it. */
+                        old = load_next(&n->next[i]);
+                        if (IS_MARKED(old) || ((old != succs[i]) && !cas_next(&n->next[i], old, succs[i])))
+                                goto out;
+
+                        if (cas_next(preds[i], succs[i], n))
+                                break;
+
+                        if (!skiplist_search(sl, key, 0, preds, succs) || (succs[0] != n))
+                                goto out;
+                }
+        }
+
+out:
+        skiplist_put(sl, r, n);
+        epoch_exit(r);
+
+        return 0;
+}
+
+/* Delete an item: mark it from the top level down, so that the levels above the bottom are frozen before it stops
+   being part of the list. */
+int skiplist_delete(struct skiplist *sl, struct epoch_reader *r, struct skiplist_node *n)
+{
+        struct skiplist_node *succ;
+        int i;
+
+        epoch_enter(r);
+
+        for (i = n->height - 1; i >= 0; i--) {
+                do {
+                        succ = load_next(&n->next[i]);
+                        if (IS_MARKED(succ))
+                                break;
+                } while (!cas_next(&n->next[i], succ, MARKED(succ)));
+
+                if ((i == 0) && IS_MARKED(succ)) {
+                        /* Someone else got the bottom level first. */
+                        epoch_exit(r);
+                        return -1;
+                }
+        }
+
+        skiplist_put(sl, r, n);
+        epoch_exit(r);
+
+        return 0;
+}
+
+/* Find an item in a skip list. */
+struct skiplist_node *skiplist_find(struct skiplist *sl, void *key)
+{
+        struct skiplist_node *n = skiplist_seek(sl, key, SEEK_GTE, NULL);
+
+        if (n && (sl->ops->compare(sl->ops->get_key(n), key) == 0))
+                return n;
+
+        return NULL;
+}
+
+/* Find the smallest item whose key is greater than or equal to 'key'. */
+struct skiplist_node *skiplist_find_smallest_gte(struct skiplist *sl, void *key)
+{
+        return skiplist_seek(sl, key, SEEK_GTE, NULL);
+}
+
+/* Find the largest item whose key is less than or equal to 'key'. */
+struct skiplist_node *skiplist_find_largest_lte(struct skiplist *sl, void *key)
+{
+        struct skiplist_node *last;
+
+        skiplist_seek(sl, key, SEEK_GT, &last);
+
+        return last;
+}
+
+/* Return the next node.  A live node's bottom level pointer leads straight there; a deleted one's may be stale. */
+struct skiplist_node *skiplist_next(struct skiplist *sl, struct skiplist_node *n)
+{
+        struct skiplist_node *curr, *succ;
+
+        succ = load_next(next_slot(sl, n, 0));
+        if (IS_MARKED(succ))
+                return skiplist_seek(sl, sl->ops->get_key(n), SEEK_GT, NULL);
+
+        for (curr = succ; curr; curr = UNMARKED(succ)) {
+                succ = load_next(&curr->next[0]);
+                if (!IS_MARKED(succ))
+                        break;
+        }
+
+        return curr;
+}
+
+/* Return the previous node. */
+struct skiplist_node *skiplist_prev(struct skiplist *sl, struct skiplist_node *n)
+{
+        struct skiplist_node *last;
+
+        skiplist_seek(sl, n ? sl->ops->get_key(n) : NULL, n ? SEEK_GTE : SEEK_END, &last);
+
+        return last;
+}
+
+/* Return the number of items in a skip list. */
+size_t skiplist_count(struct skiplist *sl)
+{
+        struct skiplist_node *n;
+        size_t count = 0;
+
+        skiplist_for_each(sl, n)
+                count++;
+
+        return count;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
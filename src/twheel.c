@@ -0,0 +1,177 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* twheel.c - Hierarchical timer wheel.
+ *
+ * A timer that expires 'delta' ticks after the next one to be processed goes in the lowest level L for which delta <
+ * TWHEEL_SLOTS^(L+1), in the slot for (expires >> (TWHEEL_BITS * L)).  That slot is next emptied at the start of the
+ * block (at level L) holding 'expires': between 1 and TWHEEL_SLOTS blocks away, so it can't come round too late.  A
+ * timer in a slot that is being emptied is always within the range of the level below, and goes there.
+ */
+
+#include "mec-lib/twheel.h"
+#include "mec-lib/util.h"
+
+
+
+#define TWHEEL_MASK     (TWHEEL_SLOTS - 1)
+#define TWHEEL_MAX      ((1ULL << (TWHEEL_BITS * TWHEEL_LEVELS)) - 1)
+
+/* Initialize an empty timer wheel. */
+void twheel_init(struct twheel *w, uint64_t now)
+{
+        unsigned level, slot;
+
+        w->now = now;
+        for (level=0; level<TWHEEL_LEVELS; level++) {
+                w->occupied[level] = 0;
+                for (slot=0; slot<TWHEEL_SLOTS; slot++)
+                        dlist_init(&w->slots[level][slot]);
+        }
+}
+
+/* Put an unlinked timer in the right slot. */
+void twheel_add(struct twheel *w, struct twheel_timer *t)
+{
+        uint64_t expires = t->expires;
+        uint64_t delta;
+        unsigned level, slot;
+
+        if (expires < w->now)
+                expires = w->now;
+
+        /* Clamping has to stick, or each cascade would push the timer out again. */
+        delta = expires - w->now;
+        if (delta > TWHEEL_MAX) {
+                delta = TWHEEL_MAX;
+                expires = t->expires = w->now + delta;
+        }
+
+        level = delta ? (63 - __builtin_clzll(delta)) / TWHEEL_BITS : 0;
+        slot = (expires >> (TWHEEL_BITS * level)) & TWHEEL_MASK;
+
+        dlist_insert_back(&w->slots[level][slot], &t->link);
+        w->occupied[level] |= 1ULL << slot;
+}
+
+/* Empty the slot at 'level' for the block that is just starting, into the levels below.  If that is the first slot,
+   a new block is starting at the level above too, so that is emptied first. */
+static void twheel_cascade(struct twheel *w, unsigned level)
+{
+        unsigned slot = (w->now >> (TWHEEL_BITS * level)) & TWHEEL_MASK;
+        struct dlist list, *d;
+
+        if ((slot == 0) && (level + 1 < TWHEEL_LEVELS))
+                twheel_cascade(w, level + 1);
+
+        if (!(w->occupied[level] & (1ULL << slot)))
+                return;
+
+        w->occupied[level] &= ~(1ULL << slot);
+        dlist_init(&list);
+        dlist_splice_back(&list, &w->slots[level][slot]);
+        while ((d = dlist_pop_front(&list)))
+                twheel_add(w, TWHEEL_ITEM(d, struct twheel_timer, link));
+}
+
+/* Return the first tick after the current one at which anything in the wheel needs doing, assuming nothing is due in
+   what is left of the current block at level 0: the start of the next block if level 0 has timers wrapped around
+   into it, or else the start of the first block whose slot at a higher level has timers to cascade. */
+static uint64_t twheel_next_event(struct twheel *w)
+{
+        uint64_t next = UINT64_MAX;
+        uint64_t block, occupied, t;
+        unsigned level, shift, rot;
+
+        if (w->occupied[0])
+                next = (w->now | TWHEEL_MASK) + 1;
+
+        for (level=1; level<TWHEEL_LEVELS; level++) {
+                if (w->occupied[level] == 0)
+                        continue;
+
+                /* Slots are emptied in order, starting with the one after the current block's. */
+                shift = TWHEEL_BITS * level;
+                block = w->now >> shift;
+                rot = (block + 1) & TWHEEL_MASK;
+                occupied = rot ? (w->occupied[level] >> rot) | (w->occupied[level] << (TWHEEL_SLOTS - rot)) :
+                        w->occupied[level];
+                t = (block + 1 + __builtin_ctzll(occupied)) << shift;
+                if (t < next)
+                        next = t;
+        }
+
+        return next;
+}
+
+/* Move time forward to tick 'now'. */
+unsigned long twheel_advance(struct twheel *w, uint64_t now, struct dlist *expired)
+{
+        unsigned long count = 0;
+        struct dlist *d;
+        unsigned slot;
+        uint64_t pending;
+
+        /* Time never goes backwards: ticks before w->now have been done already. */
+        if (now < w->now)
+                return 0;
+
+        /* w->now is always one past the last tick done, so the last tick there can be is one before the end. */
+        now = MEC_MIN(now, UINT64_MAX - 1);
+
+        while (w->now <= now) {
+                slot = w->now & TWHEEL_MASK;
+                if (slot == 0)
+                        twheel_cascade(w, 1);
+
+                pending = w->occupied[0] >> slot;
+                if (pending == 0) {
+                        /* Nothing more this block: skip straight to whenever there is, if anything is pending. */
+                        w->now = twheel_next_event(w);
+                        if (w->now == UINT64_MAX)
+                                break;
+                        continue;
+                }
+
+                slot += __builtin_ctzll(pending);
+                if ((w->now | TWHEEL_MASK) - TWHEEL_MASK + slot > now)
+                        break;
+                w->now = (w->now | TWHEEL_MASK) - TWHEEL_MASK + slot;
+
+                w->occupied[0] &= ~(1ULL << slot);
+                dlist_for_each(&w->slots[0][slot], d)
+                        count++;
+                dlist_splice_back(expired, &w->slots[0][slot]);
+                w->now++;
+        }
+
+        /* Skipping ahead may have gone past 'now', over nothing but empty slots.  Arming timers is relative to the
+           current tick, so come back. */
+        w->now = now + 1;
+
+        return count;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
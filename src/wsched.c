@@ -0,0 +1,359 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* wsched.c - Work-stealing fork/join task scheduler.
+ *
+ * The deque follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Le, Pop, Cohen and Zappa Nardelli),
+ * with a fixed size array instead of a growable one.
+ *
+ * A worker that fails to find work a number of times in a row counts itself as a sleeper, looks once more, and then
+ * waits on the condition variable until 'wakeups' changes.  Spawning a task pushes it and then checks for sleepers,
+ * so either the spawner sees the sleeper and wakes it, or the sleeper's last look finds the task.
+ */
+
+#include <sched.h>
+#include "mec-lib/util.h"
+#include "mec-lib/wsched.h"
+
+
+
+/* Failed attempts to find work before a worker thread goes to sleep. */
+#define WSCHED_IDLE_SPINS       1024
+
+/* Push a task onto the bottom of a worker's own deque.  Returns 0 on success, non-zero if it is full. */
+static int wsched_push(struct wsched_worker *w, struct wsched_task *t)
+{
+        long b = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED);
+        long top = __atomic_load_n(&w->top, __ATOMIC_ACQUIRE);
+
+        if (b - top >= WSCHED_DEQUE_SIZE)
+                return -1;
+
+        __atomic_store_n(&w->deque[b % WSCHED_DEQUE_SIZE], t, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED);
+
+        return 0;
+}
+
+/* Pop the most recently pushed task off a worker's own deque. */
+static struct wsched_task *wsched_take(struct wsched_worker *w)
+{
+        long b = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED) - 1;
+        struct wsched_task *t = NULL;
+        long top;
+
+        __atomic_store_n(&w->bottom, b, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        top = __atomic_load_n(&w->top, __ATOMIC_RELAXED);
+
+        if (top <= b) {
+                t = __atomic_load_n(&w->deque[b % WSCHED_DEQUE_SIZE], __ATOMIC_RELAXED);
+                if (top == b) {
+                        /* The last one; race thieves for it. */
+                        if (!__atomic_compare_exchange_n(&w->top, &top, top + 1, 0, __ATOMIC_SEQ_CST,
+                                                         __ATOMIC_RELAXED))
+                                t = NULL;
+                        __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED);
+                }
+        } else {
+                __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED);
+        }
+
+        return t;
+}
+
+/* Steal the oldest task from another worker's deque.  Returns NULL if it is empty or another thief got there first. */
+static struct wsched_task *wsched_steal(struct wsched_worker *victim)
+{
+        long top = __atomic_load_n(&victim->top, __ATOMIC_ACQUIRE);
+        struct wsched_task *t;
+        long b;
+
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        b = __atomic_load_n(&victim->bottom, __ATOMIC_ACQUIRE);
+
+        if (top >= b)
+                return NULL;
+
+        t = __atomic_load_n(&victim->deque[top % WSCHED_DEQUE_SIZE], __ATOMIC_RELAXED);
+        if (!__atomic_compare_exchange_n(&victim->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+                return NULL;
+
+        return t;
+}
+
+/* Try each other worker once, starting from a random one. */
+static struct wsched_task *wsched_steal_any(struct wsched_worker *w)
+{
+        struct wsched *s = w->sched;
+        struct wsched_task *t;
+        unsigned i, victim;
+
+        if (s->num_workers < 2)
+                return NULL;
+
+        w->rand ^= w->rand << 13;
+        w->rand ^= w->rand >> 7;
+        w->rand ^= w->rand << 17;
+        victim = w->rand % s->num_workers;
+
+        for (i=0; i<s->num_workers; i++, victim = (victim + 1) % s->num_workers) {
+                if (victim == w->id)
+                        continue;
+                t = wsched_steal(&s->workers[victim]);
+                if (t)
+                        return t;
+        }
+
+        return NULL;
+}
+
+/* Run a task, sync any children it left behind, and tell its parent it is done. */
+static void wsched_execute(struct wsched_worker *w, struct wsched_task *t)
+{
+        struct wsched_task *parent = t->parent;
+
+        t->fn(t, w);
+        if (__atomic_load_n(&t->pending, __ATOMIC_ACQUIRE))
+                wsched_sync(w, t);
+
+        /* 't' may be gone as soon as the parent sees this. */
+        if (parent)
+                __atomic_fetch_sub(&parent->pending, 1, __ATOMIC_RELEASE);
+}
+
+/* Spawn a child task. */
+void wsched_spawn(struct wsched_worker *w, struct wsched_task *parent, struct wsched_task *child)
+{
+        struct wsched *s = w->sched;
+
+        child->parent = parent;
+        child->pending = 0;
+        __atomic_fetch_add(&parent->pending, 1, __ATOMIC_RELAXED);
+
+        if (wsched_push(w, child)) {
+                wsched_execute(w, child);
+                return;
+        }
+
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&s->sleepers, __ATOMIC_RELAXED)) {
+                pthread_mutex_lock(&s->lock);
+                s->wakeups++;
+                pthread_cond_signal(&s->cond);
+                pthread_mutex_unlock(&s->lock);
+        }
+}
+
+/* Wait for every child of a task to finish. */
+void wsched_sync(struct wsched_worker *w, struct wsched_task *parent)
+{
+        struct wsched_task *t;
+        unsigned spins = 0;
+
+        while (__atomic_load_n(&parent->pending, __ATOMIC_ACQUIRE)) {
+                t = wsched_take(w);
+                if (t == NULL)
+                        t = wsched_steal_any(w);
+
+                if (t) {
+                        wsched_execute(w, t);
+                        spins = 0;
+                } else if (++spins < WSCHED_IDLE_SPINS) {
+                        MEC_CPU_RELAX();
+                } else {
+                        /* Whoever has our children may be waiting for this CPU. */
+                        sched_yield();
+                }
+        }
+}
+
+/* Steal work until told to stop, sleeping when there is none. */
+static void *wsched_worker_thread(void *arg)
+{
+        struct wsched_worker *w = arg;
+        struct wsched *s = w->sched;
+        struct wsched_task *t;
+        unsigned long wakeups;
+        unsigned spins = 0;
+
+        while (!__atomic_load_n(&s->stop, __ATOMIC_ACQUIRE)) {
+                t = wsched_steal_any(w);
+                if (t) {
+                        wsched_execute(w, t);
+                        spins = 0;
+                        continue;
+                }
+
+                if (++spins < WSCHED_IDLE_SPINS) {
+                        MEC_CPU_RELAX();
+                        continue;
+                }
+                spins = 0;
+
+                pthread_mutex_lock(&s->lock);
+                wakeups = s->wakeups;
+                __atomic_store_n(&s->sleepers, s->sleepers + 1, __ATOMIC_RELAXED);
+                pthread_mutex_unlock(&s->lock);
+
+                __atomic_thread_fence(__ATOMIC_SEQ_CST);
+                t = wsched_steal_any(w);
+
+                pthread_mutex_lock(&s->lock);
+                while (!t && (s->wakeups == wakeups) && !s->stop)
+                        pthread_cond_wait(&s->cond, &s->lock);
+                __atomic_store_n(&s->sleepers, s->sleepers - 1, __ATOMIC_RELAXED);
+                pthread_mutex_unlock(&s->lock);
+
+                if (t)
+                        wsched_execute(w, t);
+        }
+
+        return NULL;
+}
+
+/* Start a scheduler. */
+int wsched_init(struct wsched *s, struct wsched_worker *workers, unsigned num_workers)
+{
+        unsigned i;
+
+        if (num_workers == 0)
+                return -1;
+
+        s->workers = workers;
+        s->num_workers = num_workers;
+        s->started = 0;
+        s->stop = 0;
+        s->sleepers = 0;
+        s->wakeups = 0;
+        pthread_mutex_init(&s->run_lock, NULL);
+        pthread_mutex_init(&s->lock, NULL);
+        pthread_cond_init(&s->cond, NULL);
+
+        for (i=0; i<num_workers; i++) {
+                workers[i].top = 0;
+                workers[i].bottom = 0;
+                workers[i].sched = s;
+                workers[i].id = i;
+                workers[i].rand = 0x9e3779b97f4a7c15ULL * (i + 1);
+        }
+
+        for (i=1; i<num_workers; i++) {
+                if (pthread_create(&workers[i].thread, NULL, wsched_worker_thread, &workers[i]))
+                        break;
+                s->started++;
+        }
+
+        return 0;
+}
+
+/* Stop a scheduler's threads. */
+void wsched_destroy(struct wsched *s)
+{
+        unsigned i;
+
+        pthread_mutex_lock(&s->lock);
+        __atomic_store_n(&s->stop, 1, __ATOMIC_RELEASE);
+        pthread_cond_broadcast(&s->cond);
+        pthread_mutex_unlock(&s->lock);
+
+        for (i=1; i<=s->started; i++)
+                pthread_join(s->workers[i].thread, NULL);
+
+        pthread_cond_destroy(&s->cond);
+        pthread_mutex_destroy(&s->lock);
+        pthread_mutex_destroy(&s->run_lock);
+}
+
+/* Run a task to completion. */
+void wsched_run(struct wsched *s, struct wsched_task *t)
+{
+        pthread_mutex_lock(&s->run_lock);
+        t->parent = NULL;
+        t->pending = 0;
+        wsched_execute(&s->workers[0], t);
+        pthread_mutex_unlock(&s->run_lock);
+}
+
+
+
+struct wsched_for_task {
+        struct wsched_task task;
+        size_t lo, hi, grain;
+        void (*fn)(size_t lo, size_t hi, void *arg, struct wsched_worker *w);
+        void *arg;
+};
+
+/* Split the range in two, spawn the top half and do the bottom half here, until it is small enough to just do. */
+static void wsched_for_fn(struct wsched_task *t, struct wsched_worker *w)
+{
+        struct wsched_for_task *f = WSCHED_ITEM(t, struct wsched_for_task, task);
+        struct wsched_for_task top;
+        size_t mid;
+
+        if (f->hi - f->lo <= f->grain) {
+                f->fn(f->lo, f->hi, f->arg, w);
+                return;
+        }
+
+        mid = f->lo + (f->hi - f->lo) / 2;
+        top = *f;
+        top.lo = mid;
+        wsched_task_init(&top.task, wsched_for_fn);
+        wsched_spawn(w, t, &top.task);
+
+        f->hi = mid;
+        wsched_for_fn(t, w);
+        wsched_sync(w, t);
+}
+
+/* Call 'fn' on ranges covering 'lo' to 'hi', from inside a task. */
+void wsched_parallel_for(struct wsched_worker *w, size_t lo, size_t hi, size_t grain,
+                         void (*fn)(size_t lo, size_t hi, void *arg, struct wsched_worker *w), void *arg)
+{
+        struct wsched_for_task f = { .lo = lo, .hi = hi, .grain = grain, .fn = fn, .arg = arg };
+
+        if (lo >= hi)
+                return;
+
+        wsched_task_init(&f.task, wsched_for_fn);
+        wsched_for_fn(&f.task, w);
+}
+
+/* Call 'fn' on ranges covering 'lo' to 'hi', from outside the scheduler. */
+void wsched_for(struct wsched *s, size_t lo, size_t hi, size_t grain,
+                void (*fn)(size_t lo, size_t hi, void *arg, struct wsched_worker *w), void *arg)
+{
+        struct wsched_for_task f = { .lo = lo, .hi = hi, .grain = grain, .fn = fn, .arg = arg };
+
+        if (lo >= hi)
+                return;
+
+        wsched_task_init(&f.task, wsched_for_fn);
+        wsched_run(s, &f.task);
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
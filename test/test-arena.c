@@ -0,0 +1,264 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-arena.c - Unit tests for arenas. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mec-lib/arena.h"
+#include "mec-lib/bst.h"
+#include "mec-lib/dlist.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+#define NUM_THINGS      10000
+#define NUM_REQUESTS    10
+
+struct thing {
+        uint64_t key;
+        struct bst_node bst;
+        struct dlist list;
+};
+
+struct arena arena;
+char buf[4096] __attribute__((aligned(8192)));
+
+unsigned chunk_allocs, chunk_frees;
+int fail_allocs;
+
+void *alloc_chunk(size_t size)
+{
+        void *c;
+
+        if (fail_allocs)
+                return NULL;
+
+        TEST(posix_memalign(&c, ARENA_ALIGN, size) == 0);
+        chunk_allocs++;
+
+        return c;
+}
+
+void free_chunk(void *chunk, size_t size)
+{
+        TEST(chunk != buf);
+        chunk_frees++;
+        free(chunk);
+}
+
+struct arena_ops ops = {
+        .alloc_chunk = alloc_chunk,
+        .free_chunk = free_chunk,
+};
+
+void *thing_get_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct thing, bst)->key;
+}
+
+int compare_u64s(void *key_a, void *key_b)
+{
+        uint64_t a = *(uint64_t *)key_a;
+        uint64_t b = *(uint64_t *)key_b;
+
+        return (a > b) - (a < b);
+}
+
+struct bst_ops thing_bst_ops = {
+        .get_key = thing_get_key,
+        .compare = compare_u64s,
+};
+
+void test_buffer(void)
+{
+        char *p, *first, *last = NULL;
+        size_t align;
+        unsigned n;
+
+        printf("Checking a caller supplied buffer...\n");
+
+        /* With no ops, allocations fail once the buffer is used up. */
+        arena_init(&arena, NULL, buf, sizeof(buf));
+        first = arena_alloc(&arena, 24);
+        TEST(first >= buf && first + 24 <= buf + sizeof(buf));
+        for (n = 1; (p = arena_alloc(&arena, 24)); n++) {
+                TEST(((uintptr_t)p % ARENA_ALIGN) == 0);
+                TEST(p >= first + 32 * n && p + 24 <= buf + sizeof(buf));
+                last = p;
+        }
+        TEST(n > sizeof(buf) / 32 - 2);
+        TEST(last + 32 > buf + sizeof(buf) - 32);
+
+        /* Resetting makes the whole buffer available again. */
+        arena_reset(&arena);
+        TEST(arena_alloc(&arena, 24) == first);
+
+        /* Odd sizes and alignments. */
+        arena_reset(&arena);
+        last = first;
+        for (align = 1; align <= 1024; align *= 2) {
+                p = arena_alloc_aligned(&arena, 3, align);
+                TEST(p != NULL);
+                TEST(((uintptr_t)p % align) == 0);
+                TEST(p >= last);
+                last = p + 3;
+        }
+        TEST(arena_alloc_aligned(&arena, 1, 8192) == NULL);
+        TEST(arena_alloc(&arena, sizeof(buf)) == NULL);
+
+        /* A buffer too small for a chunk header is ignored. */
+        arena_destroy(&arena);
+        arena_init(&arena, NULL, buf + 1, 8);
+        TEST(arena_alloc(&arena, 1) == NULL);
+        TEST(arena_size(&arena) == 0);
+        arena_destroy(&arena);
+}
+
+void test_chunks(void)
+{
+        struct arena_mark m, m2;
+        char *p, *first, *after_mark;
+        unsigned i, allocs;
+
+        printf("Checking chunks from ops...\n");
+
+        chunk_allocs = chunk_frees = 0;
+        arena_init(&arena, &ops, buf, sizeof(buf));
+
+        /* The buffer is used first, then new chunks. */
+        first = arena_alloc(&arena, 1000);
+        TEST(first >= buf && first < buf + sizeof(buf));
+        TEST(chunk_allocs == 0);
+        for (i=0; i<100; i++)
+                TEST(arena_alloc(&arena, 1000) != NULL);
+        TEST(chunk_allocs == 100 * 1000 / ARENA_CHUNK_SIZE + 1);
+        TEST(arena_size(&arena) == sizeof(buf) + chunk_allocs * ARENA_CHUNK_SIZE);
+
+        /* A failure to get a chunk fails the allocation, but leaves the arena usable. */
+        arena_mark(&arena, &m);
+        fail_allocs = 1;
+        TEST(arena_alloc(&arena, ARENA_CHUNK_SIZE) == NULL);
+        fail_allocs = 0;
+        after_mark = arena_alloc(&arena, 8);
+        TEST(after_mark != NULL);
+
+        /* Rewinding frees everything after the mark, and the chunks get reused. */
+        allocs = chunk_allocs;
+        for (i=0; i<1000; i++)
+                TEST(arena_alloc(&arena, 1000) != NULL);
+        arena_mark(&arena, &m2);
+        TEST(chunk_allocs > allocs);
+        allocs = chunk_allocs;
+        arena_rewind(&arena, &m);
+        TEST(arena_alloc(&arena, 8) == after_mark);
+        for (i=0; i<1000; i++)
+                TEST(arena_alloc(&arena, 1000) != NULL);
+        TEST(chunk_allocs == allocs);
+
+        /* Allocations bigger than a chunk get one of their own. */
+        p = arena_alloc_aligned(&arena, 3 * ARENA_CHUNK_SIZE, 4096);
+        TEST(p != NULL);
+        TEST(((uintptr_t)p % 4096) == 0);
+        memset(p, 0xa5, 3 * ARENA_CHUNK_SIZE);
+        TEST(chunk_allocs == allocs + 1);
+
+        /* Which is kept after a reset too, even though it is bigger than the rest. */
+        arena_reset(&arena);
+        TEST(arena_alloc(&arena, 1000) == first);
+        arena_rewind(&arena, &m2);
+        TEST(arena_alloc_aligned(&arena, 3 * ARENA_CHUNK_SIZE, 4096) != NULL);
+        TEST(chunk_allocs == allocs + 1);
+
+        arena_destroy(&arena);
+        TEST(chunk_frees == chunk_allocs);
+        TEST(arena_size(&arena) == 0);
+}
+
+/* Build and tear down temporary structures, as a server might for each request. */
+void test_requests(void)
+{
+        struct thing *t, *found;
+        struct dlist list;
+        struct bst bst;
+        unsigned r, i, allocs = 0;
+        uint64_t key;
+
+        printf("Checking reuse across requests...\n");
+
+        chunk_allocs = chunk_frees = 0;
+        arena_init(&arena, &ops, NULL, 0);
+
+        for (r=0; r<NUM_REQUESTS; r++) {
+                bst_init(&bst, &thing_bst_ops);
+                dlist_init(&list);
+
+                for (i=0; i<NUM_THINGS; i++) {
+                        t = arena_alloc(&arena, sizeof(*t));
+                        TEST(t != NULL);
+                        t->key = (i * 7919 + r) % NUM_THINGS;
+                        TEST(bst_insert(&bst, &t->bst) == 0);
+                        dlist_insert_back(&list, &t->list);
+                }
+
+                for (key=0; key<NUM_THINGS; key++) {
+                        found = BST_ITEM(bst_find(&bst, &key), struct thing, bst);
+                        TEST(found != NULL && found->key == key);
+                }
+                i = 0;
+                dlist_for_each_item(&list, t, struct thing, list)
+                        TEST(t->key == (i++ * 7919 + r) % NUM_THINGS);
+                TEST(i == NUM_THINGS);
+
+                /* Throwing it all away is just a reset; after the first request, no more chunks are needed. */
+                arena_reset(&arena);
+                if (r == 0)
+                        allocs = chunk_allocs;
+                TEST(chunk_allocs == allocs);
+        }
+
+        arena_destroy(&arena);
+        TEST(chunk_frees == chunk_allocs);
+}
+
+int main(void)
+{
+        test_buffer();
+        test_chunks();
+        test_requests();
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
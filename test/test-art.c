@@ -0,0 +1,426 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-art.c - Unit tests for adaptive radix trees. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mec-lib/art.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+#define MAX_KEY_LEN     32
+
+struct thing {
+        unsigned char key[MAX_KEY_LEN];
+        size_t len;
+        int in_tree;
+};
+
+#define NUM_THINGS      20000
+
+struct art art;
+struct thing thing_array[NUM_THINGS];
+unsigned num_things;
+
+const void *thing_get_key(void *item, size_t *len)
+{
+        struct thing *t = item;
+
+        *len = t->len;
+        return t->key;
+}
+
+/* Allocations can be made to fail, to check that a failed insert leaves the tree alone. */
+unsigned nodes_allocated;
+int fail_allocs;
+
+struct art_node *alloc_node(size_t size)
+{
+        if (fail_allocs)
+                return NULL;
+        nodes_allocated++;
+
+        return malloc(size);
+}
+
+void free_node(struct art_node *n, size_t size)
+{
+        TEST(nodes_allocated > 0);
+        nodes_allocated--;
+        free(n);
+}
+
+struct art_ops thing_art_ops = {
+        .get_key = thing_get_key,
+        .alloc_node = alloc_node,
+        .free_node = free_node,
+};
+
+int compare_things(const void *a, const void *b)
+{
+        const struct thing *ta = a, *tb = b;
+        int rc = memcmp(ta->key, tb->key, (ta->len < tb->len) ? ta->len : tb->len);
+
+        return rc ? rc : (ta->len > tb->len) - (ta->len < tb->len);
+}
+
+/* Check a subtree at depth 'd', where 'path' holds the bytes that lead to it (or -1 for prefix bytes that the nodes
+   don't store).  Returns the number of items. */
+size_t assert_subtree_valid(void *p, int *path, size_t d)
+{
+        static const unsigned min_children[] = { 0, 4, 13, 38 };
+        static const unsigned max_children[] = { 4, 16, 48, 256 };
+        struct art_node *n;
+        struct thing *t;
+        unsigned char *keys = NULL;
+        void **children = NULL;
+        size_t items = 0, i;
+        unsigned c, num = 0;
+        int last = -1;
+
+        if ((uintptr_t)p & 1) {
+                t = (struct thing *)((uintptr_t)p - 1);
+                TEST(t->in_tree);
+                TEST(t->len >= d);
+                for (i = 0; i < d; i++)
+                        TEST((path[i] < 0) || (path[i] == t->key[i]));
+                return 1;
+        }
+
+        n = p;
+        TEST(n->type <= ART_NODE256);
+        TEST(n->num_children >= min_children[n->type]);
+        TEST(n->num_children <= max_children[n->type]);
+        TEST(n->num_children + (n->leaf != NULL) >= 2);
+        TEST(d + n->prefix_len + 1 < MAX_KEY_LEN * 2);
+        for (i = 0; i < n->prefix_len; i++)
+                path[d + i] = (i < ART_MAX_PREFIX_LEN) ? n->prefix[i] : -1;
+        d += n->prefix_len;
+
+        if (n->leaf) {
+                t = n->leaf;
+                TEST(t->in_tree);
+                TEST(t->len == d);
+                for (i = 0; i < d; i++)
+                        TEST((path[i] < 0) || (path[i] == t->key[i]));
+                items++;
+        }
+
+        if (n->type == ART_NODE4) {
+                keys = ((struct art_node4 *)n)->keys;
+                children = ((struct art_node4 *)n)->children;
+        } else if (n->type == ART_NODE16) {
+                keys = ((struct art_node16 *)n)->keys;
+                children = ((struct art_node16 *)n)->children;
+        }
+
+        if (keys) {
+                for (i = 0; i < n->num_children; i++) {
+                        TEST((int)keys[i] > last);
+                        last = keys[i];
+                        path[d] = keys[i];
+                        items += assert_subtree_valid(children[i], path, d + 1);
+                }
+                return items;
+        }
+
+        for (c = 0; c < 256; c++) {
+                void *child = NULL;
+
+                if (n->type == ART_NODE48) {
+                        if (((struct art_node48 *)n)->index[c])
+                                child = ((struct art_node48 *)n)->children[((struct art_node48 *)n)->index[c] - 1];
+                } else {
+                        child = ((struct art_node256 *)n)->children[c];
+                }
+                if (child) {
+                        num++;
+                        path[d] = c;
+                        items += assert_subtree_valid(child, path, d + 1);
+                }
+        }
+        TEST(num == n->num_children);
+
+        return items;
+}
+
+/* Check the tree's structure, then every lookup against what should be in it.  thing_array is sorted, so the answers
+   can be found by scanning it. */
+void assert_art_valid(int lookups)
+{
+        int path[MAX_KEY_LEN * 2];
+        struct thing *thingp, *expect, probe;
+        size_t count = 0;
+        unsigned i, j;
+
+        for (i = 0; i < num_things; i++)
+                count += thing_array[i].in_tree;
+        TEST((art.root ? assert_subtree_valid(art.root, path, 0) : 0) == count);
+        if (!lookups)
+                return;
+
+        expect = NULL;
+        for (i = 0, thingp = art_next(&art, NULL); i < num_things; i++) {
+                if (!thing_array[i].in_tree)
+                        continue;
+                TEST(thingp == &thing_array[i]);
+                TEST(art_prev(&art, thingp) == expect);
+                expect = thingp;
+                thingp = art_next(&art, thingp);
+        }
+        TEST(thingp == NULL);
+        TEST(art_prev(&art, NULL) == expect);
+
+        for (i = 0; i < num_things; i++) {
+                TEST(art_find(&art, thing_array[i].key, thing_array[i].len) ==
+                     (thing_array[i].in_tree ? &thing_array[i] : NULL));
+
+                for (j = i; (j < num_things) && !thing_array[j].in_tree; j++)
+                        ;
+                TEST(art_find_smallest_gte(&art, thing_array[i].key, thing_array[i].len) ==
+                     ((j < num_things) ? &thing_array[j] : NULL));
+                for (j = i + 1; (j > 0) && !thing_array[j - 1].in_tree; j--)
+                        ;
+                TEST(art_find_largest_lte(&art, thing_array[i].key, thing_array[i].len) ==
+                     ((j > 0) ? &thing_array[j - 1] : NULL));
+
+                /* Keys don't contain 0 bytes, so adding one gives a key that is just after this one. */
+                probe = thing_array[i];
+                probe.key[probe.len++] = 0;
+                for (j = i + 1; (j < num_things) && !thing_array[j].in_tree; j++)
+                        ;
+                TEST(art_find(&art, probe.key, probe.len) == NULL);
+                TEST(art_find_smallest_gte(&art, probe.key, probe.len) == ((j < num_things) ? &thing_array[j] : NULL));
+                for (j = i + 1; (j > 0) && !thing_array[j - 1].in_tree; j--)
+                        ;
+                TEST(art_find_largest_lte(&art, probe.key, probe.len) == ((j > 0) ? &thing_array[j - 1] : NULL));
+        }
+}
+
+/* Keys are made to share prefixes often: short ones over a few letters (so many are prefixes of others), and long ones
+   that start with the same 12 bytes, which is more than a node stores. */
+void make_keys(void)
+{
+        unsigned i, j, n;
+
+        thing_array[0].len = 0;
+        for (i = 1; i < NUM_THINGS; i++) {
+                struct thing *t = &thing_array[i];
+
+                switch (random() % 4) {
+                case 0:
+                        t->len = random() % 8;
+                        for (j = 0; j < t->len; j++)
+                                t->key[j] = 'a' + random() % 3;
+                        break;
+                case 1:
+                        t->len = 12 + random() % 8;
+                        memcpy(t->key, "common/prefix", 12);
+                        for (j = 12; j < t->len; j++)
+                                t->key[j] = 'a' + random() % 26;
+                        break;
+                case 2:
+                        t->len = 1 + random() % 24;
+                        for (j = 0; j < t->len; j++)
+                                t->key[j] = 1 + random() % 255;
+                        break;
+                case 3:
+                        n = 1 + random() % 4;
+                        t->len = n * 5;
+                        for (j = 0; j < t->len; j++)
+                                t->key[j] = (j % 5) ? 'x' : '0' + random() % 10;
+                        break;
+                }
+        }
+
+        qsort(thing_array, NUM_THINGS, sizeof(thing_array[0]), compare_things);
+        for (i = 1, num_things = 1; i < NUM_THINGS; i++)
+                if (compare_things(&thing_array[i], &thing_array[num_things - 1]))
+                        thing_array[num_things++] = thing_array[i];
+}
+
+unsigned random_thing(int in_tree)
+{
+        unsigned j = random() % num_things;
+
+        while (thing_array[j].in_tree != in_tree)
+                j = (j + 1) % num_things;
+
+        return j;
+}
+
+struct u64_thing {
+        uint64_t key;           /* Big endian, from art_u64_key(). */
+        uint64_t value;
+};
+
+const void *u64_thing_get_key(void *item, size_t *len)
+{
+        *len = sizeof(uint64_t);
+        return &((struct u64_thing *)item)->key;
+}
+
+struct art_ops u64_thing_art_ops = {
+        .get_key = u64_thing_get_key,
+        .alloc_node = alloc_node,
+        .free_node = free_node,
+};
+
+int compare_u64s(const void *a, const void *b)
+{
+        uint64_t va = *(const uint64_t *)a, vb = *(const uint64_t *)b;
+
+        return (va > vb) - (va < vb);
+}
+
+#define NUM_U64_THINGS  50000
+
+struct u64_thing u64_things[NUM_U64_THINGS];
+uint64_t sorted_values[NUM_U64_THINGS];
+
+void test_u64_keys(void)
+{
+        struct u64_thing *thingp;
+        uint64_t key;
+        unsigned i;
+
+        printf("Checking 64 bit integer keys...\n");
+        art_init(&art, &u64_thing_art_ops);
+        for (i = 0; i < NUM_U64_THINGS; i++) {
+                /* Dense runs of small values, and scattered large ones. */
+                u64_things[i].value = (i % 2) ? i : ((uint64_t)random() << 32) ^ random();
+                u64_things[i].key = art_u64_key(u64_things[i].value);
+                sorted_values[i] = u64_things[i].value;
+                TEST(art_insert(&art, &u64_things[i]) == 0);
+        }
+        qsort(sorted_values, NUM_U64_THINGS, sizeof(sorted_values[0]), compare_u64s);
+
+        for (i = 0, thingp = art_next(&art, NULL); thingp; i++, thingp = art_next(&art, thingp)) {
+                TEST(thingp->value == sorted_values[i]);
+                key = art_u64_key(thingp->value + 1);
+                if (i + 1 < NUM_U64_THINGS)
+                        TEST(art_find_smallest_gte(&art, &key, sizeof(key)) == art_next(&art, thingp));
+        }
+        TEST(i == NUM_U64_THINGS);
+
+        for (i = 0; i < NUM_U64_THINGS; i++)
+                TEST(art_delete(&art, &u64_things[i].key, sizeof(uint64_t)) == 0);
+        TEST(art.root == NULL);
+        TEST(nodes_allocated == 0);
+}
+
+int main(void)
+{
+        unsigned i, j, allocated;
+        int rc;
+
+        art_init(&art, &thing_art_ops);
+
+        printf("Checking an empty ART...\n");
+        TEST(art_find(&art, "", 0) == NULL);
+        TEST(art_find_smallest_gte(&art, "", 0) == NULL);
+        TEST(art_find_largest_lte(&art, "\xff", 1) == NULL);
+        TEST(art_next(&art, NULL) == NULL);
+        TEST(art_prev(&art, NULL) == NULL);
+        TEST(art_delete(&art, "", 0) != 0);
+
+        make_keys();
+        printf("Adding %u items in random order...\n", num_things);
+        for (i = 0; i < num_things; i++) {
+                j = random_thing(0);
+                TEST(art_insert(&art, &thing_array[j]) == 0);
+                thing_array[j].in_tree = 1;
+                TEST(art_insert(&art, &thing_array[j]) != 0);
+
+                if ((i < 200) || ((i % 2000) == 0))
+                        assert_art_valid((i < 50) || ((i % 4000) == 0));
+        }
+        assert_art_valid(1);
+
+        printf("Deleting half the items in random order...\n");
+        for (i = 0; i < num_things / 2; i++) {
+                j = random_thing(1);
+                TEST(art_delete(&art, thing_array[j].key, thing_array[j].len) == 0);
+                thing_array[j].in_tree = 0;
+                TEST(art_delete(&art, thing_array[j].key, thing_array[j].len) != 0);
+                TEST(art_find(&art, thing_array[j].key, thing_array[j].len) == NULL);
+
+                if ((i % 1000) == 0)
+                        assert_art_valid(0);
+        }
+        assert_art_valid(1);
+
+        printf("Checking that a failed allocation leaves the tree alone...\n");
+        fail_allocs = 1;
+        for (i = 0; i < 200; i++) {
+                j = random_thing(0);
+                allocated = nodes_allocated;
+                rc = art_insert(&art, &thing_array[j]);
+                TEST(nodes_allocated == allocated);
+                if (rc == 0)
+                        thing_array[j].in_tree = 1;
+                if ((i % 20) == 0)
+                        assert_art_valid(0);
+        }
+        fail_allocs = 0;
+        assert_art_valid(1);
+
+        printf("Deleting the rest...\n");
+        for (i = 0; i < num_things; i++) {
+                if (!thing_array[i].in_tree)
+                        continue;
+                TEST(art_delete(&art, thing_array[i].key, thing_array[i].len) == 0);
+                thing_array[i].in_tree = 0;
+                if ((i % 500) == 0)
+                        assert_art_valid(0);
+        }
+        TEST(art.root == NULL);
+        TEST(nodes_allocated == 0);
+
+        printf("Checking art_destroy()...\n");
+        for (i = 0; i < num_things; i += 2)
+                TEST(art_insert(&art, &thing_array[i]) == 0);
+        TEST(nodes_allocated > 0);
+        art_destroy(&art);
+        TEST(nodes_allocated == 0);
+        TEST(art_find(&art, thing_array[0].key, thing_array[0].len) == NULL);
+
+        test_u64_keys();
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,245 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-bst-conc.c - Multi-threaded stress test for concurrent bst's. */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mec-lib/bst-conc.h"
+#include "mec-lib/epoch.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+/* Even keys are inserted up front and never deleted.  The writer keeps deleting odd keyed things and reinserting them
+   with new odd keys once they have been reclaimed. */
+struct thing {
+        int a;
+        int reclaimed;
+        struct bst_node bstn;
+        struct epoch_deferred ed;
+        struct dlist free_link;
+};
+
+#define NUM_STABLE      1000
+#define NUM_CHURN       1000
+#define NUM_READERS     4
+#define NUM_WRITES      200000
+#define KEY_RANGE       (NUM_STABLE * 2)
+
+struct bst_conc tree;
+struct epoch epoch;
+struct thing stable_things[NUM_STABLE];
+struct thing churn_things[NUM_CHURN];
+struct dlist free_things;
+int writer_done;
+
+void *thing_get_int_key(struct bst_node *n)
+{
+        struct thing *thing;
+
+        thing = BST_ITEM(n, struct thing, bstn);
+
+        return &thing->a;
+}
+
+int compare_ints(void *key_a, void *key_b)
+{
+        int *int_a = (int *)key_a;
+        int *int_b = (int *)key_b;
+
+        return *int_a - *int_b;
+}
+
+struct bst_ops thing_int_bst_ops = {
+        .get_key = thing_get_int_key,
+        .compare = compare_ints,
+};
+
+/* Called once no reader can see the thing any more; poison it and make it available to the writer again. */
+void thing_reclaim(struct epoch_deferred *d)
+{
+        struct thing *thing = EPOCH_ITEM(d, struct thing, ed);
+
+        __atomic_store_n(&thing->reclaimed, 1, __ATOMIC_RELAXED);
+        dlist_insert_back(&free_things, &thing->free_link);
+}
+
+/* Check a node returned from a lookup while still inside the critical section. */
+struct thing *check_node(struct bst_node *n)
+{
+        struct thing *thing = BST_ITEM(n, struct thing, bstn);
+
+        if (thing)
+                TEST(__atomic_load_n(&thing->reclaimed, __ATOMIC_RELAXED) == 0);
+
+        return thing;
+}
+
+void *reader_thread(void *arg)
+{
+        struct epoch_reader reader;
+        unsigned seed = (unsigned)(unsigned long)arg;
+        unsigned long lookups = 0;
+        struct thing *thing, *last;
+        struct bst_node *n;
+        unsigned i;
+        int key;
+
+        epoch_reader_register(&epoch, &reader);
+
+        while (!__atomic_load_n(&writer_done, __ATOMIC_ACQUIRE)) {
+                key = rand_r(&seed) % (KEY_RANGE - 1);
+
+                epoch_enter(&reader);
+
+                /* Stable items must always be found. */
+                thing = check_node(bst_conc_find(&tree, &(int){ key & ~1 }));
+                TEST(thing && (thing->a == (key & ~1)));
+
+                /* The smallest item >= key is at most the next stable item. */
+                thing = check_node(bst_conc_find_smallest_gte(&tree, &key));
+                TEST(thing && (thing->a >= key) && (thing->a <= ((key + 1) & ~1)));
+
+                thing = check_node(bst_conc_find_largest_lte(&tree, &key));
+                TEST(thing && (thing->a <= key) && (thing->a >= (key & ~1)));
+
+                /* Walk a little way in both directions. */
+                last = thing;
+                for (i=0, n = bst_conc_next(&tree, &last->bstn); n && (i < 4); i++, n = bst_conc_next(&tree, n)) {
+                        thing = check_node(n);
+                        TEST(thing->a > last->a);
+                        last = thing;
+                }
+                for (i=0, n = bst_conc_prev(&tree, &last->bstn); n && (i < 4); i++, n = bst_conc_prev(&tree, n)) {
+                        thing = check_node(n);
+                        TEST(thing->a < last->a);
+                        last = thing;
+                }
+
+                epoch_exit(&reader);
+                lookups++;
+        }
+
+        epoch_reader_unregister(&reader);
+
+        return (void *)lookups;
+}
+
+int main(void)
+{
+        struct epoch_reader writer;
+        pthread_t readers[NUM_READERS];
+        struct thing *thing, *last;
+        struct bst_node *n;
+        unsigned long total_lookups = 0;
+        unsigned i, count;
+        void *lookups;
+
+        epoch_init(&epoch);
+        bst_conc_init(&tree, &thing_int_bst_ops);
+        dlist_init(&free_things);
+
+        printf("Adding %u stable and %u churning items to concurrent bst...\n", NUM_STABLE, NUM_CHURN);
+        for (i=0; i<NUM_STABLE; i++) {
+                stable_things[i].a = i * 2;
+                TEST(bst_conc_insert(&tree, &stable_things[i].bstn) == 0);
+        }
+        for (i=0; i<NUM_CHURN; i++) {
+                churn_things[i].a = i * 2 + 1;
+                TEST(bst_conc_insert(&tree, &churn_things[i].bstn) == 0);
+        }
+
+        printf("Checking bst_conc_next() and bst_conc_prev() walk every item in order...\n");
+        for (i=0, n = bst_conc_next(&tree, NULL); n; i++, n = bst_conc_next(&tree, n))
+                TEST(BST_ITEM(n, struct thing, bstn)->a == i);
+        TEST(i == NUM_STABLE + NUM_CHURN);
+        for (n = bst_conc_prev(&tree, NULL); n; n = bst_conc_prev(&tree, n))
+                TEST(BST_ITEM(n, struct thing, bstn)->a == --i);
+        TEST(i == 0);
+
+        printf("Running %u readers against a writer doing %u deletes and inserts...\n", NUM_READERS, NUM_WRITES);
+        epoch_reader_register(&epoch, &writer);
+        for (i=0; i<NUM_READERS; i++)
+                TEST(pthread_create(&readers[i], NULL, reader_thread, (void *)(unsigned long)(i + 1)) == 0);
+
+        for (i=0; i<NUM_WRITES; i++) {
+                thing = &churn_things[random() % NUM_CHURN];
+
+                if (thing->bstn.level) {
+                        TEST(bst_conc_delete(&tree, &thing->bstn) == 0);
+                        epoch_retire(&writer, &thing->ed, thing_reclaim);
+                }
+
+                /* Reuse the thing that has been free the longest, under a new key. */
+                thing = DLIST_ITEM(dlist_pop_front(&free_things), struct thing, free_link);
+                if (thing) {
+                        thing->reclaimed = 0;
+                        do {
+                                thing->a = (random() % KEY_RANGE) | 1;
+                        } while (bst_conc_insert(&tree, &thing->bstn) != 0);
+                }
+        }
+
+        __atomic_store_n(&writer_done, 1, __ATOMIC_RELEASE);
+        for (i=0; i<NUM_READERS; i++) {
+                TEST(pthread_join(readers[i], &lookups) == 0);
+                total_lookups += (unsigned long)lookups;
+        }
+        printf("  (Readers did %lu rounds of lookups)\n", total_lookups);
+
+        printf("Checking tree is still ordered and reclaiming everything...\n");
+        epoch_synchronize(&writer);
+        count = 0;
+        last = NULL;
+        for (n = bst_conc_next(&tree, NULL); n; n = bst_conc_next(&tree, n)) {
+                thing = BST_ITEM(n, struct thing, bstn);
+                TEST(!last || (thing->a > last->a));
+                if ((thing->a & 1) == 0)
+                        count++;
+                last = thing;
+        }
+        TEST(count == NUM_STABLE);
+        for (thing = stable_things; thing < &stable_things[NUM_STABLE]; thing++)
+                TEST(bst_conc_delete(&tree, &thing->bstn) == 0);
+        for (thing = churn_things; thing < &churn_things[NUM_CHURN]; thing++)
+                if (thing->bstn.level)
+                        TEST(bst_conc_delete(&tree, &thing->bstn) == 0);
+        TEST(tree.bst.root == bst_nil);
+        epoch_reader_unregister(&writer);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
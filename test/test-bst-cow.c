@@ -0,0 +1,246 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-bst-cow.c - Unit tests for persistent bst's. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mec-lib/bst-cow.h"
+#include "mec-lib/util.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+struct thing {
+        int a;
+};
+
+#define NUM_THINGS      10000
+#define NUM_SNAPSHOTS   10
+
+struct thing thing_array[NUM_THINGS];
+long live_nodes;
+long allocs_left = -1;
+
+void *thing_get_int_key(void *item)
+{
+        return &((struct thing *)item)->a;
+}
+
+int compare_ints(void *key_a, void *key_b)
+{
+        int *int_a = (int *)key_a;
+        int *int_b = (int *)key_b;
+
+        return *int_a - *int_b;
+}
+
+/* Count live nodes so the test can check that everything gets freed, and fail allocations once 'allocs_left' runs
+   out. */
+struct bst_cow_node *alloc_node(void)
+{
+        if (allocs_left == 0)
+                return NULL;
+        if (allocs_left > 0)
+                allocs_left--;
+
+        live_nodes++;
+        return malloc(sizeof(struct bst_cow_node));
+}
+
+void free_node(struct bst_cow_node *n)
+{
+        live_nodes--;
+        free(n);
+}
+
+struct bst_cow_ops thing_ops = {
+        .get_key = thing_get_int_key,
+        .compare = compare_ints,
+        .alloc_node = alloc_node,
+        .free_node = free_node,
+};
+
+/* Check the AA tree invariants below 'n', returning the number of nodes. */
+unsigned check_node(struct bst_cow_node *n)
+{
+        if (n == NULL)
+                return 0;
+
+        TEST(n->refs > 0);
+        if (n->left == NULL && n->right == NULL)
+                TEST(n->level == 1);
+        if (n->left) {
+                TEST(n->left->level == n->level - 1);
+                TEST(*(int *)thing_get_int_key(n->left->item) < *(int *)thing_get_int_key(n->item));
+        } else {
+                TEST(n->level == 1);
+        }
+        if (n->right) {
+                TEST(n->right->level == n->level || n->right->level == n->level - 1);
+                TEST(!n->right->right || n->right->right->level < n->level);
+                TEST(*(int *)thing_get_int_key(n->right->item) > *(int *)thing_get_int_key(n->item));
+        } else {
+                TEST(n->level == 1);
+        }
+
+        return 1 + check_node(n->left) + check_node(n->right);
+}
+
+/* Check that a version holds exactly the things with 'present' set, in order. */
+void check_contents(struct bst_cow *t, const char *present)
+{
+        struct thing *thingp, *last = NULL;
+        unsigned i, count = 0;
+
+        for (i=0; i<NUM_THINGS; i++) {
+                if (present[i]) {
+                        count++;
+                        TEST(bst_cow_find(t, &thing_array[i].a) == &thing_array[i]);
+                } else {
+                        TEST(bst_cow_find(t, &thing_array[i].a) == NULL);
+                }
+        }
+
+        TEST(check_node(t->root) == count);
+
+        for (i=0, thingp = bst_cow_next(t, NULL); thingp; i++, thingp = bst_cow_next(t, thingp)) {
+                TEST(present[thingp - thing_array]);
+                if (last) {
+                        TEST(thingp->a > last->a);
+                        TEST(bst_cow_prev(t, thingp) == last);
+                }
+                last = thingp;
+        }
+        TEST(i == count);
+        TEST(bst_cow_prev(t, NULL) == last);
+}
+
+int main(void)
+{
+        struct bst_cow tree, snaps[NUM_SNAPSHOTS];
+        static char present[NUM_SNAPSHOTS + 1][NUM_THINGS];
+        struct thing *thingp, extra;
+        long before;
+        unsigned i, s;
+        int key;
+
+        /* Things have the even keys, so odd keys can be used to test gte/lte. */
+        for (i=0; i<NUM_THINGS; i++)
+                thing_array[i].a = i * 2;
+
+        bst_cow_init(&tree, &thing_ops);
+
+        printf("Adding %u items in random order, taking %u snapshots along the way...\n", NUM_THINGS, NUM_SNAPSHOTS);
+        for (i=0; i<NUM_THINGS * 2; i++) {
+                unsigned j = random() % NUM_THINGS;
+
+                if (present[NUM_SNAPSHOTS][j]) {
+                        TEST(bst_cow_insert(&tree, &thing_array[j]) != 0);
+                        TEST(bst_cow_delete(&tree, &thing_array[j].a) == 0);
+                } else {
+                        TEST(bst_cow_insert(&tree, &thing_array[j]) == 0);
+                }
+                present[NUM_SNAPSHOTS][j] = !present[NUM_SNAPSHOTS][j];
+
+                if ((i % (NUM_THINGS * 2 / NUM_SNAPSHOTS)) == 0) {
+                        s = i / (NUM_THINGS * 2 / NUM_SNAPSHOTS);
+                        bst_cow_snapshot(&tree, &snaps[s]);
+                        memcpy(present[s], present[NUM_SNAPSHOTS], NUM_THINGS);
+                }
+        }
+
+        printf("Checking the tree and every snapshot...\n");
+        check_contents(&tree, present[NUM_SNAPSHOTS]);
+        for (s=0; s<NUM_SNAPSHOTS; s++)
+                check_contents(&snaps[s], present[s]);
+
+        printf("Checking that a change to a shared tree only copies a path...\n");
+        bst_cow_destroy(&snaps[0]);
+        bst_cow_snapshot(&tree, &snaps[0]);
+        memcpy(present[0], present[NUM_SNAPSHOTS], NUM_THINGS);
+        before = live_nodes;
+        extra.a = -1;
+        TEST(bst_cow_insert(&tree, &extra) == 0);
+        TEST(live_nodes - before < 200);
+        TEST(bst_cow_find(&snaps[0], &extra.a) == NULL);
+        TEST(bst_cow_find(&tree, &extra.a) == &extra);
+        TEST(bst_cow_delete(&tree, &extra.a) == 0);
+        TEST(bst_cow_delete(&tree, &extra.a) != 0);
+        check_contents(&snaps[0], present[0]);
+
+        printf("Checking that a failed allocation leaves the tree alone...\n");
+        bst_cow_destroy(&tree);
+        bst_cow_snapshot(&snaps[0], &tree);
+        allocs_left = 0;
+        TEST(bst_cow_insert(&tree, &extra) != 0);
+        for (i=0; i<NUM_THINGS; i++)
+                if (present[0][i])
+                        break;
+        TEST(bst_cow_delete(&tree, &thing_array[i].a) != 0);
+        allocs_left = -1;
+        check_contents(&tree, present[0]);
+
+        printf("Checking bst_cow_find_smallest_gte() and bst_cow_find_largest_lte()...\n");
+        for (key = -1; key <= NUM_THINGS * 2; key++) {
+                thingp = bst_cow_find_smallest_gte(&tree, &key);
+                for (i = (key + 1) / 2; i < NUM_THINGS && !present[0][i]; i++)
+                        ;
+                TEST(thingp == ((i < NUM_THINGS) ? &thing_array[i] : NULL));
+
+                thingp = bst_cow_find_largest_lte(&tree, &key);
+                for (i = MEC_MIN(key, NUM_THINGS * 2 - 1) / 2 + 1; i > 0 && !present[0][i - 1]; i--)
+                        ;
+                TEST(thingp == ((key >= 0 && i > 0) ? &thing_array[i - 1] : NULL));
+        }
+
+        printf("Removing everything from the tree while the snapshots stay intact...\n");
+        for (i=0; i<NUM_THINGS; i++) {
+                TEST(bst_cow_delete(&tree, &thing_array[i].a) == (present[0][i] ? 0 : 1));
+                present[NUM_SNAPSHOTS][i] = 0;
+        }
+        TEST(tree.root == NULL);
+        for (s=0; s<NUM_SNAPSHOTS; s++)
+                check_contents(&snaps[s], present[s]);
+
+        printf("Destroying everything...\n");
+        bst_cow_destroy(&tree);
+        for (s=0; s<NUM_SNAPSHOTS; s++)
+                bst_cow_destroy(&snaps[s]);
+        TEST(live_nodes == 0);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
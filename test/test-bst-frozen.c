@@ -0,0 +1,161 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-bst-frozen.c - Unit tests for frozen bst's. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mec-lib/bst-frozen.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+struct thing {
+        int a;
+        struct bst_node bstn;
+};
+
+void *thing_get_int_key(struct bst_node *n)
+{
+        struct thing *thing;
+
+        thing = BST_ITEM(n, struct thing, bstn);
+
+        return &thing->a;
+}
+
+int compare_ints(void *key_a, void *key_b)
+{
+        int *int_a = (int *)key_a;
+        int *int_b = (int *)key_b;
+
+        return (*int_a > *int_b) - (*int_a < *int_b);
+}
+
+struct bst_ops thing_int_bst_ops = {
+        .get_key = thing_get_int_key,
+        .compare = compare_ints,
+};
+
+/* Check every lookup on the frozen tree against the live tree it was built from. */
+void check_frozen(struct bst_frozen *f, struct bst *bst, struct thing *thing_array, unsigned num_things)
+{
+        unsigned i;
+        int key;
+
+        for (i=0; i<num_things; i++) {
+                key = thing_array[i].a;
+                TEST(bst_frozen_find(f, &key) == bst_find(bst, &key));
+                key++;
+                TEST(bst_frozen_find(f, &key) == bst_find(bst, &key));
+        }
+
+        for (i=0; i<num_things; i++) {
+                key = (int)(random() % (num_things * 8)) - 8;
+
+                TEST(bst_frozen_find_smallest_gte(f, &key) == bst_find_smallest_gte(bst, &key));
+                TEST(bst_frozen_find_largest_lte(f, &key) == bst_find_largest_lte(bst, &key));
+        }
+}
+
+int main(void)
+{
+        struct bst tree;
+        struct bst_frozen frozen;
+        struct thing *thing_array;
+        struct thing extra;
+        void *mem;
+        size_t mem_size;
+        unsigned num_things = 10000;
+        unsigned i, count;
+        int key;
+
+        thing_array = malloc(sizeof(struct thing) * num_things);
+        TEST(thing_array);
+
+        bst_init(&tree, &thing_int_bst_ops);
+
+        printf("Checking frozen empty tree...\n");
+        TEST(bst_freeze(&frozen, &tree, NULL, 0) == 0);
+        key = 0;
+        TEST(bst_frozen_find(&frozen, &key) == NULL);
+        TEST(bst_frozen_find_smallest_gte(&frozen, &key) == NULL);
+        TEST(bst_frozen_find_largest_lte(&frozen, &key) == NULL);
+
+        printf("Adding %u random even items to bst...\n", num_things);
+        for (i=0; i<num_things; i++) {
+                do {
+                        thing_array[i].a = (int)(random() % (num_things * 4)) * 2;
+                } while (bst_insert(&tree, &thing_array[i].bstn) != 0);
+        }
+
+        printf("Checking that freezing into too little memory fails...\n");
+        mem_size = BST_FROZEN_MEM_SIZE(num_things);
+        TEST(posix_memalign(&mem, 64, mem_size) == 0);
+        TEST(bst_freeze(&frozen, &tree, mem, mem_size - 1) != 0);
+
+        printf("Checking frozen tree of %u items against live tree...\n", num_things);
+        TEST(bst_freeze(&frozen, &tree, mem, mem_size) == 0);
+        TEST(frozen.count == num_things);
+        check_frozen(&frozen, &tree, thing_array, num_things);
+
+        printf("Deleting every third item and refreezing...\n");
+        for (i=0, count=num_things; i<num_things; i+=3, count--)
+                TEST(bst_delete(&tree, &thing_array[i].bstn) == 0);
+        TEST(bst_refreeze(&frozen, &tree) == 0);
+        TEST(frozen.count == count);
+        check_frozen(&frozen, &tree, thing_array, num_things);
+
+        printf("Reinserting deleted items and refreezing...\n");
+        for (i=0; i<num_things; i+=3)
+                TEST(bst_insert(&tree, &thing_array[i].bstn) == 0);
+        TEST(bst_refreeze(&frozen, &tree) == 0);
+        TEST(frozen.count == num_things);
+        check_frozen(&frozen, &tree, thing_array, num_things);
+
+        printf("Checking that refreezing an outgrown snapshot fails and leaves it intact...\n");
+        extra.a = -1;
+        TEST(bst_insert(&tree, &extra.bstn) == 0);
+        TEST(bst_refreeze(&frozen, &tree) != 0);
+        TEST(frozen.count == num_things);
+        TEST(bst_frozen_find(&frozen, &extra.a) == NULL);
+        TEST(bst_delete(&tree, &extra.bstn) == 0);
+        check_frozen(&frozen, &tree, thing_array, num_things);
+
+        free(mem);
+        free(thing_array);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,220 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-bst-image.c - Unit tests for bst images. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "mec-lib/bst-image.h"
+#include "mec-lib/util.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+struct thing {
+        int a;
+        char name[16];
+        struct bst_node bstn;
+};
+
+/* What a thing looks like in an image.  The name is stored at its real length, so records vary in size. */
+struct thing_record {
+        int a;
+        char name[];
+};
+
+#define NUM_THINGS      10000
+#define PAGE_SIZE       4096
+
+struct bst bst;
+struct thing thing_array[NUM_THINGS];
+
+void *thing_get_int_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct thing, bstn)->a;
+}
+
+int compare_ints(void *key_a, void *key_b)
+{
+        int *int_a = (int *)key_a;
+        int *int_b = (int *)key_b;
+
+        return *int_a - *int_b;
+}
+
+struct bst_ops thing_int_bst_ops = {
+        .get_key = thing_get_int_key,
+        .compare = compare_ints,
+};
+
+size_t thing_record_size(struct bst_node *n)
+{
+        return sizeof(struct thing_record) + strlen(BST_ITEM(n, struct thing, bstn)->name) + 1;
+}
+
+void thing_write_record(struct bst_node *n, void *record)
+{
+        struct thing *thing = BST_ITEM(n, struct thing, bstn);
+        struct thing_record *tr = record;
+
+        tr->a = thing->a;
+        strcpy(tr->name, thing->name);
+}
+
+void *thing_record_get_key(void *record)
+{
+        return &((struct thing_record *)record)->a;
+}
+
+struct bst_image_ops thing_image_ops = {
+        .record_size = thing_record_size,
+        .write_record = thing_write_record,
+        .get_key = thing_record_get_key,
+        .compare = compare_ints,
+};
+
+/* Build an image of 'bst', write it to a temporary file, and map it back in. */
+void *image_to_file_and_back(size_t *size)
+{
+        char path[] = "/tmp/test-bst-image-XXXXXX";
+        void *mem, *map;
+        int fd;
+
+        *size = bst_image_size(&bst, &thing_image_ops, PAGE_SIZE);
+        TEST(posix_memalign(&mem, 8, *size) == 0);
+        TEST(bst_image_build(&bst, &thing_image_ops, mem, *size - 1, PAGE_SIZE) != 0);
+        TEST(bst_image_build(&bst, &thing_image_ops, mem, *size, PAGE_SIZE) == 0);
+
+        fd = mkstemp(path);
+        TEST(fd >= 0);
+        TEST(unlink(path) == 0);
+        TEST(write(fd, mem, *size) == *size);
+        free(mem);
+
+        /* Map it privately and writable, so that the test can corrupt it without touching the file. */
+        map = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        TEST(map != MAP_FAILED);
+        close(fd);
+
+        return map;
+}
+
+int main(void)
+{
+        struct bst_image img;
+        struct thing_record *tr, *last_tr;
+        char *map;
+        size_t size;
+        unsigned i;
+        int key;
+
+        bst_init(&bst, &thing_int_bst_ops);
+
+        printf("Imaging an empty bst...\n");
+        map = image_to_file_and_back(&size);
+        TEST(bst_image_open(&img, &thing_image_ops, map, size) == 0);
+        TEST(bst_image_verify(&img) == 0);
+        TEST(bst_image_count(&img) == 0);
+        key = 0;
+        TEST(bst_image_find(&img, &key) == NULL);
+        TEST(bst_image_next(&img, NULL) == NULL);
+        TEST(bst_image_prev(&img, NULL) == NULL);
+        munmap(map, size);
+
+        /* Things have the even keys, so odd keys can be used to test gte/lte. */
+        for (i=0; i<NUM_THINGS; i++) {
+                thing_array[i].a = i * 2;
+                snprintf(thing_array[i].name, sizeof(thing_array[i].name), "thing %u", i * 1237 % NUM_THINGS);
+                TEST(bst_insert(&bst, &thing_array[i].bstn) == 0);
+        }
+
+        printf("Imaging a bst with %u items...\n", NUM_THINGS);
+        map = image_to_file_and_back(&size);
+        TEST(bst_image_open(&img, &thing_image_ops, map, size - 1) != 0);
+        TEST(bst_image_open(&img, &thing_image_ops, map, size) == 0);
+        TEST(bst_image_verify(&img) == 0);
+        TEST(bst_image_count(&img) == NUM_THINGS);
+        printf("  (%lu bytes in %u pages)\n", (unsigned long)size, img.hdr->num_pages);
+
+        printf("Checking bst_image_find() for every item...\n");
+        for (i=0; i<NUM_THINGS; i++) {
+                tr = bst_image_find(&img, &thing_array[i].a);
+                TEST(tr);
+                TEST(tr->a == thing_array[i].a);
+                TEST(strcmp(tr->name, thing_array[i].name) == 0);
+                key = i * 2 + 1;
+                TEST(bst_image_find(&img, &key) == NULL);
+        }
+
+        printf("Walking image with bst_image_next() and bst_image_prev()...\n");
+        last_tr = NULL;
+        for (i=0, tr = bst_image_next(&img, NULL); tr; i++, tr = bst_image_next(&img, tr)) {
+                TEST(tr->a == thing_array[i].a);
+                if (last_tr)
+                        TEST(bst_image_prev(&img, tr) == last_tr);
+                last_tr = tr;
+        }
+        TEST(i == NUM_THINGS);
+        TEST(bst_image_prev(&img, NULL) == last_tr);
+
+        printf("Checking bst_image_find_smallest_gte() and bst_image_find_largest_lte()...\n");
+        for (key = -1; key <= NUM_THINGS * 2; key++) {
+                tr = bst_image_find_smallest_gte(&img, &key);
+                if (key < NUM_THINGS * 2 - 1)
+                        TEST(tr && tr->a == ((key + 1) & ~1));
+                else
+                        TEST(tr == NULL);
+
+                tr = bst_image_find_largest_lte(&img, &key);
+                if (key < 0)
+                        TEST(tr == NULL);
+                else
+                        TEST(tr && tr->a == (MEC_MIN(key, NUM_THINGS * 2 - 2) & ~1));
+        }
+
+        printf("Checking that corruption is caught...\n");
+        map[size / 2] ^= 0x10;
+        TEST(bst_image_verify(&img) != 0);
+        map[size / 2] ^= 0x10;
+        TEST(bst_image_verify(&img) == 0);
+        ((struct bst_image_header *)map)->magic++;
+        TEST(bst_image_open(&img, &thing_image_ops, map, size) != 0);
+        munmap(map, size);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
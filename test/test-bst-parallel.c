@@ -0,0 +1,195 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-bst-parallel.c - Unit tests for parallel bst scans. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mec-lib/bst-parallel.h"
+#include "mec-lib/util.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+struct thing {
+        int a;
+        unsigned visits;
+        struct bst_node bstn;
+};
+
+#define NUM_THINGS      100000
+
+struct bst bst;
+struct thing thing_array[NUM_THINGS];
+
+void *thing_get_int_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct thing, bstn)->a;
+}
+
+int compare_ints(void *key_a, void *key_b)
+{
+        int *int_a = (int *)key_a;
+        int *int_b = (int *)key_b;
+
+        return *int_a - *int_b;
+}
+
+struct bst_ops thing_int_bst_ops = {
+        .get_key = thing_get_int_key,
+        .compare = compare_ints,
+};
+
+/* The last key each thread saw, to check that every thread sees its items in order. */
+__thread int last_key = -1;
+
+int visit(struct bst_node *n, void *arg)
+{
+        struct thing *thing = BST_ITEM(n, struct thing, bstn);
+
+        TEST(thing->a > last_key);
+        last_key = thing->a;
+        __atomic_add_fetch(&thing->visits, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch((unsigned *)arg, 1, __ATOMIC_RELAXED);
+
+        return 0;
+}
+
+/* Stops the scan at the item with key 'arg'. */
+int stop_at(struct bst_node *n, void *arg)
+{
+        return (BST_ITEM(n, struct thing, bstn)->a == *(int *)arg) ? 42 : 0;
+}
+
+struct sum {
+        long long total;
+        unsigned count;
+        int min, max;
+} __attribute__((aligned(64)));
+
+void sum_map(void *acc, struct bst_node *n)
+{
+        struct sum *sum = acc;
+        int a = BST_ITEM(n, struct thing, bstn)->a;
+
+        sum->total += a;
+        sum->count++;
+        if (a < sum->min)
+                sum->min = a;
+        if (a > sum->max)
+                sum->max = a;
+}
+
+void sum_combine(void *acc, void *other)
+{
+        struct sum *sum = acc, *o = other;
+
+        sum->total += o->total;
+        sum->count += o->count;
+        if (o->min < sum->min)
+                sum->min = o->min;
+        if (o->max > sum->max)
+                sum->max = o->max;
+}
+
+void check_scans(unsigned nthreads, unsigned num_things)
+{
+        struct sum sums[BST_PARALLEL_MAX_THREADS];
+        long long total = 0;
+        unsigned visits = 0;
+        unsigned i, naccs;
+        int key;
+
+        printf("Scanning %u items with %u threads...\n", num_things, nthreads);
+
+        for (i=0; i<num_things; i++)
+                thing_array[i].visits = 0;
+        last_key = -1;
+        TEST(bst_parallel_for_each(&bst, nthreads, visit, &visits) == 0);
+        TEST(visits == num_things);
+        for (i=0; i<num_things; i++) {
+                TEST(thing_array[i].visits == 1);
+                total += thing_array[i].a;
+        }
+
+        /* Only as many accumulators as threads that will really be used; 0 and too many get clamped. */
+        naccs = MEC_MAX(MEC_MIN(nthreads, BST_PARALLEL_MAX_THREADS), 1);
+        for (i=0; i<naccs; i++) {
+                memset(&sums[i], 0, sizeof(sums[i]));
+                sums[i].min = num_things * 3;
+                sums[i].max = -1;
+        }
+        bst_parallel_reduce(&bst, nthreads, sums, sizeof(sums[0]), sum_map, sum_combine);
+        TEST(sums[0].count == num_things);
+        TEST(sums[0].total == total);
+        if (num_things) {
+                TEST(sums[0].min == thing_array[0].a);
+                TEST(sums[0].max == thing_array[num_things - 1].a);
+        }
+
+        if (num_things) {
+                key = thing_array[num_things / 2].a;
+                TEST(bst_parallel_for_each(&bst, nthreads, stop_at, &key) == 42);
+                key = -1;
+                TEST(bst_parallel_for_each(&bst, nthreads, stop_at, &key) == 0);
+        }
+}
+
+int main(void)
+{
+        unsigned nthreads[] = { 0, 1, 2, 3, 4, 8, BST_PARALLEL_MAX_THREADS + 10 };
+        unsigned i, j;
+
+        bst_init(&bst, &thing_int_bst_ops);
+
+        for (i=0; i<sizeof(nthreads)/sizeof(nthreads[0]); i++)
+                check_scans(nthreads[i], 0);
+
+        for (i=0; i<NUM_THINGS; i++) {
+                thing_array[i].a = i * 3;
+                TEST(bst_insert(&bst, &thing_array[i].bstn) == 0);
+
+                /* Small trees, where some of the ranges come out empty. */
+                if (i < 20)
+                        for (j=0; j<sizeof(nthreads)/sizeof(nthreads[0]); j++)
+                                check_scans(nthreads[j], i + 1);
+        }
+
+        for (i=0; i<sizeof(nthreads)/sizeof(nthreads[0]); i++)
+                check_scans(nthreads[i], NUM_THINGS);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,205 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-bst-shard.c - Unit tests for sharded bst's. */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mec-lib/bst-shard.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+struct thing {
+        int a;
+        struct bst_node bstn;
+};
+
+#define NUM_THINGS      40000
+#define NUM_THREADS     4
+#define NUM_SHARDS      8
+#define MAX_SHARD_ITEMS 1000
+
+struct bst_shard_set set;
+struct bst_shard shards[NUM_SHARDS];
+char splitters[BST_SHARD_SPLITTERS_SIZE(NUM_SHARDS, sizeof(int))];
+struct thing thing_array[NUM_THINGS];
+
+void *thing_get_int_key(struct bst_node *n)
+{
+        struct thing *thing;
+
+        thing = BST_ITEM(n, struct thing, bstn);
+
+        return &thing->a;
+}
+
+int compare_ints(void *key_a, void *key_b)
+{
+        int *int_a = (int *)key_a;
+        int *int_b = (int *)key_b;
+
+        return *int_a - *int_b;
+}
+
+struct bst_ops thing_int_bst_ops = {
+        .get_key = thing_get_int_key,
+        .compare = compare_ints,
+};
+
+/* Each thread inserts (and later deletes) every NUM_THREADS'th thing. */
+void *insert_thread(void *arg)
+{
+        unsigned i;
+
+        for (i = (unsigned long)arg; i < NUM_THINGS; i += NUM_THREADS)
+                TEST(bst_shard_insert(&set, &thing_array[i].bstn) == 0);
+
+        return NULL;
+}
+
+void *delete_thread(void *arg)
+{
+        unsigned i;
+
+        for (i = (unsigned long)arg; i < NUM_THINGS; i += NUM_THREADS)
+                TEST(bst_shard_delete(&set, &thing_array[i].bstn) == 0);
+
+        return NULL;
+}
+
+void run_threads(void *(*fn)(void *))
+{
+        pthread_t threads[NUM_THREADS];
+        unsigned long i;
+
+        for (i=0; i<NUM_THREADS; i++)
+                TEST(pthread_create(&threads[i], NULL, fn, (void *)i) == 0);
+        for (i=0; i<NUM_THREADS; i++)
+                TEST(pthread_join(threads[i], NULL) == 0);
+}
+
+/* Check every shard only holds keys in its range, and that its count is right. */
+void assert_shards_valid(void)
+{
+        struct bst_node *n;
+        unsigned i;
+
+        for (i=0; i<set.active_shards; i++) {
+                TEST(bst_count(&shards[i].bst) == shards[i].count);
+
+                for (n = bst_next(&shards[i].bst, NULL); n; n = bst_next(&shards[i].bst, n)) {
+                        if (i > 0)
+                                TEST(compare_ints(thing_get_int_key(n), &splitters[(i - 1) * sizeof(int)]) >= 0);
+                        if (i + 1 < set.active_shards)
+                                TEST(compare_ints(thing_get_int_key(n), &splitters[i * sizeof(int)]) < 0);
+                }
+        }
+}
+
+int main(void)
+{
+        struct bst_node *n;
+        struct thing *thingp, *last_thingp;
+        unsigned i;
+        int key;
+
+        bst_shard_init(&set, &thing_int_bst_ops, shards, NUM_SHARDS, splitters, sizeof(int), MAX_SHARD_ITEMS);
+
+        /* Use a mix of increasing and random keys, so that both splitting and moving items to a neighbour happen. */
+        for (i=0; i<NUM_THINGS; i++)
+                thing_array[i].a = (i < NUM_THINGS / 2) ? (int)(i * 4) : (int)(i * 4 + 1);
+        for (i=NUM_THINGS-1; i>NUM_THINGS/2; i--) {
+                thingp = &thing_array[NUM_THINGS/2 + random() % (i - NUM_THINGS/2 + 1)];
+                key = thingp->a;
+                thingp->a = thing_array[i].a;
+                thing_array[i].a = key;
+        }
+
+        printf("Adding %u items to sharded bst from %u threads...\n", NUM_THINGS, NUM_THREADS);
+        run_threads(insert_thread);
+        printf("  (Using %u shards)\n", set.active_shards);
+        TEST(set.active_shards == NUM_SHARDS);
+        TEST(bst_shard_count(&set) == NUM_THINGS);
+        assert_shards_valid();
+
+        printf("Checking bst_shard_find() for every item...\n");
+        for (i=0; i<NUM_THINGS; i++)
+                TEST(bst_shard_find(&set, &thing_array[i].a) == &thing_array[i].bstn);
+
+        printf("Walking sharded bst with bst_shard_next() and bst_shard_prev()...\n");
+        last_thingp = NULL;
+        for (i=0, n = bst_shard_next(&set, NULL); n; i++, n = bst_shard_next(&set, n)) {
+                thingp = BST_ITEM(n, struct thing, bstn);
+                if (last_thingp) {
+                        TEST(thingp->a > last_thingp->a);
+                        TEST(bst_shard_prev(&set, n) == &last_thingp->bstn);
+                }
+                last_thingp = thingp;
+        }
+        TEST(i == NUM_THINGS);
+        TEST(bst_shard_prev(&set, NULL) == &last_thingp->bstn);
+
+        printf("Checking bst_shard_find_smallest_gte() and bst_shard_find_largest_lte()...\n");
+        for (i=0; i<NUM_THINGS; i++) {
+                key = (int)(random() % (NUM_THINGS * 4)) + 2;
+
+                n = bst_shard_find_smallest_gte(&set, &key);
+                if (n)
+                        TEST(*(int *)thing_get_int_key(n) >= key);
+                n = n ? bst_shard_prev(&set, n) : bst_shard_prev(&set, NULL);
+                TEST(*(int *)thing_get_int_key(n) < key);
+
+                n = bst_shard_find_largest_lte(&set, &key);
+                if (n)
+                        TEST(*(int *)thing_get_int_key(n) <= key);
+                n = n ? bst_shard_next(&set, n) : bst_shard_next(&set, NULL);
+                TEST(!n || (*(int *)thing_get_int_key(n) > key));
+        }
+
+        printf("Removing all items from %u threads...\n", NUM_THREADS);
+        run_threads(delete_thread);
+        TEST(bst_shard_count(&set) == 0);
+        TEST(bst_shard_next(&set, NULL) == NULL);
+        TEST(bst_shard_prev(&set, NULL) == NULL);
+        key = 0;
+        TEST(bst_shard_find_smallest_gte(&set, &key) == NULL);
+        TEST(bst_shard_find_largest_lte(&set, &key) == NULL);
+
+        bst_shard_destroy(&set);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,179 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-bst-stats.c - Unit tests for bst stats (built with BST_STATS_LATENCY). */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mec-lib/bst.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+struct thing {
+        int a;
+        struct bst_node bstn;
+};
+
+#define NUM_THINGS      4096
+
+struct bst bst;
+struct thing thing_array[NUM_THINGS];
+
+void *thing_get_int_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct thing, bstn)->a;
+}
+
+int num_compares;
+
+int compare_ints(void *key_a, void *key_b)
+{
+        int *int_a = (int *)key_a;
+        int *int_b = (int *)key_b;
+
+        num_compares++;
+
+        return *int_a - *int_b;
+}
+
+struct bst_ops thing_int_bst_ops = {
+        .get_key = thing_get_int_key,
+        .compare = compare_ints,
+};
+
+unsigned long latency_total(struct bst_stats *stats, enum bst_stats_op op)
+{
+        unsigned long total = 0;
+        unsigned i;
+
+        for (i=0; i<BST_STATS_LATENCY_BUCKETS; i++)
+                total += stats->latency[op][i];
+
+        return total;
+}
+
+int main(void)
+{
+        static unsigned order[NUM_THINGS];
+        struct bst_stats_snapshot snap;
+        size_t levels_total;
+        unsigned i;
+        int key;
+
+        bst_init(&bst, &thing_int_bst_ops);
+        bst_stats_reset(&bst);
+
+        printf("Adding %u items in random order...\n", NUM_THINGS);
+        for (i=0; i<NUM_THINGS; i++)
+                thing_array[i].a = i * 2;
+        for (i=0; i<NUM_THINGS; i++) {
+                unsigned j = random() % (i + 1);
+
+                order[i] = order[j];
+                order[j] = i;
+        }
+        for (i=0; i<NUM_THINGS; i++)
+                TEST(bst_insert(&bst, &thing_array[order[i]].bstn) == 0);
+        TEST(bst_insert(&bst, &thing_array[0].bstn) != 0);
+
+        printf("Searching for every item, and every missing key...\n");
+        for (i=0; i<NUM_THINGS; i++) {
+                TEST(bst_find(&bst, &thing_array[i].a) == &thing_array[i].bstn);
+                key = i * 2 + 1;
+                TEST(bst_find(&bst, &key) == NULL);
+                TEST(bst_find_smallest_gte(&bst, &key) != NULL || i == NUM_THINGS - 1);
+                TEST(bst_find_largest_lte(&bst, &key) == &thing_array[i].bstn);
+        }
+
+        printf("Deleting half of the items...\n");
+        for (i=0; i<NUM_THINGS; i+=2)
+                TEST(bst_delete(&bst, &thing_array[i].bstn) == 0);
+
+        bst_stats_snapshot(&bst, &snap);
+        bst_stats_dump(&snap, stdout);
+
+        printf("Checking the counts...\n");
+        TEST(snap.count == NUM_THINGS / 2);
+        TEST(snap.stats.ops[BST_STATS_INSERT] == NUM_THINGS + 1);
+        TEST(snap.stats.ops[BST_STATS_FIND] == NUM_THINGS * 2);
+        TEST(snap.stats.ops[BST_STATS_GTE] == NUM_THINGS);
+        TEST(snap.stats.ops[BST_STATS_LTE] == NUM_THINGS);
+        TEST(snap.stats.ops[BST_STATS_DELETE] == NUM_THINGS / 2);
+
+        /* Every call to compare() should have been counted against some operation. */
+        TEST(snap.stats.comparisons[BST_STATS_INSERT] + snap.stats.comparisons[BST_STATS_FIND] +
+             snap.stats.comparisons[BST_STATS_GTE] + snap.stats.comparisons[BST_STATS_LTE] == num_compares);
+        TEST(snap.stats.comparisons[BST_STATS_DELETE] == 0);
+
+        /* Random inserts need both kinds of rotation, and an AA tree is at most about 2*log2(n) deep. */
+        TEST(snap.stats.skews > 0);
+        TEST(snap.stats.splits > 0);
+        TEST(snap.stats.max_depth[BST_STATS_FIND] <= 2 * 12 + 1);
+        TEST(snap.stats.depth[BST_STATS_FIND] >= snap.stats.ops[BST_STATS_FIND] * 10);
+
+        levels_total = 0;
+        for (i=0; i<BST_STATS_MAX_LEVEL; i++)
+                levels_total += snap.levels[i];
+        TEST(levels_total == snap.count);
+        TEST(snap.levels[0] == 0);
+        TEST(snap.levels[1] >= snap.count / 2);
+
+        for (i=0; i<BST_STATS_NUM_OPS; i++)
+                TEST(latency_total(&snap.stats, i) == snap.stats.ops[i]);
+
+        printf("Checking bst_stats_reset()...\n");
+        bst_stats_reset(&bst);
+        bst_stats_snapshot(&bst, &snap);
+        TEST(snap.count == NUM_THINGS / 2);
+        for (i=0; i<BST_STATS_NUM_OPS; i++)
+                TEST(snap.stats.ops[i] == 0 && latency_total(&snap.stats, i) == 0);
+        TEST(snap.stats.skews == 0);
+
+        printf("Checking a red-black tree has no level counts...\n");
+        bst_init_balanced(&bst, &thing_int_bst_ops, BST_BALANCE_RB);
+        bst_stats_reset(&bst);
+        for (i=0; i<NUM_THINGS; i++)
+                TEST(bst_insert(&bst, &thing_array[order[i]].bstn) == 0);
+        bst_stats_snapshot(&bst, &snap);
+        bst_stats_dump(&snap, stdout);
+        TEST(snap.balance == BST_BALANCE_RB);
+        TEST(snap.count == NUM_THINGS);
+        for (i=0; i<BST_STATS_MAX_LEVEL; i++)
+                TEST(snap.levels[i] == 0);
+        TEST(snap.stats.rotations > 0);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
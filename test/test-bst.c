@@ -60,20 +60,92 @@ void assert_bst_subtree_valid(struct bst *bst, struct bst_node *n)
         }
 }
 
+/* Check a splay subtree - only the ordering and links matter. */
+void assert_splay_subtree_valid(struct bst *bst, struct bst_node *n)
+{
+        void *my_key = bst->ops->get_key(n);
+
+        if (n->left != bst_nil) {
+                TEST (bst->ops->compare(bst->ops->get_key(n->left), my_key) < 0);
+                TEST (n->left->parent == n);
+                assert_splay_subtree_valid(bst, n->left);
+        }
+
+        if (n->right != bst_nil) {
+                TEST (bst->ops->compare(my_key, bst->ops->get_key(n->right)) < 0);
+                TEST (n->right->parent == n);
+                assert_splay_subtree_valid(bst, n->right);
+        }
+}
+
+/* Check a red-black subtree, returning its black height. */
+unsigned assert_rb_subtree_valid(struct bst *bst, struct bst_node *n)
+{
+        void *my_key = bst->ops->get_key(n);
+        unsigned l_height = 0, r_height = 0;
+
+        /* Colours - black is 1 and red is 2, so a node in the tree never has level 0 (bst_nil does, and is black).  A
+           red node must not have a red child. */
+        TEST ((n->level == 1) || (n->level == 2));
+        if (n->level == 2)
+                TEST ((n->left->level != 2) && (n->right->level != 2));
+
+        if (n->left != bst_nil) {
+                void *l_key = bst->ops->get_key(n->left);
+
+                TEST (bst->ops->compare(l_key, my_key) < 0);
+                TEST (n->left->parent == n);
+                l_height = assert_rb_subtree_valid(bst, n->left);
+        }
+
+        if (n->right != bst_nil) {
+                void *r_key = bst->ops->get_key(n->right);
+
+                TEST (bst->ops->compare(my_key, r_key) < 0);
+                TEST (n->right->parent == n);
+                r_height = assert_rb_subtree_valid(bst, n->right);
+        }
+
+        /* Every path down must pass the same number of black nodes. */
+        TEST (l_height == r_height);
+
+        return l_height + (n->level == 1);
+}
+
 void assert_bst_valid(struct bst *bst)
 {
         if (bst->root != bst_nil) {
                 TEST(bst->root->parent == NULL);
 
-                assert_bst_subtree_valid(bst, bst->root);
+                if (bst->balance == BST_BALANCE_RB) {
+                        TEST(bst->root->level == 1);
+                        assert_rb_subtree_valid(bst, bst->root);
+                } else if (bst->balance == BST_BALANCE_SPLAY) {
+                        assert_splay_subtree_valid(bst, bst->root);
+                } else {
+                        assert_bst_subtree_valid(bst, bst->root);
+                }
         }
 }
 
+unsigned node_depth(struct bst_node *n)
+{
+        unsigned depth = 0;
+
+        while ((n = n->parent) != NULL)
+                depth++;
+
+        return depth;
+}
+
 struct thing {
         int a;
         char name[40];
         struct bst_node bstn;
         struct bst_node name_bstn;
+        struct bst_prefix_node prefix_bstn;
+        struct bst_node rb_bstn;
+        struct bst_node splay_bstn;
 };
 
 void *thing_get_int_key(struct bst_node *n)
@@ -98,6 +170,26 @@ struct bst_ops thing_int_bst_ops = {
         .compare = compare_ints,
 };
 
+void *thing_get_rb_int_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct thing, rb_bstn)->a;
+}
+
+struct bst_ops thing_rb_int_bst_ops = {
+        .get_key = thing_get_rb_int_key,
+        .compare = compare_ints,
+};
+
+void *thing_get_splay_int_key(struct bst_node *n)
+{
+        return &BST_ITEM(n, struct thing, splay_bstn)->a;
+}
+
+struct bst_ops thing_splay_int_bst_ops = {
+        .get_key = thing_get_splay_int_key,
+        .compare = compare_ints,
+};
+
 void *thing_get_string_key(struct bst_node *n)
 {
         struct thing *thing = BST_ITEM(n, struct thing, name_bstn);
@@ -115,6 +207,19 @@ struct bst_ops thing_string_bst_ops = {
         .compare = compare_strings,
 };
 
+void *thing_get_prefix_string_key(struct bst_node *n)
+{
+        struct thing *thing = BST_ITEM(BST_PREFIX_NODE(n), struct thing, prefix_bstn);
+
+        return &thing->name;
+}
+
+struct bst_ops thing_prefix_string_bst_ops = {
+        .get_key = thing_get_prefix_string_key,
+        .compare = compare_strings,
+        .get_prefix = bst_string_prefix,
+};
+
 struct bst_node *bruteforce_find_smallest_gte(struct bst *bst, void *key)
 {
         struct bst_node *n;
@@ -139,9 +244,82 @@ struct bst_node *bruteforce_find_largest_lte(struct bst *bst, void *key)
         return n;
 }
 
+/* The range being deleted by bst_delete_range(), for range_cb() to check. */
+int range_lo, range_hi;
+unsigned range_count;
+
+void range_cb(struct bst_node *n)
+{
+        struct thing *thingp = BST_ITEM(n, struct thing, bstn);
+
+        TEST(n->parent == NULL && n->left == NULL && n->right == NULL);
+        TEST(thingp->a >= range_lo && thingp->a <= range_hi);
+        range_count++;
+}
+
+void drain_cb(struct bst_node *n)
+{
+        TEST(n->parent == NULL && n->left == NULL && n->right == NULL);
+        range_count++;
+}
+
+/* Check bst_delete_range() and bst_drain() on a tree with the given balancing. */
+void test_delete_range(enum bst_balance balance, struct thing *thing_array, unsigned num_things)
+{
+        struct bst tree;
+        struct bst_node *n;
+        unsigned i, expected, remaining = num_things;
+        int width;
+
+        bst_init_balanced(&tree, &thing_int_bst_ops, balance);
+        for (i=0; i<num_things; i++)
+                TEST(bst_insert(&tree, &thing_array[i].bstn) == 0);
+
+        for (i=0; i<100; i++) {
+                /* Mostly ranges of a few items, but some big ones and some empty ones (lo > hi) too. */
+                width = random() % ((i % 10) ? (RAND_MAX / num_things * 20) : (RAND_MAX / 4));
+                range_lo = (int)random();
+                range_hi = (range_lo > RAND_MAX - width) ? RAND_MAX : range_lo + width;
+                if ((i % 25) == 0)
+                        range_hi = range_lo - 1;
+
+                expected = 0;
+                for (n = bst_find_smallest_gte(&tree, &range_lo);
+                     n && BST_ITEM(n, struct thing, bstn)->a <= range_hi;
+                     n = bst_next(&tree, n))
+                        expected++;
+
+                range_count = 0;
+                TEST(bst_delete_range(&tree, &range_lo, &range_hi, range_cb) == expected);
+                TEST(range_count == expected);
+                assert_bst_valid(&tree);
+                remaining -= expected;
+
+                n = bst_find_smallest_gte(&tree, &range_lo);
+                TEST(n == NULL || BST_ITEM(n, struct thing, bstn)->a > range_hi);
+        }
+        TEST(bst_count(&tree) == remaining);
+        printf("  (Removed %u items in ranges, %u left to drain)\n", num_things - remaining, remaining);
+
+        range_count = 0;
+        TEST(bst_drain(&tree, drain_cb) == remaining);
+        TEST(range_count == remaining);
+        TEST(tree.root == bst_nil);
+        TEST(bst_drain(&tree, NULL) == 0);
+
+        /* Every item can go in again, now that they have all been reset. */
+        for (i=0; i<num_things; i++)
+                TEST(bst_insert(&tree, &thing_array[i].bstn) == 0);
+        assert_bst_valid(&tree);
+        range_lo = 0;
+        range_hi = RAND_MAX;
+        TEST(bst_delete_range(&tree, &range_lo, &range_hi, NULL) == num_things);
+        TEST(tree.root == bst_nil);
+}
+
 int main(void)
 {
-        struct bst tree, name_tree;
+        struct bst tree, name_tree, prefix_tree, rb_tree, splay_tree;
         struct thing *thing_array;
         struct thing *thingp, *last_thingp;
         struct bst_node *n, *next_n;
@@ -154,6 +332,9 @@ int main(void)
 
         bst_init(&tree, &thing_int_bst_ops);
         bst_init(&name_tree, &thing_string_bst_ops);
+        bst_init(&prefix_tree, &thing_prefix_string_bst_ops);
+        bst_init_balanced(&rb_tree, &thing_rb_int_bst_ops, BST_BALANCE_RB);
+        bst_init_balanced(&splay_tree, &thing_splay_int_bst_ops, BST_BALANCE_SPLAY);
 
         printf("Adding %u random items to bst...\n", num_things);
         for (i = num_things; i>0; i--) {
@@ -167,13 +348,33 @@ int main(void)
 
                 TEST(bst_insert(&name_tree, &thingp->name_bstn) == 0);
                 assert_bst_valid(&name_tree);
+
+                TEST(bst_insert(&prefix_tree, &thingp->prefix_bstn.node) == 0);
+                TEST(thingp->prefix_bstn.prefix == bst_string_prefix(thingp->name));
+                assert_bst_valid(&prefix_tree);
+
+                TEST(bst_insert(&rb_tree, &thingp->rb_bstn) == 0);
+                assert_bst_valid(&rb_tree);
+
+                TEST(bst_insert(&splay_tree, &thingp->splay_bstn) == 0);
+                TEST(splay_tree.root == &thingp->splay_bstn);
+        }
+        assert_bst_valid(&splay_tree);
+
+        printf("Checking that bst_find() brings items near the root of a splay tree...\n");
+        for (i=0; i<num_things; i++) {
+                TEST(bst_find(&splay_tree, &thing_array[i].a) == &thing_array[i].splay_bstn);
+                TEST(node_depth(&thing_array[i].splay_bstn) < 16);
         }
 
         printf("Checking bst_find() for every item in tree...\n");
         for (i=0; i<num_things; i++) {
                 TEST(bst_find(&tree, &thing_array[i].a) == &thing_array[i].bstn);
                 TEST(bst_find(&name_tree, &thing_array[i].name) == &thing_array[i].name_bstn);
+                TEST(bst_find(&prefix_tree, &thing_array[i].name) == &thing_array[i].prefix_bstn.node);
+                TEST(bst_find(&rb_tree, &thing_array[i].a) == &thing_array[i].rb_bstn);
         }
+        assert_bst_valid(&splay_tree);
 
         printf("Checking bst_find_smallest_gte() and bst_find_largest_lte() with %u random items\n", num_things/10);
         for (i=0; i<num_things/10; i++) {
@@ -183,10 +384,21 @@ int main(void)
                 TEST(bst_find_smallest_gte(&tree, &key) == bruteforce_find_smallest_gte(&tree, &key));
                 TEST(bst_find_largest_lte(&tree, &key) == bruteforce_find_largest_lte(&tree, &key));
 
+                TEST(bst_find_smallest_gte(&rb_tree, &key) == bruteforce_find_smallest_gte(&rb_tree, &key));
+                TEST(bst_find_largest_lte(&rb_tree, &key) == bruteforce_find_largest_lte(&rb_tree, &key));
+
+                TEST(bst_find_smallest_gte(&splay_tree, &key) == bruteforce_find_smallest_gte(&splay_tree, &key));
+                TEST(bst_find_largest_lte(&splay_tree, &key) == bruteforce_find_largest_lte(&splay_tree, &key));
+
                 sprintf(name_key, "thing %d", key % num_things);
 
                 TEST(bst_find_smallest_gte(&name_tree, &name_key) == bruteforce_find_smallest_gte(&name_tree, &name_key));
                 TEST(bst_find_largest_lte(&name_tree, &name_key) == bruteforce_find_largest_lte(&name_tree, &name_key));
+
+                TEST(bst_find_smallest_gte(&prefix_tree, &name_key) ==
+                     bruteforce_find_smallest_gte(&prefix_tree, &name_key));
+                TEST(bst_find_largest_lte(&prefix_tree, &name_key) ==
+                     bruteforce_find_largest_lte(&prefix_tree, &name_key));
         }
 
         printf("Walking bst with bst_next (and deleting every other item)...\n");
@@ -251,6 +463,104 @@ int main(void)
         TEST(i == (num_things / 2));
 
 
+        printf("Walking prefix bst with bst_next (and deleting every other item)...\n");
+        last_thingp = NULL;
+        for (i=0, n = bst_next(&prefix_tree, NULL), next_n = bst_next(&prefix_tree, n);
+             n;
+             i++, n = next_n, next_n = bst_next(&prefix_tree, n)) {
+                thingp = BST_ITEM(BST_PREFIX_NODE(n), struct thing, prefix_bstn);
+
+                if (last_thingp)
+                        TEST(strcmp(thingp->name, last_thingp->name) > 0);
+                last_thingp = thingp;
+
+                if ((i % 2) == 0) {
+                        TEST(bst_delete(&prefix_tree, n) == 0);
+                        assert_bst_valid(&prefix_tree);
+                }
+        }
+
+        printf("Removing remaining items from prefix tree with bst_delete...\n");
+        i = 0;
+        while (prefix_tree.root != bst_nil) {
+                i++;
+
+                TEST(bst_delete(&prefix_tree, prefix_tree.root) == 0);
+
+                assert_bst_valid(&prefix_tree);
+        }
+        printf("  (Popped %u items)\n", i);
+        TEST(i == (num_things / 2));
+
+
+        printf("Walking red-black bst with bst_prev (and deleting every other item)...\n");
+        last_thingp = NULL;
+        for (i=0, n = bst_prev(&rb_tree, NULL), next_n = bst_prev(&rb_tree, n);
+             n;
+             i++, n = next_n, next_n = bst_prev(&rb_tree, n)) {
+                thingp = BST_ITEM(n, struct thing, rb_bstn);
+
+                if (last_thingp)
+                        TEST(thingp->a < last_thingp->a);
+                last_thingp = thingp;
+
+                if ((i % 2) == 0) {
+                        TEST(bst_delete(&rb_tree, n) == 0);
+                        assert_bst_valid(&rb_tree);
+                }
+        }
+
+        printf("Removing remaining items from red-black tree with bst_delete...\n");
+        i = 0;
+        while (rb_tree.root != bst_nil) {
+                i++;
+
+                TEST(bst_delete(&rb_tree, rb_tree.root) == 0);
+
+                assert_bst_valid(&rb_tree);
+        }
+        printf("  (Popped %u items)\n", i);
+        TEST(i == (num_things / 2));
+
+
+        printf("Walking splay bst with bst_next (and deleting every other item)...\n");
+        assert_bst_valid(&splay_tree);
+        last_thingp = NULL;
+        for (i=0, n = bst_next(&splay_tree, NULL), next_n = bst_next(&splay_tree, n);
+             n;
+             i++, n = next_n, next_n = bst_next(&splay_tree, n)) {
+                thingp = BST_ITEM(n, struct thing, splay_bstn);
+
+                if (last_thingp)
+                        TEST(thingp->a > last_thingp->a);
+                last_thingp = thingp;
+
+                if ((i % 2) == 0) {
+                        TEST(bst_delete(&splay_tree, n) == 0);
+                        TEST(bst_find(&splay_tree, &thingp->a) == NULL);
+                        assert_bst_valid(&splay_tree);
+                }
+        }
+
+        printf("Removing remaining items from splay tree with bst_delete...\n");
+        i = 0;
+        while (splay_tree.root != bst_nil) {
+                i++;
+
+                TEST(bst_delete(&splay_tree, splay_tree.root) == 0);
+
+                assert_bst_valid(&splay_tree);
+        }
+        printf("  (Popped %u items)\n", i);
+        TEST(i == (num_things / 2));
+
+
+        printf("Checking bst_delete_range() and bst_drain()...\n");
+        test_delete_range(BST_BALANCE_AA, thing_array, num_things);
+        test_delete_range(BST_BALANCE_RB, thing_array, num_things);
+        test_delete_range(BST_BALANCE_SPLAY, thing_array, num_things);
+
+
         return 0;
 }
 
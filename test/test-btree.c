@@ -0,0 +1,278 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-btree.c - Unit tests for B+trees. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mec-lib/btree.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+struct thing {
+        uint64_t key;
+        int in_tree;
+};
+
+#define NUM_THINGS      100000
+
+struct btree bt;
+struct thing thing_array[NUM_THINGS];
+
+uint64_t thing_get_key(void *item)
+{
+        return ((struct thing *)item)->key;
+}
+
+/* Allocations can be made to fail, to check that a failed insert leaves the tree alone. */
+unsigned nodes_allocated;
+int fail_allocs;
+
+struct btree_node *alloc_node(void)
+{
+        void *n;
+
+        if (fail_allocs)
+                return NULL;
+        TEST(posix_memalign(&n, 64, sizeof(struct btree_node)) == 0);
+        nodes_allocated++;
+
+        return n;
+}
+
+void free_node(struct btree_node *n)
+{
+        TEST(nodes_allocated > 0);
+        nodes_allocated--;
+        free(n);
+}
+
+struct btree_ops thing_btree_ops = {
+        .get_key = thing_get_key,
+        .alloc_node = alloc_node,
+        .free_node = free_node,
+};
+
+/* Check a subtree, whose keys must all be greater than 'lo' (unless it is the leftmost) and no greater than 'hi'.
+   Leaves are checked to be linked up in order, through 'last_leaf'.  Returns the number of items. */
+size_t assert_subtree_valid(struct btree_node *n, unsigned height, int is_root, int leftmost, uint64_t lo, uint64_t hi,
+                            struct btree_node **last_leaf)
+{
+        size_t items = 0;
+        unsigned i;
+
+        TEST(n->count <= BTREE_NODE_KEYS);
+        if (!is_root)
+                TEST(n->count >= BTREE_NODE_KEYS / 2);
+        for (i = 0; i < n->count; i++) {
+                TEST(leftmost || (n->keys[i] > lo));
+                TEST(n->keys[i] <= hi);
+                if (i > 0)
+                        TEST(n->keys[i] > n->keys[i - 1]);
+        }
+        for (; i < BTREE_NODE_KEYS; i++)
+                TEST(n->keys[i] == UINT64_MAX);
+
+        if (height == 1) {
+                TEST(n->prev == *last_leaf);
+                if (*last_leaf)
+                        TEST((*last_leaf)->next == n);
+                *last_leaf = n;
+                for (i = 0; i < n->count; i++) {
+                        TEST(thing_get_key(n->items[i]) == n->keys[i]);
+                        TEST(((struct thing *)n->items[i])->in_tree);
+                }
+                return n->count;
+        }
+
+        TEST(is_root ? (n->count >= 1) : 1);
+        for (i = 0; i <= n->count; i++)
+                items += assert_subtree_valid(n->children[i], height - 1, 0, leftmost && (i == 0),
+                                              (i == 0) ? lo : n->keys[i - 1], (i < n->count) ? n->keys[i] : hi,
+                                              last_leaf);
+
+        return items;
+}
+
+void assert_btree_valid(struct btree *bt, size_t expected)
+{
+        struct btree_node *last_leaf = NULL;
+
+        if (bt->root == NULL) {
+                TEST(bt->height == 0);
+                TEST(expected == 0);
+                return;
+        }
+
+        TEST(assert_subtree_valid(bt->root, bt->height, 1, 1, 0, UINT64_MAX, &last_leaf) == expected);
+        TEST(last_leaf->next == NULL);
+}
+
+int main(void)
+{
+        struct btree_iter it;
+        struct thing *thingp, *last_thingp, probe;
+        size_t count = 0;
+        unsigned i, j, allocated;
+        uint64_t key;
+
+        btree_init(&bt, &thing_btree_ops);
+
+        printf("Checking an empty B+tree...\n");
+        assert_btree_valid(&bt, 0);
+        TEST(btree_find(&bt, 0) == NULL);
+        TEST(btree_find_smallest_gte(&bt, 0) == NULL);
+        TEST(btree_find_largest_lte(&bt, UINT64_MAX) == NULL);
+        TEST(btree_next(&bt, NULL) == NULL);
+        TEST(btree_prev(&bt, NULL) == NULL);
+        TEST(btree_delete(&bt, 0) != 0);
+        btree_iter_seek(&bt, &it, 0);
+        TEST(btree_iter_next(&it) == NULL);
+
+        /* Things have keys that are multiples of 4 (spread over the whole range, with the ends included), so that
+           there are missing keys on either side of every one. */
+        for (i=0; i<NUM_THINGS; i++)
+                thing_array[i].key = (i == NUM_THINGS - 1) ? UINT64_MAX & ~3ULL : (uint64_t)i * 4 * 1000003;
+
+        printf("Adding %u items in random order...\n", NUM_THINGS);
+        for (i=0; i<NUM_THINGS; i++) {
+                j = random() % NUM_THINGS;
+                while (thing_array[j].in_tree)
+                        j = (j + 1) % NUM_THINGS;
+
+                /* Every so often, check that a failed allocation leaves the tree as it was. */
+                if ((i % 97) == 0) {
+                        fail_allocs = 1;
+                        allocated = nodes_allocated;
+                        while (btree_insert(&bt, &thing_array[j]) == 0) {
+                                /* It fit without a new node, so take it out and try another. */
+                                TEST(btree_delete(&bt, thing_array[j].key) == 0);
+                                j = (j + 1) % NUM_THINGS;
+                                while (thing_array[j].in_tree)
+                                        j = (j + 1) % NUM_THINGS;
+                                if ((random() % 8) == 0)
+                                        break;
+                        }
+                        fail_allocs = 0;
+                        TEST(nodes_allocated == allocated);
+                        assert_btree_valid(&bt, count);
+                }
+
+                if (!thing_array[j].in_tree && btree_find(&bt, thing_array[j].key) == NULL) {
+                        TEST(btree_insert(&bt, &thing_array[j]) == 0);
+                        thing_array[j].in_tree = 1;
+                        count++;
+                }
+                TEST(btree_insert(&bt, &thing_array[j]) != 0);
+
+                if ((i < 1000) || ((i % 1000) == 0))
+                        assert_btree_valid(&bt, count);
+        }
+        assert_btree_valid(&bt, count);
+        TEST(count == NUM_THINGS);
+        printf("  (height %u, %u nodes)\n", bt.height, nodes_allocated);
+
+        printf("Checking find, gte and lte for every item...\n");
+        for (i=0; i<NUM_THINGS; i++) {
+                key = thing_array[i].key;
+                TEST(btree_find(&bt, key) == &thing_array[i]);
+                TEST(btree_find_smallest_gte(&bt, key) == &thing_array[i]);
+                TEST(btree_find_largest_lte(&bt, key) == &thing_array[i]);
+                TEST(btree_find(&bt, key + 1) == NULL);
+                TEST(btree_find_smallest_gte(&bt, key + 1) == ((i < NUM_THINGS - 1) ? &thing_array[i + 1] : NULL));
+                TEST(btree_find_largest_lte(&bt, key + 1) == &thing_array[i]);
+                if (i > 0) {
+                        TEST(btree_find_smallest_gte(&bt, key - 1) == &thing_array[i]);
+                        TEST(btree_find_largest_lte(&bt, key - 1) == &thing_array[i - 1]);
+                }
+        }
+        TEST(btree_find_largest_lte(&bt, UINT64_MAX) == &thing_array[NUM_THINGS - 1]);
+
+        printf("Walking with btree_next() and btree_prev()...\n");
+        last_thingp = NULL;
+        for (i=0, thingp = btree_next(&bt, NULL); thingp; i++, thingp = btree_next(&bt, thingp)) {
+                TEST(thingp == &thing_array[i]);
+                TEST(btree_prev(&bt, thingp) == last_thingp);
+                last_thingp = thingp;
+        }
+        TEST(i == NUM_THINGS);
+        TEST(btree_prev(&bt, NULL) == last_thingp);
+
+        printf("Walking with an iterator...\n");
+        btree_iter_seek(&bt, &it, 0);
+        for (i=0; (thingp = btree_iter_next(&it)); i++)
+                TEST(thingp == &thing_array[i]);
+        TEST(i == NUM_THINGS);
+        for (i=NUM_THINGS; (thingp = btree_iter_prev(&it)); i--)
+                TEST(thingp == &thing_array[i - 1]);
+        TEST(i == 0);
+        btree_iter_seek(&bt, &it, thing_array[500].key - 1);
+        TEST(btree_iter_next(&it) == &thing_array[500]);
+        TEST(btree_iter_next(&it) == &thing_array[501]);
+        TEST(btree_iter_prev(&it) == &thing_array[501]);
+        TEST(btree_iter_prev(&it) == &thing_array[500]);
+        TEST(btree_iter_prev(&it) == &thing_array[499]);
+
+        printf("Deleting items in random order...\n");
+        for (i=0; i<NUM_THINGS; i++) {
+                j = random() % NUM_THINGS;
+                while (!thing_array[j].in_tree)
+                        j = (j + 1) % NUM_THINGS;
+
+                TEST(btree_delete(&bt, thing_array[j].key) == 0);
+                thing_array[j].in_tree = 0;
+                count--;
+                TEST(btree_delete(&bt, thing_array[j].key) != 0);
+                TEST(btree_find(&bt, thing_array[j].key) == NULL);
+
+                if ((count < 1000) || ((i % 1000) == 0))
+                        assert_btree_valid(&bt, count);
+        }
+        TEST(bt.root == NULL);
+        TEST(nodes_allocated == 0);
+
+        printf("Checking btree_destroy()...\n");
+        for (i=0; i<NUM_THINGS; i+=3) {
+                probe.key = thing_array[i].key;
+                TEST(btree_insert(&bt, &thing_array[i]) == 0);
+        }
+        TEST(nodes_allocated > 0);
+        btree_destroy(&bt);
+        TEST(nodes_allocated == 0);
+        TEST(btree_find(&bt, probe.key) == NULL);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -154,6 +154,36 @@ int main(void)
 
                 TEST(crc == test_cfgs[i].check);
         }
+
+        printf("Checking crc32c() against the generic CRC-32C...\n");
+        struct crc_config crc32c_cfg = { .width = 32, .poly = 0x1edc6f41, .init = 0xffffffff, .refin = 1, .refout = 1,
+                                         .xorout = 0xffffffff, };
+        uint8_t buf[256];
+
+        TEST(crc32c(0, test, strlen(test)) == 0xe3069283);
+
+        /* The examples from RFC 3720 (iSCSI), appendix B.4. */
+        memset(buf, 0, 32);
+        TEST(crc32c(0, buf, 32) == 0x8a9136aa);
+        memset(buf, 0xff, 32);
+        TEST(crc32c(0, buf, 32) == 0x62a8ab43);
+        for (unsigned i=0; i<32; i++)
+                buf[i] = i;
+        TEST(crc32c(0, buf, 32) == 0x46dd794e);
+        for (unsigned i=0; i<32; i++)
+                buf[i] = 31 - i;
+        TEST(crc32c(0, buf, 32) == 0x113fdb5c);
+
+        for (unsigned i=0; i<sizeof(buf); i++)
+                buf[i] = random();
+        for (unsigned start=0; start<8; start++) {
+                for (unsigned len=1; start+len<=sizeof(buf); len++) {
+                        uint32_t crc = crc32c(0, buf + start, len);
+
+                        TEST(crc == crc_calculate(&crc32c_cfg, buf + start, len));
+                        TEST(crc == crc32c(crc32c(0, buf + start, len / 3), buf + start + len / 3, len - len / 3));
+                }
+        }
 }
 
 
@@ -59,7 +59,7 @@ struct thing {
 
 int main(void)
 {
-        struct dlist head;
+        struct dlist head, other;
         struct thing *thing_array;
         struct thing *thingp, *next_thingp;
         struct dlist *dl, *next_dl;
@@ -162,6 +162,33 @@ int main(void)
         TEST(i == (num_things / 2));
 
 
+
+        printf("Splicing lists with dlist_splice_back...\n");
+        dlist_init(&other);
+        dlist_splice_back(&head, &other);
+        TEST(is_dlist_empty(&head) && is_dlist_empty(&other));
+
+        for (i = 0; i<num_things; i++)
+                dlist_insert_back((i < num_things / 3) ? &head : &other, &thing_array[i].dl);
+        dlist_splice_back(&head, &other);
+        TEST(is_dlist_valid(&head));
+        TEST(is_dlist_empty(&other));
+        dlist_splice_back(&head, &other);
+        TEST(is_dlist_valid(&head));
+
+        i = 0;
+        dlist_for_each_item(&head, thingp, struct thing, dl)
+                TEST(thingp == &thing_array[i++]);
+        TEST(i == num_things);
+
+        /* Onto an empty list. */
+        dlist_splice_back(&other, &head);
+        TEST(is_dlist_valid(&other));
+        TEST(is_dlist_empty(&head));
+        TEST(other.next == &thing_array[0].dl && other.prev == &thing_array[num_things - 1].dl);
+
+        free(thing_array);
+
         return 0;
 }
 
@@ -0,0 +1,279 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-hlist.c - Unit tests for hlist's. */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mec-lib/hlist.h"
+#include "mec-lib/epoch.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+/* Check every node's pprev points at whatever points at it, and return the number of nodes. */
+unsigned hlist_check(struct hlist_head *head)
+{
+        struct hlist_node **pprev = &head->first, *n;
+        unsigned count = 0;
+
+        hlist_for_each(head, n) {
+                TEST(n->pprev == pprev);
+                pprev = &n->next;
+                count++;
+        }
+
+        return count;
+}
+
+struct thing {
+        int a;
+        int reclaimed;
+        struct hlist_node hl;
+        struct epoch_deferred ed;
+};
+
+#define NUM_THINGS      1000
+#define NUM_BUCKETS     64
+#define NUM_READERS     4
+#define NUM_MOVES       200000
+
+struct thing thing_array[NUM_THINGS];
+struct hlist_head buckets[NUM_BUCKETS];
+struct epoch epoch_domain;
+struct dlist free_things;
+int writer_done;
+
+void test_basic(void)
+{
+        struct hlist_head head, other;
+        struct thing *thingp, *next_thingp;
+        struct hlist_node *n, *next_n;
+        unsigned i;
+
+        printf("Checking an hlist head is one pointer...\n");
+        TEST(sizeof(struct hlist_head) == sizeof(void *));
+
+        hlist_init(&head);
+        TEST(is_hlist_empty(&head));
+        TEST(hlist_pop_front(&head) == NULL);
+
+        printf("Adding %u items to hlist with hlist_insert_front...\n", NUM_THINGS);
+        for (i = NUM_THINGS; i > 0; i--) {
+                thing_array[i-1].a = i - 1;
+                hlist_clear(&thing_array[i-1].hl);
+                TEST(!is_hlist_linked(&thing_array[i-1].hl));
+                hlist_insert_front(&head, &thing_array[i-1].hl);
+                TEST(is_hlist_linked(&thing_array[i-1].hl));
+        }
+        TEST(hlist_check(&head) == NUM_THINGS);
+
+        printf("Checking items are in order with hlist_for_each_item...\n");
+        i = 0;
+        hlist_for_each_item(&head, thingp, struct thing, hl)
+                TEST(thingp->a == i++);
+        TEST(i == NUM_THINGS);
+
+        printf("Deleting odd items with hlist_for_each_item_safe...\n");
+        hlist_for_each_item_safe(&head, thingp, next_thingp, struct thing, hl) {
+                if (thingp->a & 1) {
+                        hlist_del(&thingp->hl);
+                        TEST(!is_hlist_linked(&thingp->hl));
+                }
+        }
+        TEST(hlist_check(&head) == NUM_THINGS / 2);
+
+        printf("Putting them back with hlist_insert_after and hlist_insert_before...\n");
+        for (i = 1; i < NUM_THINGS; i += 2) {
+                if (i & 2)
+                        hlist_insert_after(&thing_array[i-1].hl, &thing_array[i].hl);
+                else if (i + 1 < NUM_THINGS)
+                        hlist_insert_before(&thing_array[i+1].hl, &thing_array[i].hl);
+                else
+                        hlist_insert_after(&thing_array[i-1].hl, &thing_array[i].hl);
+        }
+        TEST(hlist_check(&head) == NUM_THINGS);
+        i = 0;
+        hlist_for_each_item(&head, thingp, struct thing, hl)
+                TEST(thingp->a == i++);
+
+        /* Inserting before the first item updates the head. */
+        hlist_del(&thing_array[0].hl);
+        hlist_insert_before(&thing_array[1].hl, &thing_array[0].hl);
+        TEST(head.first == &thing_array[0].hl);
+        TEST(hlist_check(&head) == NUM_THINGS);
+
+        printf("Checking hlist_splice_front...\n");
+        hlist_init(&other);
+        hlist_splice_front(&other, &head);
+        TEST(is_hlist_empty(&head));
+        TEST(hlist_check(&other) == NUM_THINGS);
+        for (i = 0; i < NUM_THINGS / 2; i++)
+                TEST(hlist_pop_front(&other) == &thing_array[i].hl);
+        hlist_for_each_safe(&other, n, next_n) {
+                hlist_del(n);
+                hlist_insert_front(&head, n);
+        }
+        TEST(is_hlist_empty(&other));
+        TEST(hlist_check(&head) == NUM_THINGS / 2);
+        hlist_splice_front(&head, &other);
+        TEST(hlist_check(&head) == NUM_THINGS / 2);
+        for (i = 0; i < NUM_THINGS / 2; i++)
+                hlist_insert_front(&other, &thing_array[NUM_THINGS / 2 - 1 - i].hl);
+        hlist_splice_front(&head, &other);
+        TEST(hlist_check(&head) == NUM_THINGS);
+        i = 0;
+        hlist_for_each_item(&head, thingp, struct thing, hl) {
+                if (i < NUM_THINGS / 2)
+                        TEST(thingp->a == i);
+                else
+                        TEST(thingp->a == NUM_THINGS - 1 - (i - NUM_THINGS / 2));
+                i++;
+        }
+
+        while (hlist_pop_front(&head))
+                ;
+        TEST(is_hlist_empty(&head));
+}
+
+/* Called once no reader can see the thing any more; poison it and make it available to the writer again. */
+void thing_reclaim(struct epoch_deferred *d)
+{
+        struct thing *thing = EPOCH_ITEM(d, struct thing, ed);
+
+        __atomic_store_n(&thing->reclaimed, 1, __ATOMIC_RELAXED);
+        dlist_insert_back(&free_things, &thing->ed.link);
+}
+
+void *reader_thread(void *arg)
+{
+        struct epoch_reader reader;
+        unsigned seed = (unsigned)(unsigned long)arg;
+        unsigned long walks = 0;
+        struct thing *thing;
+        unsigned b;
+
+        epoch_reader_register(&epoch_domain, &reader);
+
+        while (!__atomic_load_n(&writer_done, __ATOMIC_ACQUIRE)) {
+                b = rand_r(&seed) % NUM_BUCKETS;
+
+                epoch_enter(&reader);
+                hlist_for_each_item_published(&buckets[b], thing, struct thing, hl)
+                        TEST(__atomic_load_n(&thing->reclaimed, __ATOMIC_RELAXED) == 0);
+                epoch_exit(&reader);
+                walks++;
+        }
+
+        epoch_reader_unregister(&reader);
+
+        return (void *)walks;
+}
+
+void test_published(void)
+{
+        struct epoch_reader writer;
+        pthread_t readers[NUM_READERS];
+        unsigned long total_walks = 0;
+        struct thing *thing;
+        unsigned i, count;
+        void *walks;
+
+        printf("Running %u readers against a writer moving items between %u buckets %u times...\n",
+               NUM_READERS, NUM_BUCKETS, NUM_MOVES);
+        epoch_init(&epoch_domain);
+        epoch_reader_register(&epoch_domain, &writer);
+        dlist_init(&free_things);
+        for (i=0; i<NUM_BUCKETS; i++)
+                hlist_init(&buckets[i]);
+        for (i=0; i<NUM_THINGS; i++) {
+                thing_array[i].a = i;
+                thing_array[i].reclaimed = 0;
+                if (i & 1)
+                        hlist_insert_front_publish(&buckets[i % NUM_BUCKETS], &thing_array[i].hl);
+                else
+                        dlist_insert_back(&free_things, &thing_array[i].ed.link);
+        }
+
+        for (i=0; i<NUM_READERS; i++)
+                TEST(pthread_create(&readers[i], NULL, reader_thread, (void *)(unsigned long)(i + 1)) == 0);
+
+        for (i=0; i<NUM_MOVES; i++) {
+                thing = &thing_array[random() % NUM_THINGS];
+                if (is_hlist_linked(&thing->hl)) {
+                        hlist_del_publish(&thing->hl);
+                        epoch_retire(&writer, &thing->ed, thing_reclaim);
+                }
+
+                /* Reuse the thing that has been free the longest, in a new bucket. */
+                thing = DLIST_ITEM(dlist_pop_front(&free_things), struct thing, ed.link);
+                if (thing) {
+                        thing->reclaimed = 0;
+                        thing->a = random() % NUM_THINGS;
+                        if (is_hlist_empty(&buckets[thing->a % NUM_BUCKETS]) || (random() & 1))
+                                hlist_insert_front_publish(&buckets[thing->a % NUM_BUCKETS], &thing->hl);
+                        else
+                                hlist_insert_after_publish(buckets[thing->a % NUM_BUCKETS].first, &thing->hl);
+                }
+        }
+
+        __atomic_store_n(&writer_done, 1, __ATOMIC_RELEASE);
+        for (i=0; i<NUM_READERS; i++) {
+                TEST(pthread_join(readers[i], &walks) == 0);
+                total_walks += (unsigned long)walks;
+        }
+        printf("  (Readers did %lu bucket walks)\n", total_walks);
+
+        epoch_reader_unregister(&writer);
+        count = 0;
+        for (i=0; i<NUM_BUCKETS; i++) {
+                count += hlist_check(&buckets[i]);
+                hlist_for_each_item(&buckets[i], thing, struct thing, hl)
+                        TEST((thing->a % NUM_BUCKETS) == i && !thing->reclaimed);
+        }
+        i = 0;
+        dlist_for_each_item(&free_things, thing, struct thing, ed.link)
+                i++;
+        TEST(count + i == NUM_THINGS);
+}
+
+int main(void)
+{
+        test_basic();
+        test_published();
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,303 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-htable.c - Unit tests for hash tables. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mec-lib/htable.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+struct thing {
+        uint64_t key;
+        struct htable_node node;
+        int in_table;
+        int seen;
+};
+
+#define NUM_THINGS      100000
+
+struct htable ht;
+struct thing thing_array[NUM_THINGS];
+
+void *thing_get_key(struct htable_node *n)
+{
+        return &HTABLE_ITEM(n, struct thing, node)->key;
+}
+
+uint64_t thing_hash(void *key)
+{
+        return htable_hash_u64(*(uint64_t *)key);
+}
+
+/* A poor hash, so that lots of items end up in the same chains. */
+uint64_t thing_bad_hash(void *key)
+{
+        return *(uint64_t *)key % 1021;
+}
+
+int thing_compare(void *key_a, void *key_b)
+{
+        return *(uint64_t *)key_a != *(uint64_t *)key_b;
+}
+
+/* Allocations can be made to fail, to check that the table carries on without resizing. */
+size_t buckets_allocated;
+int fail_allocs;
+unsigned allocs_failed;
+
+/* Bucket arrays are filled with junk, since the table is meant to clear them as it goes. */
+struct htable_node **alloc_buckets(size_t num_buckets)
+{
+        struct htable_node **buckets;
+
+        if (fail_allocs) {
+                allocs_failed++;
+                return NULL;
+        }
+        buckets_allocated += num_buckets;
+        buckets = malloc(num_buckets * sizeof(struct htable_node *));
+        TEST(buckets != NULL);
+        memset(buckets, 0xa5, num_buckets * sizeof(struct htable_node *));
+
+        return buckets;
+}
+
+void free_buckets(struct htable_node **buckets, size_t num_buckets)
+{
+        TEST(buckets_allocated >= num_buckets);
+        buckets_allocated -= num_buckets;
+        free(buckets);
+}
+
+struct htable_ops thing_htable_ops = {
+        .get_key = thing_get_key,
+        .hash = thing_hash,
+        .compare = thing_compare,
+        .alloc_buckets = alloc_buckets,
+        .free_buckets = free_buckets,
+};
+
+struct htable_ops thing_bad_htable_ops = {
+        .get_key = thing_get_key,
+        .hash = thing_bad_hash,
+        .compare = thing_compare,
+        .alloc_buckets = alloc_buckets,
+        .free_buckets = free_buckets,
+};
+
+unsigned random_thing(int in_table)
+{
+        unsigned j = random() % NUM_THINGS;
+
+        while (thing_array[j].in_table != in_table)
+                j = (j + 1) % NUM_THINGS;
+
+        return j;
+}
+
+/* Check that every item is found (or not) as it should be, both one at a time and in batches, and that a walk sees
+   each item in the table exactly once. */
+void assert_htable_valid(void)
+{
+        static void *keys[NUM_THINGS];
+        static struct htable_node *found[NUM_THINGS];
+        struct htable_node *n;
+        size_t count = 0;
+        unsigned i;
+        uint64_t key;
+
+        for (i = 0; i < NUM_THINGS; i++) {
+                TEST(htable_find(&ht, &thing_array[i].key) == (thing_array[i].in_table ? &thing_array[i].node : NULL));
+                keys[i] = &thing_array[i].key;
+                count += thing_array[i].in_table;
+                thing_array[i].seen = 0;
+        }
+        TEST(htable_count(&ht) == count);
+
+        /* Odd sized batches, to cover a partial group at the end. */
+        htable_find_batch(&ht, keys, found, 1001);
+        htable_find_batch(&ht, keys + 1001, found + 1001, NUM_THINGS - 1001);
+        for (i = 0; i < NUM_THINGS; i++)
+                TEST(found[i] == (thing_array[i].in_table ? &thing_array[i].node : NULL));
+
+        key = NUM_THINGS * 7;
+        TEST(htable_find(&ht, &key) == NULL);
+
+        for (n = htable_next(&ht, NULL); n; n = htable_next(&ht, n)) {
+                struct thing *t = HTABLE_ITEM(n, struct thing, node);
+
+                TEST(t->in_table);
+                TEST(!t->seen);
+                t->seen = 1;
+                count--;
+        }
+        TEST(count == 0);
+}
+
+void run_tests(struct htable_ops *ops, const char *name)
+{
+        unsigned i, j, resizes = 0, max_buckets = 0;
+        size_t allocated;
+
+        printf("Checking with %s...\n", name);
+        htable_init(&ht, ops);
+        TEST(htable_find(&ht, &thing_array[0].key) == NULL);
+        TEST(htable_next(&ht, NULL) == NULL);
+        TEST(htable_delete(&ht, &thing_array[0].node) != 0);
+
+        fail_allocs = 1;
+        TEST(htable_insert(&ht, &thing_array[0].node) != 0);
+        fail_allocs = 0;
+
+        printf("  Adding %u items in random order...\n", NUM_THINGS);
+        for (i = 0; i < NUM_THINGS; i++) {
+                j = random_thing(0);
+                TEST(htable_insert(&ht, &thing_array[j].node) == 0);
+                thing_array[j].in_table = 1;
+                TEST(htable_insert(&ht, &thing_array[j].node) != 0);
+
+                if (ht.mask + 1 != max_buckets) {
+                        resizes++;
+                        max_buckets = ht.mask + 1;
+                }
+                /* Check all the way through some resizes, and at a few points during the rest. */
+                if (((ht.old_buckets != NULL) && (ht.mask < 256)) || ((i % 20011) == 0))
+                        assert_htable_valid();
+        }
+        assert_htable_valid();
+        TEST(resizes > 10);
+
+        printf("  Adding more with allocations failing...\n");
+        for (i = 0; i < NUM_THINGS / 2; i++) {
+                j = random_thing(1);
+                TEST(htable_delete(&ht, &thing_array[j].node) == 0);
+                thing_array[j].in_table = 0;
+                TEST(htable_delete(&ht, &thing_array[j].node) != 0);
+        }
+        while (ht.old_buckets) {
+                j = random_thing(0);
+                TEST(htable_insert(&ht, &thing_array[j].node) == 0);
+                thing_array[j].in_table = 1;
+        }
+        fail_allocs = 1;
+        allocated = buckets_allocated;
+        for (i = 0; i < NUM_THINGS / 4; i++) {
+                j = random_thing(0);
+                TEST(htable_insert(&ht, &thing_array[j].node) == 0);
+                thing_array[j].in_table = 1;
+        }
+        TEST(buckets_allocated == allocated);
+        fail_allocs = 0;
+        assert_htable_valid();
+
+        printf("  Deleting items in random order...\n");
+        for (i = 0; i < NUM_THINGS; i++) {
+                if (htable_count(&ht) == 0)
+                        break;
+                j = random_thing(1);
+                TEST(htable_delete(&ht, &thing_array[j].node) == 0);
+                thing_array[j].in_table = 0;
+                TEST(htable_find(&ht, &thing_array[j].key) == NULL);
+
+                if (((ht.old_buckets != NULL) && (ht.mask < 256)) || ((i % 20011) == 0))
+                        assert_htable_valid();
+        }
+        assert_htable_valid();
+        TEST(ht.mask + 1 < max_buckets);
+
+        printf("  Checking htable_destroy()...\n");
+        for (i = 0; i < NUM_THINGS; i += 3)
+                TEST(htable_insert(&ht, &thing_array[i].node) == 0);
+        htable_destroy(&ht);
+        TEST(buckets_allocated == 0);
+        TEST(htable_find(&ht, &thing_array[0].key) == NULL);
+}
+
+/* Once growing has failed, the table shouldn't try again on every insert, only once the count has doubled. */
+void test_resize_backoff(void)
+{
+        unsigned i, expect_failed = 0;
+        size_t retry_at;
+
+        printf("Checking resizes back off after failed allocations...\n");
+        htable_init(&ht, &thing_htable_ops);
+        for (i = 0; i < 16; i++)
+                TEST(htable_insert(&ht, &thing_array[i].node) == 0);
+        TEST(ht.mask + 1 == 16);
+
+        fail_allocs = 1;
+        allocs_failed = 0;
+        for (retry_at = 17; i < 1000; i++) {
+                TEST(htable_insert(&ht, &thing_array[i].node) == 0);
+                if (i + 1 == retry_at) {
+                        expect_failed++;
+                        retry_at *= 2;
+                }
+                TEST(allocs_failed == expect_failed);
+        }
+        TEST(expect_failed == 6);
+        TEST(ht.mask + 1 == 16);
+
+        /* With memory back, it grows as soon as the count reaches the next try. */
+        fail_allocs = 0;
+        for (; i + 1 < retry_at; i++)
+                TEST(htable_insert(&ht, &thing_array[i].node) == 0);
+        TEST(ht.mask + 1 == 16);
+        TEST(htable_insert(&ht, &thing_array[i++].node) == 0);
+        TEST(ht.mask + 1 == 32);
+        TEST(ht.resize_failed == 0);
+        TEST(htable_count(&ht) == i);
+
+        htable_destroy(&ht);
+        TEST(buckets_allocated == 0);
+}
+
+int main(void)
+{
+        unsigned i;
+
+        for (i = 0; i < NUM_THINGS; i++)
+                thing_array[i].key = (uint64_t)i * 3;
+
+        run_tests(&thing_htable_ops, "the CRC-32C hash");
+        run_tests(&thing_bad_htable_ops, "a poor hash");
+        test_resize_backoff();
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,254 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-lru.c - Unit tests for sharded LRU caches. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mec-lib/lru.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+struct thing {
+        uint64_t key;
+        struct lru_node lru;
+        unsigned inserts;       /* Successful inserts, evictions, deletes and holds of this item. */
+        unsigned evictions;
+        unsigned deletes;
+        unsigned holds;
+};
+
+#define NUM_THINGS      10000
+#define NUM_SHARDS      8
+#define NUM_THREADS     4
+#define OPS_PER_THREAD  200000
+
+struct lru_cache cache;
+struct lru_shard shards[NUM_SHARDS];
+struct thing thing_array[NUM_THINGS];
+struct thing *last_evicted;
+
+void *thing_get_key(struct htable_node *n)
+{
+        return &HTABLE_ITEM(n, struct thing, lru.index)->key;
+}
+
+uint64_t thing_hash(void *key)
+{
+        return htable_hash_u64(*(uint64_t *)key);
+}
+
+int thing_compare(void *key_a, void *key_b)
+{
+        return *(uint64_t *)key_a != *(uint64_t *)key_b;
+}
+
+struct htable_node **alloc_buckets(size_t num_buckets)
+{
+        return malloc(num_buckets * sizeof(struct htable_node *));
+}
+
+void free_buckets(struct htable_node **buckets, size_t num_buckets)
+{
+        free(buckets);
+}
+
+/* Evictions happen with the whole shard locked, so that count doesn't need to be atomic; holds only have their
+   thread's reader slot locked. */
+void thing_evict(struct lru_node *n)
+{
+        struct thing *thing = LRU_ITEM(n, struct thing, lru);
+
+        /* Different shards can evict at the same time. */
+        __atomic_store_n(&last_evicted, thing, __ATOMIC_RELAXED);
+        thing->evictions++;
+}
+
+void thing_hold(struct lru_node *n)
+{
+        __atomic_add_fetch(&LRU_ITEM(n, struct thing, lru)->holds, 1, __ATOMIC_RELAXED);
+}
+
+struct lru_ops thing_lru_ops = {
+        .index = {
+                .get_key = thing_get_key,
+                .hash = thing_hash,
+                .compare = thing_compare,
+                .alloc_buckets = alloc_buckets,
+                .free_buckets = free_buckets,
+        },
+        .evict = thing_evict,
+        .hold = thing_hold,
+};
+
+int thing_cached(unsigned i)
+{
+        return lru_find(&cache, &thing_array[i].key) == &thing_array[i].lru;
+}
+
+void test_order(void)
+{
+        unsigned i, j;
+
+        printf("Checking eviction order with one shard...\n");
+        lru_init(&cache, &thing_lru_ops, shards, 1, 100);
+
+        for (i = 0; i < 100; i++)
+                TEST(lru_insert(&cache, &thing_array[i].lru) == 0);
+        TEST(lru_insert(&cache, &thing_array[0].lru) != 0);
+        TEST(lru_count(&cache) == 100);
+        TEST(last_evicted == NULL);
+
+        /* With nothing used, items go in the order they were added. */
+        for (i = 100; i < 110; i++) {
+                TEST(lru_insert(&cache, &thing_array[i].lru) == 0);
+                TEST(last_evicted == &thing_array[i - 100]);
+        }
+        TEST(lru_count(&cache) == 100);
+        TEST(lru_find(&cache, &thing_array[0].key) == NULL);
+
+        /* Items that have been used go to the back of the queue. */
+        TEST(thing_cached(10));
+        TEST(thing_cached(12));
+        TEST(lru_insert(&cache, &thing_array[110].lru) == 0);
+        TEST(last_evicted == &thing_array[11]);
+        TEST(lru_insert(&cache, &thing_array[111].lru) == 0);
+        TEST(last_evicted == &thing_array[13]);
+
+        /* A full hit buffer is applied by the hit that overflows it, which then moves its own item to the front. */
+        for (i = 14; i < 14 + LRU_HIT_BUFFER + 1; i++)
+                TEST(thing_cached(i));
+        for (j = 0; j < LRU_READERS; j++)
+                TEST(cache.shards[0].readers[j].hit_count == 0);
+        TEST(cache.shards[0].list.next == &thing_array[14 + LRU_HIT_BUFFER].lru.list);
+        TEST(lru_insert(&cache, &thing_array[112].lru) == 0);
+        TEST(last_evicted == &thing_array[14 + LRU_HIT_BUFFER + 1]);
+        TEST(lru_delete(&cache, &thing_array[14 + LRU_HIT_BUFFER + 2].lru) == 0);
+        TEST(lru_delete(&cache, &thing_array[14 + LRU_HIT_BUFFER + 2].lru) != 0);
+        TEST(lru_insert(&cache, &thing_array[113].lru) == 0);
+        TEST(last_evicted == &thing_array[14 + LRU_HIT_BUFFER + 1]);
+        TEST(lru_insert(&cache, &thing_array[114].lru) == 0);
+        TEST(last_evicted == &thing_array[14 + LRU_HIT_BUFFER + 3]);
+
+        /* Then the rest of the ones that were never used, the hits on 10 and 12, and the ones that were buffered. */
+        for (i = 14 + LRU_HIT_BUFFER + 4; i < 110; i++)
+                TEST(lru_insert(&cache, &thing_array[i + 100].lru) == 0);
+        TEST(last_evicted == &thing_array[109]);
+        TEST(lru_insert(&cache, &thing_array[300].lru) == 0);
+        TEST(last_evicted == &thing_array[10]);
+        TEST(lru_insert(&cache, &thing_array[301].lru) == 0);
+        TEST(last_evicted == &thing_array[12]);
+        TEST(lru_insert(&cache, &thing_array[302].lru) == 0);
+        TEST(last_evicted == &thing_array[110]);
+        TEST(lru_insert(&cache, &thing_array[303].lru) == 0);
+        TEST(last_evicted == &thing_array[111]);
+        TEST(lru_insert(&cache, &thing_array[304].lru) == 0);
+        TEST(last_evicted == &thing_array[14]);
+
+        lru_destroy(&cache);
+        for (i = 0; i < NUM_THINGS; i++)
+                thing_array[i].inserts = thing_array[i].evictions = thing_array[i].deletes = thing_array[i].holds = 0;
+}
+
+void *thread_fn(void *arg)
+{
+        unsigned seed = (uintptr_t)arg;
+        unsigned i, j, r;
+
+        for (i = 0; i < OPS_PER_THREAD; i++) {
+                r = rand_r(&seed) % 100;
+
+                /* A skewed choice of item, so that some are hit a lot. */
+                j = rand_r(&seed) % NUM_THINGS;
+                if (rand_r(&seed) % 2)
+                        j %= NUM_THINGS / 20;
+
+                if (r < 70) {
+                        lru_find(&cache, &thing_array[j].key);
+                } else if (r < 95) {
+                        if (lru_insert(&cache, &thing_array[j].lru) == 0)
+                                __atomic_fetch_add(&thing_array[j].inserts, 1, __ATOMIC_RELAXED);
+                } else {
+                        if (lru_delete(&cache, &thing_array[j].lru) == 0)
+                                __atomic_fetch_add(&thing_array[j].deletes, 1, __ATOMIC_RELAXED);
+                }
+        }
+
+        return NULL;
+}
+
+void test_threads(void)
+{
+        pthread_t threads[NUM_THREADS];
+        size_t count = 0, holds = 0;
+        unsigned i, cached;
+
+        printf("Checking %u threads on %u shards...\n", NUM_THREADS, NUM_SHARDS);
+        lru_init(&cache, &thing_lru_ops, shards, NUM_SHARDS, 1000);
+
+        for (i = 0; i < NUM_THREADS; i++)
+                TEST(pthread_create(&threads[i], NULL, thread_fn, (void *)(uintptr_t)(i + 1)) == 0);
+        for (i = 0; i < NUM_THREADS; i++)
+                TEST(pthread_join(threads[i], NULL) == 0);
+
+        /* Every item is in the cache if and only if it has been inserted once more than it has been removed. */
+        for (i = 0; i < NUM_THINGS; i++) {
+                cached = thing_cached(i);
+                TEST(thing_array[i].inserts == thing_array[i].evictions + thing_array[i].deletes + cached);
+                count += cached;
+                holds += thing_array[i].holds;
+        }
+        TEST(holds > 0);
+        TEST(lru_count(&cache) == count);
+        for (i = 0; i < NUM_SHARDS; i++)
+                TEST(htable_count(&shards[i].index) <= shards[i].capacity);
+        TEST(count > 900);
+
+        lru_destroy(&cache);
+}
+
+int main(void)
+{
+        unsigned i;
+
+        for (i = 0; i < NUM_THINGS; i++)
+                thing_array[i].key = i;
+
+        test_order();
+        test_threads();
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
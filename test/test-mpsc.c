@@ -0,0 +1,209 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-mpsc.c - Unit tests for MPSC queues. */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "mec-lib/mpsc.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+struct thing {
+        unsigned producer;
+        unsigned seq;
+        struct dlist link;
+};
+
+#define NUM_THINGS      1000
+#define NUM_PRODUCERS   4
+#define ITEMS_PER_PRODUCER 100000
+
+enum consume {
+        CONSUME_POP,
+        CONSUME_POP_ALL,
+        CONSUME_WAIT,
+};
+
+const char *consume_names[] = { [CONSUME_POP] = "pop", [CONSUME_POP_ALL] = "pop_all", [CONSUME_WAIT] = "wait" };
+
+struct mpsc_queue q;
+struct thing thing_array[NUM_THINGS];
+struct thing *producer_things[NUM_PRODUCERS];
+
+void test_order(void)
+{
+        struct dlist out, *d;
+        struct thing *t;
+        unsigned i, j, n;
+
+        printf("Checking FIFO order...\n");
+
+        mpsc_init(&q);
+        TEST(mpsc_is_empty(&q));
+        TEST(mpsc_pop(&q) == NULL);
+
+        for (i=0; i<NUM_THINGS; i++) {
+                thing_array[i].seq = i;
+                mpsc_push(&q, &thing_array[i].link);
+        }
+        TEST(!mpsc_is_empty(&q));
+        for (i=0; i<NUM_THINGS; i++)
+                TEST(DLIST_ITEM(mpsc_pop(&q), struct thing, link) == &thing_array[i]);
+        TEST(mpsc_pop(&q) == NULL);
+        TEST(mpsc_is_empty(&q));
+
+        /* Going empty and back again, with zero, one and several items in the queue. */
+        for (i=0; i<NUM_THINGS; i+=(n ? n : 1)) {
+                n = (i % 5 < NUM_THINGS - i) ? i % 5 : NUM_THINGS - i;
+                for (j=0; j<n; j++)
+                        mpsc_push(&q, &thing_array[i + j].link);
+                for (j=0; j<n; j++)
+                        TEST(mpsc_pop(&q) == &thing_array[i + j].link);
+                TEST(mpsc_pop(&q) == NULL);
+                TEST(mpsc_is_empty(&q));
+        }
+
+        /* Everything at once, onto the back of a list that already has something in it. */
+        dlist_init(&out);
+        dlist_insert_back(&out, &thing_array[0].link);
+        TEST(mpsc_pop_all(&q, &out) == 0);
+        for (i=1; i<NUM_THINGS; i++)
+                mpsc_push(&q, &thing_array[i].link);
+        TEST(mpsc_pop_all(&q, &out) == NUM_THINGS - 1);
+        TEST(mpsc_is_empty(&q));
+        i = 0;
+        dlist_for_each_item(&out, t, struct thing, link)
+                TEST(t->seq == i++);
+        TEST(i == NUM_THINGS);
+
+        /* And it really is a dlist. */
+        i = NUM_THINGS;
+        for (d = out.prev; d != &out; d = d->prev)
+                TEST(DLIST_ITEM(d, struct thing, link)->seq == --i);
+
+        /* Items can be queued again once they are off. */
+        mpsc_push(&q, &thing_array[5].link);
+        TEST(mpsc_pop_all(&q, &out) == 1);
+        TEST(out.prev == &thing_array[5].link);
+}
+
+void *producer_fn(void *arg)
+{
+        unsigned p = (uintptr_t)arg;
+        unsigned i;
+
+        for (i=0; i<ITEMS_PER_PRODUCER; i++) {
+                producer_things[p][i].producer = p;
+                producer_things[p][i].seq = i;
+                mpsc_push(&q, &producer_things[p][i].link);
+
+                /* Give the consumer a chance to go to sleep now and then. */
+                if ((i % 10000) == 0)
+                        usleep(1000);
+        }
+
+        return NULL;
+}
+
+/* Consume everything the producers push, with pop, pop_all, or wait and then pop_all.  Each producer's items must come
+   out in the order it pushed them. */
+void test_producers(enum consume how)
+{
+        pthread_t threads[NUM_PRODUCERS];
+        unsigned next_seq[NUM_PRODUCERS] = { 0 };
+        unsigned long total = 0;
+        struct dlist out, *d;
+        struct thing *t;
+        unsigned i;
+
+        printf("Checking %u producers with %s...\n", NUM_PRODUCERS, consume_names[how]);
+
+        mpsc_init(&q);
+        for (i=0; i<NUM_PRODUCERS; i++)
+                TEST(pthread_create(&threads[i], NULL, producer_fn, (void *)(uintptr_t)i) == 0);
+
+        while (total < NUM_PRODUCERS * ITEMS_PER_PRODUCER) {
+                dlist_init(&out);
+
+                if (how == CONSUME_WAIT)
+                        mpsc_wait(&q);
+
+                if (how == CONSUME_POP) {
+                        d = mpsc_pop(&q);
+                        if (d)
+                                dlist_insert_back(&out, d);
+                } else {
+                        mpsc_pop_all(&q, &out);
+                }
+
+                dlist_for_each_item(&out, t, struct thing, link) {
+                        TEST(t->seq == next_seq[t->producer]);
+                        next_seq[t->producer]++;
+                        total++;
+                }
+        }
+
+        for (i=0; i<NUM_PRODUCERS; i++)
+                TEST(pthread_join(threads[i], NULL) == 0);
+
+        TEST(mpsc_pop(&q) == NULL);
+        TEST(mpsc_is_empty(&q));
+        for (i=0; i<NUM_PRODUCERS; i++)
+                TEST(next_seq[i] == ITEMS_PER_PRODUCER);
+}
+
+int main(void)
+{
+        unsigned i;
+
+        for (i=0; i<NUM_PRODUCERS; i++) {
+                producer_things[i] = malloc(ITEMS_PER_PRODUCER * sizeof(struct thing));
+                TEST(producer_things[i] != NULL);
+        }
+
+        test_order();
+        test_producers(CONSUME_POP);
+        test_producers(CONSUME_POP_ALL);
+        test_producers(CONSUME_WAIT);
+
+        for (i=0; i<NUM_PRODUCERS; i++)
+                free(producer_things[i]);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
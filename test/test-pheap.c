@@ -0,0 +1,262 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-pheap.c - Unit tests for pairing heaps. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "mec-lib/pheap.h"
+#include "mec-lib/util.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+struct thing {
+        unsigned long key;
+        int in_heap;
+        struct pheap_node node;
+};
+
+#define NUM_THINGS      5000
+
+struct thing thing_array[NUM_THINGS];
+uint64_t state = 1;
+
+static inline uint64_t rand64(void)
+{
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+}
+
+void *thing_get_key(struct pheap_node *n)
+{
+        return &PHEAP_ITEM(n, struct thing, node)->key;
+}
+
+int compare_keys(void *key_a, void *key_b)
+{
+        unsigned long a = *(unsigned long *)key_a, b = *(unsigned long *)key_b;
+
+        return (a > b) - (a < b);
+}
+
+struct pheap_ops thing_ops = {
+        .get_key = thing_get_key,
+        .compare = compare_keys,
+};
+
+/* Check the links and ordering of a subtree, returning the number of nodes in it. */
+size_t check_subtree(struct pheap_node *n)
+{
+        struct pheap_node *c, *prev = n;
+        size_t count = 1;
+
+        TEST(PHEAP_ITEM(n, struct thing, node)->in_heap);
+        for (c = n->child; c; prev = c, c = c->next) {
+                TEST(c->prev == prev);
+                TEST(compare_keys(thing_get_key(n), thing_get_key(c)) <= 0);
+                count += check_subtree(c);
+        }
+
+        return count;
+}
+
+void check_heap(struct pheap *h)
+{
+        size_t count = 0;
+        unsigned i;
+
+        if (h->root) {
+                TEST(h->root->next == NULL && h->root->prev == NULL);
+                TEST(check_subtree(h->root) == pheap_count(h));
+        }
+
+        for (i=0; i<NUM_THINGS; i++)
+                count += (thing_array[i].in_heap != 0);
+        TEST(count == pheap_count(h));
+}
+
+/* Return the smallest key of anything in the heap, the slow way. */
+unsigned long smallest_key(void)
+{
+        unsigned long min = ~0UL;
+        unsigned i;
+
+        for (i=0; i<NUM_THINGS; i++)
+                if (thing_array[i].in_heap && thing_array[i].key < min)
+                        min = thing_array[i].key;
+
+        return min;
+}
+
+void test_sort(void)
+{
+        struct pheap h;
+        struct pheap_node *n;
+        unsigned long prev = 0;
+        unsigned i;
+
+        printf("Checking %u items come out in order...\n", NUM_THINGS);
+
+        pheap_init(&h, &thing_ops);
+        TEST(pheap_min(&h) == NULL);
+        TEST(pheap_pop(&h) == NULL);
+
+        for (i=0; i<NUM_THINGS; i++) {
+                /* Plenty of duplicates. */
+                thing_array[i].key = rand64() % (NUM_THINGS / 4);
+                thing_array[i].in_heap = 1;
+                pheap_insert(&h, &thing_array[i].node);
+        }
+        check_heap(&h);
+
+        for (i=0; i<NUM_THINGS; i++) {
+                n = pheap_pop(&h);
+                TEST(n != NULL);
+                TEST(PHEAP_ITEM(n, struct thing, node)->key >= prev);
+                prev = PHEAP_ITEM(n, struct thing, node)->key;
+                PHEAP_ITEM(n, struct thing, node)->in_heap = 0;
+                if ((i % 1000) == 0)
+                        check_heap(&h);
+        }
+        TEST(pheap_pop(&h) == NULL);
+        TEST(pheap_count(&h) == 0);
+}
+
+void test_random(void)
+{
+        struct pheap h;
+        struct pheap_node *n;
+        struct thing *t;
+        unsigned i, op;
+
+        printf("Checking random inserts, pops, deletes and decreases...\n");
+
+        pheap_init(&h, &thing_ops);
+        for (i=0; i<NUM_THINGS; i++)
+                thing_array[i].in_heap = 0;
+
+        for (op=0; op<50000; op++) {
+                t = &thing_array[rand64() % NUM_THINGS];
+
+                switch (rand64() % 5) {
+                case 0:
+                        n = pheap_pop(&h);
+                        if (n) {
+                                TEST(PHEAP_ITEM(n, struct thing, node)->key == smallest_key());
+                                PHEAP_ITEM(n, struct thing, node)->in_heap = 0;
+                        } else {
+                                TEST(pheap_count(&h) == 0);
+                        }
+                        break;
+
+                case 1:
+                        if (t->in_heap) {
+                                pheap_delete(&h, &t->node);
+                                t->in_heap = 0;
+                        }
+                        break;
+
+                case 2:
+                        if (t->in_heap) {
+                                t->key -= MEC_MIN(t->key, rand64() % 100000);
+                                pheap_decrease(&h, &t->node);
+                                TEST(PHEAP_ITEM(pheap_min(&h), struct thing, node)->key == smallest_key());
+                        }
+                        break;
+
+                default:
+                        if (!t->in_heap) {
+                                t->key = rand64() % 1000000;
+                                t->in_heap = 1;
+                                pheap_insert(&h, &t->node);
+                                TEST(PHEAP_ITEM(pheap_min(&h), struct thing, node)->key == smallest_key());
+                        }
+                        break;
+                }
+
+                if ((op % 1000) == 0)
+                        check_heap(&h);
+        }
+        check_heap(&h);
+}
+
+void test_meld(void)
+{
+        struct pheap a, b;
+        struct pheap_node *n;
+        unsigned long prev = 0;
+        unsigned i;
+
+        printf("Checking melding two heaps...\n");
+
+        pheap_init(&a, &thing_ops);
+        pheap_init(&b, &thing_ops);
+        pheap_meld(&a, &b);
+        TEST(pheap_count(&a) == 0 && pheap_min(&a) == NULL);
+
+        for (i=0; i<NUM_THINGS; i++) {
+                thing_array[i].key = rand64() % 1000000;
+                thing_array[i].in_heap = 1;
+                pheap_insert((i % 3) ? &a : &b, &thing_array[i].node);
+        }
+        pheap_meld(&a, &b);
+        TEST(pheap_count(&b) == 0 && pheap_min(&b) == NULL);
+        check_heap(&a);
+
+        /* Melding into an empty heap. */
+        pheap_meld(&b, &a);
+        TEST(pheap_count(&a) == 0 && pheap_min(&a) == NULL);
+        check_heap(&b);
+
+        while ((n = pheap_pop(&b))) {
+                TEST(PHEAP_ITEM(n, struct thing, node)->key >= prev);
+                prev = PHEAP_ITEM(n, struct thing, node)->key;
+                PHEAP_ITEM(n, struct thing, node)->in_heap = 0;
+        }
+        check_heap(&b);
+}
+
+int main(void)
+{
+        test_sort();
+        test_random();
+        test_meld();
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
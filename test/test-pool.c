@@ -0,0 +1,304 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-pool.c - Unit tests for slab pools. */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mec-lib/pool.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+#define NUM_OBJS        20000
+#define NUM_SLOTS       1024
+#define NUM_THREADS     4
+#define OPS_PER_THREAD  200000
+
+/* Every object handed out is filled with its own address, to catch two being handed out over each other. */
+struct obj {
+        uintptr_t self[5];
+};
+
+struct pool pool;
+void *objs[NUM_OBJS];
+void *slots[NUM_SLOTS];
+
+void fill_obj(struct obj *o)
+{
+        unsigned i;
+
+        for (i=0; i<5; i++)
+                o->self[i] = (uintptr_t)o;
+}
+
+int check_obj(struct obj *o)
+{
+        unsigned i;
+
+        for (i=0; i<5; i++)
+                if (o->self[i] != (uintptr_t)o)
+                        return 0;
+
+        return 1;
+}
+
+int compare_ptrs(const void *a, const void *b)
+{
+        uintptr_t pa = *(uintptr_t *)a;
+        uintptr_t pb = *(uintptr_t *)b;
+
+        return (pa > pb) - (pa < pb);
+}
+
+/* Allocate 'n' objects into objs[], and check none of them overlap. */
+void alloc_objs(struct pool_cache *c, size_t obj_size, unsigned align, unsigned n)
+{
+        void *sorted[NUM_OBJS];
+        unsigned i;
+
+        for (i=0; i<n; i++) {
+                objs[i] = pool_alloc(c);
+                TEST(objs[i] != NULL);
+                TEST(((uintptr_t)objs[i] % align) == 0);
+                fill_obj(objs[i]);
+        }
+
+        memcpy(sorted, objs, n * sizeof(objs[0]));
+        qsort(sorted, n, sizeof(sorted[0]), compare_ptrs);
+        for (i=1; i<n; i++)
+                TEST((char *)sorted[i] - (char *)sorted[i-1] >= obj_size);
+
+        for (i=0; i<n; i++)
+                TEST(check_obj(objs[i]));
+}
+
+void test_basic(void)
+{
+        struct pool_cache c;
+        size_t size;
+        unsigned i;
+
+        printf("Checking allocation and reuse...\n");
+
+        TEST(pool_init(&pool, sizeof(struct obj), 0) == 0);
+        pool_cache_init(&pool, &c);
+        TEST(pool_size(&pool) == 0);
+
+        alloc_objs(&c, sizeof(struct obj), POOL_ALIGN, NUM_OBJS);
+        size = pool_size(&pool);
+        TEST(size % POOL_SLAB_SIZE == 0);
+        TEST(size <= (NUM_OBJS * pool.obj_size / POOL_SLAB_SIZE + 2) * POOL_SLAB_SIZE);
+
+        /* Objects allocated one after the other from a fresh pool are packed together. */
+        for (i=1; i<POOL_BATCH; i++)
+                TEST((char *)objs[i] == (char *)objs[i-1] + pool.obj_size);
+
+        /* Freed objects get reused, in any order and through more than one cache. */
+        for (i=0; i<NUM_OBJS; i+=2)
+                pool_free(&c, objs[i]);
+        for (i=1; i<NUM_OBJS; i+=2)
+                pool_free(&c, objs[i]);
+        pool_cache_flush(&c);
+        TEST(c.count == 0);
+
+        pool_cache_init(&pool, &c);
+        alloc_objs(&c, sizeof(struct obj), POOL_ALIGN, NUM_OBJS);
+        TEST(pool_size(&pool) == size);
+
+        pool_destroy(&pool);
+        TEST(pool_size(&pool) == 0);
+}
+
+void test_cacheline(void)
+{
+        struct pool_cache c;
+        unsigned i;
+
+        printf("Checking cache line aligned objects...\n");
+
+        TEST(pool_init(&pool, sizeof(struct obj), POOL_CACHELINE_ALIGN) == 0);
+        pool_cache_init(&pool, &c);
+        TEST(pool.obj_size == 64);
+        alloc_objs(&c, 64, 64, NUM_OBJS);
+        pool_destroy(&pool);
+
+        /* The smallest objects still have room to be linked into a batch, and keep POOL_ALIGN. */
+        TEST(pool_init(&pool, 1, 0) == 0);
+        TEST(pool.obj_size >= 3 * sizeof(void *));
+        TEST((pool.obj_size % POOL_ALIGN) == 0);
+        pool_cache_init(&pool, &c);
+        for (i=0; i<1000; i++) {
+                objs[i] = pool_alloc(&c);
+                TEST(objs[i] && (((uintptr_t)objs[i] % POOL_ALIGN) == 0));
+        }
+        pool_destroy(&pool);
+
+        /* Objects too big to carve several from a slab are refused. */
+        TEST(pool_init(&pool, POOL_SLAB_SIZE / 4, 0) == 0);
+        pool_destroy(&pool);
+        TEST(pool_init(&pool, POOL_SLAB_SIZE / 4 + 1, 0) != 0);
+        TEST(pool_init(&pool, POOL_SLAB_SIZE, 0) != 0);
+        TEST(pool_init(&pool, POOL_SLAB_SIZE, POOL_HUGE_PAGES) == 0);
+        pool_destroy(&pool);
+}
+
+void test_bulk(void)
+{
+        struct pool_cache c, c2;
+        size_t size;
+        unsigned n;
+
+        printf("Checking bulk frees...\n");
+
+        TEST(pool_init(&pool, sizeof(struct obj), 0) == 0);
+        pool_cache_init(&pool, &c);
+        pool_cache_init(&pool, &c2);
+
+        /* Odd sizes, to leave the cache part full each time. */
+        for (n = 1; n < NUM_OBJS; n = n * 3 + 1) {
+                alloc_objs(&c, sizeof(struct obj), POOL_ALIGN, n);
+                size = pool_size(&pool);
+                pool_free_bulk(&c, objs, n);
+                TEST(c.count <= POOL_MAGAZINE_SIZE);
+                pool_cache_flush(&c);
+
+                /* Everything freed is back in the pool for another cache. */
+                alloc_objs(&c2, sizeof(struct obj), POOL_ALIGN, n);
+                TEST(pool_size(&pool) == size);
+                pool_free_bulk(&c2, objs, n);
+                pool_cache_flush(&c2);
+        }
+
+        pool_destroy(&pool);
+}
+
+/* Each thread swaps objects in and out of slots[], so most objects are freed by a different thread from the one that
+   allocated them. */
+void *thread_fn(void *arg)
+{
+        uint64_t state = (uintptr_t)arg * 0x9e3779b97f4a7c15ULL;
+        struct pool_cache c;
+        struct obj *o;
+        unsigned i;
+
+        pool_cache_init(&pool, &c);
+
+        for (i=0; i<OPS_PER_THREAD; i++) {
+                state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+                o = __atomic_exchange_n(&slots[(state >> 33) % NUM_SLOTS], NULL, __ATOMIC_ACQ_REL);
+                if (o) {
+                        TEST(check_obj(o));
+                        memset(o, 0, sizeof(*o));
+                        pool_free(&c, o);
+                } else {
+                        o = pool_alloc(&c);
+                        TEST(o != NULL);
+                        fill_obj(o);
+                        o = __atomic_exchange_n(&slots[(state >> 33) % NUM_SLOTS], o, __ATOMIC_ACQ_REL);
+                        if (o) {
+                                TEST(check_obj(o));
+                                pool_free(&c, o);
+                        }
+                }
+        }
+
+        pool_cache_flush(&c);
+
+        return NULL;
+}
+
+void test_threads(void)
+{
+        pthread_t threads[NUM_THREADS];
+        struct pool_cache c;
+        unsigned i;
+
+        printf("Checking %u threads...\n", NUM_THREADS);
+
+        TEST(pool_init(&pool, sizeof(struct obj), 0) == 0);
+
+        for (i=0; i<NUM_THREADS; i++)
+                TEST(pthread_create(&threads[i], NULL, thread_fn, (void *)(uintptr_t)(i + 1)) == 0);
+        for (i=0; i<NUM_THREADS; i++)
+                TEST(pthread_join(threads[i], NULL) == 0);
+
+        /* At most NUM_SLOTS objects were live at once, plus what the caches held; so objects were reused. */
+        TEST(pool_size(&pool) <= (((NUM_SLOTS + NUM_THREADS * (POOL_MAGAZINE_SIZE + POOL_BATCH)) * sizeof(struct obj)) /
+                                  POOL_SLAB_SIZE + NUM_THREADS + 1) * POOL_SLAB_SIZE);
+
+        pool_cache_init(&pool, &c);
+        for (i=0; i<NUM_SLOTS; i++) {
+                if (slots[i]) {
+                        TEST(check_obj(slots[i]));
+                        pool_free(&c, slots[i]);
+                        slots[i] = NULL;
+                }
+        }
+        pool_cache_flush(&c);
+
+        pool_destroy(&pool);
+}
+
+void test_huge_pages(void)
+{
+        struct pool_cache c;
+
+        printf("Checking huge page slabs...\n");
+
+        /* This works whether or not the system has huge pages reserved. */
+        TEST(pool_init(&pool, sizeof(struct obj), POOL_HUGE_PAGES) == 0);
+        pool_cache_init(&pool, &c);
+        alloc_objs(&c, sizeof(struct obj), POOL_ALIGN, NUM_OBJS);
+        TEST(pool_size(&pool) == POOL_HUGE_SLAB_SIZE);
+        TEST(((uintptr_t)objs[0] & (POOL_HUGE_SLAB_SIZE - 1)) == 64);
+        pool_free_bulk(&c, objs, NUM_OBJS);
+        pool_destroy(&pool);
+}
+
+int main(void)
+{
+        test_basic();
+        test_cacheline();
+        test_bulk();
+        test_threads();
+        test_huge_pages();
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
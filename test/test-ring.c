@@ -0,0 +1,322 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-ring.c - Unit tests for ring buffers. */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mec-lib/ring.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+/* An odd size, to check elements aren't assumed to be words. */
+struct elem {
+        uint32_t producer;
+        uint32_t seq;
+        uint32_t check;
+};
+
+#define NUM_SLOTS       64
+#define NUM_THREADS     4
+#define ITEMS_PER_THREAD 200000
+
+struct spsc_ring spsc;
+struct mpmc_ring mpmc;
+struct elem spsc_slots[NUM_SLOTS];
+size_t mpmc_slots[NUM_SLOTS * MPMC_RING_SLOT_SIZE(sizeof(struct elem)) / sizeof(size_t)];
+unsigned char *seen;
+
+static inline struct elem make_elem(uint32_t producer, uint32_t seq)
+{
+        struct elem e = { producer, seq, producer * 0x9e3779b9 ^ seq };
+
+        return e;
+}
+
+static inline int check_elem(struct elem *e)
+{
+        return e->check == (e->producer * 0x9e3779b9 ^ e->seq);
+}
+
+void test_spsc(void)
+{
+        struct elem e, batch[NUM_SLOTS * 2];
+        unsigned i, j, seq = 0, next = 0, n;
+        void *slots;
+        struct elem *s;
+
+        printf("Checking SPSC ring...\n");
+
+        TEST(spsc_ring_init(&spsc, spsc_slots, 0, sizeof(struct elem)) != 0);
+        TEST(spsc_ring_init(&spsc, spsc_slots, 48, sizeof(struct elem)) != 0);
+        TEST(spsc_ring_init(&spsc, spsc_slots, NUM_SLOTS, sizeof(struct elem)) == 0);
+
+        /* Fill it, and empty it. */
+        TEST(spsc_pop(&spsc, &e) != 0);
+        for (i=0; i<NUM_SLOTS; i++) {
+                e = make_elem(0, seq++);
+                TEST(spsc_push(&spsc, &e) == 0);
+        }
+        TEST(spsc_push(&spsc, &e) != 0);
+        for (i=0; i<NUM_SLOTS; i++) {
+                TEST(spsc_pop(&spsc, &e) == 0);
+                TEST(check_elem(&e) && e.seq == next++);
+        }
+        TEST(spsc_pop(&spsc, &e) != 0);
+
+        /* Batches of every size, wrapping around many times. */
+        for (i=1; i<NUM_SLOTS * 2; i++) {
+                for (j=0; j<i; j++)
+                        batch[j] = make_elem(0, seq + j);
+                n = spsc_push_bulk(&spsc, batch, i);
+                TEST(n == ((i < NUM_SLOTS) ? i : NUM_SLOTS));
+                seq += n;
+                TEST(spsc_pop_bulk(&spsc, batch, i) == n);
+                for (j=0; j<n; j++)
+                        TEST(check_elem(&batch[j]) && batch[j].seq == next++);
+        }
+
+        /* Slots reserved in place stop where the ring wraps around. */
+        for (i=0; i<NUM_SLOTS * 3; i+=n) {
+                n = spsc_reserve(&spsc, &slots, 5);
+                TEST(n == MEC_MIN(5U, NUM_SLOTS - (seq % NUM_SLOTS)));
+                TEST(slots == &spsc_slots[seq % NUM_SLOTS]);
+                for (s = slots, j=0; j<n; j++)
+                        s[j] = make_elem(0, seq++);
+                spsc_commit(&spsc, n);
+
+                TEST(spsc_peek(&spsc, &slots, NUM_SLOTS) == n);
+                for (s = slots, j=0; j<n; j++)
+                        TEST(check_elem(&s[j]) && s[j].seq == next++);
+                spsc_release(&spsc, n);
+        }
+        TEST(spsc_peek(&spsc, &slots, 1) == 0);
+}
+
+void *spsc_producer(void *arg)
+{
+        struct elem batch[7];
+        unsigned seq = 0, j, n;
+        void *slots;
+
+        while (seq < ITEMS_PER_THREAD) {
+                switch (seq % 3) {
+                case 0:
+                        batch[0] = make_elem(0, seq);
+                        n = !spsc_push(&spsc, &batch[0]);
+                        break;
+                case 1:
+                        n = MEC_MIN(7U, ITEMS_PER_THREAD - seq);
+                        for (j=0; j<n; j++)
+                                batch[j] = make_elem(0, seq + j);
+                        n = spsc_push_bulk(&spsc, batch, n);
+                        break;
+                default:
+                        n = spsc_reserve(&spsc, &slots, MEC_MIN(5U, ITEMS_PER_THREAD - seq));
+                        for (j=0; j<n; j++)
+                                ((struct elem *)slots)[j] = make_elem(0, seq + j);
+                        spsc_commit(&spsc, n);
+                        break;
+                }
+
+                seq += n;
+                if (n == 0)
+                        sched_yield();
+        }
+
+        return NULL;
+}
+
+void test_spsc_threads(void)
+{
+        struct elem batch[11];
+        unsigned next = 0, j, n;
+        pthread_t thread;
+
+        printf("Checking SPSC ring between two threads...\n");
+
+        TEST(spsc_ring_init(&spsc, spsc_slots, NUM_SLOTS, sizeof(struct elem)) == 0);
+        TEST(pthread_create(&thread, NULL, spsc_producer, NULL) == 0);
+
+        while (next < ITEMS_PER_THREAD) {
+                n = spsc_pop_bulk(&spsc, batch, 1 + next % 11);
+                for (j=0; j<n; j++)
+                        TEST(check_elem(&batch[j]) && batch[j].seq == next++);
+                if (n == 0)
+                        sched_yield();
+        }
+
+        TEST(pthread_join(thread, NULL) == 0);
+        TEST(spsc_pop(&spsc, &batch[0]) != 0);
+}
+
+void test_mpmc(void)
+{
+        struct elem e, batch[NUM_SLOTS * 2];
+        unsigned i, j, seq = 0, next = 0, n;
+        size_t ticket;
+
+        printf("Checking MPMC ring...\n");
+
+        TEST(mpmc_ring_init(&mpmc, mpmc_slots, 1, sizeof(struct elem)) != 0);
+        TEST(mpmc_ring_init(&mpmc, mpmc_slots, 48, sizeof(struct elem)) != 0);
+        TEST(mpmc_ring_init(&mpmc, mpmc_slots, NUM_SLOTS, sizeof(struct elem)) == 0);
+
+        TEST(mpmc_pop(&mpmc, &e) != 0);
+        for (i=0; i<NUM_SLOTS; i++) {
+                e = make_elem(0, seq++);
+                TEST(mpmc_push(&mpmc, &e) == 0);
+        }
+        TEST(mpmc_push(&mpmc, &e) != 0);
+        for (i=0; i<NUM_SLOTS; i++) {
+                TEST(mpmc_pop(&mpmc, &e) == 0);
+                TEST(check_elem(&e) && e.seq == next++);
+        }
+        TEST(mpmc_pop(&mpmc, &e) != 0);
+
+        for (i=1; i<NUM_SLOTS * 2; i++) {
+                for (j=0; j<i; j++)
+                        batch[j] = make_elem(0, seq + j);
+                n = mpmc_push_bulk(&mpmc, batch, i);
+                TEST(n == ((i < NUM_SLOTS) ? i : NUM_SLOTS));
+                seq += n;
+                TEST(mpmc_pop_bulk(&mpmc, batch, i) == n);
+                for (j=0; j<n; j++)
+                        TEST(check_elem(&batch[j]) && batch[j].seq == next++);
+        }
+
+        /* A claimed slot that hasn't been committed holds up the ones after it. */
+        TEST(mpmc_reserve(&mpmc, &ticket, 1) == 1);
+        e = make_elem(0, seq + 1);
+        TEST(mpmc_push(&mpmc, &e) == 0);
+        TEST(mpmc_pop(&mpmc, &e) != 0);
+        *(struct elem *)mpmc_slot(&mpmc, ticket) = make_elem(0, seq);
+        mpmc_commit(&mpmc, ticket, 1);
+        seq += 2;
+        TEST(mpmc_peek(&mpmc, &ticket, NUM_SLOTS) == 2);
+        for (j=0; j<2; j++)
+                TEST(((struct elem *)mpmc_slot(&mpmc, ticket + j))->seq == next++);
+        mpmc_release(&mpmc, ticket, 2);
+        TEST(mpmc_pop(&mpmc, &e) != 0);
+}
+
+void *mpmc_producer(void *arg)
+{
+        uint32_t p = (uintptr_t)arg;
+        struct elem batch[4];
+        unsigned seq = 0, j, n;
+
+        while (seq < ITEMS_PER_THREAD) {
+                n = MEC_MIN(1 + seq % 4, ITEMS_PER_THREAD - seq);
+                for (j=0; j<n; j++)
+                        batch[j] = make_elem(p, seq + j);
+                n = (n == 1) ? !mpmc_push(&mpmc, &batch[0]) : mpmc_push_bulk(&mpmc, batch, n);
+                seq += n;
+                if (n == 0)
+                        sched_yield();
+        }
+
+        return NULL;
+}
+
+unsigned long consumed;
+
+/* Each consumer must see each producer's items in order, though they are shared between the consumers. */
+void *mpmc_consumer(void *arg)
+{
+        uint32_t last[NUM_THREADS];
+        struct elem batch[3];
+        unsigned j, n;
+
+        for (j=0; j<NUM_THREADS; j++)
+                last[j] = UINT32_MAX;
+
+        while (__atomic_load_n(&consumed, __ATOMIC_RELAXED) < NUM_THREADS * ITEMS_PER_THREAD) {
+                n = mpmc_pop_bulk(&mpmc, batch, 3);
+                for (j=0; j<n; j++) {
+                        TEST(check_elem(&batch[j]));
+                        TEST(batch[j].producer < NUM_THREADS);
+                        TEST((last[batch[j].producer] == UINT32_MAX) || (batch[j].seq > last[batch[j].producer]));
+                        last[batch[j].producer] = batch[j].seq;
+                        TEST(__atomic_fetch_add(&seen[batch[j].producer * ITEMS_PER_THREAD + batch[j].seq], 1,
+                                                __ATOMIC_RELAXED) == 0);
+                }
+                __atomic_fetch_add(&consumed, n, __ATOMIC_RELAXED);
+                if (n == 0)
+                        sched_yield();
+        }
+
+        return NULL;
+}
+
+void test_mpmc_threads(void)
+{
+        pthread_t producers[NUM_THREADS], consumers[NUM_THREADS];
+        unsigned i;
+
+        printf("Checking MPMC ring with %u producers and %u consumers...\n", NUM_THREADS, NUM_THREADS);
+
+        seen = calloc(NUM_THREADS * ITEMS_PER_THREAD, 1);
+        TEST(seen != NULL);
+        TEST(mpmc_ring_init(&mpmc, mpmc_slots, NUM_SLOTS, sizeof(struct elem)) == 0);
+
+        for (i=0; i<NUM_THREADS; i++) {
+                TEST(pthread_create(&producers[i], NULL, mpmc_producer, (void *)(uintptr_t)i) == 0);
+                TEST(pthread_create(&consumers[i], NULL, mpmc_consumer, NULL) == 0);
+        }
+        for (i=0; i<NUM_THREADS; i++) {
+                TEST(pthread_join(producers[i], NULL) == 0);
+                TEST(pthread_join(consumers[i], NULL) == 0);
+        }
+
+        TEST(consumed == NUM_THREADS * ITEMS_PER_THREAD);
+        for (i=0; i<NUM_THREADS * ITEMS_PER_THREAD; i++)
+                TEST(seen[i] == 1);
+        free(seen);
+}
+
+int main(void)
+{
+        test_spsc();
+        test_spsc_threads();
+        test_mpmc();
+        test_mpmc_threads();
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,430 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-skiplist.c - Unit and multi-threaded stress tests for lock-free skip lists. */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mec-lib/skiplist.h"
+#include "mec-lib/util.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+/* Even keys are inserted up front and never deleted.  Each thread keeps deleting its own odd keyed things and
+   reinserting them with new odd keys once they have been reclaimed. */
+struct thing {
+        int a;
+        int in_list;
+        int reclaimed;
+        struct dlist free_link;
+        struct skiplist_node node;      /* Must be last. */
+};
+
+#define NUM_STABLE      1000
+#define NUM_THREADS     4
+#define NUM_CHURN       250             /* Per thread. */
+#define NUM_WRITES      100000          /* Per thread. */
+#define KEY_RANGE       (NUM_STABLE * 2)
+
+struct skiplist list;
+struct epoch epoch;
+struct thing *stable_things[NUM_STABLE];
+struct thing *churn_things[NUM_THREADS][NUM_CHURN];
+struct dlist free_things[NUM_THREADS];
+
+void *thing_get_int_key(struct skiplist_node *n)
+{
+        return &SKIPLIST_ITEM(n, struct thing, node)->a;
+}
+
+int compare_ints(void *key_a, void *key_b)
+{
+        int *int_a = (int *)key_a;
+        int *int_b = (int *)key_b;
+
+        return *int_a - *int_b;
+}
+
+/* Called once no reader can see the thing any more; poison it and make it available again.  Things are only ever
+   deleted and reinserted by the thread that owns them, so that's the thread that retires them. */
+void thing_reclaim(struct epoch_deferred *d)
+{
+        struct thing *thing = EPOCH_ITEM(d, struct thing, node.deferred);
+
+        TEST(__atomic_add_fetch(&thing->reclaimed, 1, __ATOMIC_RELAXED) == 1);
+        if ((thing->a & 1) && (thing->a >= 0))
+                dlist_insert_back(&free_things[(thing->a >> 1) % NUM_THREADS], &thing->free_link);
+}
+
+struct skiplist_ops thing_ops = {
+        .get_key = thing_get_int_key,
+        .compare = compare_ints,
+        .reclaim = thing_reclaim,
+};
+
+struct thing *new_thing(int a, uint64_t *state)
+{
+        unsigned height = skiplist_random_height(state);
+        struct thing *thing = malloc(sizeof(*thing) + height * sizeof(struct skiplist_node *));
+
+        TEST(thing != NULL);
+        thing->a = a;
+        thing->in_list = 0;
+        thing->reclaimed = 0;
+        skiplist_node_init(&thing->node, height);
+
+        return thing;
+}
+
+/* Check a node returned from a lookup while still inside the critical section. */
+struct thing *check_node(struct skiplist_node *n)
+{
+        struct thing *thing = SKIPLIST_ITEM(n, struct thing, node);
+
+        if (thing)
+                TEST(__atomic_load_n(&thing->reclaimed, __ATOMIC_RELAXED) == 0);
+
+        return thing;
+}
+
+void test_basic(void)
+{
+        struct epoch_reader reader;
+        struct thing *things[100], *thing;
+        struct skiplist_node *n;
+        uint64_t state = 1;
+        unsigned i, heights[SKIPLIST_MAX_HEIGHT + 1] = { 0 };
+        int key;
+
+        printf("Checking skiplist_random_height()...\n");
+        for (i=0; i<100000; i++) {
+                key = skiplist_random_height(&state);
+                TEST(key >= 1 && key <= SKIPLIST_MAX_HEIGHT);
+                heights[key]++;
+        }
+        /* About 3/4 should be 1 high, 3/16 2 high... */
+        TEST(heights[1] > 74000 && heights[1] < 76000);
+        TEST(heights[2] > 18000 && heights[2] < 19500);
+
+        printf("Checking single threaded inserts, lookups and deletes...\n");
+        epoch_reader_register(&epoch, &reader);
+        skiplist_init(&list, &thing_ops);
+
+        epoch_enter(&reader);
+        TEST(skiplist_next(&list, NULL) == NULL);
+        TEST(skiplist_prev(&list, NULL) == NULL);
+        TEST(skiplist_find(&list, &(int){ 0 }) == NULL);
+        epoch_exit(&reader);
+
+        /* Keys -100, -98, ... 98, inserted in a scrambled order. */
+        for (i=0; i<100; i++)
+                things[i] = new_thing(((i * 37) % 100) * 2 - 100, &state);
+        for (i=0; i<100; i++) {
+                TEST(skiplist_insert(&list, &reader, &things[i]->node) == 0);
+                things[i]->in_list = 1;
+        }
+        thing = new_thing(0, &state);
+        TEST(skiplist_insert(&list, &reader, &thing->node) != 0);
+        free(thing);
+
+        epoch_enter(&reader);
+        TEST(skiplist_count(&list) == 100);
+        for (key = -102; key <= 100; key++) {
+                thing = SKIPLIST_ITEM(skiplist_find(&list, &key), struct thing, node);
+                if ((key & 1) || (key < -100) || (key > 98))
+                        TEST(thing == NULL);
+                else
+                        TEST(thing && (thing->a == key));
+
+                thing = SKIPLIST_ITEM(skiplist_find_smallest_gte(&list, &key), struct thing, node);
+                if (key > 98)
+                        TEST(thing == NULL);
+                else
+                        TEST(thing && (thing->a == MEC_MAX(-100, (key + 1) & ~1)));
+
+                thing = SKIPLIST_ITEM(skiplist_find_largest_lte(&list, &key), struct thing, node);
+                if (key < -100)
+                        TEST(thing == NULL);
+                else
+                        TEST(thing && (thing->a == MEC_MIN(98, key & ~1)));
+        }
+
+        key = -100;
+        skiplist_for_each(&list, n) {
+                TEST(SKIPLIST_ITEM(n, struct thing, node)->a == key);
+                key += 2;
+        }
+        TEST(key == 100);
+        for (n = skiplist_prev(&list, NULL); n; n = skiplist_prev(&list, n)) {
+                key -= 2;
+                TEST(SKIPLIST_ITEM(n, struct thing, node)->a == key);
+        }
+        TEST(key == -100);
+        epoch_exit(&reader);
+
+        /* Delete every other one, and make sure walking on from a deleted node still works. */
+        for (i=0; i<100; i++) {
+                if ((things[i]->a % 4) == 0) {
+                        TEST(skiplist_delete(&list, &reader, &things[i]->node) == 0);
+                        TEST(skiplist_delete(&list, &reader, &things[i]->node) != 0);
+                        things[i]->in_list = 0;
+                }
+        }
+        epoch_enter(&reader);
+        TEST(skiplist_count(&list) == 50);
+        for (i=0; i<100; i++) {
+                if (things[i]->in_list || (things[i]->a == 96))
+                        continue;
+                thing = check_node(skiplist_next(&list, &things[i]->node));
+                TEST(thing && (thing->a == things[i]->a + 2));
+                thing = check_node(skiplist_prev(&list, &things[i]->node));
+                TEST(thing ? (thing->a == things[i]->a - 2) : (things[i]->a == -100));
+                TEST(skiplist_find(&list, &things[i]->a) == NULL);
+        }
+        epoch_exit(&reader);
+
+        /* Everything deleted gets reclaimed exactly once, and nothing else. */
+        epoch_synchronize(&reader);
+        for (i=0; i<100; i++)
+                TEST(things[i]->reclaimed == !things[i]->in_list);
+
+        for (i=0; i<100; i++)
+                if (things[i]->in_list)
+                        TEST(skiplist_delete(&list, &reader, &things[i]->node) == 0);
+        epoch_synchronize(&reader);
+        for (i=0; i<SKIPLIST_MAX_HEIGHT; i++)
+                TEST(list.head[i] == NULL);
+        for (i=0; i<100; i++) {
+                TEST(things[i]->reclaimed == 1);
+                free(things[i]);
+        }
+
+        epoch_reader_unregister(&reader);
+}
+
+void *churn_thread(void *arg)
+{
+        unsigned t = (unsigned)(unsigned long)arg;
+        struct epoch_reader reader;
+        unsigned seed = t + 1;
+        struct thing *thing, *last;
+        struct skiplist_node *n;
+        unsigned i, j;
+        int key;
+
+        epoch_reader_register(&epoch, &reader);
+
+        for (i=0; i<NUM_WRITES; i++) {
+                thing = churn_things[t][rand_r(&seed) % NUM_CHURN];
+                if (thing->in_list) {
+                        TEST(skiplist_delete(&list, &reader, &thing->node) == 0);
+                        thing->in_list = 0;
+                }
+
+                /* Reuse the thing that has been free the longest, under a new key of our own. */
+                thing = DLIST_ITEM(dlist_pop_front(&free_things[t]), struct thing, free_link);
+                if (thing) {
+                        thing->reclaimed = 0;
+                        do {
+                                key = (rand_r(&seed) % (KEY_RANGE / 2 / NUM_THREADS)) * NUM_THREADS + t;
+                                thing->a = (key << 1) | 1;
+                        } while (skiplist_insert(&list, &reader, &thing->node) != 0);
+                        thing->in_list = 1;
+                }
+
+                key = rand_r(&seed) % (KEY_RANGE - 1);
+
+                epoch_enter(&reader);
+
+                /* Stable items must always be found. */
+                thing = check_node(skiplist_find(&list, &(int){ key & ~1 }));
+                TEST(thing && (thing->a == (key & ~1)));
+
+                /* The smallest item >= key is at most the next stable item. */
+                thing = check_node(skiplist_find_smallest_gte(&list, &key));
+                TEST(thing && (thing->a >= key) && (thing->a <= ((key + 1) & ~1)));
+
+                thing = check_node(skiplist_find_largest_lte(&list, &key));
+                TEST(thing && (thing->a <= key) && (thing->a >= (key & ~1)));
+
+                /* Walk a little way in both directions. */
+                last = thing;
+                for (j=0, n = skiplist_next(&list, &last->node); n && (j < 4); j++, n = skiplist_next(&list, n)) {
+                        thing = check_node(n);
+                        TEST(thing->a > last->a);
+                        last = thing;
+                }
+                for (j=0, n = skiplist_prev(&list, &last->node); n && (j < 4); j++, n = skiplist_prev(&list, n)) {
+                        thing = check_node(n);
+                        TEST(thing->a < last->a);
+                        last = thing;
+                }
+
+                epoch_exit(&reader);
+        }
+
+        epoch_reader_unregister(&reader);
+
+        return NULL;
+}
+
+void test_churn(void)
+{
+        struct epoch_reader reader;
+        pthread_t threads[NUM_THREADS];
+        struct skiplist_node *n;
+        struct thing *thing, *last;
+        uint64_t state = 2;
+        unsigned i, t, count, stable;
+
+        printf("Running %u threads each doing %u deletes, inserts and lookups...\n", NUM_THREADS, NUM_WRITES);
+        epoch_reader_register(&epoch, &reader);
+        skiplist_init(&list, &thing_ops);
+
+        for (i=0; i<NUM_STABLE; i++) {
+                stable_things[i] = new_thing(i * 2, &state);
+                TEST(skiplist_insert(&list, &reader, &stable_things[i]->node) == 0);
+        }
+        for (t=0; t<NUM_THREADS; t++) {
+                dlist_init(&free_things[t]);
+                for (i=0; i<NUM_CHURN; i++) {
+                        churn_things[t][i] = new_thing(-1, &state);
+                        dlist_insert_back(&free_things[t], &churn_things[t][i]->free_link);
+                }
+        }
+
+        for (t=0; t<NUM_THREADS; t++)
+                TEST(pthread_create(&threads[t], NULL, churn_thread, (void *)(unsigned long)t) == 0);
+        for (t=0; t<NUM_THREADS; t++)
+                TEST(pthread_join(threads[t], NULL) == 0);
+
+        printf("Checking list is still ordered and complete...\n");
+        epoch_enter(&reader);
+        count = stable = 0;
+        last = NULL;
+        skiplist_for_each(&list, n) {
+                thing = check_node(n);
+                TEST(!last || (thing->a > last->a));
+                if ((thing->a & 1) == 0)
+                        stable++;
+                count++;
+                last = thing;
+        }
+        epoch_exit(&reader);
+        TEST(stable == NUM_STABLE);
+        for (t=0; t<NUM_THREADS; t++)
+                for (i=0; i<NUM_CHURN; i++)
+                        stable += churn_things[t][i]->in_list;
+        TEST(count == stable);
+
+        for (i=0; i<NUM_STABLE; i++)
+                TEST(skiplist_delete(&list, &reader, &stable_things[i]->node) == 0);
+        for (t=0; t<NUM_THREADS; t++)
+                for (i=0; i<NUM_CHURN; i++)
+                        if (churn_things[t][i]->in_list)
+                                TEST(skiplist_delete(&list, &reader, &churn_things[t][i]->node) == 0);
+        epoch_reader_unregister(&reader);
+        for (i=0; i<SKIPLIST_MAX_HEIGHT; i++)
+                TEST(list.head[i] == NULL);
+
+        for (i=0; i<NUM_STABLE; i++)
+                free(stable_things[i]);
+        for (t=0; t<NUM_THREADS; t++)
+                for (i=0; i<NUM_CHURN; i++)
+                        free(churn_things[t][i]);
+}
+
+/* Every thread tries to delete every stable thing, starting at a different place. */
+void *delete_thread(void *arg)
+{
+        unsigned t = (unsigned)(unsigned long)arg;
+        struct epoch_reader reader;
+        unsigned long wins = 0;
+        unsigned i;
+
+        epoch_reader_register(&epoch, &reader);
+        for (i=0; i<NUM_STABLE; i++)
+                wins += (skiplist_delete(&list, &reader, &stable_things[(i + t * 97) % NUM_STABLE]->node) == 0);
+        epoch_reader_unregister(&reader);
+
+        return (void *)wins;
+}
+
+void test_racing_deletes(void)
+{
+        struct epoch_reader reader;
+        pthread_t threads[NUM_THREADS];
+        unsigned long total = 0;
+        uint64_t state = 3;
+        unsigned i, t;
+        void *wins;
+
+        printf("Checking racing deletes each succeed exactly once...\n");
+        epoch_reader_register(&epoch, &reader);
+        skiplist_init(&list, &thing_ops);
+        for (i=0; i<NUM_STABLE; i++) {
+                stable_things[i] = new_thing(i * 2, &state);
+                TEST(skiplist_insert(&list, &reader, &stable_things[i]->node) == 0);
+        }
+
+        for (t=0; t<NUM_THREADS; t++)
+                TEST(pthread_create(&threads[t], NULL, delete_thread, (void *)(unsigned long)t) == 0);
+        for (t=0; t<NUM_THREADS; t++) {
+                TEST(pthread_join(threads[t], &wins) == 0);
+                total += (unsigned long)wins;
+        }
+        TEST(total == NUM_STABLE);
+        for (i=0; i<SKIPLIST_MAX_HEIGHT; i++)
+                TEST(list.head[i] == NULL);
+
+        epoch_reader_unregister(&reader);
+        for (i=0; i<NUM_STABLE; i++) {
+                TEST(stable_things[i]->reclaimed == 1);
+                free(stable_things[i]);
+        }
+}
+
+int main(void)
+{
+        epoch_init(&epoch);
+
+        test_basic();
+        test_churn();
+        test_racing_deletes();
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
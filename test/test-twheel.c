@@ -0,0 +1,222 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-twheel.c - Unit tests for timer wheels. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mec-lib/twheel.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+struct thing {
+        unsigned id;
+        uint64_t due;           /* When it should go off, or 0 if it shouldn't. */
+        struct twheel_timer timer;
+};
+
+#define NUM_THINGS      100000
+
+struct twheel wheel;
+struct thing thing_array[NUM_THINGS];
+uint64_t state = 1;
+
+static inline uint64_t rand64(void)
+{
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+}
+
+/* Advance to 'now', and check that exactly the things due in ('last', 'now'] went off, in order. */
+void advance(uint64_t last, uint64_t now)
+{
+        struct dlist expired;
+        struct thing *t, *tn;
+        unsigned long count = 0;
+        uint64_t prev = 0;
+
+        dlist_init(&expired);
+        count = twheel_advance(&wheel, now, &expired);
+
+        dlist_for_each_item_safe(&expired, t, tn, struct thing, timer.link) {
+                TEST(t->due > last && t->due <= now);
+                TEST(t->due >= prev);
+                prev = t->due;
+                t->due = 0;
+                dlist_del(&t->timer.link);
+                TEST(!twheel_timer_pending(&t->timer));
+                count--;
+        }
+        TEST(count == 0);
+}
+
+/* Check nothing that should have gone off by 'now' is still waiting. */
+void check_none_late(uint64_t now)
+{
+        unsigned i;
+
+        for (i=0; i<NUM_THINGS; i++)
+                TEST(thing_array[i].due == 0 || thing_array[i].due > now);
+}
+
+void test_exact(void)
+{
+        uint64_t deltas[] = { 0, 1, 2, 62, 63, 64, 65, 127, 128, 4095, 4096, 4097, 100000, 262143, 262144,
+                              1ULL << 30, (1ULL << 36) + 17 };
+        unsigned n = sizeof(deltas) / sizeof(deltas[0]);
+        uint64_t start, now;
+        unsigned i, s;
+
+        printf("Checking timers go off on the exact tick...\n");
+
+        /* Start at a few points relative to block boundaries (not 0, which is 'due' for things that aren't). */
+        for (s=0; s<4; s++) {
+                start = (uint64_t[]){ 1, 63, 64 * 64 - 1, 1000003 }[s];
+                twheel_init(&wheel, start);
+
+                for (i=0; i<n; i++) {
+                        twheel_timer_init(&thing_array[i].timer);
+                        thing_array[i].due = start + deltas[i];
+                        twheel_arm(&wheel, &thing_array[i].timer, thing_array[i].due);
+                        TEST(twheel_timer_pending(&thing_array[i].timer));
+                }
+
+                /* Tick by tick for a while, then straight to each due time. */
+                for (now = start; now < start + 10000; now++) {
+                        advance(now - 1, now);
+                        for (i=0; i<n; i++)
+                                TEST(thing_array[i].due == 0 || thing_array[i].due > now);
+                }
+                for (i=0; i<n; i++) {
+                        if (thing_array[i].due == 0)
+                                continue;
+                        advance(now - 1, thing_array[i].due - 1);
+                        TEST(thing_array[i].due != 0);
+                        advance(thing_array[i].due - 2, thing_array[i].due);
+                        TEST(thing_array[i].due == 0);
+                        now = thing_array[i].due + 1;
+                }
+        }
+
+        /* Timers in the past go off on the next advance. */
+        twheel_init(&wheel, 5000);
+        thing_array[0].due = 5000;
+        twheel_arm(&wheel, &thing_array[0].timer, 10);
+        advance(4999, 5000);
+        TEST(thing_array[0].due == 0);
+
+        /* And ones too far in the future go off at the end of the wheel's range. */
+        now = thing_array[0].due = 5001 + (1ULL << (TWHEEL_BITS * TWHEEL_LEVELS)) - 1;
+        twheel_arm(&wheel, &thing_array[0].timer, UINT64_MAX);
+        advance(5000, thing_array[0].due - 1);
+        TEST(thing_array[0].due != 0);
+        advance(thing_array[0].due - 1, thing_array[0].due);
+        TEST(thing_array[0].due == 0);
+
+        /* Going back in time does nothing, and doesn't move the wheel back. */
+        thing_array[0].due = now + 100;
+        twheel_arm(&wheel, &thing_array[0].timer, thing_array[0].due);
+        advance(now, now - 1000);
+        advance(now, now);
+        TEST(wheel.now == now + 1);
+        advance(now, thing_array[0].due);
+        TEST(thing_array[0].due == 0);
+
+        /* Advancing to the end of time finishes, with or without anything pending. */
+        twheel_init(&wheel, 7);
+        thing_array[0].due = 1000;
+        twheel_arm(&wheel, &thing_array[0].timer, thing_array[0].due);
+        advance(6, UINT64_MAX);
+        TEST(thing_array[0].due == 0);
+        advance(UINT64_MAX, UINT64_MAX);
+        TEST(wheel.now == UINT64_MAX);
+}
+
+void test_random(void)
+{
+        uint64_t now = 12345, next;
+        unsigned i, round, armed = 0;
+        struct thing *t;
+
+        printf("Checking %u timers being armed, re-armed and cancelled...\n", NUM_THINGS);
+
+        twheel_init(&wheel, now);
+        for (i=0; i<NUM_THINGS; i++) {
+                thing_array[i].id = i;
+                thing_array[i].due = 0;
+                twheel_timer_init(&thing_array[i].timer);
+        }
+
+        for (round=0; round<2000; round++) {
+                /* Timeouts that mostly get pushed back before they go off. */
+                for (i=0; i<1000; i++) {
+                        t = &thing_array[rand64() % NUM_THINGS];
+                        if ((rand64() % 10) == 0) {
+                                TEST(twheel_cancel(&t->timer) == (t->due != 0));
+                                TEST(!twheel_timer_pending(&t->timer));
+                                t->due = 0;
+                        } else {
+                                t->due = now + 1 + rand64() % ((rand64() % 2) ? 100 : 1000000);
+                                twheel_arm(&wheel, &t->timer, t->due);
+                        }
+                }
+
+                next = now + 1 + rand64() % 3000;
+                advance(now, next);
+                now = next;
+                if ((round % 100) == 0)
+                        check_none_late(now);
+        }
+
+        /* Let everything left go off. */
+        for (i=0; i<NUM_THINGS; i++)
+                armed += (thing_array[i].due != 0);
+        TEST(armed > 0);
+        advance(now, now + 2000000);
+        check_none_late(UINT64_MAX - 1);
+        for (i=0; i<NUM_THINGS; i++)
+                TEST(!twheel_timer_pending(&thing_array[i].timer));
+}
+
+int main(void)
+{
+        test_exact();
+        test_random();
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */
@@ -0,0 +1,226 @@
+/* Copyright (c) 2026, Matthew E. Cross <matt.cross@gmail.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software
+ * for any purpose with or without fee is hereby granted, provided
+ * that the above copyright notice and this permission notice appear
+ * in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE
+ * AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* test-wsched.c - Unit tests for the work-stealing scheduler. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "mec-lib/wsched.h"
+
+
+
+#define TEST(_expr)                             \
+        do {                                    \
+                if (!(_expr)) {                 \
+                        fprintf(stderr, "TEST FAILED @ %s:%d '%s' not true\n",  \
+                                __FILE__, __LINE__, #_expr );                   \
+                        abort();                                                \
+                }                                                               \
+        } while (0)
+
+#define NUM_WORKERS     4
+#define NUM_ITEMS       1000000
+#define NUM_CHILDREN    (WSCHED_DEQUE_SIZE * 3)
+
+struct wsched sched;
+struct wsched_worker workers[NUM_WORKERS];
+unsigned char covered[NUM_ITEMS];
+unsigned long ran_on[NUM_WORKERS];
+
+/* Naive recursive Fibonacci, the usual fork/join exercise: lots of tiny tasks. */
+struct fib {
+        struct wsched_task task;
+        unsigned n;
+        unsigned long result;
+};
+
+void fib_fn(struct wsched_task *t, struct wsched_worker *w)
+{
+        struct fib *f = WSCHED_ITEM(t, struct fib, task);
+        struct fib a, b;
+
+        if (f->n < 2) {
+                f->result = f->n;
+                return;
+        }
+
+        a.n = f->n - 1;
+        b.n = f->n - 2;
+        wsched_task_init(&a.task, fib_fn);
+        wsched_task_init(&b.task, fib_fn);
+        wsched_spawn(w, t, &a.task);
+        wsched_spawn(w, t, &b.task);
+        wsched_sync(w, t);
+
+        f->result = a.result + b.result;
+}
+
+unsigned long fib_serial(unsigned n)
+{
+        return (n < 2) ? n : fib_serial(n - 1) + fib_serial(n - 2);
+}
+
+void test_fib(void)
+{
+        struct fib f;
+        unsigned n;
+
+        printf("Checking spawn and sync...\n");
+
+        for (n = 0; n < 25; n += 3) {
+                f.n = n;
+                wsched_task_init(&f.task, fib_fn);
+                wsched_run(&sched, &f.task);
+                TEST(f.result == fib_serial(n));
+        }
+}
+
+void cover(size_t lo, size_t hi, void *arg, struct wsched_worker *w)
+{
+        size_t grain = *(size_t *)arg;
+        size_t i;
+
+        TEST(lo < hi && hi <= NUM_ITEMS);
+        TEST(hi - lo <= grain);
+        TEST(w->id < NUM_WORKERS);
+        __atomic_fetch_add(&ran_on[w->id], hi - lo, __ATOMIC_RELAXED);
+
+        for (i=lo; i<hi; i++)
+                __atomic_fetch_add(&covered[i], 1, __ATOMIC_RELAXED);
+}
+
+void test_for(void)
+{
+        size_t grains[] = { 1, 7, 1000, NUM_ITEMS, NUM_ITEMS * 2 };
+        size_t i, g;
+
+        printf("Checking parallel for...\n");
+
+        for (g=0; g<sizeof(grains)/sizeof(grains[0]); g++) {
+                for (i=0; i<NUM_ITEMS; i++)
+                        covered[i] = 0;
+
+                wsched_for(&sched, 0, NUM_ITEMS, grains[g], cover, &grains[g]);
+                for (i=0; i<NUM_ITEMS; i++)
+                        TEST(covered[i] == 1);
+
+                /* Empty and offset ranges. */
+                wsched_for(&sched, 5, 5, grains[g], cover, &grains[g]);
+                wsched_for(&sched, NUM_ITEMS - 3, NUM_ITEMS, grains[g], cover, &grains[g]);
+                for (i=0; i<NUM_ITEMS; i++)
+                        TEST(covered[i] == 1 + (i >= NUM_ITEMS - 3));
+        }
+}
+
+/* A task that spawns more children than fit in a deque, each of which runs a parallel for of its own. */
+struct wide {
+        struct wsched_task task;
+        struct wsched_task children[NUM_CHILDREN];
+};
+
+void child_fn(struct wsched_task *t, struct wsched_worker *w)
+{
+        size_t grain = 10;
+
+        wsched_parallel_for(w, (t - WSCHED_ITEM(t->parent, struct wide, task)->children) * 100,
+                            (t - WSCHED_ITEM(t->parent, struct wide, task)->children + 1) * 100, grain, cover, &grain);
+}
+
+void wide_fn(struct wsched_task *t, struct wsched_worker *w)
+{
+        struct wide *wide = WSCHED_ITEM(t, struct wide, task);
+        unsigned i;
+
+        /* No sync; returning does it. */
+        for (i=0; i<NUM_CHILDREN; i++) {
+                wsched_task_init(&wide->children[i], child_fn);
+                wsched_spawn(w, t, &wide->children[i]);
+        }
+}
+
+void test_wide(void)
+{
+        static struct wide wide;
+        size_t i;
+
+        printf("Checking a full deque...\n");
+
+        for (i=0; i<NUM_ITEMS; i++)
+                covered[i] = 0;
+
+        wsched_task_init(&wide.task, wide_fn);
+        wsched_run(&sched, &wide.task);
+        TEST(wide.task.pending == 0);
+        for (i=0; i<NUM_ITEMS; i++)
+                TEST(covered[i] == (i < NUM_CHILDREN * 100));
+}
+
+void test_idle(void)
+{
+        unsigned i;
+
+        printf("Checking work after workers have gone to sleep...\n");
+
+        usleep(100000);
+        TEST(__atomic_load_n(&sched.sleepers, __ATOMIC_RELAXED) == sched.started);
+        test_fib();
+
+        /* Over enough work, every worker should get some. */
+        for (i=0; i<NUM_WORKERS; i++)
+                ran_on[i] = 0;
+        test_for();
+        for (i=0; i<NUM_WORKERS; i++)
+                TEST(ran_on[i] > 0);
+}
+
+int main(void)
+{
+        struct wsched_worker one;
+        struct fib f = { .n = 20 };
+
+        TEST(wsched_init(&sched, workers, 0) != 0);
+
+        /* A scheduler with only the calling thread just runs things. */
+        TEST(wsched_init(&sched, &one, 1) == 0);
+        wsched_task_init(&f.task, fib_fn);
+        wsched_run(&sched, &f.task);
+        TEST(f.result == fib_serial(20));
+        wsched_destroy(&sched);
+
+        TEST(wsched_init(&sched, workers, NUM_WORKERS) == 0);
+        TEST(sched.started == NUM_WORKERS - 1);
+
+        test_fib();
+        test_for();
+        test_wide();
+        test_idle();
+
+        wsched_destroy(&sched);
+
+        return 0;
+}
+
+
+
+/* Local Variables:            */
+/* mode: c                     */
+/* c-basic-offset: 8           */
+/* indent-tabs-mode: nil       */
+/* fill-column: 120            */
+/* c-backslash-max-column: 120 */
+/* End:                        */